@@ -0,0 +1,35 @@
+// Set 0 bindings 5 to 7, written by LightClusterSystem. Include global_ubo.glsl first
+const uint MAX_LIGHTS_PER_CLUSTER = 128; // Matches LightClusterSystem
+
+struct PointLight {
+  vec4 position; // w is the radius
+  vec4 color;    // w is intensity
+};
+
+layout(std430, set = 0, binding = 5) readonly buffer LightBuffer {
+  PointLight pointLights[];
+};
+
+layout(std430, set = 0, binding = 6) readonly buffer ClusterBuffer {
+  uint clusterLightCounts[];
+};
+
+layout(std430, set = 0, binding = 7) readonly buffer LightIndexBuffer {
+  uint clusterLightIndices[]; // MAX_LIGHTS_PER_CLUSTER per cluster
+};
+
+// The cluster a fragment falls in, from its window position and view space depth
+uint clusterIndex(vec2 fragCoord, float viewDepth) {
+  uvec3 grid = ubo.clusterGrid.xyz;
+  uvec2 tile = min(uvec2(fragCoord * vec2(grid.xy) / ubo.viewport.xy), grid.xy - 1u);
+  float slice = log(max(viewDepth, 1e-4)) * ubo.clusterDepth.x + ubo.clusterDepth.y;
+  uint z = uint(clamp(slice, 0.0, float(grid.z - 1u)));
+  return (z * grid.y + tile.y) * grid.x + tile.x;
+}
+
+// Inverse square, windowed to reach zero at the light's radius so lights can be left out of clusters past it
+float pointLightAttenuation(float distanceSquared, float radius) {
+  float ratio = distanceSquared / (radius * radius);
+  float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+  return window * window / max(distanceSquared, 1e-4);
+}
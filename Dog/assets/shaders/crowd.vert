@@ -0,0 +1,134 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+
+// Crowd instances, skinned here from palettes baked ahead of time (see AnimationBaker.h) instead of by
+// skin.comp, so animating them costs nothing on the CPU. Each instance plays its clip from the frame time
+// with its own offset and speed, blending the two nearest baked frames.
+// Compiled once per vertex layout like simple_shader.vert, VERTEX_SKINNED adds the bone stream at binding 1
+#ifdef VERTEX_PACKED
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec2 inNormal;
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec3 inNormal;
+#endif
+layout(location = 3) in vec2 inTexCoord;
+
+#ifdef VERTEX_COLOR
+#ifdef VERTEX_PACKED
+layout(location = 1) in vec4 inColor;
+#else
+layout(location = 1) in vec3 inColor;
+#endif
+#endif
+
+#ifdef VERTEX_SKINNED
+#ifdef VERTEX_PACKED
+layout(location = 4) in uvec4 inBoneIds;
+#else
+layout(location = 4) in ivec4 inBoneIds;
+#endif
+layout(location = 5) in vec4 inWeights;
+#endif
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCoord;
+layout(location = 4) flat out int fragTextureIndex;
+
+#include "global_ubo.glsl"
+
+// Every baked clip's palettes, frame after frame
+layout(std430, set = 2, binding = 0) readonly buffer BakedPaletteBuffer {
+  mat4 bakedBones[];
+};
+
+struct CrowdInstance {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+  float timeOffset; // Seconds
+  float speed;
+};
+
+layout(std430, set = 2, binding = 1) readonly buffer CrowdInstanceBuffer {
+  CrowdInstance crowdInstances[];
+};
+
+layout(push_constant) uniform Push {
+  vec4 positionDecode; // xyz offset, w scale
+  vec4 uvDecode;       // xy offset, zw scale
+  uint firstMatrix;    // The clip's first frame in the baked palettes
+  uint boneCount;
+  uint frameCount;
+  float framesPerSecond;
+  float time;          // Seconds
+  int textureIndex;
+} push;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+#ifdef VERTEX_SKINNED
+// Unused slots have no weight or a negative id, like skin.comp
+mat4 bakedSkin(uint frame, ivec4 boneIds, vec4 weights) {
+    uint palette = push.firstMatrix + frame * push.boneCount;
+    mat4 skin = mat4(0.0);
+    for (int k = 0; k < 4; k++) {
+        if (weights[k] == 0.0 || boneIds[k] < 0 || uint(boneIds[k]) >= push.boneCount) {
+            continue;
+        }
+        skin += bakedBones[palette + uint(boneIds[k])] * weights[k];
+    }
+    return skin;
+}
+#endif
+
+void main() {
+    CrowdInstance instance = crowdInstances[gl_InstanceIndex];
+
+    vec3 position = push.positionDecode.xyz + inPosition.xyz * push.positionDecode.w;
+    vec2 texCoord = push.uvDecode.xy + inTexCoord * push.uvDecode.zw;
+#ifdef VERTEX_PACKED
+    vec3 normal = decodeOctahedral(inNormal);
+#else
+    vec3 normal = inNormal;
+#endif
+#ifdef VERTEX_COLOR
+    vec3 color = inColor.rgb;
+#else
+    vec3 color = vec3(1.0);
+#endif
+
+#ifdef VERTEX_SKINNED
+    // mod keeps negative times in range, and the last frame blends back into the first as the clip loops
+    float frameTime = mod((push.time * instance.speed + instance.timeOffset) * push.framesPerSecond, float(push.frameCount));
+    uint frame = min(uint(frameTime), push.frameCount - 1);
+    uint nextFrame = (frame + 1) % push.frameCount;
+    float blend = frameTime - float(frame);
+
+    ivec4 boneIds = ivec4(inBoneIds);
+    mat4 skin = bakedSkin(frame, boneIds, inWeights) * (1.0 - blend) + bakedSkin(nextFrame, boneIds, inWeights) * blend;
+    if (skin == mat4(0.0)) {
+        skin = mat4(1.0);
+    }
+
+    position = (skin * vec4(position, 1.0)).xyz;
+    normal = mat3(skin) * normal;
+#endif
+
+    vec4 worldPosition = instance.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * worldPosition;
+
+    fragColor = color;
+    fragPosWorld = worldPosition.xyz;
+    fragNormalWorld = normalize((instance.normalMatrix * vec4(normal, 0.0)).xyz);
+    fragTexCoord = texCoord;
+    fragTextureIndex = push.textureIndex;
+}
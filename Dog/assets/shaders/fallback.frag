@@ -0,0 +1,17 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 0) in vec3 fragPosWorld;
+
+layout (location = 0) out vec4 outColor;
+
+#include "global_ubo.glsl"
+
+void main() {
+  // Flat grey, shaded by the face's angle to the camera so shapes still read
+  vec3 faceNormal = normalize(cross(dFdx(fragPosWorld), dFdy(fragPosWorld)));
+  vec3 viewDirection = normalize(ubo.invView[3].xyz - fragPosWorld);
+  float shade = 0.3 + 0.5 * abs(dot(faceNormal, viewDirection));
+  outColor = vec4(vec3(shade), 1.0);
+}
@@ -0,0 +1,37 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+
+// Drawn while a mesh's real pipeline is still compiling. Only positions are read, and they're at
+// location 0 in every vertex layout, so this one shader serves them all
+layout(location = 0) in vec4 inPosition;
+
+layout(location = 0) out vec3 fragPosWorld;
+
+#include "global_ubo.glsl"
+
+struct InstanceData {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+  vec4 positionDecode; // xyz offset, w scale
+  vec4 uvDecode;       // xy offset, zw scale
+  int textureIndex;
+  uint drawIndex;
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer InstanceBuffer {
+  InstanceData instances[];
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer VisibleInstanceBuffer {
+  uint visibleInstances[];
+};
+
+void main() {
+  InstanceData instance = instances[visibleInstances[gl_InstanceIndex]];
+
+  vec3 position = instance.positionDecode.xyz + inPosition.xyz * instance.positionDecode.w;
+  vec4 worldPosition = instance.modelMatrix * vec4(position, 1.0);
+  gl_Position = ubo.projection * ubo.view * worldPosition;
+  fragPosWorld = worldPosition.xyz;
+}
@@ -0,0 +1,10 @@
+// Set 0 binding 0, written once per frame by the renderer (GlobalUbo in FrameInfo.h)
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;
+  vec4 ambientLightColor; // w is intensity
+  vec4 viewport;          // xy is the size in pixels
+  vec4 clusterDepth;      // log(view depth) * x + y is the cluster slice
+  uvec4 clusterGrid;      // xyz is the cluster count along each axis, w the point light count
+} ubo;
@@ -1,32 +1,17 @@
 #version 450
 
+#extension GL_GOOGLE_include_directive : require
+
 layout (location = 0) in vec2 fragOffset;
+layout (location = 1) in vec3 fragColor;
 layout (location = 0) out vec4 outColor;
 
-struct PointLight {
-  vec4 position; // ignore w
-  vec4 color; // w is intensity
-};
-
-layout(set = 0, binding = 0) uniform GlobalUbo {
-  mat4 projection;
-  mat4 view;
-  mat4 invView;
-  vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
-  int numLights;
-} ubo;
-
-layout(push_constant) uniform Push {
-  vec4 position;
-  vec4 color;
-  float radius;
-} push;
+#include "global_ubo.glsl"
 
 void main() {
   float dis = sqrt(dot(fragOffset, fragOffset));
   
-  vec3 clr = push.color.xyz;
+  vec3 clr = fragColor;
 
   if (dis >= 1.0) {
     discard;
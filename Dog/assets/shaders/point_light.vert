@@ -1,5 +1,9 @@
 #version 450
 
+#extension GL_GOOGLE_include_directive : require
+
+// A billboard per point light, instanced over the light buffer
+
 const vec2 OFFSETS[6] = vec2[](
   vec2(-1.0, -1.0),
   vec2(-1.0, 1.0),
@@ -9,37 +13,25 @@ const vec2 OFFSETS[6] = vec2[](
   vec2(1.0, 1.0)
 );
 
-layout (location = 0) out vec2 fragOffset;
-
-struct PointLight {
-  vec4 position; // ignore w
-  vec4 color; // w is intensity
-};
+const float BILLBOARD_RADIUS = 0.1;
 
-layout(set = 0, binding = 0) uniform GlobalUbo {
-  mat4 projection;
-  mat4 view;
-  mat4 invView;
-  vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
-  int numLights;
-} ubo;
-
-layout(push_constant) uniform Push {
-  vec4 position;
-  vec4 color;
-  float radius;
-} push;
+layout (location = 0) out vec2 fragOffset;
+layout (location = 1) out vec3 fragColor;
 
+#include "global_ubo.glsl"
+#include "clustered_lights.glsl"
 
 void main() {
+  PointLight light = pointLights[gl_InstanceIndex];
+
   fragOffset = OFFSETS[gl_VertexIndex];
+  fragColor = light.color.xyz;
   vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
   vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-  vec3 positionWorld = push.position.xyz
-    + push.radius * fragOffset.x * cameraRightWorld
-    + push.radius * fragOffset.y * cameraUpWorld;
+  vec3 positionWorld = light.position.xyz
+    + BILLBOARD_RADIUS * fragOffset.x * cameraRightWorld
+    + BILLBOARD_RADIUS * fragOffset.y * cameraUpWorld;
 
   gl_Position = ubo.projection * (ubo.view * vec4(positionWorld, 1.0));
-}
\ No newline at end of file
+}
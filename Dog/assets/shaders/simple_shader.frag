@@ -1,38 +1,28 @@
 #version 450
 
+#extension GL_GOOGLE_include_directive : require
 #extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
 layout (location = 2) in vec3 fragNormalWorld;
 layout (location = 3) in vec2 fragTexCoord;
+layout (location = 4) flat in int fragTextureIndex;
 
 layout (location = 0) out vec4 outColor;
 
-struct PointLight {
-  vec4 position; // ignore w
-  vec4 color; // w is intensity
-};
+#include "global_ubo.glsl"
+#include "clustered_lights.glsl"
 
-layout(set = 0, binding = 0) uniform GlobalUbo {
-  mat4 projection;
-  mat4 view;
-  mat4 invView;
-  vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
-  int numLights;
-} ubo;
-
-layout(set = 0, binding = 1) uniform sampler2D uTextures[];  // Texture sampler
-
-layout(push_constant) uniform Push {
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-  int textureIndex;
-} push;
+layout(set = 1, binding = 0) uniform sampler2D uTextures[];  // Bindless textures, indexed by texture index
 
 void main() {
-   // Ambient light
+  // Discarded fragments skip the light loop
+  if (fragTextureIndex == 999) {
+    discard;
+  }
+
+  // Ambient light
   vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
   vec3 specularLight = vec3(0.0);
   vec3 surfaceNormal = normalize(fragNormalWorld);
@@ -40,10 +30,15 @@ void main() {
   vec3 cameraPosWorld = ubo.invView[3].xyz;
   vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-  for (int i = 0; i < ubo.numLights; i++) {
-    PointLight light = ubo.pointLights[i];
+  // Only the lights whose radius reaches this fragment's cluster
+  float viewDepth = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+  uint cluster = clusterIndex(gl_FragCoord.xy, viewDepth);
+  uint clusterLightCount = clusterLightCounts[cluster];
+
+  for (uint i = 0; i < clusterLightCount; i++) {
+    PointLight light = pointLights[clusterLightIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
     vec3 directionToLight = light.position.xyz - fragPosWorld;
-    float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
+    float attenuation = pointLightAttenuation(dot(directionToLight, directionToLight), light.position.w);
     directionToLight = normalize(directionToLight);
 
     // Diffuse lighting
@@ -59,13 +54,7 @@ void main() {
   }
 
   // Fetch texture color
-  vec4 texColor = vec4(1.0);
-  if (push.textureIndex == 999) {
-    discard;
-  }
-  if (push.textureIndex != 999) {
-    texColor = texture(uTextures[push.textureIndex], fragTexCoord);
-  }
+  vec4 texColor = texture(uTextures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
 
   // Combine texture color with diffuse lighting (multiplicative)
   vec3 lightingContribution = texColor.xyz * diffuseLight;
@@ -74,6 +63,5 @@ void main() {
   vec3 finalColor = lightingContribution + specularLight;
 
   // Output final color
-  //outColor = vec4(finalColor, 1.f);
-  outColor = vec4(texColor.rgba);
+  outColor = vec4(finalColor, texColor.a);
 }
@@ -1,70 +1,87 @@
 #version 450
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
-layout(location = 3) in vec2 texCoord;
-layout(location = 4) in ivec4 boneIds;
-layout(location = 5) in vec4 weights;
+#extension GL_GOOGLE_include_directive : require
+
+// Compiled once per static vertex layout (see VertexLayout.h):
+//   VERTEX_PACKED  - snorm16 positions and octahedral normals, unorm16 uvs, unorm8 colors
+//   VERTEX_COLOR   - per-vertex colors, white without
+// Skinned meshes are skinned by skin.comp first and drawn from its full precision copies, so no bones here
+#ifdef VERTEX_PACKED
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec2 inNormal;
+#else
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec3 inNormal;
+#endif
+layout(location = 3) in vec2 inTexCoord;
+
+#ifdef VERTEX_COLOR
+#ifdef VERTEX_PACKED
+layout(location = 1) in vec4 inColor;
+#else
+layout(location = 1) in vec3 inColor;
+#endif
+#endif
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragTexCoord;
+layout(location = 4) flat out int fragTextureIndex;
 
-struct PointLight {
-  vec4 position; // ignore w
-  vec4 color; // w is intensity
-};
+#include "global_ubo.glsl"
 
-layout(set = 0, binding = 0) uniform GlobalUbo {
-  mat4 projection;
-  mat4 view;
-  mat4 invView;
-  vec4 ambientLightColor; // w is intensity
-  PointLight pointLights[10];
-  int numLights;
-} ubo;
-
-layout(push_constant) uniform Push {
+struct InstanceData {
   mat4 modelMatrix;
   mat4 normalMatrix;
-} push;
+  vec4 positionDecode; // xyz offset, w scale
+  vec4 uvDecode;       // xy offset, zw scale
+  int textureIndex;
+  uint drawIndex;
+};
 
-const int MAX_BONES = 100;
-const int MAX_BONE_INFLUENCE = 4;
+layout(std430, set = 0, binding = 3) readonly buffer InstanceBuffer {
+  InstanceData instances[];
+};
+
+// Written by the cull pass, maps each drawn instance to its slot in the instance buffer
+layout(std430, set = 0, binding = 4) readonly buffer VisibleInstanceBuffer {
+  uint visibleInstances[];
+};
 
-layout(set = 0, binding = 2) uniform BonesUbo {
-    mat4 finalBonesMatrices[MAX_BONES];
-} bones;
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 void main() {
-    vec4 totalPosition = vec4(0.0f);
-    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
-    {
-        if(boneIds[i] == -1) 
-            continue;
-        if(boneIds[i] >=MAX_BONES) 
-        {
-            totalPosition = vec4(position,1.0f);
-            break;
-        }
-        vec4 localPosition = bones.finalBonesMatrices[boneIds[i]] * vec4(position,1.0f);
-        totalPosition += localPosition * weights[i];
-        vec3 localNormal = mat3(bones.finalBonesMatrices[boneIds[i]]) * normal;
-   }
+    InstanceData instance = instances[visibleInstances[gl_InstanceIndex]];
 
-    if (totalPosition == vec4(0.0)) {
-		totalPosition = vec4(position, 1.0);
-	}
+    // Full precision meshes have identity decode transforms
+    vec3 position = instance.positionDecode.xyz + inPosition.xyz * instance.positionDecode.w;
+    vec2 texCoord = instance.uvDecode.xy + inTexCoord * instance.uvDecode.zw;
+#ifdef VERTEX_PACKED
+    vec3 normal = decodeOctahedral(inNormal);
+#else
+    vec3 normal = inNormal;
+#endif
+#ifdef VERTEX_COLOR
+    vec3 color = inColor.rgb;
+#else
+    vec3 color = vec3(1.0);
+#endif
 
     // Transform the vertex by the model matrix and the projection/view matrices
-    vec4 worldPosition = push.modelMatrix * totalPosition;
+    vec4 worldPosition = instance.modelMatrix * vec4(position, 1.0);
     gl_Position = ubo.projection * ubo.view * worldPosition;
 
     // Pass through the other varying data (colors, normals, texture coordinates)
     fragColor = color;
     fragPosWorld = worldPosition.xyz;
-    fragNormalWorld = normalize((push.normalMatrix * vec4(normal, 0.0)).xyz);
+    fragNormalWorld = normalize((instance.normalMatrix * vec4(normal, 0.0)).xyz);
     fragTexCoord = texCoord;
+    fragTextureIndex = instance.textureIndex;
 }
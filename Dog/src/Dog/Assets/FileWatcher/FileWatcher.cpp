@@ -0,0 +1,224 @@
+#include <PCH/pch.h>
+#include "FileWatcher.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace Dog {
+
+	void FileWatcher::AddChange(std::vector<FileChange>& changes, const std::string& path, Change change)
+	{
+		for (FileChange& existing : changes) {
+			if (existing.path != path) continue;
+
+			// Writing a file just created doesn't make it any less new
+			if (!(existing.change == Change::Created && change == Change::Modified)) {
+				existing.change = change;
+			}
+			return;
+		}
+
+		changes.push_back({ path, change });
+	}
+
+#ifdef _WIN32
+
+	static constexpr DWORD WATCH_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+	FileWatcher::FileWatcher(const std::string& directory)
+		: m_Directory(directory)
+		, m_Buffer(64 * 1024)
+	{
+		HANDLE handle = CreateFileA(
+			directory.c_str(),
+			FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			nullptr);
+		if (handle == INVALID_HANDLE_VALUE) {
+			DOG_WARN("Can't watch {0} for changes", directory);
+			return;
+		}
+		m_Handle = handle;
+
+		OVERLAPPED* overlapped = new OVERLAPPED{};
+		overlapped->hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		m_Overlapped = overlapped;
+
+		BeginRead();
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		OVERLAPPED* overlapped = static_cast<OVERLAPPED*>(m_Overlapped);
+		if (m_Handle) {
+			// The pending read writes into m_Buffer, so it has to finish before the buffer goes
+			CancelIo(m_Handle);
+			DWORD bytes = 0;
+			GetOverlappedResult(m_Handle, overlapped, &bytes, TRUE);
+			CloseHandle(m_Handle);
+		}
+		if (overlapped) {
+			CloseHandle(overlapped->hEvent);
+			delete overlapped;
+		}
+	}
+
+	bool FileWatcher::IsWatching() const
+	{
+		return m_Handle != nullptr;
+	}
+
+	void FileWatcher::BeginRead()
+	{
+		OVERLAPPED* overlapped = static_cast<OVERLAPPED*>(m_Overlapped);
+		ResetEvent(overlapped->hEvent);
+		if (!ReadDirectoryChangesW(m_Handle, m_Buffer.data(), static_cast<DWORD>(m_Buffer.size()), TRUE, WATCH_FILTER, nullptr, overlapped, nullptr)) {
+			DOG_WARN("Stopped watching {0} for changes", m_Directory);
+			CloseHandle(m_Handle);
+			m_Handle = nullptr;
+		}
+	}
+
+	std::vector<FileWatcher::FileChange> FileWatcher::Poll()
+	{
+		std::vector<FileChange> changes;
+		if (!m_Handle) return changes;
+
+		OVERLAPPED* overlapped = static_cast<OVERLAPPED*>(m_Overlapped);
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(m_Handle, overlapped, &bytes, FALSE)) {
+			// Still waiting for something to change
+			return changes;
+		}
+
+		// Zero bytes means the buffer overflowed and the changes were lost
+		size_t offset = 0;
+		while (bytes > 0) {
+			const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(m_Buffer.data() + offset);
+
+			std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+			std::string path = (std::filesystem::path(m_Directory) / name).generic_string();
+
+			switch (info->Action) {
+			case FILE_ACTION_ADDED:
+			case FILE_ACTION_RENAMED_NEW_NAME:
+				AddChange(changes, path, Change::Created);
+				break;
+			case FILE_ACTION_MODIFIED:
+				AddChange(changes, path, Change::Modified);
+				break;
+			case FILE_ACTION_REMOVED:
+			case FILE_ACTION_RENAMED_OLD_NAME:
+				AddChange(changes, path, Change::Deleted);
+				break;
+			}
+
+			if (info->NextEntryOffset == 0) break;
+			offset += info->NextEntryOffset;
+		}
+
+		BeginRead();
+		return changes;
+	}
+
+#else
+
+	static constexpr uint32_t WATCH_MASK = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+	FileWatcher::FileWatcher(const std::string& directory)
+		: m_Directory(directory)
+	{
+		m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_Inotify < 0) {
+			DOG_WARN("Can't watch {0} for changes", directory);
+			return;
+		}
+
+		// inotify watches a single directory, so every subdirectory gets its own watch
+		AddWatch("");
+		std::error_code error;
+		for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+			if (it->is_directory()) {
+				AddWatch(std::filesystem::relative(it->path(), directory).generic_string());
+			}
+		}
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		// Closing the descriptor removes every watch
+		if (m_Inotify >= 0) close(m_Inotify);
+	}
+
+	bool FileWatcher::IsWatching() const
+	{
+		return m_Inotify >= 0;
+	}
+
+	void FileWatcher::AddWatch(const std::string& relativeDirectory)
+	{
+		std::string path = relativeDirectory.empty() ? m_Directory : m_Directory + "/" + relativeDirectory;
+		int watch = inotify_add_watch(m_Inotify, path.c_str(), WATCH_MASK);
+		if (watch < 0) {
+			DOG_WARN("Can't watch {0} for changes", path);
+			return;
+		}
+		m_WatchedDirectories[watch] = relativeDirectory;
+	}
+
+	std::vector<FileWatcher::FileChange> FileWatcher::Poll()
+	{
+		std::vector<FileChange> changes;
+		if (m_Inotify < 0) return changes;
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		for (;;) {
+			ssize_t length = read(m_Inotify, buffer, sizeof(buffer));
+			if (length <= 0) break; // EAGAIN, nothing more queued
+
+			for (ssize_t offset = 0; offset < length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				auto directory = m_WatchedDirectories.find(event->wd);
+				if (directory == m_WatchedDirectories.end() || event->len == 0) continue;
+
+				std::string relativePath = directory->second.empty() ? event->name : directory->second + "/" + event->name;
+
+				// New directories need watches of their own, their files are reported from then on
+				if (event->mask & IN_ISDIR) {
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						AddWatch(relativePath);
+					}
+					continue;
+				}
+
+				std::string path = m_Directory + "/" + relativePath;
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					AddChange(changes, path, Change::Created);
+				}
+				else if (event->mask & IN_CLOSE_WRITE) {
+					// Only once the writer is done, so the file is never read half written
+					AddChange(changes, path, Change::Modified);
+				}
+				else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					AddChange(changes, path, Change::Deleted);
+				}
+			}
+		}
+
+		return changes;
+	}
+
+#endif
+
+}
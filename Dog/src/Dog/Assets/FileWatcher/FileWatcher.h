@@ -0,0 +1,49 @@
+#pragma once
+
+namespace Dog {
+
+	// Reports files created, modified and deleted anywhere under a directory, through
+	// inotify on Linux and ReadDirectoryChangesW on Windows. Nothing happens in the
+	// background, changes queue up in the OS until the next Poll.
+	class FileWatcher
+	{
+	public:
+		enum class Change { Created, Modified, Deleted };
+
+		struct FileChange {
+			std::string path; // The watched directory joined with the file's path in it, with forward slashes
+			Change change;
+		};
+
+		// Watching nothing, with a warning, if the directory can't be watched
+		FileWatcher(const std::string& directory);
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		// Changes since the last call, never blocks. A file saved several times, or created
+		// and then written, is reported once
+		std::vector<FileChange> Poll();
+
+		bool IsWatching() const;
+
+	private:
+		void AddChange(std::vector<FileChange>& changes, const std::string& path, Change change);
+
+		std::string m_Directory;
+
+#ifdef _WIN32
+		void* m_Handle = nullptr;
+		void* m_Overlapped = nullptr; // OVERLAPPED, kept out of the header with the rest of windows.h
+		std::vector<uint8_t> m_Buffer;
+		void BeginRead();
+#else
+		void AddWatch(const std::string& relativeDirectory);
+
+		int m_Inotify = -1;
+		std::unordered_map<int, std::string> m_WatchedDirectories; // Watch descriptor to its directory, relative to m_Directory
+#endif
+	};
+
+}
@@ -0,0 +1,90 @@
+#include <PCH/pch.h>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Dog {
+
+#ifdef _WIN32
+
+	MappedFile::MappedFile(const std::string& path)
+	{
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Failed to open file for mapping: " + path);
+		}
+		m_File = file;
+
+		LARGE_INTEGER size{};
+		GetFileSizeEx(file, &size);
+		m_Size = static_cast<size_t>(size.QuadPart);
+
+		// Empty files can't be mapped, they just have no data
+		if (m_Size == 0) return;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) {
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+		m_Mapping = mapping;
+
+		m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_Data) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data) UnmapViewOfFile(m_Data);
+		if (m_Mapping) CloseHandle(m_Mapping);
+		if (m_File) CloseHandle(m_File);
+	}
+
+#else
+
+	MappedFile::MappedFile(const std::string& path)
+	{
+		m_File = open(path.c_str(), O_RDONLY);
+		if (m_File < 0) {
+			throw std::runtime_error("Failed to open file for mapping: " + path);
+		}
+
+		struct stat info{};
+		fstat(m_File, &info);
+		m_Size = static_cast<size_t>(info.st_size);
+
+		// Empty files can't be mapped, they just have no data
+		if (m_Size == 0) return;
+
+		void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+		if (data == MAP_FAILED) {
+			close(m_File);
+			throw std::runtime_error("Failed to map file: " + path);
+		}
+		m_Data = static_cast<const uint8_t*>(data);
+
+		// Loaders read the file front to back
+		madvise(data, m_Size, MADV_SEQUENTIAL);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (m_Data) munmap(const_cast<uint8_t*>(m_Data), m_Size);
+		if (m_File >= 0) close(m_File);
+	}
+
+#endif
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+namespace Dog {
+
+	// A read-only view of a whole file through the OS's memory mapping, so
+	// loaders read straight out of the page cache instead of copying the file.
+	class MappedFile
+	{
+	public:
+		// Throws if the file can't be opened or mapped
+		MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+		// True if [offset, offset + size) lies within [0, limit). Offsets read from a file
+		// can be anything, so this never computes offset + size, which could wrap around
+		static bool InRange(uint64_t offset, uint64_t size, uint64_t limit) { return size <= limit && offset <= limit - size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+
+#ifdef _WIN32
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#else
+		int m_File = -1;
+#endif
+	};
+
+}
@@ -8,6 +8,9 @@
 #include "Graphics/Vulkan/systems/SimpleRenderSystem.h"
 #include "Graphics/Vulkan/Texture/Texture.h"
 #include "Graphics/Vulkan/Texture/ImGuiTexture.h"
+#include "Graphics/Vulkan/Models/GeometryPool.h"
+#include "Graphics/Vulkan/Pipeline/PipelineCache.h"
+#include "Graphics/Vulkan/Pipeline/PipelineCompiler.h"
 
 #include "glslang/Public/ShaderLang.h"
 
@@ -21,30 +24,107 @@
 #include "Scene/Entity/Components.h"
 
 #include "Graphics/Editor/Editor.h"
+#include "Profiling/FrameProfiler.h"
+#include "Assets/FileWatcher/FileWatcher.h"
+#include "Events/Event.h"
 
 namespace Dog {
 
     Engine::Engine(const EngineSpec& specs)
-        : m_Window(specs.width, specs.height, specs.name)
-        , m_Renderer(std::make_unique<Renderer>(m_Window, device))
-        , textureLibrary(device)
-        , modelLibrary(device, textureLibrary)
+        : m_Window(specs.width, specs.height, specs.name, specs.headless)
+        , m_JobSystem(specs.workerThreads)
+        , m_Renderer(std::make_unique<Renderer>(m_Window, device, m_JobSystem, specs.recordThreads))
+        , textureLibrary(device, m_JobSystem)
+        , modelLibrary(device, textureLibrary, m_JobSystem, specs.quantizeVertices)
         , fps(specs.fps)
     {
         Logger::Init();
         m_Editor = std::make_unique<Editor>();
+        m_ShaderWatcher = std::make_unique<FileWatcher>("assets/shaders");
+        m_Renderer->SetLodQuality(specs.lodQuality);
+        m_Renderer->SetAnimationLodEnabled(specs.animationLod);
+        m_Renderer->SetDrawSortingEnabled(specs.sortDraws);
     }
 
     Engine::~Engine() {
-        m_Editor->Exit();
+        if (!m_Window.isHeadless()) {
+            m_Editor->Exit();
+        }
     }
 
-    void Engine::Run(const std::string& sceneName) {
+    void Engine::InitScene(const std::string& sceneName) {
         // Init some stuff
-        m_Editor->Init();
+        if (!m_Window.isHeadless()) {
+            m_Editor->Init();
+        }
         m_Renderer->Init();
 
         SceneManager::Init(sceneName);
+    }
+
+    void Engine::Tick(float dt) {
+        if (!m_Window.isHeadless()) {
+            Input::Update();
+        }
+
+        // Edited shaders start rebuilding their pipelines, they're swapped in when ready
+        PublishShaderChanges();
+
+        // Swap scenes if necessary (also does Init/Exit)
+        SceneManager::SwapScenes();
+
+        // Publish models that finished loading in the background
+        modelLibrary.Update();
+
+        // Update scenes
+        SceneManager::Update(dt);
+
+        // Render scenes (doesn't do anything rn)
+        SceneManager::Render(dt, false);
+
+        m_Renderer->Render(dt, gameObjects); // actual render
+    }
+
+    void Engine::PublishShaderChanges() {
+        static const std::array<std::string, 7> SHADER_EXTENSIONS = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese", ".glsl" };
+
+        for (const FileWatcher::FileChange& change : m_ShaderWatcher->Poll()) {
+            // Also skips what the pipeline cache writes under assets/shaders/cache
+            std::string extension = std::filesystem::path(change.path).extension().string();
+            if (std::find(SHADER_EXTENSIONS.begin(), SHADER_EXTENSIONS.end(), extension) == SHADER_EXTENSIONS.end()) continue;
+
+            switch (change.change) {
+            case FileWatcher::Change::Created:
+                PUBLISH_EVENT(Event::ShaderFileCreated, change.path);
+                break;
+            case FileWatcher::Change::Modified:
+                PUBLISH_EVENT(Event::ShaderFileModified, change.path);
+                break;
+            case FileWatcher::Change::Deleted:
+                PUBLISH_EVENT(Event::ShaderFileDeleted, change.path);
+                break;
+            }
+        }
+    }
+
+    void Engine::ReportStartup() {
+        PipelineCacheStats cacheStats = device.getPipelineCache().getStats();
+
+        StartupTimings startup;
+        startup.firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_CreatedAt).count();
+        startup.shadersCompiled = cacheStats.shadersCompiled;
+        startup.shadersFromDisk = cacheStats.shadersFromDisk;
+        startup.pipelineCacheLoaded = cacheStats.pipelineCacheLoaded;
+        m_Renderer->GetProfiler().SetStartupTimings(startup);
+
+        bool warm = startup.shadersCompiled == 0 && startup.pipelineCacheLoaded;
+        std::cout << "Startup: first frame after " << startup.firstFrameMs << " ms (" << (warm ? "warm" : "cold") << ", "
+            << startup.shadersCompiled << " shaders compiled, " << startup.shadersFromDisk << " from cache, pipeline cache "
+            << (startup.pipelineCacheLoaded ? "loaded" : "empty") << ")" << std::endl;
+    }
+
+    void Engine::Run(const std::string& sceneName) {
+        InitScene(sceneName);
         //SceneManager::SwapScenes();
 
         //Scene& scene = *SceneManager::GetCurrentScene();
@@ -65,28 +145,92 @@ namespace Dog {
 
         //FrameRateController frameRateController(fps);
 
+        bool firstFrame = true;
         auto currentTime = std::chrono::high_resolution_clock::now();
         while (!m_Window.shouldClose() && m_Running) {
-            Input::Update();
-            
             // Need to move in frame rate controller
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            // Swap scenes if necessary (also does Init/Exit)
-            SceneManager::SwapScenes();
+            Tick(frameTime);
+
+            if (firstFrame) {
+                ReportStartup();
+                firstFrame = false;
+            }
+        }
+
+        m_Renderer->Exit();
+    }
+
+    bool Engine::RunBenchmark(const std::string& sceneName, unsigned frameCount, const std::string& outputPath, unsigned warmupFrames) {
+        using Clock = std::chrono::high_resolution_clock;
+        auto elapsedMs = [](Clock::time_point from) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+        };
+
+        // Fixed timestep so every run simulates the same frames
+        const float dt = 1.f / static_cast<float>(fps ? fps : 60);
+        FrameProfiler& profiler = m_Renderer->GetProfiler();
+        LoadTimings loadTimings;
+
+        // The scene is deserialized by the first frame's scene swap
+        Clock::time_point loadStart = Clock::now();
+        InitScene(sceneName);
+        Tick(dt);
+        loadTimings.sceneLoadMs = elapsedMs(loadStart);
+        ReportStartup();
+
+        // Warmup lets caches, pipelines and drivers settle, and keeps going until every model has streamed in
+        // and every pipeline has compiled, so no measured frame draws with a fallback
+        PipelineCompiler& pipelineCompiler = m_Renderer->GetPipelineCompiler();
+        for (unsigned i = 1; (i < warmupFrames || modelLibrary.GetPendingLoadCount() > 0 || pipelineCompiler.getPendingCount() > 0) && !m_Window.shouldClose() && m_Running; ++i) {
+            bool loading = modelLibrary.GetPendingLoadCount() > 0;
+
+            Clock::time_point frameStart = Clock::now();
+            Tick(dt);
+
+            if (loading) {
+                loadTimings.worstLoadFrameMs = std::max(loadTimings.worstLoadFrameMs, elapsedMs(frameStart));
+                if (modelLibrary.GetPendingLoadCount() == 0) {
+                    loadTimings.modelsReadyMs = elapsedMs(loadStart);
+                }
+            }
+        }
 
-            // Update scenes
-            SceneManager::Update(frameTime);
+        if (loadTimings.modelsReadyMs < 0.0) {
+            loadTimings.modelsReadyMs = loadTimings.sceneLoadMs;
+        }
+        profiler.SetLoadTimings(loadTimings);
 
-            // Render scenes (doesn't do anything rn)
-            SceneManager::Render(frameTime, false);
+        GeometryPool& geometryPool = modelLibrary.GetGeometryPool();
+        GeometryMemory geometryMemory;
+        geometryMemory.quantized = geometryPool.isQuantizing();
+        geometryMemory.vertexCount = geometryPool.getVertexCount();
+        geometryMemory.vertexBytes = geometryPool.getVertexBytes();
+        geometryMemory.indexBytes = geometryPool.getIndexBytes();
+        geometryMemory.unpackedVertexBytes = geometryMemory.vertexCount * sizeof(Vertex);
+        profiler.SetGeometryMemory(geometryMemory);
 
-            m_Renderer->Render(frameTime, gameObjects); // actual render
+        m_Renderer->Exit();
+        profiler.Reset();
+        profiler.SetEnabled(true);
+
+        for (unsigned i = 0; i < frameCount && !m_Window.shouldClose() && m_Running; ++i) {
+            Tick(dt);
         }
 
         m_Renderer->Exit();
+        profiler.Resolve();
+        profiler.SetEnabled(false);
+
+        bool written = profiler.WriteJson(outputPath, sceneName, m_Renderer->GetSwapChain().getSwapChainExtent());
+        if (written) {
+            std::cout << "Benchmark: " << profiler.GetTimings().size() << " frames of " << sceneName << " written to " << outputPath << std::endl;
+        }
+
+        return written;
     }
     void Engine::Exit()
     {
@@ -7,8 +7,8 @@
 #include "Graphics/Vulkan/Window/Window.h"
 #include "Graphics/Vulkan/Texture/TextureLibrary.h"
 #include "Graphics/Vulkan/Models/ModelLibrary.h"
-#include "Graphics/Vulkan/Animation/Animation.h"
-#include "Graphics/Vulkan/Animation/Animator.h"
+#include "Graphics/Vulkan/Animation/AnimationLibrary.h"
+#include "Jobs/JobSystem.h"
 
 namespace Dog {
 
@@ -17,9 +17,17 @@ namespace Dog {
 		unsigned width = 1280;           // The width of the window.
 		unsigned height = 720;           // The height of the window.
 		unsigned fps = 60;			     // The target frames per second.
+		bool headless = false;           // Render offscreen with no window, editor or input.
+		int workerThreads = -1;          // Job system workers besides the main thread, -1 for one per remaining core.
+		unsigned recordThreads = 1;      // Jobs recording draw commands. 1 records inline, 0 uses every job thread.
+		bool quantizeVertices = true;    // Packed vertex layouts. False keeps full precision floats, for comparisons.
+		float lodQuality = 1.0f;         // Scales the screen size LODs are picked from. Higher keeps detail further away.
+		bool animationLod = true;        // Samples small and off screen animators at reduced rates. False samples every one every frame.
+		bool sortDraws = true;           // Sorts draws by render queue key and skips redundant binds. False records every bind, for comparisons.
 	};
 
 	class Editor;
+	class FileWatcher;
 
 	class Engine {
 	public:
@@ -51,21 +59,50 @@ namespace Dog {
 		 * brief: Run the engine with the specified scene.
 		 *********************************************************************/
 		void Run(const std::string& sceneName);
+
+		/*********************************************************************
+		 * param:  sceneName: The name of the scene to run. (read from assets/scenes)
+		 * param:  frameCount: The number of frames to record.
+		 * param:  outputPath: Where the JSON report is written.
+		 * param:  warmupFrames: Frames rendered before recording starts.
+		 * return: True if the report was written.
+		 *
+		 * brief: Render the scene for a fixed number of frames at a fixed
+		 *        timestep and write the per-frame CPU record, submit and GPU
+		 *        times as JSON, along with how long the scene and its
+		 *        streamed models took to load and how much memory their
+		 *        geometry takes. Pair with
+		 *        EngineSpec::headless for runs that don't need a display.
+		 *********************************************************************/
+		bool RunBenchmark(const std::string& sceneName, unsigned frameCount, const std::string& outputPath, unsigned warmupFrames = 10);
+
 		void Exit();
 
 		// getters
 		Window& GetWindow() { return m_Window; }
 		Device& GetDevice() { return device; }
+		JobSystem& GetJobSystem() { return m_JobSystem; }
 		Renderer& GetRenderer() { return *m_Renderer; }
 		TextureLibrary& GetTextureLibrary() { return textureLibrary; }
 		ModelLibrary& GetModelLibrary() { return modelLibrary; }
+		AnimationLibrary& GetAnimationLibrary() { return animationLibrary; }
 		Editor& GetEditor() { return *m_Editor; }
 
 	private:
 		void loadGameObjects();
+		void InitScene(const std::string& sceneName);
+		void Tick(float dt);
+		void ReportStartup();
+
+		// Publishes the shader file events for anything changed in assets/shaders since last frame
+		void PublishShaderChanges();
+
+		// Set before anything else is created, for the time to first frame
+		std::chrono::steady_clock::time_point m_CreatedAt = std::chrono::steady_clock::now();
 
 		Window m_Window; // { WIDTH, HEIGHT, "Woof" };
 		Device device{ m_Window };
+		JobSystem m_JobSystem;
 		std::unique_ptr<Renderer> m_Renderer;
 
 		// note: order of declarations matters
@@ -74,13 +111,15 @@ namespace Dog {
 		TextureLibrary textureLibrary;
 		ModelLibrary modelLibrary;
 
-		// Animation
-		std::unique_ptr<Animation> animation;
-		std::unique_ptr<Animator> animator;
+		// Clips shared by every entity's AnimatorComponent
+		AnimationLibrary animationLibrary;
 
 		// Editor
 		std::unique_ptr<Editor> m_Editor;
 
+		// Shader hot reload
+		std::unique_ptr<FileWatcher> m_ShaderWatcher;
+
 		// target fps
 		unsigned fps;
 
@@ -15,10 +15,6 @@ struct TransformComponent {
     glm::mat3 normalMatrix() const;
 };
 
-struct PointLightComponent {
-    float lightIntensity = 1.0f;
-};
-
 class GameObject {
 public:
     using id_t = unsigned int;
@@ -29,9 +25,6 @@ public:
         return GameObject{ currentId++ };
     }
 
-    static GameObject makePointLight(
-        float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
-
     GameObject(const GameObject&) = delete;
     GameObject& operator=(const GameObject&) = delete;
     GameObject(GameObject&&) = default;
@@ -42,8 +35,6 @@ public:
     glm::vec3 color{};
     TransformComponent transform{};
 
-    std::unique_ptr<PointLightComponent> pointLight = nullptr;
-
     uint32_t model = INVALID_MODEL_INDEX;
     uint32_t textureIndex = INVALID_TEXTURE_INDEX;
 
@@ -20,6 +20,7 @@
 #include "Dog/Graphics/Vulkan/Window/Window.h"
 #include "Dog/Graphics/Vulkan/Core/Device.h"
 #include "Dog/Graphics/Vulkan/Core/SwapChain.h"
+#include "Dog/Graphics/Vulkan/Systems/CullingSystem.h"
 
 #include "Scene/Serializer/SceneSerializer.h"
 
@@ -74,7 +75,7 @@ namespace Dog {
 		SwapChain& swapChain = Engine::Get().GetRenderer().GetSwapChain();
 
 		VkDescriptorPoolSize pool_sizes[] = { { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_COUNT },
 			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
 			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
@@ -221,9 +222,10 @@ namespace Dog {
 			ImGui::EndMenu();
 		}
 
-		// FPS
-		char fpsText[32];
-		sprintf_s(fpsText, "FPS: %.1f", ImGui::GetIO().Framerate);
+		// FPS and how many instances survived GPU culling
+		const CullingStats& cullingStats = Engine::Get().GetRenderer().GetCullingStats();
+		char fpsText[64];
+		sprintf_s(fpsText, "Visible: %u/%u  FPS: %.1f", cullingStats.visibleInstances, cullingStats.candidateInstances, ImGui::GetIO().Framerate);
 
 		ImVec2 textSize = ImGui::CalcTextSize(fpsText, NULL, true);
 		ImGui::SetCursorPosX(ImGui::GetWindowWidth() - textSize.x - 10);
@@ -62,6 +62,9 @@ namespace Dog {
 			DisplayAddComponent<TagComponent>(selectedEntity, "Tag");
 			DisplayAddComponent<TransformComponent>(selectedEntity, "Transform");
 			DisplayAddComponent<ModelComponent>(selectedEntity, "Model");
+			DisplayAddComponent<AnimatorComponent>(selectedEntity, "Animator");
+			DisplayAddComponent<BakedAnimatorComponent>(selectedEntity, "Baked Animator");
+			DisplayAddComponent<PointLightComponent>(selectedEntity, "Point Light");
 			// DisplayAddComponent<SpriteComponent>(selectedEntity, "Sprite");
 			// DisplayAddComponent<ShaderComponent>(selectedEntity, "Shader");
 			// DisplayAddComponent<CameraComponent>(selectedEntity, "Camera");
@@ -126,7 +129,7 @@ namespace Dog {
 			viewNames.reserve(modelCount);
 
 			for (uint32_t i = 0; i < modelCount; i++) {
-				auto& str = modelNames.emplace_back(ml.GetModelByIndex(i)->GetPath());
+				auto& str = modelNames.emplace_back(ml.GetModelPath(i));
 				viewNames.emplace_back(str.substr(str.find_last_of('/') + 1));
 			}
 
@@ -156,6 +159,41 @@ namespace Dog {
 
 				ImGui::EndCombo();
 			}
+
+			ImGui::DragFloat("LOD Bias##ModelProp", &model.LodBias, 0.05f, -4.0f, 4.0f);
+			ImGui::Text("LOD: %u", model.CurrentLod);
+		}
+	}
+
+	void RenderAnimatorComponent(AnimatorComponent& animator) {
+		ImGui::SetNextItemOpen(false, ImGuiCond_FirstUseEver);
+
+		if (ImGui::CollapsingHeader("Animator##header")) {
+			ImGui::Text("Clip: %s", animator.AnimationPath.empty() ? "(model's own)" : animator.AnimationPath.c_str());
+			ImGui::Checkbox("Playing##AnimatorProp", &animator.Playing);
+			ImGui::DragFloat("Speed##AnimatorProp", &animator.Speed, 0.05f, 0.0f, 10.0f);
+			ImGui::DragFloat("Time##AnimatorProp", &animator.Time, 0.5f);
+			ImGui::Text("Bones: %u", static_cast<uint32_t>(animator.Pose.palette.size()));
+		}
+	}
+
+	void RenderBakedAnimatorComponent(BakedAnimatorComponent& animator) {
+		ImGui::SetNextItemOpen(false, ImGuiCond_FirstUseEver);
+
+		if (ImGui::CollapsingHeader("Baked Animator##header")) {
+			ImGui::Text("Clip: %s", animator.AnimationPath.empty() ? "(model's own)" : animator.AnimationPath.c_str());
+			ImGui::DragFloat("Speed##BakedAnimatorProp", &animator.Speed, 0.05f, 0.0f, 10.0f);
+			ImGui::DragFloat("Time Offset##BakedAnimatorProp", &animator.TimeOffset, 0.01f);
+		}
+	}
+
+	void RenderPointLightComponent(PointLightComponent& light) {
+		ImGui::SetNextItemOpen(false, ImGuiCond_FirstUseEver);
+
+		if (ImGui::CollapsingHeader("Point Light##header")) {
+			ImGui::ColorEdit3("Color##PointLightProp", &light.Color.x);
+			ImGui::DragFloat("Intensity##PointLightProp", &light.Intensity, 0.05f, 0.0f, 1000.0f);
+			ImGui::DragFloat("Radius##PointLightProp", &light.Radius, 0.05f, 0.0f, 1000.0f);
 		}
 	}
 
@@ -172,6 +210,15 @@ namespace Dog {
 		if (entity.HasComponent<ModelComponent>())
 			RenderModelComponent(entity.GetComponent<ModelComponent>());
 
+		if (entity.HasComponent<AnimatorComponent>())
+			RenderAnimatorComponent(entity.GetComponent<AnimatorComponent>());
+
+		if (entity.HasComponent<BakedAnimatorComponent>())
+			RenderBakedAnimatorComponent(entity.GetComponent<BakedAnimatorComponent>());
+
+		if (entity.HasComponent<PointLightComponent>())
+			RenderPointLightComponent(entity.GetComponent<PointLightComponent>());
+
 		/*if (entity.HasComponent<SpriteComponent>())
 			RenderSpriteComponent(entity.GetComponent<SpriteComponent>());
 
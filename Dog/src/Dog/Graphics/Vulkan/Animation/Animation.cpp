@@ -1,2 +1,199 @@
 #include <PCH/pch.h>
 #include "Animation.h"
+#include "CookedAnimation.h"
+#include "Assets/MappedFile/MappedFile.h"
+
+namespace Dog {
+
+	Animation::Animation(const std::string& animationPath, Model* model, ModelSource source)
+	{
+		std::string cookedPath = GetCookedPath(animationPath);
+
+		if (source != ModelSource::Assimp) {
+			bool useCooked = source == ModelSource::Cooked || Model::IsCookedUpToDate(animationPath, cookedPath);
+			if (useCooked && LoadCooked(cookedPath, *model)) {
+				return;
+			}
+			if (source == ModelSource::Cooked) {
+				throw std::runtime_error("No usable cooked animation at " + cookedPath);
+			}
+		}
+
+		LoadAssimp(animationPath, *model);
+
+		// Cook it now so the next load skips Assimp
+		if (source == ModelSource::Auto && !Cook(cookedPath)) {
+			std::cerr << "Failed to cook animation: " << animationPath << std::endl;
+		}
+	}
+
+	std::string Animation::GetCookedPath(const std::string& animationPath)
+	{
+		return "assets/models/cooked/" + Model::GetCookedName(animationPath) + ".doganim";
+	}
+
+	void Animation::AddMissingBone(const std::string& name, Model& model)
+	{
+		auto& boneInfoMap = model.GetBoneInfoMap();
+		if (boneInfoMap.find(name) == boneInfoMap.end())
+		{
+			int& boneCount = model.GetBoneCount();
+			boneInfoMap[name].id = boneCount;
+			boneCount++;
+		}
+	}
+
+	void Animation::LoadAssimp(const std::string& animationPath, Model& model)
+	{
+		static Assimp::Importer importer;
+
+		// cut filepath until the last slash and remove extension
+		std::string filename = animationPath.substr(animationPath.find_last_of("/\\") + 1);
+		filename = filename.substr(0, filename.find_last_of("."));
+		std::string assbinFilename = "assets/models/cached/" + filename + ".assbin";
+
+		// check if the assbin file exists
+		bool doesAssbinExist = true;
+		{
+			std::ifstream assbinFileCheck(assbinFilename);
+			if (!assbinFileCheck.good()) doesAssbinExist = false;
+		}
+		if (!doesAssbinExist) {
+			throw std::runtime_error("Assbin file does not exist, load model before animation!!!!!!");
+		}
+
+		const aiScene* scene = importer.ReadFile(animationPath, 0);
+
+		assert(scene && scene->mRootNode);
+		if (scene->mNumAnimations == 0) {
+			throw std::runtime_error("File has no animations: " + animationPath);
+		}
+		auto animation = scene->mAnimations[0];
+		ReadHierarchyData(m_RootNode, scene->mRootNode);
+		ReadMissingBones(animation, model);
+
+		// CAREFUL, mTicksPerSecond MIGHT NOT BE SET (0), the clip falls back to the default rate
+		m_Skeleton = Skeleton(m_RootNode, m_BoneInfoMap);
+		m_Clip = CompressedClip(m_Bones, m_Skeleton, float(animation->mDuration), float(animation->mTicksPerSecond));
+	}
+
+	bool Animation::LoadCooked(const std::string& cookedPath, Model& model)
+	{
+		std::unique_ptr<MappedFile> file;
+		try {
+			file = std::make_unique<MappedFile>(cookedPath);
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+
+		const uint8_t* data = file->GetData();
+		const uint64_t size = file->GetSize();
+
+		CookedAnimationHeader header;
+		if (size < sizeof(header)) return false;
+		memcpy(&header, data, sizeof(header));
+
+		// Anything written by another version gets recooked
+		if (header.magic != COOKED_ANIMATION_MAGIC || header.version != COOKED_ANIMATION_VERSION) {
+			return false;
+		}
+
+		const uint64_t nodeTableOffset = sizeof(CookedAnimationHeader);
+		if (!MappedFile::InRange(nodeTableOffset, sizeof(CookedNode) * uint64_t(header.nodeCount), size) ||
+			!MappedFile::InRange(header.clipOffset, header.clipSize, size) ||
+			!MappedFile::InRange(header.blobOffset, header.blobSize, size)) {
+			return false;
+		}
+
+		const uint8_t* blob = data + header.blobOffset;
+		std::vector<std::string> names(header.nodeCount);
+		std::vector<int> parents(header.nodeCount);
+		std::vector<glm::mat4> bindTransforms(header.nodeCount);
+		for (uint32_t i = 0; i < header.nodeCount; ++i) {
+			CookedNode node;
+			memcpy(&node, data + nodeTableOffset + sizeof(CookedNode) * i, sizeof(node));
+			if (!MappedFile::InRange(node.name.offset, node.name.size, header.blobSize) || node.parent >= int32_t(i)) return false;
+
+			names[i] = std::string(reinterpret_cast<const char*>(blob + node.name.offset), node.name.size);
+			parents[i] = node.parent;
+			bindTransforms[i] = node.bindTransform;
+		}
+
+		CompressedClip clip;
+		if (!clip.Deserialize(data + header.clipOffset, header.clipSize, header.nodeCount)) return false;
+
+		std::cout << "Loading cooked animation: " << cookedPath << std::endl;
+
+		// Registered in node order, which can give other ids than the source file's channel order. Ids
+		// past the model's own bones only index this clip's palette, so that's harmless
+		const std::vector<int>& nodeTracks = clip.GetNodeTracks();
+		for (uint32_t i = 0; i < header.nodeCount; ++i) {
+			if (nodeTracks[i] >= 0) AddMissingBone(names[i], model);
+		}
+		m_BoneInfoMap = model.GetBoneInfoMap();
+
+		m_Skeleton = Skeleton(names, parents, bindTransforms, m_BoneInfoMap);
+		m_Clip = std::move(clip);
+		m_LoadedFromCooked = true;
+		return true;
+	}
+
+	bool Animation::Cook(const std::string& outputPath) const
+	{
+		const std::vector<std::string>& names = m_Skeleton.GetNodeNames();
+		const std::vector<int>& parents = m_Skeleton.GetParents();
+		const std::vector<glm::mat4>& bindTransforms = m_Skeleton.GetBindTransforms();
+
+		std::vector<uint8_t> blob;
+		std::vector<CookedNode> nodes(names.size());
+		for (size_t i = 0; i < names.size(); ++i) {
+			nodes[i].name = { blob.size(), names[i].size() };
+			blob.insert(blob.end(), names[i].begin(), names[i].end());
+			nodes[i].parent = parents[i];
+			nodes[i].bindTransform = bindTransforms[i];
+		}
+
+		std::vector<uint8_t> clip = m_Clip.Serialize();
+
+		auto align16 = [](uint64_t offset) { return (offset + 15) & ~uint64_t(15); };
+
+		CookedAnimationHeader header;
+		header.nodeCount = uint32_t(nodes.size());
+		header.clipOffset = align16(sizeof(CookedAnimationHeader) + sizeof(CookedNode) * nodes.size());
+		header.clipSize = clip.size();
+		header.blobOffset = align16(header.clipOffset + header.clipSize);
+		header.blobSize = blob.size();
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), error);
+
+		// Written next to the target and renamed over it, so a loader never maps half a file
+		std::string tempPath = outputPath + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) return false;
+
+			auto padTo = [&out](uint64_t offset) {
+				static const char zeros[16]{};
+				uint64_t position = static_cast<uint64_t>(out.tellp());
+				if (offset > position) out.write(zeros, static_cast<std::streamsize>(offset - position));
+			};
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(nodes.data()), sizeof(CookedNode) * nodes.size());
+
+			padTo(header.clipOffset);
+			out.write(reinterpret_cast<const char*>(clip.data()), clip.size());
+
+			padTo(header.blobOffset);
+			out.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+			if (!out.good()) return false;
+		}
+
+		std::filesystem::rename(tempPath, outputPath, error);
+		return !error;
+	}
+
+} // namespace Dog
@@ -2,6 +2,7 @@
 
 #include "../Models/Model.h"
 #include "Bone.h"
+#include "CompressedClip.h"
 
 namespace Dog {
 
@@ -18,36 +19,16 @@ namespace Dog {
 	public:
 		Animation() = default;
 
-		Animation(const std::string& animationPath, Model* model)
-		{
-			static Assimp::Importer importer;
-
-			// cut filepath until the last slash and remove extension
-			std::string filename = animationPath.substr(animationPath.find_last_of("/\\") + 1);
-			filename = filename.substr(0, filename.find_last_of("."));
-			std::string assbinFilename = "assets/models/cached/" + filename + ".assbin";
-
-			// check if the assbin file exists
-			bool doesAssbinExist = true;
-			{
-				std::ifstream assbinFileCheck(assbinFilename);
-				if (!assbinFileCheck.good()) doesAssbinExist = false;
-			}
-			if (!doesAssbinExist) {
-				throw std::runtime_error("Assbin file does not exist, load model before animation!!!!!!");
-			}
-
-			const aiScene* scene = importer.ReadFile(animationPath, 0);
-
-			assert(scene && scene->mRootNode);
-			auto animation = scene->mAnimations[0];
-			m_Duration = float(animation->mDuration);
-			m_TicksPerSecond = int(animation->mTicksPerSecond); // CAREFUL, MIGHT NOT BE SET (0)
-			aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
-			globalTransformation = globalTransformation.Inverse();
-			ReadHierarchyData(m_RootNode, scene->mRootNode);
-			ReadMissingBones(animation, *model);
-		}
+		/*********************************************************************
+		 * param:  animationPath: The file the clip is read from
+		 * param:  model: The model it animates, bones missing from the model are added to it
+		 * param:  source: Where the clip is read from, as with models
+		 *
+		 * brief:  Reads the file's first clip and compresses it. Unless told
+		 *         otherwise the cooked clip is used when it's up to date,
+		 *         otherwise the file is imported with Assimp and cooked.
+		 *********************************************************************/
+		Animation(const std::string& animationPath, Model* model, ModelSource source = ModelSource::Auto);
 
 		~Animation()
 		{
@@ -66,21 +47,40 @@ namespace Dog {
 		}
 
 
-		inline float GetTicksPerSecond() { return float(m_TicksPerSecond); }
-		inline float GetDuration() { return m_Duration; }
+		inline float GetTicksPerSecond() { return m_Clip.GetTicksPerSecond(); }
+		inline float GetDuration() { return m_Clip.GetDuration(); }
 		inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
 		inline const std::map<std::string, BoneInfo>& GetBoneIDMap()
 		{
 			return m_BoneInfoMap;
 		}
 
+		// Flattened runtime data the Animator samples, built once the bones are read
+		inline const Skeleton& GetSkeleton() const { return m_Skeleton; }
+		inline const CompressedClip& GetClip() const { return m_Clip; }
+
+		// The uncompressed keys and node tree, only read from the source file. Cooked clips have neither
+		inline const std::vector<Bone>& GetBones() const { return m_Bones; }
+		inline bool IsCooked() const { return m_LoadedFromCooked; }
+
+		// Writes the skeleton and compressed clip as a cooked animation (see CookedAnimation.h)
+		bool Cook(const std::string& outputPath) const;
+
+		// assets/models/cooked/<name>.doganim, named like cooked models (see Model::GetCookedName)
+		static std::string GetCookedPath(const std::string& animationPath);
+
 	private:
+		void LoadAssimp(const std::string& animationPath, Model& model);
+		bool LoadCooked(const std::string& cookedPath, Model& model);
+
+		// Bones the clip animates that don't skin the model get ids after the model's own
+		static void AddMissingBone(const std::string& name, Model& model);
+
 		void ReadMissingBones(const aiAnimation* animation, Model& model)
 		{
 			int size = animation->mNumChannels;
 
 			auto& boneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
-			int& boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
 
 			//reading channels(bones engaged in an animation and their keyframes)
 			for (int i = 0; i < size; i++)
@@ -88,11 +88,7 @@ namespace Dog {
 				auto channel = animation->mChannels[i];
 				std::string boneName = channel->mNodeName.data;
 
-				if (boneInfoMap.find(boneName) == boneInfoMap.end())
-				{
-					boneInfoMap[boneName].id = boneCount;
-					boneCount++;
-				}
+				AddMissingBone(boneName, model);
 				m_Bones.push_back(Bone(channel->mNodeName.data,
 					boneInfoMap[channel->mNodeName.data].id, channel));
 			}
@@ -118,11 +114,12 @@ namespace Dog {
 				dest.children.push_back(newData);
 			}
 		}
-		float m_Duration;
-		int m_TicksPerSecond;
 		std::vector<Bone> m_Bones;
 		AssimpNodeData m_RootNode;
 		std::map<std::string, BoneInfo> m_BoneInfoMap;
+		Skeleton m_Skeleton;
+		CompressedClip m_Clip;
+		bool m_LoadedFromCooked = false;
 	};
 
 } // namespace Dog
\ No newline at end of file
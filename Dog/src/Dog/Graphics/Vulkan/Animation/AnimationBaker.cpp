@@ -0,0 +1,35 @@
+#include <PCH/pch.h>
+#include "AnimationBaker.h"
+#include "Animation.h"
+
+namespace Dog {
+
+	BakedClip BakeAnimation(const Animation& animation, float framesPerSecond)
+	{
+		const Skeleton& skeleton = animation.GetSkeleton();
+		const CompressedClip& clip = animation.GetClip();
+
+		BakedClip baked;
+		float durationSeconds = clip.GetDuration() / clip.GetTicksPerSecond();
+		if (durationSeconds <= 0.f || framesPerSecond <= 0.f || skeleton.GetBoneCount() == 0) {
+			return baked;
+		}
+
+		baked.boneCount = skeleton.GetBoneCount();
+		baked.frameCount = std::max(1u, static_cast<uint32_t>(std::ceil(durationSeconds * framesPerSecond)));
+		baked.framesPerSecond = framesPerSecond;
+		baked.palettes.reserve(static_cast<size_t>(baked.frameCount) * baked.boneCount);
+
+		// Frames are sampled in order, so the pose's key cursors only ever step forward
+		AnimationPose pose;
+		clip.InitPose(skeleton, pose);
+		for (uint32_t frame = 0; frame < baked.frameCount; ++frame) {
+			float time = std::min(frame / framesPerSecond * clip.GetTicksPerSecond(), clip.GetDuration());
+			clip.Sample(skeleton, time, pose);
+			baked.palettes.insert(baked.palettes.end(), pose.palette.begin(), pose.palette.end());
+		}
+
+		return baked;
+	}
+
+} // namespace Dog
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace Dog {
+
+	class Animation;
+
+	/*
+	 * A clip sampled ahead of time into one bone palette per frame, for the GPU to play back
+	 * without any CPU work per instance.
+	 */
+	struct BakedClip
+	{
+		uint32_t boneCount = 0;
+		uint32_t frameCount = 0;
+		float framesPerSecond = 0.f;     // Frames per second of clip time
+		std::vector<glm::mat4> palettes; // frameCount palettes of boneCount matrices, frame after frame
+	};
+
+	/*********************************************************************
+	 * param:  animation: The clip to bake
+	 * param:  framesPerSecond: Sample rate, playback blends between frames
+	 * return: The baked palettes, empty if the clip has no duration
+	 *
+	 * brief:  Samples the clip with the same flattened skeleton and key
+	 *         sampling the Animator uses. The last frame is the one before
+	 *         the clip loops, playback blends from it back to the first.
+	 *********************************************************************/
+	BakedClip BakeAnimation(const Animation& animation, float framesPerSecond = 30.f);
+
+} // namespace Dog
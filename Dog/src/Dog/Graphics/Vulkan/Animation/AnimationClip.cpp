@@ -0,0 +1,137 @@
+#include <PCH/pch.h>
+#include "AnimationClip.h"
+#include "Bone.h"
+
+namespace Dog {
+
+	AnimationClip::AnimationClip(const std::vector<Bone>& bones, const Skeleton& skeleton, float duration, float ticksPerSecond)
+		: m_Duration(duration)
+		, m_TicksPerSecond(ticksPerSecond > 0.f ? ticksPerSecond : DEFAULT_TICKS_PER_SECOND)
+	{
+		const std::vector<std::string>& nodeNames = skeleton.GetNodeNames();
+		m_NodeTracks.assign(nodeNames.size(), -1);
+
+		for (const Bone& bone : bones) {
+			std::string name = bone.GetBoneName();
+
+			// Every node with the bone's name plays its track, as with Animation::FindBone
+			bool used = false;
+			int track = int(m_PositionTracks.size());
+			for (size_t node = 0; node < nodeNames.size(); ++node) {
+				if (nodeNames[node] == name && m_NodeTracks[node] < 0) {
+					m_NodeTracks[node] = track;
+					used = true;
+				}
+			}
+			if (!used) continue;
+
+			const std::vector<KeyPosition>& positions = bone.GetPositionKeys();
+			m_PositionTracks.push_back({ uint32_t(m_PositionTimes.size()), uint32_t(positions.size()) });
+			for (const KeyPosition& key : positions) {
+				m_PositionTimes.push_back(key.timeStamp);
+				m_PositionValues.push_back(key.position);
+			}
+
+			const std::vector<KeyRotation>& rotations = bone.GetRotationKeys();
+			m_RotationTracks.push_back({ uint32_t(m_RotationTimes.size()), uint32_t(rotations.size()) });
+			for (const KeyRotation& key : rotations) {
+				m_RotationTimes.push_back(key.timeStamp);
+				m_RotationValues.push_back(key.orientation);
+			}
+
+			const std::vector<KeyScale>& scales = bone.GetScaleKeys();
+			m_ScaleTracks.push_back({ uint32_t(m_ScaleTimes.size()), uint32_t(scales.size()) });
+			for (const KeyScale& key : scales) {
+				m_ScaleTimes.push_back(key.timeStamp);
+				m_ScaleValues.push_back(key.scale);
+			}
+		}
+	}
+
+	size_t AnimationClip::GetMemorySize() const
+	{
+		return m_PositionTimes.size() * sizeof(float) + m_PositionValues.size() * sizeof(glm::vec3) +
+			m_RotationTimes.size() * sizeof(float) + m_RotationValues.size() * sizeof(glm::quat) +
+			m_ScaleTimes.size() * sizeof(float) + m_ScaleValues.size() * sizeof(glm::vec3) +
+			(m_PositionTracks.size() + m_RotationTracks.size() + m_ScaleTracks.size()) * sizeof(KeyRange) +
+			m_NodeTracks.size() * sizeof(int);
+	}
+
+	void AnimationClip::InitPose(const Skeleton& skeleton, AnimationPose& pose) const
+	{
+		pose.globals.assign(skeleton.GetNodeCount(), glm::mat4(1.0f));
+		pose.palette.assign(skeleton.GetBoneCount(), glm::mat4(1.0f));
+		pose.cursors.assign(GetTrackCount(), KeyCursor{});
+	}
+
+	void AnimationClip::Sample(const Skeleton& skeleton, float time, AnimationPose& pose) const
+	{
+		assert(pose.globals.size() == skeleton.GetNodeCount() && pose.cursors.size() == GetTrackCount() && "Pose wasn't initialized for this clip");
+
+		const uint32_t nodeCount = skeleton.GetNodeCount();
+		const int* parents = skeleton.GetParents().data();
+		const int* nodeBones = skeleton.GetNodeBones().data();
+		const glm::mat4* bindTransforms = skeleton.GetBindTransforms().data();
+		const glm::mat4* boneOffsets = skeleton.GetBoneOffsets().data();
+		glm::mat4* globals = pose.globals.data();
+		glm::mat4* palette = pose.palette.data();
+
+		for (uint32_t node = 0; node < nodeCount; ++node) {
+			glm::mat4 local;
+			int track = m_NodeTracks[node];
+			if (track >= 0) {
+				KeyCursor& cursor = pose.cursors[track];
+				local = ComposeTransform(
+					SamplePosition(track, time, cursor.position),
+					SampleRotation(track, time, cursor.rotation),
+					SampleScale(track, time, cursor.scale));
+			}
+			else {
+				local = bindTransforms[node];
+			}
+
+			// Parents come first, so theirs is already this frame's
+			int parent = parents[node];
+			globals[node] = parent < 0 ? local : globals[parent] * local;
+
+			int bone = nodeBones[node];
+			if (bone >= 0) {
+				palette[bone] = globals[node] * boneOffsets[node];
+			}
+		}
+	}
+
+	glm::vec3 AnimationClip::SamplePosition(uint32_t track, float time, uint32_t& cursor) const
+	{
+		KeyRange range = m_PositionTracks[track];
+		const float* times = m_PositionTimes.data() + range.first;
+		const glm::vec3* values = m_PositionValues.data() + range.first;
+		if (range.count == 1) return values[0];
+
+		uint32_t k = Seek(times, range.count, time, cursor);
+		return glm::mix(values[k], values[k + 1], Factor(times[k], times[k + 1], time));
+	}
+
+	glm::quat AnimationClip::SampleRotation(uint32_t track, float time, uint32_t& cursor) const
+	{
+		KeyRange range = m_RotationTracks[track];
+		const float* times = m_RotationTimes.data() + range.first;
+		const glm::quat* values = m_RotationValues.data() + range.first;
+		if (range.count == 1) return glm::normalize(values[0]);
+
+		uint32_t k = Seek(times, range.count, time, cursor);
+		return glm::normalize(glm::slerp(values[k], values[k + 1], Factor(times[k], times[k + 1], time)));
+	}
+
+	glm::vec3 AnimationClip::SampleScale(uint32_t track, float time, uint32_t& cursor) const
+	{
+		KeyRange range = m_ScaleTracks[track];
+		const float* times = m_ScaleTimes.data() + range.first;
+		const glm::vec3* values = m_ScaleValues.data() + range.first;
+		if (range.count == 1) return values[0];
+
+		uint32_t k = Seek(times, range.count, time, cursor);
+		return glm::mix(values[k], values[k + 1], Factor(times[k], times[k + 1], time));
+	}
+
+} // namespace Dog
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Skeleton.h"
+
+namespace Dog {
+
+	class Bone;
+
+	// Last key used by each channel of a track, sampling resumes from it
+	struct KeyCursor
+	{
+		uint32_t position = 0;
+		uint32_t rotation = 0;
+		uint32_t scale = 0;
+	};
+
+	// translate * rotate * scale, without the matrix products
+	inline glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		glm::mat4 transform = glm::toMat4(rotation);
+		transform[0] *= scale.x;
+		transform[1] *= scale.y;
+		transform[2] *= scale.z;
+		transform[3] = glm::vec4(position, 1.f);
+		return transform;
+	}
+
+	// Index of the key starting the segment that contains time. Needs at least two keys. Key times
+	// may be stored in any type that converts to float, like the quantized ticks of a CompressedClip
+	template <typename KeyTime>
+	inline uint32_t Seek(const KeyTime* times, uint32_t count, float time, uint32_t& cursor)
+	{
+		uint32_t last = count - 2;
+		if (cursor > last || time < float(times[cursor])) {
+			uint32_t next = uint32_t(std::upper_bound(times, times + count, time, [](float t, KeyTime key) { return t < float(key); }) - times);
+			cursor = next > 0 ? std::min(next - 1, last) : 0;
+		}
+
+		while (cursor < last && time >= float(times[cursor + 1])) {
+			++cursor;
+		}
+		return cursor;
+	}
+
+	// Times outside the keys hold the first or last key instead of extrapolating
+	inline float Factor(float t0, float t1, float time)
+	{
+		float length = t1 - t0;
+		return length > 0.f ? glm::clamp((time - t0) / length, 0.f, 1.f) : 0.f;
+	}
+
+	/*
+	 * Sampling output for one animated instance. Sized once by AnimationClip::InitPose,
+	 * sampling only overwrites it.
+	 */
+	struct AnimationPose
+	{
+		std::vector<glm::mat4> globals; // Model space transform of every node
+		std::vector<glm::mat4> palette; // Final bone matrices, by bone id
+		std::vector<KeyCursor> cursors; // By track
+	};
+
+	/*
+	 * One clip's keyframes as structure of arrays. Each channel's keys for every track are packed
+	 * into one times array and one values array, and a track is a range of each.
+	 */
+	class AnimationClip
+	{
+	public:
+		AnimationClip() = default;
+
+		// Tracks whose bone has no node in the skeleton are dropped, nothing would read them
+		AnimationClip(const std::vector<Bone>& bones, const Skeleton& skeleton, float duration, float ticksPerSecond);
+
+		// Sizes the pose for the skeleton and this clip, with every bone at identity
+		void InitPose(const Skeleton& skeleton, AnimationPose& pose) const;
+
+		// Samples the clip at a time in ticks into the pose. Cursors make moving forward through
+		// the clip O(1) per channel, going backwards (looping) binary searches once
+		void Sample(const Skeleton& skeleton, float time, AnimationPose& pose) const;
+
+		// Files that don't set a rate play at Assimp's default of 25 ticks per second
+		static constexpr float DEFAULT_TICKS_PER_SECOND = 25.f;
+
+		inline float GetDuration() const { return m_Duration; }
+		inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+		inline uint32_t GetTrackCount() const { return uint32_t(m_PositionTracks.size()); }
+
+		// Keys across every channel of every track
+		inline uint32_t GetKeyCount() const { return uint32_t(m_PositionTimes.size() + m_RotationTimes.size() + m_ScaleTimes.size()); }
+
+		// Bytes held by the clip's keys and tables
+		size_t GetMemorySize() const;
+
+	private:
+		struct KeyRange
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		glm::vec3 SamplePosition(uint32_t track, float time, uint32_t& cursor) const;
+		glm::quat SampleRotation(uint32_t track, float time, uint32_t& cursor) const;
+		glm::vec3 SampleScale(uint32_t track, float time, uint32_t& cursor) const;
+
+		std::vector<float> m_PositionTimes;
+		std::vector<glm::vec3> m_PositionValues;
+		std::vector<float> m_RotationTimes;
+		std::vector<glm::quat> m_RotationValues;
+		std::vector<float> m_ScaleTimes;
+		std::vector<glm::vec3> m_ScaleValues;
+
+		// By track
+		std::vector<KeyRange> m_PositionTracks;
+		std::vector<KeyRange> m_RotationTracks;
+		std::vector<KeyRange> m_ScaleTracks;
+
+		std::vector<int> m_NodeTracks; // Track animating each skeleton node, -1 for none
+		float m_Duration = 0.f;
+		float m_TicksPerSecond = 0.f;
+	};
+
+} // namespace Dog
@@ -0,0 +1,42 @@
+#include <PCH/pch.h>
+#include "AnimationLibrary.h"
+#include "Animation.h"
+
+namespace Dog {
+
+	AnimationLibrary::AnimationLibrary()
+	{
+	}
+
+	AnimationLibrary::~AnimationLibrary()
+	{
+	}
+
+	uint32_t AnimationLibrary::AddAnimation(const std::string& animationPath, uint32_t modelIndex, Model& model)
+	{
+		auto it = m_AnimationMap.find({ animationPath, modelIndex });
+		if (it != m_AnimationMap.end()) {
+			return it->second;
+		}
+
+		std::unique_ptr<Animation> animation;
+		try {
+			animation = std::make_unique<Animation>(animationPath, &model);
+		}
+		catch (const std::exception& e) {
+			DOG_ERROR("Failed to load animation {0}: {1}", animationPath, e.what());
+		}
+
+		uint32_t animationIndex = static_cast<uint32_t>(m_Animations.size());
+		m_Animations.push_back(std::move(animation));
+		m_AnimationMap[{ animationPath, modelIndex }] = animationIndex;
+
+		return animationIndex;
+	}
+
+	Animation* AnimationLibrary::GetAnimationByIndex(uint32_t index)
+	{
+		return index < m_Animations.size() ? m_Animations[index].get() : nullptr;
+	}
+
+} // namespace Dog
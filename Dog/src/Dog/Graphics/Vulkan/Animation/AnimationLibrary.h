@@ -0,0 +1,45 @@
+#pragma once
+
+namespace Dog {
+
+	class Animation;
+	class Model;
+
+	class AnimationLibrary
+	{
+	public:
+		AnimationLibrary();
+		~AnimationLibrary();
+
+		/*********************************************************************
+		 * param:  animationPath: path to the file holding the clip
+		 * param:  modelIndex: index of the model in the model library
+		 * param:  model: the model the clip animates, must be loaded
+		 * return: index of the animation in the library
+		 *
+		 * brief:  Loads the file's first clip for the model if it isn't
+		 *         already loaded. The clip's bone ids come from the model,
+		 *         so every animator playing the file on the same model
+		 *         shares it, and other models get their own. A clip that
+		 *         fails to load keeps its index, with no animation, so it
+		 *         isn't retried every frame.
+		 *********************************************************************/
+		uint32_t AddAnimation(const std::string& animationPath, uint32_t modelIndex, Model& model);
+
+		/*********************************************************************
+		 * param:  index: The animation index
+		 * return: The animation at the index, null if it failed to load
+		 *********************************************************************/
+		Animation* GetAnimationByIndex(uint32_t index);
+
+		/*********************************************************************
+		 * return: The number of animations in the library
+		 *********************************************************************/
+		uint32_t GetAnimationCount() const { return static_cast<uint32_t>(m_Animations.size()); }
+
+	private:
+		std::vector<std::unique_ptr<Animation>> m_Animations;
+		std::map<std::pair<std::string, uint32_t>, uint32_t> m_AnimationMap; // (path, model index)
+	};
+
+} // namespace Dog
@@ -9,13 +9,7 @@ namespace Dog {
 	public:
 		Animator(Animation* animation)
 		{
-			m_CurrentTime = 0.0;
-			m_CurrentAnimation = animation;
-
-			m_FinalBoneMatrices.reserve(100);
-
-			for (int i = 0; i < 100; i++)
-				m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+			PlayAnimation(animation);
 		}
 
 		void UpdateAnimation(float dt)
@@ -23,48 +17,27 @@ namespace Dog {
 			m_DeltaTime = dt;
 			if (m_CurrentAnimation)
 			{
-				m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-				m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-				CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+				const CompressedClip& clip = m_CurrentAnimation->GetClip();
+				m_CurrentTime += clip.GetTicksPerSecond() * dt;
+				m_CurrentTime = fmod(m_CurrentTime, clip.GetDuration());
+				clip.Sample(m_CurrentAnimation->GetSkeleton(), m_CurrentTime, m_Pose);
 			}
 		}
 
+		// Sizes the pose for the animation's skeleton, nothing is allocated while it plays
 		void PlayAnimation(Animation* pAnimation)
 		{
 			m_CurrentAnimation = pAnimation;
 			m_CurrentTime = 0.0f;
-		}
-
-		void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
-		{
-			std::string nodeName = node->name;
-			glm::mat4 nodeTransform = node->transformation;
-
-			Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
-
-			if (Bone)
-			{
-				Bone->Update(m_CurrentTime);
-				nodeTransform = Bone->GetLocalTransform();
-			}
 
-			glm::mat4 globalTransformation = parentTransform * nodeTransform;
-
-			auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-			if (boneInfoMap.find(nodeName) != boneInfoMap.end())
-			{
-				int index = boneInfoMap[nodeName].id;
-				glm::mat4 offset = boneInfoMap[nodeName].offset;
-				m_FinalBoneMatrices[index] = globalTransformation * offset;
-			}
-
-			for (int i = 0; i < node->childrenCount; i++)
-				CalculateBoneTransform(&node->children[i], globalTransformation);
+			if (m_CurrentAnimation)
+				m_CurrentAnimation->GetClip().InitPose(m_CurrentAnimation->GetSkeleton(), m_Pose);
 		}
 
-		std::vector<glm::mat4> GetFinalBoneMatrices()
+		// One matrix per bone id of the animation's model
+		const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 		{
-			return m_FinalBoneMatrices;
+			return m_Pose.palette;
 		}
 
 		// getters
@@ -72,8 +45,8 @@ namespace Dog {
 		float GetCurrentTime() { return m_CurrentTime; }
 
 	private:
-		std::vector<glm::mat4> m_FinalBoneMatrices;
-		Animation* m_CurrentAnimation;
+		AnimationPose m_Pose;
+		Animation* m_CurrentAnimation = nullptr;
 		float m_CurrentTime = 0;
 		float m_DeltaTime = 0;
 
@@ -75,6 +75,10 @@ namespace Dog {
 		std::string GetBoneName() const { return m_Name; }
 		int GetBoneID() { return m_ID; }
 
+		const std::vector<KeyPosition>& GetPositionKeys() const { return m_Positions; }
+		const std::vector<KeyRotation>& GetRotationKeys() const { return m_Rotations; }
+		const std::vector<KeyScale>& GetScaleKeys() const { return m_Scales; }
+
 
 
 		int GetPositionIndex(float animationTime)
@@ -0,0 +1,372 @@
+#include <PCH/pch.h>
+#include "CompressedClip.h"
+#include "CookedAnimation.h"
+#include "Bone.h"
+
+namespace Dog {
+
+	namespace {
+		constexpr float QUANTIZED_MAX = 65535.f;
+		constexpr float SMALLEST_THREE_MAX = 32767.f;
+		constexpr float SMALLEST_THREE_RANGE = 0.70710678f; // The three smallest components of a unit quaternion are within +-1/sqrt(2)
+
+		glm::vec3 DecodeVector(const uint16_t* value, const QuantizedChannel& channel)
+		{
+			return glm::vec3(channel.offset) + glm::vec3(value[0], value[1], value[2]) * glm::vec3(channel.scale);
+		}
+
+		// The largest component is dropped and rebuilt from the other three, its index is in the top bits of the first two words
+		void EncodeRotation(glm::quat rotation, uint16_t* out)
+		{
+			rotation = glm::normalize(rotation);
+			float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+			int largest = 0;
+			for (int i = 1; i < 4; ++i) {
+				if (std::abs(components[i]) > std::abs(components[largest])) largest = i;
+			}
+
+			// q and -q are the same rotation, so the dropped component is always positive
+			float sign = components[largest] < 0.f ? -1.f : 1.f;
+			int word = 0;
+			for (int i = 0; i < 4; ++i) {
+				if (i == largest) continue;
+				float normalized = glm::clamp(components[i] * sign / SMALLEST_THREE_RANGE, -1.f, 1.f) * 0.5f + 0.5f;
+				out[word++] = uint16_t(std::lround(normalized * SMALLEST_THREE_MAX));
+			}
+			out[0] |= uint16_t((largest & 1) << 15);
+			out[1] |= uint16_t((largest >> 1) << 15);
+		}
+
+		glm::quat DecodeRotation(const uint16_t* value)
+		{
+			int largest = (value[0] >> 15) | ((value[1] >> 15) << 1);
+
+			float components[4];
+			float sum = 0.f;
+			int word = 0;
+			for (int i = 0; i < 4; ++i) {
+				if (i == largest) continue;
+				float component = ((value[word++] & 0x7FFF) / SMALLEST_THREE_MAX * 2.f - 1.f) * SMALLEST_THREE_RANGE;
+				components[i] = component;
+				sum += component * component;
+			}
+			components[largest] = std::sqrt(std::max(0.f, 1.f - sum));
+
+			return glm::quat(components[3], components[0], components[1], components[2]);
+		}
+
+		float RotationDistance(const glm::quat& a, const glm::quat& b)
+		{
+			return 2.f * std::acos(glm::clamp(std::abs(glm::dot(glm::normalize(a), glm::normalize(b))), 0.f, 1.f));
+		}
+
+		// Keys kept so every removed key is within tolerance of what the kept ones interpolate to. A channel whose
+		// keys all hold one value keeps only its first
+		template<typename Value, typename Interpolate, typename Distance>
+		std::vector<uint32_t> ReduceKeys(const std::vector<float>& times, const std::vector<Value>& values, float tolerance, Interpolate interpolate, Distance distance)
+		{
+			uint32_t count = uint32_t(values.size());
+			std::vector<uint32_t> kept{ 0 };
+			if (count < 2) return kept;
+
+			uint32_t anchor = 0;
+			for (uint32_t end = 2; end < count; ++end) {
+				for (uint32_t k = anchor + 1; k < end; ++k) {
+					float factor = Factor(times[anchor], times[end], times[k]);
+					if (distance(interpolate(values[anchor], values[end], factor), values[k]) > tolerance) {
+						kept.push_back(end - 1);
+						anchor = end - 1;
+						break;
+					}
+				}
+			}
+
+			if (kept.size() > 1 || distance(values[0], values[count - 1]) > tolerance) {
+				kept.push_back(count - 1);
+			}
+			return kept;
+		}
+
+		uint16_t QuantizeTime(float time, float timeToKey)
+		{
+			return uint16_t(std::lround(glm::clamp(time * timeToKey, 0.f, QUANTIZED_MAX)));
+		}
+
+		// Appends the kept keys of a vector channel, quantized within their own range
+		QuantizedChannel AddVectorChannel(const std::vector<float>& times, const std::vector<glm::vec3>& values, const std::vector<uint32_t>& kept,
+			float timeToKey, std::vector<uint16_t>& keyTimes, std::vector<uint16_t>& keyValues)
+		{
+			QuantizedChannel channel;
+			channel.firstKey = uint32_t(keyTimes.size());
+			channel.keyCount = uint32_t(kept.size());
+
+			glm::vec3 minimum = values[kept[0]];
+			glm::vec3 maximum = minimum;
+			for (uint32_t k : kept) {
+				minimum = glm::min(minimum, values[k]);
+				maximum = glm::max(maximum, values[k]);
+			}
+
+			glm::vec3 scale = (maximum - minimum) / QUANTIZED_MAX;
+			channel.offset = glm::vec4(minimum, 0.f);
+			channel.scale = glm::vec4(scale, 0.f);
+
+			for (uint32_t k : kept) {
+				keyTimes.push_back(QuantizeTime(times[k], timeToKey));
+				for (int axis = 0; axis < 3; ++axis) {
+					float quantized = scale[axis] > 0.f ? (values[k][axis] - minimum[axis]) / scale[axis] : 0.f;
+					keyValues.push_back(uint16_t(std::lround(glm::clamp(quantized, 0.f, QUANTIZED_MAX))));
+				}
+			}
+			return channel;
+		}
+
+		template<typename T>
+		size_t VectorBytes(const std::vector<T>& vector)
+		{
+			return vector.size() * sizeof(T);
+		}
+	}
+
+	CompressedClip::CompressedClip(const std::vector<Bone>& bones, const Skeleton& skeleton, float duration, float ticksPerSecond, const ClipCompressionSettings& settings)
+		: m_Duration(duration)
+		, m_TicksPerSecond(ticksPerSecond > 0.f ? ticksPerSecond : AnimationClip::DEFAULT_TICKS_PER_SECOND)
+		, m_TimeToKey(duration > 0.f ? QUANTIZED_MAX / duration : 0.f)
+	{
+		const std::vector<std::string>& nodeNames = skeleton.GetNodeNames();
+		m_NodeTracks.assign(nodeNames.size(), -1);
+
+		auto mixVectors = [](const glm::vec3& a, const glm::vec3& b, float factor) { return glm::mix(a, b, factor); };
+		auto vectorDistance = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+		auto mixRotations = [](const glm::quat& a, const glm::quat& b, float factor) { return glm::normalize(glm::slerp(a, b, factor)); };
+
+		std::vector<float> times;
+		std::vector<glm::vec3> vectors;
+		std::vector<glm::quat> rotations;
+
+		for (const Bone& bone : bones) {
+			std::string name = bone.GetBoneName();
+
+			// Every node with the bone's name plays its track, as with AnimationClip
+			bool used = false;
+			int track = int(m_Tracks.size());
+			for (size_t node = 0; node < nodeNames.size(); ++node) {
+				if (nodeNames[node] == name && m_NodeTracks[node] < 0) {
+					m_NodeTracks[node] = track;
+					used = true;
+				}
+			}
+			if (!used) continue;
+
+			CompressedTrack& compressed = m_Tracks.emplace_back();
+
+			times.clear();
+			vectors.clear();
+			for (const KeyPosition& key : bone.GetPositionKeys()) {
+				times.push_back(key.timeStamp);
+				vectors.push_back(key.position);
+			}
+			std::vector<uint32_t> kept = ReduceKeys(times, vectors, settings.positionTolerance, mixVectors, vectorDistance);
+			compressed.position = AddVectorChannel(times, vectors, kept, m_TimeToKey, m_PositionTimes, m_PositionValues);
+
+			times.clear();
+			rotations.clear();
+			for (const KeyRotation& key : bone.GetRotationKeys()) {
+				times.push_back(key.timeStamp);
+				rotations.push_back(key.orientation);
+			}
+			kept = ReduceKeys(times, rotations, settings.rotationTolerance, mixRotations, RotationDistance);
+			compressed.rotation.firstKey = uint32_t(m_RotationTimes.size());
+			compressed.rotation.keyCount = uint32_t(kept.size());
+			for (uint32_t k : kept) {
+				m_RotationTimes.push_back(QuantizeTime(times[k], m_TimeToKey));
+				size_t first = m_RotationValues.size();
+				m_RotationValues.resize(first + 3);
+				EncodeRotation(rotations[k], m_RotationValues.data() + first);
+			}
+
+			times.clear();
+			vectors.clear();
+			for (const KeyScale& key : bone.GetScaleKeys()) {
+				times.push_back(key.timeStamp);
+				vectors.push_back(key.scale);
+			}
+			kept = ReduceKeys(times, vectors, settings.scaleTolerance, mixVectors, vectorDistance);
+			compressed.scale = AddVectorChannel(times, vectors, kept, m_TimeToKey, m_ScaleTimes, m_ScaleValues);
+		}
+	}
+
+	uint32_t CompressedClip::GetKeyCount() const
+	{
+		return uint32_t(m_PositionTimes.size() + m_RotationTimes.size() + m_ScaleTimes.size());
+	}
+
+	size_t CompressedClip::GetMemorySize() const
+	{
+		return VectorBytes(m_Tracks) + VectorBytes(m_NodeTracks) +
+			VectorBytes(m_PositionTimes) + VectorBytes(m_PositionValues) +
+			VectorBytes(m_RotationTimes) + VectorBytes(m_RotationValues) +
+			VectorBytes(m_ScaleTimes) + VectorBytes(m_ScaleValues);
+	}
+
+	void CompressedClip::InitPose(const Skeleton& skeleton, AnimationPose& pose) const
+	{
+		pose.globals.assign(skeleton.GetNodeCount(), glm::mat4(1.0f));
+		pose.palette.assign(skeleton.GetBoneCount(), glm::mat4(1.0f));
+		pose.cursors.assign(GetTrackCount(), KeyCursor{});
+	}
+
+	void CompressedClip::Sample(const Skeleton& skeleton, float time, AnimationPose& pose) const
+	{
+		assert(pose.globals.size() == skeleton.GetNodeCount() && pose.cursors.size() == GetTrackCount() && "Pose wasn't initialized for this clip");
+
+		const uint32_t nodeCount = skeleton.GetNodeCount();
+		const int* parents = skeleton.GetParents().data();
+		const int* nodeBones = skeleton.GetNodeBones().data();
+		const glm::mat4* bindTransforms = skeleton.GetBindTransforms().data();
+		const glm::mat4* boneOffsets = skeleton.GetBoneOffsets().data();
+		glm::mat4* globals = pose.globals.data();
+		glm::mat4* palette = pose.palette.data();
+
+		// Key times are stored quantized, so the time is converted once instead of every key
+		float keyTime = time * m_TimeToKey;
+
+		for (uint32_t node = 0; node < nodeCount; ++node) {
+			glm::mat4 local;
+			int track = m_NodeTracks[node];
+			if (track >= 0) {
+				const CompressedTrack& compressed = m_Tracks[track];
+				KeyCursor& cursor = pose.cursors[track];
+				local = ComposeTransform(
+					SamplePosition(compressed.position, keyTime, cursor.position),
+					SampleRotation(compressed.rotation, keyTime, cursor.rotation),
+					SampleScale(compressed.scale, keyTime, cursor.scale));
+			}
+			else {
+				local = bindTransforms[node];
+			}
+
+			int parent = parents[node];
+			globals[node] = parent < 0 ? local : globals[parent] * local;
+
+			int bone = nodeBones[node];
+			if (bone >= 0) {
+				palette[bone] = globals[node] * boneOffsets[node];
+			}
+		}
+	}
+
+	glm::vec3 CompressedClip::SamplePosition(const QuantizedChannel& channel, float time, uint32_t& cursor) const
+	{
+		const uint16_t* times = m_PositionTimes.data() + channel.firstKey;
+		const uint16_t* values = m_PositionValues.data() + channel.firstKey * 3;
+		if (channel.keyCount == 1) return DecodeVector(values, channel);
+
+		uint32_t k = Seek(times, channel.keyCount, time, cursor);
+		return glm::mix(DecodeVector(values + k * 3, channel), DecodeVector(values + k * 3 + 3, channel), Factor(times[k], times[k + 1], time));
+	}
+
+	glm::quat CompressedClip::SampleRotation(const QuantizedChannel& channel, float time, uint32_t& cursor) const
+	{
+		const uint16_t* times = m_RotationTimes.data() + channel.firstKey;
+		const uint16_t* values = m_RotationValues.data() + channel.firstKey * 3;
+		if (channel.keyCount == 1) return DecodeRotation(values);
+
+		uint32_t k = Seek(times, channel.keyCount, time, cursor);
+		return glm::normalize(glm::slerp(DecodeRotation(values + k * 3), DecodeRotation(values + k * 3 + 3), Factor(times[k], times[k + 1], time)));
+	}
+
+	glm::vec3 CompressedClip::SampleScale(const QuantizedChannel& channel, float time, uint32_t& cursor) const
+	{
+		const uint16_t* times = m_ScaleTimes.data() + channel.firstKey;
+		const uint16_t* values = m_ScaleValues.data() + channel.firstKey * 3;
+		if (channel.keyCount == 1) return DecodeVector(values, channel);
+
+		uint32_t k = Seek(times, channel.keyCount, time, cursor);
+		return glm::mix(DecodeVector(values + k * 3, channel), DecodeVector(values + k * 3 + 3, channel), Factor(times[k], times[k + 1], time));
+	}
+
+	std::vector<uint8_t> CompressedClip::Serialize() const
+	{
+		static_assert(sizeof(int) == sizeof(int32_t), "Node tracks are cooked as int32_t");
+
+		CookedClipHeader header;
+		header.duration = m_Duration;
+		header.ticksPerSecond = m_TicksPerSecond;
+		header.trackCount = GetTrackCount();
+		header.nodeCount = uint32_t(m_NodeTracks.size());
+		header.positionKeyCount = uint32_t(m_PositionTimes.size());
+		header.rotationKeyCount = uint32_t(m_RotationTimes.size());
+		header.scaleKeyCount = uint32_t(m_ScaleTimes.size());
+
+		std::vector<uint8_t> data;
+		auto append = [&data](const void* bytes, size_t size) {
+			data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+		};
+
+		append(&header, sizeof(header));
+		append(m_NodeTracks.data(), VectorBytes(m_NodeTracks));
+		append(m_Tracks.data(), VectorBytes(m_Tracks));
+		append(m_PositionTimes.data(), VectorBytes(m_PositionTimes));
+		append(m_PositionValues.data(), VectorBytes(m_PositionValues));
+		append(m_RotationTimes.data(), VectorBytes(m_RotationTimes));
+		append(m_RotationValues.data(), VectorBytes(m_RotationValues));
+		append(m_ScaleTimes.data(), VectorBytes(m_ScaleTimes));
+		append(m_ScaleValues.data(), VectorBytes(m_ScaleValues));
+		return data;
+	}
+
+	bool CompressedClip::Deserialize(const uint8_t* data, uint64_t size, uint32_t nodeCount)
+	{
+		CookedClipHeader header;
+		if (size < sizeof(header)) return false;
+		memcpy(&header, data, sizeof(header));
+
+		uint64_t expected = sizeof(header) +
+			sizeof(int32_t) * uint64_t(header.nodeCount) +
+			sizeof(CompressedTrack) * uint64_t(header.trackCount) +
+			sizeof(uint16_t) * 4 * (uint64_t(header.positionKeyCount) + header.rotationKeyCount + header.scaleKeyCount);
+		if (header.nodeCount != nodeCount || expected != size || header.duration < 0.f || header.ticksPerSecond <= 0.f) {
+			return false;
+		}
+
+		uint64_t offset = sizeof(header);
+		auto read = [data, &offset](auto& vector, size_t count) {
+			vector.resize(count);
+			size_t bytes = VectorBytes(vector);
+			memcpy(vector.data(), data + offset, bytes);
+			offset += bytes;
+		};
+
+		read(m_NodeTracks, header.nodeCount);
+		read(m_Tracks, header.trackCount);
+		read(m_PositionTimes, header.positionKeyCount);
+		read(m_PositionValues, header.positionKeyCount * size_t(3));
+		read(m_RotationTimes, header.rotationKeyCount);
+		read(m_RotationValues, header.rotationKeyCount * size_t(3));
+		read(m_ScaleTimes, header.scaleKeyCount);
+		read(m_ScaleValues, header.scaleKeyCount * size_t(3));
+
+		// Sampling doesn't check ranges, so everything it indexes with is checked here
+		auto inRange = [](const QuantizedChannel& channel, uint32_t keyCount) {
+			return channel.keyCount > 0 && uint64_t(channel.firstKey) + channel.keyCount <= keyCount;
+		};
+		for (const CompressedTrack& track : m_Tracks) {
+			if (!inRange(track.position, header.positionKeyCount) ||
+				!inRange(track.rotation, header.rotationKeyCount) ||
+				!inRange(track.scale, header.scaleKeyCount)) {
+				return false;
+			}
+		}
+		for (int track : m_NodeTracks) {
+			if (track >= int(header.trackCount)) return false;
+		}
+
+		m_Duration = header.duration;
+		m_TicksPerSecond = header.ticksPerSecond;
+		m_TimeToKey = m_Duration > 0.f ? QUANTIZED_MAX / m_Duration : 0.f;
+		return true;
+	}
+
+} // namespace Dog
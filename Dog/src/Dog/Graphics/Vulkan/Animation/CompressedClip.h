@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AnimationClip.h"
+
+namespace Dog {
+
+	class Bone;
+
+	// How far a removed key may be from what its neighbours interpolate to, in the node's local space
+	struct ClipCompressionSettings
+	{
+		float positionTolerance = 0.001f; // Model units
+		float rotationTolerance = 0.001f; // Radians
+		float scaleTolerance = 0.001f;
+	};
+
+	// One channel of one track: its range of keys, and how the channel's 16 bit values decode
+	struct QuantizedChannel
+	{
+		uint32_t firstKey = 0;
+		uint32_t keyCount = 0;
+		glm::vec4 offset{ 0.f }; // value = offset + q * scale, w unused. Rotations don't use either
+		glm::vec4 scale{ 0.f };
+	};
+
+	struct CompressedTrack
+	{
+		QuantizedChannel position;
+		QuantizedChannel rotation;
+		QuantizedChannel scale;
+	};
+
+	/*
+	 * A clip with redundant keys removed and every key stored in 16 bits per component. Key times are
+	 * fractions of the duration, translations and scales are quantized within each track's range, and
+	 * rotations keep their three smallest components. Samples like AnimationClip, decoding as it goes.
+	 */
+	class CompressedClip
+	{
+	public:
+		CompressedClip() = default;
+
+		// Tracks whose bone has no node in the skeleton are dropped, like AnimationClip
+		CompressedClip(const std::vector<Bone>& bones, const Skeleton& skeleton, float duration, float ticksPerSecond, const ClipCompressionSettings& settings = {});
+
+		void InitPose(const Skeleton& skeleton, AnimationPose& pose) const;
+		void Sample(const Skeleton& skeleton, float time, AnimationPose& pose) const;
+
+		inline float GetDuration() const { return m_Duration; }
+		inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+		inline uint32_t GetTrackCount() const { return uint32_t(m_Tracks.size()); }
+		inline const std::vector<int>& GetNodeTracks() const { return m_NodeTracks; }
+
+		// Keys across every channel of every track
+		uint32_t GetKeyCount() const;
+
+		// Bytes held by the clip's keys and tables
+		size_t GetMemorySize() const;
+
+		// The clip as one block for a cooked animation file (see CookedAnimation.h), and back.
+		// Deserialize returns false for data that is out of range or not for a skeleton of nodeCount nodes
+		std::vector<uint8_t> Serialize() const;
+		bool Deserialize(const uint8_t* data, uint64_t size, uint32_t nodeCount);
+
+	private:
+		glm::vec3 SamplePosition(const QuantizedChannel& channel, float time, uint32_t& cursor) const;
+		glm::quat SampleRotation(const QuantizedChannel& channel, float time, uint32_t& cursor) const;
+		glm::vec3 SampleScale(const QuantizedChannel& channel, float time, uint32_t& cursor) const;
+
+		std::vector<CompressedTrack> m_Tracks;
+		std::vector<uint16_t> m_PositionTimes; // Fractions of the duration, 0 to 65535
+		std::vector<uint16_t> m_PositionValues; // 3 per key
+		std::vector<uint16_t> m_RotationTimes;
+		std::vector<uint16_t> m_RotationValues; // 3 per key, smallest three
+		std::vector<uint16_t> m_ScaleTimes;
+		std::vector<uint16_t> m_ScaleValues; // 3 per key
+
+		std::vector<int> m_NodeTracks; // Track animating each skeleton node, -1 for none
+		float m_Duration = 0.f;
+		float m_TicksPerSecond = 0.f;
+		float m_TimeToKey = 0.f; // Ticks to quantized key time
+	};
+
+} // namespace Dog
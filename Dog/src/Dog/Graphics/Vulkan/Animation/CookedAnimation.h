@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CompressedClip.h"
+#include "../Models/CookedModel.h"
+
+namespace Dog {
+
+	// Dog's own animation format, written by Animation::Cook and read through a memory mapping, so
+	// playing a clip never goes through Assimp once it's cooked. Holds the skeleton's node hierarchy
+	// and the file's first clip, compressed:
+	//
+	//   CookedAnimationHeader
+	//   CookedNode[nodeCount], parents first
+	//   the clip, as written by CompressedClip::Serialize              (clipOffset)
+	//     CookedClipHeader
+	//     int32_t nodeTracks[nodeCount]
+	//     CompressedTrack[trackCount]
+	//     uint16_t position times, position values, rotation times,
+	//     rotation values, scale times, scale values
+	//   blob: node names                                               (blobOffset)
+	//
+	// Offsets are from the start of the file, blob references are relative to blobOffset. Bone ids and
+	// offsets come from the model the clip is played on, like a clip read from the source file.
+	// Files from another version are rejected and recooked.
+
+	static constexpr uint32_t COOKED_ANIMATION_MAGIC = 0x4D4E4144; // "DANM"
+	static constexpr uint32_t COOKED_ANIMATION_VERSION = 1;
+
+	struct CookedAnimationHeader
+	{
+		uint32_t magic = COOKED_ANIMATION_MAGIC;
+		uint32_t version = COOKED_ANIMATION_VERSION;
+		uint32_t nodeCount = 0;
+		uint32_t padding = 0;
+		uint64_t clipOffset = 0;
+		uint64_t clipSize = 0;
+		uint64_t blobOffset = 0;
+		uint64_t blobSize = 0;
+	};
+
+	struct CookedNode
+	{
+		CookedBlobRef name;
+		int32_t parent = -1;
+		int32_t padding[3]{};
+		glm::mat4 bindTransform{ 1.f };
+	};
+
+	struct CookedClipHeader
+	{
+		float duration = 0.f;
+		float ticksPerSecond = 0.f;
+		uint32_t trackCount = 0;
+		uint32_t nodeCount = 0;
+		uint32_t positionKeyCount = 0;
+		uint32_t rotationKeyCount = 0;
+		uint32_t scaleKeyCount = 0;
+		uint32_t padding = 0;
+	};
+
+	static_assert(std::is_trivially_copyable_v<CookedAnimationHeader> && std::is_trivially_copyable_v<CookedNode> &&
+		std::is_trivially_copyable_v<CookedClipHeader> && std::is_trivially_copyable_v<CompressedTrack>,
+		"Cooked animation structs are written and read as raw bytes");
+
+} // namespace Dog
@@ -0,0 +1,65 @@
+#include <PCH/pch.h>
+#include "Skeleton.h"
+#include "Animation.h"
+
+namespace Dog {
+
+	Skeleton::Skeleton(const AssimpNodeData& root, const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		CountBones(boneInfoMap);
+		AddNode(root, -1, boneInfoMap);
+	}
+
+	Skeleton::Skeleton(const std::vector<std::string>& names, const std::vector<int>& parents, const std::vector<glm::mat4>& bindTransforms, const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		assert(names.size() == parents.size() && names.size() == bindTransforms.size());
+
+		CountBones(boneInfoMap);
+		for (size_t i = 0; i < names.size(); ++i) {
+			assert(parents[i] < int(i) && "Nodes must come after their parent");
+			AppendNode(names[i], parents[i], bindTransforms[i], boneInfoMap);
+		}
+	}
+
+	int Skeleton::FindNode(const std::string& name) const
+	{
+		auto it = std::find(m_Names.begin(), m_Names.end(), name);
+		return it == m_Names.end() ? -1 : int(it - m_Names.begin());
+	}
+
+	void Skeleton::CountBones(const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		for (const auto& [name, info] : boneInfoMap) {
+			m_BoneCount = std::max(m_BoneCount, uint32_t(info.id + 1));
+		}
+	}
+
+	void Skeleton::AddNode(const AssimpNodeData& node, int parent, const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		int index = int(m_Parents.size());
+		AppendNode(node.name, parent, node.transformation, boneInfoMap);
+
+		for (int i = 0; i < node.childrenCount; i++) {
+			AddNode(node.children[i], index, boneInfoMap);
+		}
+	}
+
+	void Skeleton::AppendNode(const std::string& name, int parent, const glm::mat4& bindTransform, const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		m_Parents.push_back(parent);
+		m_BindTransforms.push_back(bindTransform);
+		m_Names.push_back(name);
+
+		auto bone = boneInfoMap.find(name);
+		if (bone != boneInfoMap.end()) {
+			m_NodeBones.push_back(bone->second.id);
+			m_BoneOffsets.push_back(bone->second.offset);
+			++m_SkinnedNodeCount;
+		}
+		else {
+			m_NodeBones.push_back(-1);
+			m_BoneOffsets.push_back(glm::mat4(1.0f));
+		}
+	}
+
+} // namespace Dog
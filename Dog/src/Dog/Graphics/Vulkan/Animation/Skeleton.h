@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BoneInfo.h"
+
+namespace Dog {
+
+	struct AssimpNodeData;
+
+	/*
+	 * The node hierarchy flattened into arrays. Nodes are stored parents first, so a single forward
+	 * pass computes every global transform, with no recursion and no name lookups.
+	 */
+	class Skeleton
+	{
+	public:
+		Skeleton() = default;
+		Skeleton(const AssimpNodeData& root, const std::map<std::string, BoneInfo>& boneInfoMap);
+
+		// From nodes already flattened parents first, as in a cooked animation
+		Skeleton(const std::vector<std::string>& names, const std::vector<int>& parents, const std::vector<glm::mat4>& bindTransforms, const std::map<std::string, BoneInfo>& boneInfoMap);
+
+		// Index of the first node with this name, -1 if there is none. Only meant for building, it's a linear search
+		int FindNode(const std::string& name) const;
+
+		inline uint32_t GetNodeCount() const { return uint32_t(m_Parents.size()); }
+		inline uint32_t GetBoneCount() const { return m_BoneCount; }
+		inline uint32_t GetSkinnedNodeCount() const { return m_SkinnedNodeCount; }
+
+		inline const std::vector<int>& GetParents() const { return m_Parents; }
+		inline const std::vector<glm::mat4>& GetBindTransforms() const { return m_BindTransforms; }
+		inline const std::vector<int>& GetNodeBones() const { return m_NodeBones; }
+		inline const std::vector<glm::mat4>& GetBoneOffsets() const { return m_BoneOffsets; }
+		inline const std::vector<std::string>& GetNodeNames() const { return m_Names; }
+
+	private:
+		void AddNode(const AssimpNodeData& node, int parent, const std::map<std::string, BoneInfo>& boneInfoMap);
+		void AppendNode(const std::string& name, int parent, const glm::mat4& bindTransform, const std::map<std::string, BoneInfo>& boneInfoMap);
+		void CountBones(const std::map<std::string, BoneInfo>& boneInfoMap);
+
+		std::vector<int> m_Parents;               // -1 for the root, otherwise lower than the node's own index
+		std::vector<glm::mat4> m_BindTransforms;  // Local transform of nodes the clip doesn't animate
+		std::vector<int> m_NodeBones;             // Palette index of each node, -1 if it isn't a bone
+		std::vector<glm::mat4> m_BoneOffsets;     // Offset matrix of each node, identity if it isn't a bone
+		std::vector<std::string> m_Names;
+		uint32_t m_BoneCount = 0;                 // Palette size, highest bone id + 1
+		uint32_t m_SkinnedNodeCount = 0;          // Nodes writing a palette entry
+	};
+
+} // namespace Dog
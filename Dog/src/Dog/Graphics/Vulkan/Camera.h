@@ -18,10 +18,16 @@ namespace Dog {
         const glm::mat4& getView() const { return viewMatrix; }
         const glm::mat4& getInverseView() const { return inverseViewMatrix; }
 
+        // Of the last perspective projection
+        float getNear() const { return nearPlane; }
+        float getFar() const { return farPlane; }
+
     private:
         glm::mat4 projectionMatrix{ 1.f };
         glm::mat4 viewMatrix{ 1.f };
         glm::mat4 inverseViewMatrix{ 1.f };
+        float nearPlane = 0.1f;
+        float farPlane = 100.f;
     };
 
 } // namespace Dog
@@ -1,5 +1,7 @@
 #include <PCH/pch.h>
 #include "Device.h"
+#include "UploadManager.h"
+#include "../Pipeline/PipelineCache.h"
 
 namespace Dog {
 
@@ -43,7 +45,11 @@ namespace Dog {
     }
 
     // class member functions
-    Device::Device(Window& window) : window{ window } {
+    Device::Device(Window& window) : window{ window }, headless{ window.isHeadless() } {
+        if (!headless) {
+            deviceExtensions.insert(deviceExtensions.end(), presentationExtensions.begin(), presentationExtensions.end());
+        }
+
         createInstance();
         setupDebugMessenger();
         createSurface();
@@ -57,9 +63,14 @@ namespace Dog {
         allocatorInfo.instance = instance;
         allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
         vmaCreateAllocator(&allocatorInfo, &allocator);
+
+        uploadManager = std::make_unique<UploadManager>(*this);
+        pipelineCache = std::make_unique<PipelineCache>(*this);
     }
 
     Device::~Device() {
+        pipelineCache.reset();
+        uploadManager.reset();
         vmaDestroyAllocator(allocator);
 
         vkDestroyCommandPool(device_, commandPool, nullptr);
@@ -69,7 +80,9 @@ namespace Dog {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -143,9 +156,10 @@ namespace Dog {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
         graphicsFamily_ = indices.graphicsFamily;
         presentFamily_ = indices.presentFamily;
+        transferFamily_ = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+        std::set<uint32_t> uniqueQueueFamilies = { graphicsFamily_, presentFamily_, transferFamily_ };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -157,21 +171,42 @@ namespace Dog {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
         deviceFeatures.fillModeNonSolid = VK_TRUE;
-
-        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
-        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
-        indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
-        indexingFeatures.runtimeDescriptorArray = VK_TRUE;
-        indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
-        indexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        enabledFeatures = deviceFeatures;
+
+        VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+        supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 supportedFeatures2{};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supportedVulkan12Features;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures2);
+
+        // Descriptor indexing goes through the 1.2 struct, which can't share a chain with the EXT one
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.descriptorIndexing = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE; // Bindless textures are written while frames are in flight
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        vulkan12Features.drawIndirectCount = supportedVulkan12Features.drawIndirectCount;
+        vulkan12Features.timelineSemaphore = VK_TRUE; // Upload completion, core since 1.2
+        enabledVulkan12Features = vulkan12Features;
 
         VkPhysicalDeviceAccelerationStructureFeaturesKHR accelFeature{};
         accelFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
         accelFeature.accelerationStructure = VK_TRUE; // not in guide, is it needed?
-        accelFeature.pNext = &indexingFeatures;
+        accelFeature.pNext = &vulkan12Features;
 
         VkPhysicalDeviceRayTracingPipelineFeaturesKHR rtPipelineFeature{};
         rtPipelineFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
@@ -181,7 +216,14 @@ namespace Dog {
         // Make sure you pass these enabled features and extensions when creating your device
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        createInfo.pNext = &rtPipelineFeature;
+
+        // Headless runs skip the ray tracing features, so software devices without them still work
+        if (headless) {
+            createInfo.pNext = &vulkan12Features;
+        }
+        else {
+            createInfo.pNext = &rtPipelineFeature;
+        }
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -206,6 +248,7 @@ namespace Dog {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, transferFamily_, 0, &transferQueue_);
     }
 
     void Device::createCommandPool() {
@@ -222,15 +265,18 @@ namespace Dog {
         }
     }
 
-    void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void Device::createSurface() {
+        if (headless) return;
+        window.createWindowSurface(instance, &surface_);
+    }
 
     bool Device::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        bool swapChainAdequate = headless;
+        if (extensionsSupported && !headless) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -289,11 +335,15 @@ namespace Dog {
     }
 
     std::vector<const char*> Device::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        std::vector<const char*> extensions;
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        if (!headless) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -361,7 +411,13 @@ namespace Dog {
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (headless) {
+                // Nothing is presented, so the graphics queue stands in for the present queue
+                presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -373,6 +429,24 @@ namespace Dog {
             i++;
         }
 
+        // Prefer a transfer-only family (the copy engine), then any other family without graphics
+        for (uint32_t family = 0; family < queueFamilyCount; ++family) {
+            const VkQueueFamilyProperties& queueFamily = queueFamilies[family];
+            if (queueFamily.queueCount == 0 || !(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) ||
+                (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                continue;
+            }
+
+            bool transferOnly = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+            if (!indices.transferFamilyHasValue || transferOnly) {
+                indices.transferFamily = family;
+                indices.transferFamilyHasValue = true;
+            }
+            if (transferOnly) {
+                break;
+            }
+        }
+
         return indices;
     }
 
@@ -445,6 +519,14 @@ namespace Dog {
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+        // Upload targets are written on the transfer queue and read on the graphics queue
+        uint32_t queueFamilies[] = { graphicsFamily_, transferFamily_ };
+        if (hasDedicatedTransferQueue() && (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT)) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = queueFamilies;
+        }
+
         // Allocation description for VMA
         VmaAllocationCreateInfo allocInfo{};
         allocInfo.usage = memoryUsage;
@@ -496,18 +578,6 @@ namespace Dog {
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
-    void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-        endSingleTimeCommands(commandBuffer);
-    }
-
     void Device::createImageWithInfo(
         const VkImageCreateInfo& imageInfo,
         VmaMemoryUsage memoryUsage,
@@ -10,11 +10,16 @@ namespace Dog {
         std::vector<VkPresentModeKHR> presentModes;
     };
 
+    class UploadManager;
+    class PipelineCache;
+
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false; // Only set for a family without graphics support
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -40,8 +45,10 @@ namespace Dog {
         VkCommandPool getCommandPool() const { return commandPool; }
         VkDevice device() const { return device_; }
         VkSurfaceKHR surface() const { return surface_; }
+        bool isHeadless() const { return headless; }
         VkQueue graphicsQueue() const { return graphicsQueue_; }
         VkQueue presentQueue() const { return presentQueue_; }
+        VkQueue transferQueue() const { return transferQueue_; }
         const VkPhysicalDevice& getPhysicalDevice() const { return physicalDevice; }
         const VkInstance& getInstance() const { return instance; }
 
@@ -54,6 +61,14 @@ namespace Dog {
 
         uint32_t GetGraphicsFamily() const { return graphicsFamily_; }
         uint32_t GetPresentFamily() const { return presentFamily_; }
+        uint32_t GetTransferFamily() const { return transferFamily_; }
+
+        // Uploads run on a transfer-only queue family when there is one, which resources
+        // they write have to be shared with
+        bool hasDedicatedTransferQueue() const { return transferFamily_ != graphicsFamily_; }
+
+        UploadManager& getUploadManager() { return *uploadManager; }
+        PipelineCache& getPipelineCache() { return *pipelineCache; }
 
         // Buffer Helper Functions
         void createBuffer(
@@ -65,7 +80,6 @@ namespace Dog {
 
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
         void createImageWithInfo(
             const VkImageCreateInfo& imageInfo,
@@ -73,6 +87,10 @@ namespace Dog {
             VkImage& image,
             VmaAllocation& imageAllocation);
 
+        // Optional features are only enabled when the physical device supports them
+        const VkPhysicalDeviceFeatures& getEnabledFeatures() const { return enabledFeatures; }
+        const VkPhysicalDeviceVulkan12Features& getEnabledVulkan12Features() const { return enabledVulkan12Features; }
+
         VkPhysicalDeviceProperties properties;
         VmaAllocator allocator;
 
@@ -100,18 +118,31 @@ namespace Dog {
         Window& window;
         VkCommandPool commandPool;
 
+        // Headless devices skip the surface, swapchain and ray tracing requirements
+        bool headless = false;
+
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        VkPhysicalDeviceVulkan12Features enabledVulkan12Features{};
+
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
 
         uint32_t graphicsFamily_ = 0;
         uint32_t presentFamily_ = 0;
+        uint32_t transferFamily_ = 0;
+
+        std::unique_ptr<UploadManager> uploadManager;
+        std::unique_ptr<PipelineCache> pipelineCache;
 
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-        const std::vector<const char*> deviceExtensions = {
+        std::vector<const char*> deviceExtensions = {
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME
+        };
+        const std::vector<const char*> presentationExtensions = {
             VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
             VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
             VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
             VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME
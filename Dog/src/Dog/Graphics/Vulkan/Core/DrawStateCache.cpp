@@ -0,0 +1,76 @@
+#include <PCH/pch.h>
+#include "DrawStateCache.h"
+
+namespace Dog {
+
+    DrawStateStats& DrawStateStats::operator+=(const DrawStateStats& other) {
+        pipelineBinds += other.pipelineBinds;
+        vertexBufferBinds += other.vertexBufferBinds;
+        indexBufferBinds += other.indexBufferBinds;
+        pushConstantUpdates += other.pushConstantUpdates;
+        skippedBinds += other.skippedBinds;
+        return *this;
+    }
+
+    DrawStateCache::DrawStateCache(VkCommandBuffer commandBuffer, bool skipRedundant)
+        : commandBuffer{ commandBuffer }
+        , skipRedundant{ skipRedundant }
+    {
+    }
+
+    void DrawStateCache::bindPipeline(VkPipeline newPipeline) {
+        if (skipRedundant && newPipeline == pipeline) {
+            ++stats.skippedBinds;
+            return;
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, newPipeline);
+        pipeline = newPipeline;
+        ++stats.pipelineBinds;
+    }
+
+    void DrawStateCache::bindVertexBuffers(uint32_t count, const VkBuffer* buffers) {
+        assert(count <= MAX_VERTEX_BUFFERS && "More vertex streams than the cache tracks");
+
+        if (skipRedundant && count <= vertexBufferCount && std::equal(buffers, buffers + count, vertexBuffers.begin())) {
+            ++stats.skippedBinds;
+            return;
+        }
+
+        VkDeviceSize offsets[MAX_VERTEX_BUFFERS]{};
+        vkCmdBindVertexBuffers(commandBuffer, 0, count, buffers, offsets);
+        std::copy(buffers, buffers + count, vertexBuffers.begin());
+        vertexBufferCount = std::max(vertexBufferCount, count);
+        ++stats.vertexBufferBinds;
+    }
+
+    void DrawStateCache::bindIndexBuffer(VkBuffer buffer, VkIndexType type) {
+        if (skipRedundant && buffer == indexBuffer && type == indexType) {
+            ++stats.skippedBinds;
+            return;
+        }
+
+        vkCmdBindIndexBuffer(commandBuffer, buffer, 0, type);
+        indexBuffer = buffer;
+        indexType = type;
+        ++stats.indexBufferBinds;
+    }
+
+    void DrawStateCache::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t size, const void* data) {
+        assert(size <= MAX_PUSH_CONSTANT_SIZE && "Push constants larger than the cache tracks");
+
+        // Only a full match is skipped, a push of part of the range leaves the rest as it was
+        if (skipRedundant && layout == pushLayout && stages == pushStages && size == pushSize && memcmp(data, pushData.data(), size) == 0) {
+            ++stats.skippedBinds;
+            return;
+        }
+
+        vkCmdPushConstants(commandBuffer, layout, stages, 0, size, data);
+        pushLayout = layout;
+        pushStages = stages;
+        pushSize = size;
+        memcpy(pushData.data(), data, size);
+        ++stats.pushConstantUpdates;
+    }
+
+} // namespace Dog
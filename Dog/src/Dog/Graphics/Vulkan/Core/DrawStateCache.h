@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Device.h"
+
+namespace Dog {
+
+    // What was recorded into a command buffer, and what was left out for being bound already
+    struct DrawStateStats {
+        uint32_t pipelineBinds = 0;
+        uint32_t vertexBufferBinds = 0;
+        uint32_t indexBufferBinds = 0;
+        uint32_t pushConstantUpdates = 0;
+        uint32_t skippedBinds = 0; // Binds and push constants matching what was already set
+
+        DrawStateStats& operator+=(const DrawStateStats& other);
+    };
+
+    // Records pipeline, vertex buffer and index buffer binds and push constants into one command buffer, dropping
+    // any that would set what's already set. It knows nothing bound at the start, so the first of each is recorded.
+    // Descriptor sets are bound by the caller, once per command buffer
+    class DrawStateCache {
+    public:
+        // Without skipping every call is recorded, for comparisons
+        explicit DrawStateCache(VkCommandBuffer commandBuffer, bool skipRedundant = true);
+
+        VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+
+        void bindPipeline(VkPipeline pipeline);
+
+        // From binding 0, at offset 0. Bindings past count are left as they were
+        void bindVertexBuffers(uint32_t count, const VkBuffer* buffers);
+        void bindIndexBuffer(VkBuffer buffer, VkIndexType indexType);
+
+        void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t size, const void* data);
+
+        const DrawStateStats& getStats() const { return stats; }
+
+    private:
+        static constexpr uint32_t MAX_VERTEX_BUFFERS = 2;
+        static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128; // The smallest limit Vulkan guarantees
+
+        VkCommandBuffer commandBuffer;
+        bool skipRedundant;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::array<VkBuffer, MAX_VERTEX_BUFFERS> vertexBuffers{};
+        uint32_t vertexBufferCount = 0;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+
+        VkPipelineLayout pushLayout = VK_NULL_HANDLE;
+        VkShaderStageFlags pushStages = 0;
+        uint32_t pushSize = 0;
+        std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> pushData{};
+
+        DrawStateStats stats{};
+    };
+
+} // namespace Dog
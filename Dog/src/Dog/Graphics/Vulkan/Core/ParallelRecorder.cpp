@@ -0,0 +1,111 @@
+#include <PCH/pch.h>
+#include "ParallelRecorder.h"
+
+namespace Dog {
+
+    ParallelRecorder::ParallelRecorder(Device& device, JobSystem& jobSystem, uint32_t bucketCount, uint32_t framesInFlight)
+        : device{ device }
+        , jobSystem{ jobSystem }
+        , bucketCount{ bucketCount }
+    {
+        if (this->bucketCount == 0) {
+            this->bucketCount = jobSystem.GetThreadCount();
+        }
+
+        pools.resize(framesInFlight);
+        for (auto& framePools : pools) {
+            framePools.resize(jobSystem.GetThreadCount());
+            for (ThreadCommandPool& threadPool : framePools) {
+                VkCommandPoolCreateInfo poolInfo{};
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.queueFamilyIndex = device.GetGraphicsFamily();
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+                if (vkCreateCommandPool(device, &poolInfo, nullptr, &threadPool.pool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create command pool!");
+                }
+            }
+        }
+    }
+
+    ParallelRecorder::~ParallelRecorder() {
+        // Destroying a pool frees its command buffers
+        for (auto& framePools : pools) {
+            for (ThreadCommandPool& threadPool : framePools) {
+                vkDestroyCommandPool(device, threadPool.pool, nullptr);
+            }
+        }
+    }
+
+    void ParallelRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+        currentFrame = frameIndex;
+        currentRenderPass = renderPass;
+        currentFramebuffer = framebuffer;
+        currentExtent = extent;
+
+        for (ThreadCommandPool& threadPool : pools[frameIndex]) {
+            if (threadPool.usedCount == 0) continue;
+
+            vkResetCommandPool(device, threadPool.pool, 0);
+            threadPool.usedCount = 0;
+        }
+    }
+
+    VkCommandBuffer ParallelRecorder::beginSecondary() {
+        ThreadCommandPool& threadPool = pools[currentFrame][JobSystem::GetThreadIndex()];
+
+        if (threadPool.usedCount == threadPool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = threadPool.pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
+            threadPool.commandBuffers.push_back(commandBuffer);
+        }
+
+        VkCommandBuffer commandBuffer = threadPool.commandBuffers[threadPool.usedCount++];
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = currentRenderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = currentFramebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+
+        // Dynamic state isn't inherited from the primary
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(currentExtent.width);
+        viewport.height = static_cast<float>(currentExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ {0, 0}, currentExtent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        return commandBuffer;
+    }
+
+    void ParallelRecorder::run(const std::function<void(uint32_t bucket)>& task) {
+        jobSystem.ParallelFor(bucketCount, 1, [&task](uint32_t begin, uint32_t end) {
+            for (uint32_t bucket = begin; bucket < end; ++bucket) {
+                task(bucket);
+            }
+        });
+    }
+
+} // namespace Dog
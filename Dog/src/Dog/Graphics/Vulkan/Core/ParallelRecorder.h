@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Device.h"
+#include "Jobs/JobSystem.h"
+
+namespace Dog {
+
+    // Records secondary command buffers from jobs. Work is split into buckets that run as jobs on the job
+    // system, and every job system thread gets its own command pool per frame in flight, so pools are never
+    // shared between threads and can be reset wholesale once the frame's fence has been waited on.
+    class ParallelRecorder {
+    public:
+        // A bucket count of 0 uses one per job system thread, 1 records everything inline
+        ParallelRecorder(Device& device, JobSystem& jobSystem, uint32_t bucketCount, uint32_t framesInFlight);
+        ~ParallelRecorder();
+
+        ParallelRecorder(const ParallelRecorder&) = delete;
+        ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+        uint32_t getBucketCount() const { return bucketCount; }
+        bool isParallel() const { return bucketCount > 1; }
+
+        // Resets the frame's pools and sets the render pass secondaries will continue.
+        // The frame's previous submission must have finished.
+        void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+        // Begins a secondary command buffer from the calling thread's pool with the viewport and scissor already set
+        VkCommandBuffer beginSecondary();
+
+        // Runs task(bucket) once for every bucket as jobs and returns when all of them have finished.
+        // An exception thrown by a task is rethrown here.
+        void run(const std::function<void(uint32_t bucket)>& task);
+
+    private:
+        struct ThreadCommandPool {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers;
+            size_t usedCount = 0;
+        };
+
+        Device& device;
+        JobSystem& jobSystem;
+        uint32_t bucketCount;
+
+        // [frame][thread]
+        std::vector<std::vector<ThreadCommandPool>> pools;
+        int currentFrame = 0;
+        VkRenderPass currentRenderPass = VK_NULL_HANDLE;
+        VkFramebuffer currentFramebuffer = VK_NULL_HANDLE;
+        VkExtent2D currentExtent{};
+    };
+
+} // namespace Dog
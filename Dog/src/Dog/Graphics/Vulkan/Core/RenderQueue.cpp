@@ -0,0 +1,58 @@
+#include <PCH/pch.h>
+#include "RenderQueue.h"
+
+namespace Dog {
+
+    uint64_t RenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth) {
+        auto field = [](uint32_t value, uint32_t bits) { return static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1); };
+
+        uint64_t key = field(pass, PASS_BITS);
+        key = (key << PIPELINE_BITS) | field(pipeline, PIPELINE_BITS);
+        key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+        key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+        key = (key << DEPTH_BITS) | field(depth, DEPTH_BITS);
+        return key;
+    }
+
+    uint32_t RenderQueue::quantizeDepth(float depth, float nearPlane, float farPlane) {
+        constexpr float maxDepth = float((1u << DEPTH_BITS) - 1);
+        if (depth <= nearPlane) return 0;
+
+        float t = std::log(depth / nearPlane) / std::log(farPlane / nearPlane);
+        return static_cast<uint32_t>(std::min(t, 1.f) * maxDepth);
+    }
+
+    void RenderQueue::sort() {
+        if (entries.size() < 2) return;
+
+        // Every byte's histogram in one read of the keys
+        std::array<std::array<uint32_t, 256>, 8> counts{};
+        for (const Entry& entry : entries) {
+            for (uint32_t digit = 0; digit < 8; ++digit) {
+                ++counts[digit][(entry.key >> (digit * 8)) & 0xFF];
+            }
+        }
+
+        scratch.resize(entries.size());
+        for (uint32_t digit = 0; digit < 8; ++digit) {
+            std::array<uint32_t, 256>& digitCounts = counts[digit];
+
+            // A byte every key has doesn't reorder anything
+            uint8_t firstByte = static_cast<uint8_t>((entries[0].key >> (digit * 8)) & 0xFF);
+            if (digitCounts[firstByte] == entries.size()) continue;
+
+            uint32_t offset = 0;
+            for (uint32_t& count : digitCounts) {
+                uint32_t bucketSize = count;
+                count = offset;
+                offset += bucketSize;
+            }
+
+            for (const Entry& entry : entries) {
+                scratch[digitCounts[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+    }
+
+} // namespace Dog
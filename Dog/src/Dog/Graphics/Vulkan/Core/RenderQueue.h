@@ -0,0 +1,48 @@
+#pragma once
+
+namespace Dog {
+
+    // Draws to record, each an item index with a 64 bit key, sorted so draws sharing state end up next to each other.
+    // From most to least significant the key holds the pass, the pipeline, the material, the mesh and the quantized
+    // depth, so within the same state draws go front to back for early depth rejection
+    class RenderQueue {
+    public:
+        static constexpr uint32_t PASS_BITS = 3;
+        static constexpr uint32_t PIPELINE_BITS = 7;
+        static constexpr uint32_t MATERIAL_BITS = 16;
+        static constexpr uint32_t MESH_BITS = 22;
+        static constexpr uint32_t DEPTH_BITS = 16;
+        static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64, "Sort key fields must fill 64 bits");
+
+        // Passes draw in this order
+        static constexpr uint32_t PASS_OPAQUE = 0;
+
+        struct Entry {
+            uint64_t key;
+            uint32_t item;
+        };
+
+        // Fields wider than their bits keep their low bits
+        static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+
+        // View depth in DEPTH_BITS, spaced logarithmically between the planes so near draws get the finer steps
+        static uint32_t quantizeDepth(float depth, float nearPlane, float farPlane);
+
+        void clear() { entries.clear(); }
+        void push(uint64_t key, uint32_t item) { entries.push_back({ key, item }); }
+
+        // Least significant digit radix sort, a byte per pass. Bytes every key shares are skipped, and equal keys keep
+        // the order they were pushed in
+        void sort();
+
+        const std::vector<Entry>& getEntries() const { return entries; }
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+
+    private:
+        // Reused every frame to avoid reallocating
+        std::vector<Entry> entries;
+        std::vector<Entry> scratch;
+    };
+
+} // namespace Dog
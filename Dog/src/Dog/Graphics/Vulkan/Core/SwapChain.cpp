@@ -4,19 +4,24 @@
 namespace Dog {
 
     SwapChain::SwapChain(Device& deviceRef, VkExtent2D extent)
-        : device{ deviceRef }, windowExtent{ extent } {
+        : device{ deviceRef }, windowExtent{ extent }, headless{ deviceRef.isHeadless() } {
         init();
     }
 
     SwapChain::SwapChain(
         Device& deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous)
-        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+        : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous }, headless{ deviceRef.isHeadless() } {
         init();
         oldSwapChain = nullptr;
     }
 
     void SwapChain::init() {
-        createSwapChain();
+        if (headless) {
+            createOffscreenImages();
+        }
+        else {
+            createSwapChain();
+        }
         createImageViews();
         createRenderPass();
         createDepthResources();
@@ -30,6 +35,11 @@ namespace Dog {
         }
         swapChainImageViews.clear();
 
+        for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+            vmaDestroyImage(device.allocator, swapChainImages[i], offscreenImageMemorys[i]);
+        }
+        offscreenImageMemorys.clear();
+
         if (swapChain != VK_NULL_HANDLE) {
             vkDestroySwapchainKHR(device, swapChain, nullptr);
             swapChain = VK_NULL_HANDLE;
@@ -62,6 +72,12 @@ namespace Dog {
             VK_TRUE,
             std::numeric_limits<uint64_t>::max());
 
+        if (headless) {
+            // One offscreen image per frame in flight, so the fence above already guards it
+            *imageIndex = static_cast<uint32_t>(currentFrame);
+            return VK_SUCCESS;
+        }
+
         VkResult result = vkAcquireNextImageKHR(
             device,
             swapChain,
@@ -73,20 +89,56 @@ namespace Dog {
         return result;
     }
 
-    VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) {
+    VkResult SwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex, VkSemaphore waitTimeline, uint64_t waitValue) {
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
             vkWaitForFences(device, 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
         }
         imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
+        // Binary semaphores ignore their entry in the value list
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues;
+
+        if (!headless) {
+            waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            waitValues.push_back(0);
+        }
+        if (waitTimeline != VK_NULL_HANDLE && waitValue > 0) {
+            waitSemaphores.push_back(waitTimeline);
+            // Every stage that could read an upload first, indirect arguments and transfer sources included
+            waitStages.push_back(
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+            waitValues.push_back(waitValue);
+        }
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+
+        if (headless) {
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = buffers;
+
+            vkResetFences(device, 1, &inFlightFences[currentFrame]);
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+                VK_SUCCESS) {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
 
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
+            currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+            return VK_SUCCESS;
+        }
 
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
@@ -182,6 +234,41 @@ namespace Dog {
         swapChainExtent = extent;
     }
 
+    void SwapChain::createOffscreenImages() {
+        swapChainImageFormat = device.findSupportedFormat(
+            { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+        swapChainExtent = windowExtent;
+
+        swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+        offscreenImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.flags = 0;
+
+            device.createImageWithInfo(
+                imageInfo,
+                VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                swapChainImages[i],
+                offscreenImageMemorys[i]);
+        }
+    }
+
     void SwapChain::createImageViews() {
         swapChainImageViews.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -226,7 +313,8 @@ namespace Dog {
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // Present layouts come from the swapchain extension, which headless devices don't enable
+        colorAttachment.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
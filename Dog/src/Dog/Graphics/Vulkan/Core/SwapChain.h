@@ -32,7 +32,12 @@ namespace Dog {
         VkFormat findDepthFormat();
 
         VkResult acquireNextImage(uint32_t* imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+        // The submit also waits for waitTimeline to reach waitValue before any vertex or shader work
+        VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex,
+            VkSemaphore waitTimeline = VK_NULL_HANDLE, uint64_t waitValue = 0);
+
+        // Offscreen swap chains render into their own images and never present
+        bool isHeadless() const { return headless; }
 
         bool compareSwapFormats(const SwapChain& swapChain) const {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -42,6 +47,7 @@ namespace Dog {
     private:
         void init();
         void createSwapChain();
+        void createOffscreenImages();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -67,12 +73,14 @@ namespace Dog {
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
+        std::vector<VmaAllocation> offscreenImageMemorys;
 
         Device& device;
         VkExtent2D windowExtent;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
         std::shared_ptr<SwapChain> oldSwapChain;
+        bool headless = false;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
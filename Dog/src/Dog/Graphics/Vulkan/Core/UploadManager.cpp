@@ -0,0 +1,365 @@
+#include <PCH/pch.h>
+#include "UploadManager.h"
+#include "Device.h"
+#include "../Buffers/Buffer.h"
+
+namespace Dog {
+
+    UploadManager::UploadManager(Device& device)
+        : device{ device }
+        , transferQueue{ device.transferQueue() }
+        , graphicsQueue{ device.graphicsQueue() }
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        poolInfo.queueFamilyIndex = device.GetTransferFamily();
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &transferPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload transfer command pool!");
+        }
+
+        poolInfo.queueFamilyIndex = device.GetGraphicsFamily();
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &graphicsPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload graphics command pool!");
+        }
+
+        VkSemaphoreTypeCreateInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &timelineInfo;
+
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload timeline semaphore!");
+        }
+
+        stagingRing = std::make_unique<Buffer>(
+            device,
+            STAGING_RING_SIZE,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY);
+        stagingRing->map();
+    }
+
+    UploadManager::~UploadManager() {
+        flush();
+
+        current.releasedBuffers.clear();
+        stagingRing.reset();
+
+        vkDestroySemaphore(device, timeline, nullptr);
+        vkDestroyCommandPool(device, transferPool, nullptr);
+        vkDestroyCommandPool(device, graphicsPool, nullptr);
+    }
+
+    StagingAllocation UploadManager::stage(VkDeviceSize size, VkDeviceSize alignment) {
+        size = std::max<VkDeviceSize>(size, 1);
+
+        if (size > stagingRing->getBufferSize()) {
+            auto buffer = std::make_unique<Buffer>(device, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+            buffer->map();
+
+            StagingAllocation allocation{ buffer->getMappedMemory(), buffer->getBuffer(), 0 };
+            current.releasedBuffers.push_back(std::move(buffer));
+            return allocation;
+        }
+
+        VkDeviceSize offset = 0;
+        while (!tryAllocate(size, alignment, offset)) {
+            retireCompleted();
+            if (tryAllocate(size, alignment, offset)) break;
+
+            // Everything in the ring is still being read, hand the current batch to the GPU
+            // and wait for the oldest batch to give its space back
+            if (current.usesRing) {
+                submit();
+            }
+            if (!inFlight.empty()) {
+                wait(inFlight.front().value);
+            }
+        }
+
+        current.usesRing = true;
+        return { static_cast<char*>(stagingRing->getMappedMemory()) + offset, stagingRing->getBuffer(), offset };
+    }
+
+    void UploadManager::uploadToBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+        StagingAllocation staging = stage(size);
+        memcpy(staging.data, data, static_cast<size_t>(size));
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = staging.offset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(getTransferCommandBuffer(), staging.buffer, dst, 1, &copyRegion);
+    }
+
+    void UploadManager::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+        VkCommandBuffer commandBuffer = getTransferCommandBuffer();
+
+        // The source may have been written by a copy earlier in this batch
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
+    }
+
+    VkCommandBuffer UploadManager::getTransferCommandBuffer() {
+        if (current.transferCommands == VK_NULL_HANDLE) {
+            current.transferCommands = acquireCommandBuffer(transferPool, freeTransferCommands);
+
+            // Order this batch's copies after the writes of batches submitted before it
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(current.transferCommands,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+        }
+        return current.transferCommands;
+    }
+
+    VkCommandBuffer UploadManager::getGraphicsCommandBuffer() {
+        if (current.graphicsCommands == VK_NULL_HANDLE) {
+            current.graphicsCommands = acquireCommandBuffer(graphicsPool, freeGraphicsCommands);
+        }
+        return current.graphicsCommands;
+    }
+
+    void UploadManager::releaseAfterUpload(std::unique_ptr<Buffer> buffer) {
+        current.releasedBuffers.push_back(std::move(buffer));
+    }
+
+    uint64_t UploadManager::submit() {
+        retireCompleted();
+
+        if (current.transferCommands == VK_NULL_HANDLE && current.graphicsCommands == VK_NULL_HANDLE) {
+            // Nothing new to wait for, released buffers only have to outlive what's already queued
+            if (!current.releasedBuffers.empty() && !inFlight.empty()) {
+                for (auto& buffer : current.releasedBuffers) {
+                    inFlight.back().releasedBuffers.push_back(std::move(buffer));
+                }
+            }
+            current.releasedBuffers.clear();
+            return submittedValue;
+        }
+
+        const uint64_t previousDone = submittedValue;
+        const uint64_t copiesDone = submittedValue + 1;
+        const uint64_t batchDone = submittedValue + 2;
+
+        // Batches may go to two queues, so the first submit of each waits for the previous batch.
+        // Otherwise a later batch could signal past one still running, which would then look done
+        // and would signal a value lower than the semaphore's.
+        bool waitForPrevious = previousDone > 0;
+
+        if (current.transferCommands != VK_NULL_HANDLE) {
+            if (vkEndCommandBuffer(current.transferCommands) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record upload command buffer!");
+            }
+
+            uint64_t signalValue = current.graphicsCommands != VK_NULL_HANDLE ? copiesDone : batchDone;
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo{};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.waitSemaphoreValueCount = waitForPrevious ? 1 : 0;
+            timelineInfo.pWaitSemaphoreValues = &previousDone;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.waitSemaphoreCount = waitForPrevious ? 1 : 0;
+            submitInfo.pWaitSemaphores = &timeline;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &current.transferCommands;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &timeline;
+
+            if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit upload command buffer!");
+            }
+        }
+
+        if (current.graphicsCommands != VK_NULL_HANDLE) {
+            if (vkEndCommandBuffer(current.graphicsCommands) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record upload command buffer!");
+            }
+
+            // After this batch's copies, or the previous batch when there are none
+            bool waitForCopies = current.transferCommands != VK_NULL_HANDLE;
+            bool waitForSemaphore = waitForCopies || waitForPrevious;
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+            VkTimelineSemaphoreSubmitInfo timelineInfo{};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.waitSemaphoreValueCount = waitForSemaphore ? 1 : 0;
+            timelineInfo.pWaitSemaphoreValues = waitForCopies ? &copiesDone : &previousDone;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &batchDone;
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.waitSemaphoreCount = waitForSemaphore ? 1 : 0;
+            submitInfo.pWaitSemaphores = &timeline;
+            submitInfo.pWaitDstStageMask = &waitStage;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &current.graphicsCommands;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &timeline;
+
+            if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit upload command buffer!");
+            }
+        }
+
+        current.value = batchDone;
+        current.ringEnd = ringHead;
+        inFlight.push_back(std::move(current));
+        current = Batch{};
+
+        submittedValue = batchDone;
+        return submittedValue;
+    }
+
+    void UploadManager::flush() {
+        wait(submit());
+    }
+
+    void UploadManager::wait(uint64_t value) {
+        if (value > 0) {
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &timeline;
+            waitInfo.pValues = &value;
+            vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+        }
+
+        retireCompleted();
+    }
+
+    bool UploadManager::isComplete(uint64_t value) {
+        uint64_t completed = 0;
+        vkGetSemaphoreCounterValue(device, timeline, &completed);
+        return completed >= value;
+    }
+
+    VkCommandBuffer UploadManager::acquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        if (!freeList.empty()) {
+            commandBuffer = freeList.back();
+            freeList.pop_back();
+        }
+        else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = pool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin upload command buffer!");
+        }
+
+        return commandBuffer;
+    }
+
+    void UploadManager::retireCompleted() {
+        if (inFlight.empty()) return;
+
+        uint64_t completed = 0;
+        vkGetSemaphoreCounterValue(device, timeline, &completed);
+
+        while (!inFlight.empty() && inFlight.front().value <= completed) {
+            retire(inFlight.front());
+            inFlight.pop_front();
+        }
+    }
+
+    void UploadManager::retire(Batch& batch) {
+        if (batch.transferCommands != VK_NULL_HANDLE) {
+            freeTransferCommands.push_back(batch.transferCommands);
+        }
+        if (batch.graphicsCommands != VK_NULL_HANDLE) {
+            freeGraphicsCommands.push_back(batch.graphicsCommands);
+        }
+        batch.releasedBuffers.clear();
+
+        // Batches finish in order, so the ring is free up to the end of this one
+        if (batch.usesRing) {
+            ringTail = batch.ringEnd;
+        }
+    }
+
+    bool UploadManager::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+        bool ringInUse = current.usesRing;
+        for (const Batch& batch : inFlight) {
+            ringInUse = ringInUse || batch.usesRing;
+        }
+
+        if (!ringInUse) {
+            ringHead = 0;
+            ringTail = 0;
+        }
+
+        VkDeviceSize alignedHead = (ringHead + alignment - 1) & ~(alignment - 1);
+
+        // Live data spans [tail, head), free space is at the end and, once wrapped, before the tail
+        if (!ringInUse || ringHead > ringTail) {
+            if (alignedHead + size <= stagingRing->getBufferSize()) {
+                offset = alignedHead;
+            }
+            else if (size < ringTail) {
+                offset = 0;
+            }
+            else {
+                return false;
+            }
+        }
+        // Wrapped, live data spans [tail, end) and [0, head); head may never catch up to the tail
+        else if (alignedHead + size < ringTail) {
+            offset = alignedHead;
+        }
+        else {
+            return false;
+        }
+
+        ringHead = offset + size;
+        return true;
+    }
+
+} // namespace Dog
@@ -0,0 +1,98 @@
+#pragma once
+
+namespace Dog {
+
+    class Device;
+    class Buffer;
+
+    // Where staged data was written; the copy source for recorded uploads
+    struct StagingAllocation {
+        void* data = nullptr;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+    };
+
+    // Batches every CPU to GPU upload into one submission per frame instead of a blocking
+    // single-time command each. Data is staged in a persistently mapped ring, copies run on
+    // the dedicated transfer queue when the device has one, and completion is tracked with a
+    // timeline semaphore that the frame's graphics submit waits on. Work that needs a graphics
+    // queue (mip blits) is recorded into a second command buffer that waits on the copies.
+    // Not thread safe, uploads are recorded from the main thread.
+    class UploadManager {
+    public:
+        static constexpr VkDeviceSize STAGING_RING_SIZE = 64ull * 1024 * 1024;
+
+        UploadManager(Device& device);
+        ~UploadManager();
+
+        UploadManager(const UploadManager&) = delete;
+        UploadManager& operator=(const UploadManager&) = delete;
+
+        // Reserves staging memory for the current batch. Allocations bigger than the ring get a
+        // buffer of their own; when the ring is full the batch is submitted and the oldest
+        // batches are waited on until there is room
+        StagingAllocation stage(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+        // Stages data and records copying it into dst
+        void uploadToBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+        // Records a GPU side copy, ordered after every upload recorded before it
+        void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+
+        // Command buffers of the current batch. Transfer commands may run on a transfer-only
+        // queue; graphics commands run on the graphics queue once the transfer commands are done
+        VkCommandBuffer getTransferCommandBuffer();
+        VkCommandBuffer getGraphicsCommandBuffer();
+
+        // Keeps a buffer alive until the current batch has finished with it
+        void releaseAfterUpload(std::unique_ptr<Buffer> buffer);
+
+        // Submits the recorded batch, returns the timeline value that signals its completion.
+        // Returns the last submitted value if nothing was recorded
+        uint64_t submit();
+
+        // Submits and blocks until every upload so far has completed
+        void flush();
+
+        void wait(uint64_t value);
+        bool isComplete(uint64_t value);
+
+        VkSemaphore getTimeline() const { return timeline; }
+        uint64_t getSubmittedValue() const { return submittedValue; }
+
+    private:
+        struct Batch {
+            VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+            VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+            uint64_t value = 0;
+            VkDeviceSize ringEnd = 0;
+            bool usesRing = false;
+            std::vector<std::unique_ptr<Buffer>> releasedBuffers;
+        };
+
+        VkCommandBuffer acquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+        void retireCompleted();
+        void retire(Batch& batch);
+        bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+        Device& device;
+
+        VkQueue transferQueue;
+        VkQueue graphicsQueue;
+        VkCommandPool transferPool = VK_NULL_HANDLE;
+        VkCommandPool graphicsPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> freeTransferCommands;
+        std::vector<VkCommandBuffer> freeGraphicsCommands;
+
+        VkSemaphore timeline = VK_NULL_HANDLE;
+        uint64_t submittedValue = 0;
+
+        std::unique_ptr<Buffer> stagingRing;
+        VkDeviceSize ringHead = 0;
+        VkDeviceSize ringTail = 0;
+
+        Batch current;
+        std::deque<Batch> inFlight;
+    };
+
+} // namespace Dog
@@ -0,0 +1,138 @@
+#include <PCH/pch.h>
+#include "BindlessTextureTable.h"
+
+namespace Dog {
+
+    BindlessTextureTable::BindlessTextureTable(Device& device, uint32_t framesInFlight)
+        : device{ device }
+        , framesInFlight{ framesInFlight } {
+        // The array's upper bound counts against the update-after-bind limits whether it's used or not
+        VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+        vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &vulkan12Properties;
+        vkGetPhysicalDeviceProperties2(device.getPhysicalDevice(), &properties2);
+
+        maxCapacity = std::min({
+            static_cast<uint32_t>(MAX_TEXTURE_COUNT),
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+            vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+        setLayout =
+            DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, maxCapacity,
+                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT)
+            .build();
+
+        allocateSet(std::min(static_cast<uint32_t>(INITIAL_TEXTURE_CAPACITY), maxCapacity));
+    }
+
+    BindlessTextureTable::~BindlessTextureTable() {
+        // Pools destroy their sets
+        retiredSets.clear();
+        pool.reset();
+    }
+
+    uint32_t BindlessTextureTable::add(VkImageView imageView, VkSampler sampler) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            if (slots.size() >= maxCapacity) {
+                throw std::runtime_error("Texture count exceeded maximum");
+            }
+            slot = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[slot].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        slots[slot].imageView = imageView;
+        slots[slot].sampler = sampler;
+        pendingWrites.push_back(slot);
+        return slot;
+    }
+
+    void BindlessTextureTable::remove(uint32_t slot) {
+        assert(slot < slots.size() && slots[slot].imageView != VK_NULL_HANDLE && "Slot is not in use");
+
+        // Partially bound, so the stale descriptor can stay until the slot is reused
+        slots[slot] = {};
+        freeSlots.push_back(slot);
+    }
+
+    void BindlessTextureTable::update() {
+        ++frame;
+
+        if (slots.size() > capacity) {
+            // Doubling keeps growing rare, the new set gets every slot written
+            uint32_t newCapacity = capacity;
+            while (newCapacity < slots.size()) {
+                newCapacity *= 2;
+            }
+            retiredSets.push_back({ std::move(pool), frame });
+            allocateSet(std::min(newCapacity, maxCapacity));
+
+            pendingWrites.clear();
+            for (uint32_t slot = 0; slot < slots.size(); ++slot) {
+                pendingWrites.push_back(slot);
+            }
+        }
+
+        writeSlots(pendingWrites);
+        pendingWrites.clear();
+
+        // A set replaced at frame N was last bound in frame N - 1, whose fence has been waited on
+        // by the time frame N + framesInFlight begins
+        std::erase_if(retiredSets, [this](const RetiredSet& retired) {
+            return frame >= retired.frame + framesInFlight;
+        });
+    }
+
+    void BindlessTextureTable::allocateSet(uint32_t newCapacity) {
+        pool =
+            DescriptorPool::Builder(device)
+            .setMaxSets(1)
+            .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, newCapacity)
+            .build();
+
+        if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet, newCapacity)) {
+            throw std::runtime_error("failed to allocate bindless texture set!");
+        }
+        capacity = newCapacity;
+    }
+
+    void BindlessTextureTable::writeSlots(const std::vector<uint32_t>& slotsToWrite) {
+        std::vector<VkWriteDescriptorSet> writes;
+        writes.reserve(slotsToWrite.size());
+
+        for (uint32_t slot : slotsToWrite) {
+            // Removed again before it was ever written
+            if (slots[slot].imageView == VK_NULL_HANDLE) continue;
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = descriptorSet;
+            write.dstBinding = 0;
+            write.dstArrayElement = slot;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.descriptorCount = 1;
+            write.pImageInfo = &slots[slot];
+            writes.push_back(write);
+        }
+
+        if (!writes.empty()) {
+            vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+} // namespace Dog
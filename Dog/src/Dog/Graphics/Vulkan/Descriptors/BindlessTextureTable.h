@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Descriptors.h"
+
+namespace Dog {
+
+    // Every texture in one descriptor set, indexed by slot in the shaders. The set's one binding is an
+    // UPDATE_AFTER_BIND, PARTIALLY_BOUND array with a variable descriptor count:
+    //  - only slots that changed are written, while frames using the set are still in flight
+    //  - freed slots are handed out again
+    //  - when the slots run out a bigger set replaces it, and the old one is destroyed once no frame uses it.
+    //    The layout doesn't change, so pipelines using it are unaffected
+    // A slot stays the same for as long as its texture is loaded, so it can go straight into instance data.
+    // Main thread only
+    class BindlessTextureTable {
+    public:
+        BindlessTextureTable(Device& device, uint32_t framesInFlight);
+        ~BindlessTextureTable();
+
+        BindlessTextureTable(const BindlessTextureTable&) = delete;
+        BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+
+        // Takes a slot for the texture, a freed one if there is one. Its descriptor is written by the next update
+        uint32_t add(VkImageView imageView, VkSampler sampler);
+
+        // Gives a slot back. No frame in flight may still be reading it
+        void remove(uint32_t slot);
+
+        // Called at the start of each frame, once its fence has been waited on. Grows the set if the slots
+        // outgrew it, writes new slots and destroys sets that were replaced framesInFlight frames ago
+        void update();
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+
+        // Only changes in update
+        VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+
+        uint32_t getCapacity() const { return capacity; }
+        uint32_t getMaxCapacity() const { return maxCapacity; }
+        uint32_t getTextureCount() const { return static_cast<uint32_t>(slots.size() - freeSlots.size()); }
+
+    private:
+        void allocateSet(uint32_t newCapacity);
+        void writeSlots(const std::vector<uint32_t>& slotsToWrite);
+
+        struct RetiredSet {
+            std::unique_ptr<DescriptorPool> pool;
+            uint64_t frame; // When it was replaced
+        };
+
+        Device& device;
+        uint32_t framesInFlight;
+        uint32_t maxCapacity;
+
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        std::unique_ptr<DescriptorPool> pool; // One set per pool, so a replaced set goes with its pool
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t capacity = 0;
+
+        std::vector<VkDescriptorImageInfo> slots; // A free slot has no image view
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint32_t> pendingWrites;
+        std::vector<RetiredSet> retiredSets;
+        uint64_t frame = 0;
+    };
+
+} // namespace Dog
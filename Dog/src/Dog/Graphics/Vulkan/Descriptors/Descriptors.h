@@ -14,16 +14,21 @@ namespace Dog {
                 uint32_t binding,
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
-                uint32_t count = 1);
+                uint32_t count = 1,
+                VkDescriptorBindingFlags bindingFlags = 0);
             std::unique_ptr<DescriptorSetLayout> build() const;
 
         private:
             Device& device;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
         };
 
+        // A binding with UPDATE_AFTER_BIND makes the layout need a pool created with UPDATE_AFTER_BIND
         DescriptorSetLayout(
-            Device& device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            Device& device,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {});
         ~DescriptorSetLayout();
         DescriptorSetLayout(const DescriptorSetLayout&) = delete;
         DescriptorSetLayout& operator=(const DescriptorSetLayout&) = delete;
@@ -65,8 +70,9 @@ namespace Dog {
         DescriptorPool(const DescriptorPool&) = delete;
         DescriptorPool& operator=(const DescriptorPool&) = delete;
 
+        // variableDescriptorCount sizes the layout's VARIABLE_DESCRIPTOR_COUNT binding, if it has one
         bool allocateDescriptor(
-            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const;
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor, uint32_t variableDescriptorCount = 0) const;
 
         void freeDescriptors(std::vector<VkDescriptorSet>& descriptors) const;
 
@@ -5,10 +5,11 @@
 
 namespace Dog {
 
-#define MAX_LIGHTS 10
+	class Buffer;
 
+	// One entry of the point light buffer, see LightClusterSystem
 	struct PointLight {
-		glm::vec4 position{};  // ignore w
+		glm::vec4 position{};  // w is the radius
 		glm::vec4 color{};     // w is intensity
 	};
 
@@ -16,13 +17,21 @@ namespace Dog {
 		glm::mat4 projection{ 1.f };
 		glm::mat4 view{ 1.f };
 		glm::mat4 inverseView{ 1.f };
-		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .2f };  // w is intensity
-		PointLight pointLights[MAX_LIGHTS];
-		int numLights;
+		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .2f };  // w is intensity, point lights add on top of it
+		glm::vec4 viewport{ 0.f };     // xy is the size in pixels
+		glm::vec4 clusterDepth{ 0.f }; // log(view depth) * x + y is a fragment's cluster slice
+		glm::uvec4 clusterGrid{ 0 };   // xyz is the cluster count along each axis, w the point light count
 	};
 
-	struct BonesUbo {
-		glm::mat4 finalBonesMatrices[MAX_BONES];
+	// Per-instance data read by gl_InstanceIndex, padded to match std430
+	struct InstanceData {
+		glm::mat4 modelMatrix{ 1.f };
+		glm::mat4 normalMatrix{ 1.f };
+		glm::vec4 positionDecode{ 0.f, 0.f, 0.f, 1.f }; // The mesh's packed vertex transforms, see VertexLayout.h
+		glm::vec4 uvDecode{ 0.f, 0.f, 1.f, 1.f };
+		int textureIndex{ 0 };
+		uint32_t drawIndex{ 0 }; // Draw group this instance belongs to, used by the cull pass
+		int padding[2]{};
 	};
 
 	struct FrameInfo {
@@ -32,6 +41,7 @@ namespace Dog {
 		Camera& camera;
 		VkDescriptorSet globalDescriptorSet;
 		GameObject::Map& gameObjects;
+		Buffer& instanceBuffer;
 	};
 
 } // namespace Dog
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Mesh.h"
+
+namespace Dog {
+
+    // Dog's own model format, written by Model::cook and read through a memory mapping.
+    // Everything a model needs at load time is stored ready to use, so loading is a header
+    // check, a few table reads and a memcpy per stream into the staging ring:
+    //
+    //   CookedModelHeader
+    //   CookedMesh[meshCount]
+    //   CookedBone[boneCount]
+    //   each mesh's vertex stream and skin stream, encoded in its packed
+    //   VertexLayout, every stream 16 byte aligned                      (vertexDataOffset)
+    //   each mesh's indices, as uint16_t when its vertices allow it,
+    //   otherwise uint32_t, every LOD back to back, every stream
+    //   4 byte aligned                                                  (indexDataOffset)
+    //   blob: bone names, texture paths and embedded texture images     (blobOffset)
+    //
+    // Offsets are from the start of the file; vertex and skin stream offsets are relative to
+    // vertexDataOffset, index stream offsets to indexDataOffset and blob references to blobOffset. Files from another version are rejected and recooked.
+
+    static constexpr uint32_t COOKED_MODEL_MAGIC = 0x48534D44; // "DMSH"
+    static constexpr uint32_t COOKED_MODEL_VERSION = 4;
+
+    struct CookedModelHeader {
+        uint32_t magic = COOKED_MODEL_MAGIC;
+        uint32_t version = COOKED_MODEL_VERSION;
+        uint32_t meshCount = 0;
+        uint32_t boneCount = 0;
+        uint32_t boneCounter = 0;
+        uint32_t padding = 0;
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        uint64_t vertexDataOffset = 0;
+        uint64_t vertexDataSize = 0;
+        uint64_t indexDataOffset = 0;
+        uint64_t indexDataSize = 0;
+        uint64_t blobOffset = 0;
+        uint64_t blobSize = 0;
+    };
+
+    // A string or byte range in the blob, empty when size is 0
+    struct CookedBlobRef {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    struct CookedMesh {
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t layout = 0;
+        uint32_t indexSize = 0;          // Bytes per index, 2 or 4
+        uint64_t vertexStreamOffset = 0;
+        uint64_t skinStreamOffset = 0;   // Skinned layouts only
+        uint64_t indexStreamOffset = 0;
+        uint32_t lodCount = 0;
+        uint32_t lodPadding = 0;
+        MeshLod lods[Mesh::MAX_LODS]{};  // Index ranges within the mesh's index stream
+        glm::vec4 aabbMin{ 0.f };        // w unused, keeps the struct free of padding
+        glm::vec4 aabbMax{ 0.f };
+        glm::vec4 boundingSphere{ 0.f };
+        glm::vec4 positionDecode{ 0.f };
+        glm::vec4 uvDecode{ 0.f };
+        CookedBlobRef texturePath;       // Diffuse texture file
+        CookedBlobRef embeddedTexture;   // Or a compressed image stored in the model
+    };
+
+    struct CookedBone {
+        CookedBlobRef name;
+        int32_t id = 0;
+        int32_t padding[3]{};
+        glm::mat4 offset{ 1.f };
+    };
+
+    static_assert(std::is_trivially_copyable_v<CookedModelHeader> && std::is_trivially_copyable_v<CookedMesh> && std::is_trivially_copyable_v<CookedBone>,
+        "Cooked model structs are written and read as raw bytes");
+
+} // namespace Dog
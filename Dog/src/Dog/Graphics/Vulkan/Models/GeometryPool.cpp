@@ -0,0 +1,262 @@
+#include <PCH/pch.h>
+#include "GeometryPool.h"
+#include "Mesh.h"
+#include "../Core/UploadManager.h"
+
+namespace Dog {
+
+    static constexpr VkBufferUsageFlags VERTEX_POOL_USAGE =
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    static constexpr VkBufferUsageFlags INDEX_POOL_USAGE =
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    // The type of each index arena, in order
+    static constexpr VkIndexType INDEX_ARENA_TYPES[] = { VK_INDEX_TYPE_UINT32, VK_INDEX_TYPE_UINT16 };
+
+    static VkDeviceSize align16(VkDeviceSize size) {
+        return (size + 15) & ~VkDeviceSize(15);
+    }
+
+    GeometryPool::GeometryPool(Device& device, bool quantizeVertices)
+        : device{ device }
+        , quantizeVertices{ quantizeVertices }
+    {
+        for (VkIndexType indexType : INDEX_ARENA_TYPES) {
+            IndexArena& arena = getIndexArena(indexType);
+            reserve(arena.buffer, arena.capacity, 0, INITIAL_INDEX_CAPACITY, getIndexSize(indexType), INDEX_POOL_USAGE);
+        }
+    }
+
+    GeometryPool::~GeometryPool() {
+        // Pending uploads still write into the pool
+        device.getUploadManager().flush();
+    }
+
+    VkIndexType GeometryPool::getIndexType(uint32_t vertexCount) {
+        return vertexCount <= (1u << 16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
+    void GeometryPool::uploadMeshes(std::vector<Mesh>& meshes) {
+        for (Mesh& mesh : meshes) {
+            assert(mesh.vertices.size() >= 3 && "Vertex count must be at least 3");
+
+            // Everything in the pool is drawn indexed, so unindexed meshes get a trivial index list
+            if (mesh.indices.empty()) {
+                mesh.indices.resize(mesh.vertices.size());
+                std::iota(mesh.indices.begin(), mesh.indices.end(), 0u);
+            }
+
+            VertexEncoding encoding = chooseVertexEncoding(mesh.vertices, mesh.aabbMin, mesh.aabbMax, quantizeVertices);
+            mesh.layout = encoding.layout;
+            mesh.positionDecode = encoding.positionDecode;
+            mesh.uvDecode = encoding.uvDecode;
+            mesh.indexType = getIndexType(static_cast<uint32_t>(mesh.vertices.size()));
+            mesh.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            mesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+            if (mesh.lodCount <= 1) {
+                mesh.lodCount = 1;
+                mesh.lods[0] = { 0, mesh.indexCount };
+            }
+        }
+
+        uploadStreams(meshes, [&meshes](size_t i, void* vertices, void* skin, void* indices) {
+            const Mesh& mesh = meshes[i];
+            encodeVertices(mesh.vertices, { mesh.layout, mesh.positionDecode, mesh.uvDecode }, vertices, skin);
+            if (mesh.indexType == VK_INDEX_TYPE_UINT16) {
+                std::copy(mesh.indices.begin(), mesh.indices.end(), static_cast<uint16_t*>(indices));
+            }
+            else {
+                memcpy(indices, mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+            }
+        });
+    }
+
+    void GeometryPool::uploadPacked(std::vector<Mesh>& meshes, const std::vector<PackedMeshData>& data) {
+        assert(data.size() == meshes.size() && "Every mesh needs its packed data");
+
+        // Already encoded, so each stream is a straight copy
+        uploadStreams(meshes, [&meshes, &data](size_t i, void* vertices, void* skin, void* indices) {
+            const Mesh& mesh = meshes[i];
+            memcpy(vertices, data[i].vertices, getVertexStride(mesh.layout) * static_cast<size_t>(mesh.vertexCount));
+            if (skin) {
+                memcpy(skin, data[i].skin, getSkinStride(mesh.layout) * static_cast<size_t>(mesh.vertexCount));
+            }
+            memcpy(indices, data[i].indices, getIndexSize(mesh.indexType) * static_cast<size_t>(mesh.indexCount));
+        });
+    }
+
+    void GeometryPool::uploadStreams(std::vector<Mesh>& meshes, const std::function<void(size_t, void*, void*, void*)>& writeMesh) {
+        std::array<uint32_t, 2> newIndexCounts{}; // Per index arena
+        VkDeviceSize streamBytes = 0;
+
+        for (const Mesh& mesh : meshes) {
+            newIndexCounts[mesh.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0] += mesh.indexCount;
+            streamBytes += align16(getVertexStride(mesh.layout) * static_cast<VkDeviceSize>(mesh.vertexCount));
+            streamBytes += align16(getSkinStride(mesh.layout) * static_cast<VkDeviceSize>(mesh.vertexCount));
+        }
+
+        if (streamBytes == 0) return;
+
+        // Growing a buffer records a copy of its contents, which has to come before the copies below
+        std::array<uint32_t, 2> firstNewIndices{};
+        for (size_t i = 0; i < indexArenas.size(); ++i) {
+            IndexArena& arena = indexArenas[i];
+            firstNewIndices[i] = arena.count;
+            reserve(arena.buffer, arena.capacity, arena.count, arena.count + newIndexCounts[i], getIndexSize(INDEX_ARENA_TYPES[i]), INDEX_POOL_USAGE);
+        }
+        for (Mesh& mesh : meshes) {
+            IndexArena& indexArena = getIndexArena(mesh.indexType);
+            mesh.vertexOffset = allocateVertices(mesh.layout, mesh.vertexCount);
+            mesh.firstIndex = indexArena.count;
+            indexArena.count += mesh.indexCount;
+        }
+
+        // Each mesh's streams, then every mesh's 32 bit indices, then every 16 bit index, staged in one allocation
+        const VkDeviceSize indexBytes32 = sizeof(uint32_t) * static_cast<VkDeviceSize>(newIndexCounts[0]);
+        const VkDeviceSize indexBytes16 = sizeof(uint16_t) * static_cast<VkDeviceSize>(newIndexCounts[1]);
+        const std::array<VkDeviceSize, 2> indexRegionOffsets = { streamBytes, streamBytes + indexBytes32 };
+
+        UploadManager& uploads = device.getUploadManager();
+        StagingAllocation staging = uploads.stage(streamBytes + indexBytes32 + indexBytes16);
+        char* stagingData = static_cast<char*>(staging.data);
+
+        VkDeviceSize streamWriteOffset = 0;
+        std::array<VkDeviceSize, 2> indexWriteOffsets = indexRegionOffsets;
+
+        // Drawn from the next submitted frame on, which waits for the copies
+        VkCommandBuffer commandBuffer = uploads.getTransferCommandBuffer();
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const Mesh& mesh = meshes[i];
+            const VertexArena& arena = arenas[mesh.layout];
+            VkDeviceSize vertexStride = getVertexStride(mesh.layout);
+            VkDeviceSize skinStride = getSkinStride(mesh.layout);
+
+            VkDeviceSize vertexWriteOffset = streamWriteOffset;
+            streamWriteOffset += align16(vertexStride * mesh.vertexCount);
+            VkDeviceSize skinWriteOffset = streamWriteOffset;
+            streamWriteOffset += align16(skinStride * mesh.vertexCount);
+
+            size_t indexArena = mesh.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+            writeMesh(
+                i,
+                stagingData + vertexWriteOffset,
+                skinStride > 0 ? stagingData + skinWriteOffset : nullptr,
+                stagingData + indexWriteOffsets[indexArena]);
+            indexWriteOffsets[indexArena] += getIndexSize(mesh.indexType) * static_cast<VkDeviceSize>(mesh.indexCount);
+
+            VkBufferCopy region{};
+            region.srcOffset = staging.offset + vertexWriteOffset;
+            region.dstOffset = vertexStride * mesh.vertexOffset;
+            region.size = vertexStride * mesh.vertexCount;
+            vkCmdCopyBuffer(commandBuffer, staging.buffer, arena.vertexBuffer->getBuffer(), 1, &region);
+
+            if (skinStride > 0) {
+                region.srcOffset = staging.offset + skinWriteOffset;
+                region.dstOffset = skinStride * mesh.vertexOffset;
+                region.size = skinStride * mesh.vertexCount;
+                vkCmdCopyBuffer(commandBuffer, staging.buffer, arena.skinBuffer->getBuffer(), 1, &region);
+            }
+        }
+
+        for (size_t i = 0; i < indexArenas.size(); ++i) {
+            VkDeviceSize indexSize = getIndexSize(INDEX_ARENA_TYPES[i]);
+
+            VkBufferCopy indexRegion{};
+            indexRegion.srcOffset = staging.offset + indexRegionOffsets[i];
+            indexRegion.dstOffset = indexSize * firstNewIndices[i];
+            indexRegion.size = indexSize * newIndexCounts[i];
+            if (indexRegion.size > 0) {
+                vkCmdCopyBuffer(commandBuffer, staging.buffer, indexArenas[i].buffer->getBuffer(), 1, &indexRegion);
+            }
+        }
+    }
+
+    int32_t GeometryPool::allocateVertices(VertexLayout layout, uint32_t vertexCount) {
+        VertexArena& arena = arenas[layout];
+
+        // Arenas start at the initial capacity, so a layout's first small mesh doesn't cause a string of regrows
+        uint32_t required = std::max(arena.count + vertexCount, arena.vertexBuffer ? 0u : INITIAL_VERTEX_CAPACITY);
+        reserve(arena.vertexBuffer, arena.vertexCapacity, arena.count, required, getVertexStride(layout), VERTEX_POOL_USAGE);
+        if (layout & VERTEX_LAYOUT_SKINNED) {
+            reserve(arena.skinBuffer, arena.skinCapacity, arena.count, required, getSkinStride(layout), VERTEX_POOL_USAGE);
+        }
+
+        int32_t vertexOffset = static_cast<int32_t>(arena.count);
+        arena.count += vertexCount;
+        return vertexOffset;
+    }
+
+    void GeometryPool::bind(DrawStateCache& state, VertexLayout layout, VkIndexType indexType) {
+        const VertexArena& arena = arenas[layout];
+        assert(arena.vertexBuffer && "No mesh of this layout has been uploaded");
+
+        VkBuffer buffers[] = { arena.vertexBuffer->getBuffer(), arena.skinBuffer ? arena.skinBuffer->getBuffer() : VK_NULL_HANDLE };
+        state.bindVertexBuffers(arena.skinBuffer ? 2 : 1, buffers);
+        bindIndices(state, indexType);
+    }
+
+    void GeometryPool::bindIndices(DrawStateCache& state, VkIndexType indexType) {
+        state.bindIndexBuffer(getIndexArena(indexType).buffer->getBuffer(), indexType);
+    }
+
+    uint32_t GeometryPool::getVertexCount() const {
+        uint32_t vertexCount = 0;
+        for (const VertexArena& arena : arenas) {
+            vertexCount += arena.count;
+        }
+        return vertexCount;
+    }
+
+    VkDeviceSize GeometryPool::getVertexBytes() const {
+        VkDeviceSize bytes = 0;
+        for (VertexLayout layout = 0; layout < VERTEX_LAYOUT_COUNT; ++layout) {
+            bytes += static_cast<VkDeviceSize>(arenas[layout].count) * (getVertexStride(layout) + getSkinStride(layout));
+        }
+        return bytes;
+    }
+
+    VkDeviceSize GeometryPool::getIndexBytes() const {
+        return sizeof(uint32_t) * static_cast<VkDeviceSize>(indexArenas[0].count) +
+               sizeof(uint16_t) * static_cast<VkDeviceSize>(indexArenas[1].count);
+    }
+
+    void GeometryPool::reserve(
+        std::unique_ptr<Buffer>& buffer,
+        uint32_t& capacity,
+        uint32_t used,
+        uint32_t required,
+        VkDeviceSize elementSize,
+        VkBufferUsageFlags usage)
+    {
+        if (buffer && required <= capacity) {
+            return;
+        }
+
+        uint32_t newCapacity = std::max(capacity * 2, required);
+        auto newBuffer = std::make_unique<Buffer>(
+            device,
+            elementSize,
+            newCapacity,
+            usage,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+        UploadManager& uploads = device.getUploadManager();
+        if (buffer && used > 0) {
+            uploads.copyBuffer(buffer->getBuffer(), newBuffer->getBuffer(), elementSize * used);
+        }
+
+        // Frames in flight may still reference the old buffer, and the copy above reads it
+        if (buffer) {
+            vkDeviceWaitIdle(device);
+            uploads.releaseAfterUpload(std::move(buffer));
+        }
+
+        buffer = std::move(newBuffer);
+        capacity = newCapacity;
+    }
+
+} // namespace Dog
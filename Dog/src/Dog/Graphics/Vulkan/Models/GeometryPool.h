@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../Buffers/Buffer.h"
+#include "../Core/Device.h"
+#include "../Core/DrawStateCache.h"
+#include "VertexLayout.h"
+
+namespace Dog {
+
+    class Mesh;
+
+    // Vertices and indices of one mesh, already encoded in the mesh's layout (cooked models)
+    struct PackedMeshData {
+        const void* vertices = nullptr;
+        const void* skin = nullptr; // Skinned layouts only
+        const void* indices = nullptr; // In the mesh's index type
+    };
+
+    // Every mesh's geometry, so draws never rebind buffers between meshes. Each vertex layout has an arena
+    // of its own (a vertex buffer, plus a skin buffer for skinned layouts) created when the first mesh of that
+    // layout arrives. Indices live in one of two buffers, 16 bit for meshes with at most 65536 vertices and
+    // 32 bit for the rest. Meshes are bump allocated and never freed, and buffers double in size when they run out.
+    class GeometryPool {
+    public:
+        static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 1 << 18;
+        static constexpr uint32_t INITIAL_INDEX_CAPACITY = 1 << 20;
+
+        // quantizeVertices picks packed layouts for uploaded meshes, otherwise they keep full precision floats
+        GeometryPool(Device& device, bool quantizeVertices = true);
+        ~GeometryPool();
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        // The narrowest index type that can address every vertex of a mesh
+        static VkIndexType getIndexType(uint32_t vertexCount);
+        static uint32_t getIndexSize(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4; }
+
+        // Picks each mesh's layout and index type, encodes its vertices and indices into one staging allocation and stores
+        // its offsets. The copies are submitted with the next frame
+        void uploadMeshes(std::vector<Mesh>& meshes);
+
+        // Same, for meshes that come encoded already. Their counts, layout, index type and decode transforms must be set
+        void uploadPacked(std::vector<Mesh>& meshes, const std::vector<PackedMeshData>& data);
+
+        // Binds the layout's vertex streams and the index buffer of the given type, skipping whichever are bound already
+        void bind(DrawStateCache& state, VertexLayout layout, VkIndexType indexType);
+
+        // Binds only the index buffer, for vertices that come from elsewhere (skinned copies)
+        void bindIndices(DrawStateCache& state, VkIndexType indexType);
+
+        // A layout's streams, for passes that read vertices as storage buffers. Null until the layout's first mesh,
+        // and replaced when the arena grows
+        Buffer* getVertexBuffer(VertexLayout layout) const { return arenas[layout].vertexBuffer.get(); }
+        Buffer* getSkinBuffer(VertexLayout layout) const { return arenas[layout].skinBuffer.get(); }
+
+        bool isQuantizing() const { return quantizeVertices; }
+
+        uint32_t getVertexCount() const;
+        uint32_t getIndexCount() const { return indexArenas[0].count + indexArenas[1].count; }
+
+        // Bytes in use, not the capacity of the buffers
+        VkDeviceSize getVertexBytes() const;
+        VkDeviceSize getIndexBytes() const;
+
+    private:
+        struct VertexArena {
+            std::unique_ptr<Buffer> vertexBuffer;
+            std::unique_ptr<Buffer> skinBuffer;
+            uint32_t vertexCapacity = 0;
+            uint32_t skinCapacity = 0;
+            uint32_t count = 0;
+        };
+
+        struct IndexArena {
+            std::unique_ptr<Buffer> buffer;
+            uint32_t capacity = 0;
+            uint32_t count = 0;
+        };
+
+        IndexArena& getIndexArena(VkIndexType indexType) { return indexArenas[indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0]; }
+
+        // Reserves every mesh's vertices and indices, then has writeMesh(meshIndex, vertices, skin, indices)
+        // fill in its staging memory and records the copies. skin is null for layouts without one
+        void uploadStreams(std::vector<Mesh>& meshes, const std::function<void(size_t, void*, void*, void*)>& writeMesh);
+
+        // Adds a mesh's vertices to its arena and records where they go, returns the mesh's vertex offset
+        int32_t allocateVertices(VertexLayout layout, uint32_t vertexCount);
+
+        void reserve(
+            std::unique_ptr<Buffer>& buffer,
+            uint32_t& capacity,
+            uint32_t used,
+            uint32_t required,
+            VkDeviceSize elementSize,
+            VkBufferUsageFlags usage);
+
+        Device& device;
+        bool quantizeVertices;
+
+        std::array<VertexArena, VERTEX_LAYOUT_COUNT> arenas;
+        std::array<IndexArena, 2> indexArenas; // 32 bit, then 16 bit
+    };
+
+} // namespace Dog
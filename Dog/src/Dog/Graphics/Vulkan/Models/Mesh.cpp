@@ -7,103 +7,126 @@
 
 namespace Dog {
 
-    void Mesh::createVertexBuffers(Device& device) {
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
-
-        Buffer stagingBuffer{
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)vertices.data());
-
-        vertexBuffer = std::make_unique<Buffer>(
-            device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
-
-        device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+    // LOD n aims for half the triangles of LOD n - 1 and may move the surface by at most this much relative to
+    // the mesh's size, doubling every level. Screen size thresholds halve every level, so the error stays
+    // about the same number of pixels whichever level is drawn
+    static constexpr float LOD_BASE_ERROR = 0.01f;
+
+    // Chains stop below this many triangles, or once a level can't get under this fraction of the last
+    static constexpr uint32_t LOD_MIN_TRIANGLES = 64;
+    static constexpr float LOD_MIN_REDUCTION = 0.8f;
+
+    void Mesh::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) {
+        const MeshLod& meshLod = lods[lod];
+        vkCmdDrawIndexed(commandBuffer, meshLod.indexCount, instanceCount, firstIndex + meshLod.firstIndex, vertexOffset, firstInstance);
     }
 
-    void Mesh::createIndexBuffers(Device& device) {
-        indexCount = static_cast<uint32_t>(indices.size());
-        hasIndexBuffer = indexCount > 0;
-
-        if (!hasIndexBuffer) {
+    void Mesh::computeBounds() {
+        if (vertices.empty()) {
+            aabbMin = aabbMax = glm::vec3(0.f);
+            boundingSphere = glm::vec4(0.f);
             return;
         }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
+        aabbMin = aabbMax = vertices[0].position;
+        for (const Vertex& vertex : vertices) {
+            aabbMin = glm::min(aabbMin, vertex.position);
+            aabbMax = glm::max(aabbMax, vertex.position);
+        }
 
-        Buffer stagingBuffer{
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY,
-        };
+        // Centered on the box, but sized to the farthest vertex so it's tighter than the box's corners
+        glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+        float radiusSquared = 0.f;
+        for (const Vertex& vertex : vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+
+        boundingSphere = glm::vec4(center, std::sqrt(radiusSquared));
+    }
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)indices.data());
+    void Mesh::optimize() {
+        // Only triangle lists can be reordered
+        if (indices.empty() || indices.size() % 3 != 0) return;
 
-        indexBuffer = std::make_unique<Buffer>(
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+        uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        cacheStatsBefore = analyzeVertexCache(indices, vertexCount);
 
-        device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        optimizeVertexCache(indices, vertexCount);
+        optimizeOverdraw(indices, vertices);
+        optimizeVertexFetch(vertices, indices);
+
+        cacheStatsAfter = analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
     }
 
+    void Mesh::generateLods() {
+        lodCount = 1;
+        lods[0] = { 0, static_cast<uint32_t>(indices.size()) };
+        if (indices.empty() || indices.size() % 3 != 0) return;
 
-    void Mesh::bind(VkCommandBuffer commandBuffer) {
-        VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        const size_t baseIndexCount = indices.size();
 
-        if (hasIndexBuffer) {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        }
-    }
+        // Each level simplifies the one before, which is much cheaper than starting over from the full mesh
+        std::vector<uint32_t> previous(indices);
+        for (uint32_t level = 1; level < MAX_LODS; ++level) {
+            size_t targetIndexCount = (baseIndexCount >> level) / 3 * 3;
+            if (targetIndexCount < LOD_MIN_TRIANGLES * 3) break;
 
-    void Mesh::draw(VkCommandBuffer commandBuffer) {
-        if (hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-        }
-        else {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            float targetError = LOD_BASE_ERROR * static_cast<float>(1u << (level - 1));
+            std::vector<uint32_t> lodIndices = simplifyMesh(vertices, previous, targetIndexCount, targetError);
+            if (static_cast<float>(lodIndices.size()) > static_cast<float>(previous.size()) * LOD_MIN_REDUCTION) break;
+
+            optimizeVertexCache(lodIndices, vertexCount);
+
+            lods[level] = { static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()) };
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+            lodCount++;
+
+            previous = std::move(lodIndices);
         }
     }
 
-    std::vector<VkVertexInputBindingDescription> Vertex::getBindingDescriptions() {
-        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-        bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Vertex);
-        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    std::vector<VkVertexInputBindingDescription> Vertex::getBindingDescriptions(VertexLayout layout) {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        bindingDescriptions.push_back({ 0, getVertexStride(layout), VK_VERTEX_INPUT_RATE_VERTEX });
+        if (layout & VERTEX_LAYOUT_SKINNED) {
+            bindingDescriptions.push_back({ 1, getSkinStride(layout), VK_VERTEX_INPUT_RATE_VERTEX });
+        }
         return bindingDescriptions;
     }
 
-    std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions() {
+    // Locations match simple_shader.vert: 0 position, 1 color, 2 normal, 3 uv. Skinned layouts add 4 bone ids and
+    // 5 weights, though they're only drawn through their skinned copies (see SkinningSystem)
+    std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions(VertexLayout layout) {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+        bool hasColor = layout & VERTEX_LAYOUT_COLOR;
+        bool isSkinned = layout & VERTEX_LAYOUT_SKINNED;
+
+        if (layout & VERTEX_LAYOUT_FLOAT) {
+            attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FloatVertex, position) });
+            attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(FloatVertex, normal) });
+            attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(FloatVertex, uv) });
+            if (hasColor) {
+                attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, sizeof(FloatVertex) });
+            }
+            if (isSkinned) {
+                attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R32G32B32A32_SINT, offsetof(FloatSkin, boneIds) });
+                attributeDescriptions.push_back({ 5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(FloatSkin, weights) });
+            }
+            return attributeDescriptions;
+        }
 
-        attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) });
-        attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) });
-        attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
-        attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
-
-        attributeDescriptions.push_back({ 4, 0, VK_FORMAT_R32G32B32A32_SINT, offsetof(Vertex, mBoneIDs) });
-        attributeDescriptions.push_back({ 5, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, mWeights) });
+        attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(PackedVertex, position) });
+        attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal) });
+        attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_UNORM, offsetof(PackedVertex, uv) });
+        if (hasColor) {
+            attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, sizeof(PackedVertex) });
+        }
+        if (isSkinned) {
+            attributeDescriptions.push_back({ 4, 1, VK_FORMAT_R8G8B8A8_UINT, offsetof(PackedSkin, boneIds) });
+            attributeDescriptions.push_back({ 5, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedSkin, weights) });
+        }
 
         return attributeDescriptions;
     }
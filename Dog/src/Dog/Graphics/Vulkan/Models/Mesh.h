@@ -2,11 +2,14 @@
 
 #include "../Buffers/Buffer.h"
 #include "../Core/Device.h"
+#include "VertexLayout.h"
+#include "MeshOptimizer.h"
 
 namespace Dog {
 
     struct MaterialComponent;
 
+    // A vertex as imported. Meshes are stored in the GeometryPool in their VertexLayout instead
     struct Vertex {
         glm::vec3 position{};
         glm::vec3 color{};
@@ -16,30 +19,72 @@ namespace Dog {
         int mBoneIDs[MAX_BONE_INFLUENCE];
         float mWeights[MAX_BONE_INFLUENCE];
 
-        static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        // Vertex input state for reading a layout from the pool: binding 0 holds the vertex stream and
+        // binding 1 the skin stream of skinned layouts
+        static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VertexLayout layout);
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexLayout layout);
+    };
+
+    // One level of detail: a range of the mesh's indices over the same vertices. LOD 0 is the full mesh
+    struct MeshLod {
+        uint32_t firstIndex = 0; // Relative to the mesh's first index
+        uint32_t indexCount = 0;
     };
 
     class Mesh {
     public:
+        static constexpr uint32_t MAX_LODS = 5;
+
         Mesh() = default;
 
-        void createVertexBuffers(Device& device);
-        void createIndexBuffers(Device& device);
-        void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        // Geometry lives in the GeometryPool, which must be bound before drawing
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+
+        // Fills in the local space bounds below from the vertices
+        void computeBounds();
+
+        // Reorders the triangles for the vertex cache and overdraw, then the vertices for fetch order,
+        // and records the cache stats before and after
+        void optimize();
 
-        std::unique_ptr<Buffer> vertexBuffer;
+        // Appends simplified copies of the triangles to the indices, each about half the last, until MAX_LODS
+        // levels exist or simplifying stops paying off. Must run after optimize, which may drop vertices
+        void generateLods();
+
+        uint32_t getTriangleCount(uint32_t lod = 0) const { return lods[lod].indexCount / 3; }
+
+        // Location of this mesh in the GeometryPool, filled in by GeometryPool::uploadMeshes.
+        // Cooked meshes come with their counts and encoding set and no vertex or index vectors.
+        // vertexOffset counts vertices in the arena of the mesh's layout
         uint32_t vertexCount = 0;
+        int32_t vertexOffset = 0;
+        uint32_t indexCount = 0; // Every LOD's indices
+        uint32_t firstIndex = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32; // 16 bit when the vertex count allows, set on upload
 
-        bool hasIndexBuffer = false;
-        std::unique_ptr<Buffer> indexBuffer;
-        uint32_t indexCount = 0;
+        // How the vertices are stored, chosen by the pool on upload. The decode transforms go to the
+        // vertex shader with every instance
+        VertexLayout layout = 0;
+        glm::vec4 positionDecode{ 0.f, 0.f, 0.f, 1.f };
+        glm::vec4 uvDecode{ 0.f, 0.f, 1.f, 1.f };
 
         std::vector<Vertex> vertices{};
         std::vector<uint32_t> indices{};
 
+        // Meshes without a LOD chain have one level, set to the whole index range on upload
+        std::array<MeshLod, MAX_LODS> lods{};
+        uint32_t lodCount = 1;
+
         uint32_t textureIndex = INVALID_TEXTURE_INDEX;
+
+        // Local space bounds (bind pose for skinned meshes), used for culling
+        glm::vec3 aabbMin{ 0.f };
+        glm::vec3 aabbMax{ 0.f };
+        glm::vec4 boundingSphere{ 0.f }; // xyz is the center, w is the radius
+
+        // Filled in by optimize, zero for meshes that weren't imported this run
+        VertexCacheStats cacheStatsBefore{};
+        VertexCacheStats cacheStatsAfter{};
         
         // MaterialComponent materialComponent{};
     };
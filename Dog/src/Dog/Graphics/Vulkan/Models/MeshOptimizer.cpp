@@ -0,0 +1,609 @@
+#include <PCH/pch.h>
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+
+namespace Dog {
+
+    // FIFO cache simulation. A vertex is cached while fewer than cacheSize misses have happened since it was
+    // last loaded, so resetting is just moving time past every timestamp
+    class FifoCache {
+    public:
+        FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+            : timestamps(vertexCount, 0)
+            , cacheSize{ cacheSize }
+            , time{ cacheSize + 1 } {}
+
+        // Returns whether the vertex had to be transformed
+        bool access(uint32_t vertex) {
+            if (time - timestamps[vertex] <= cacheSize) return false;
+            timestamps[vertex] = time++;
+            return true;
+        }
+
+        uint32_t accessTriangle(const uint32_t* triangle) {
+            return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+        }
+
+        void reset() { time += cacheSize + 1; }
+
+    private:
+        std::vector<uint32_t> timestamps;
+        uint32_t cacheSize;
+        uint32_t time;
+    };
+
+    VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+        VertexCacheStats stats;
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) return stats;
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> used(vertexCount, false);
+        uint32_t misses = 0;
+        uint32_t usedCount = 0;
+
+        for (uint32_t index : indices) {
+            misses += cache.access(index);
+            if (!used[index]) {
+                used[index] = true;
+                usedCount++;
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(usedCount);
+        return stats;
+    }
+
+    // Tuning from Forsyth's article, for a 32 entry LRU model of the cache
+    static constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+    static constexpr float CACHE_DECAY_POWER = 1.5f;
+    static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+    static float forsythVertexScore(int cachePosition, uint32_t remainingTriangles) {
+        if (remainingTriangles == 0) return -1.f;
+
+        float score = 0.f;
+        if (cachePosition >= 0) {
+            // The last triangle's vertices get a flat score so the next triangle isn't biased to one edge
+            if (cachePosition < 3) {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else {
+                float scale = 1.f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.f - static_cast<float>(cachePosition - 3) * scale, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Vertices with few triangles left are finished off first, so they don't linger
+        score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount == 0) return;
+
+        // Remaining triangles of every vertex, in one array. Emitted triangles are swapped out of each range
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (uint32_t index : indices) {
+            remaining[index]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            for (uint32_t k = 0; k < 3; ++k) {
+                adjacency[fill[indices[t * 3 + k]]++] = t;
+            }
+        }
+
+        std::vector<float> vertexScores(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            vertexScores[v] = forsythVertexScore(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        }
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        uint32_t scanCursor = 0;
+        int64_t bestTriangle = -1;
+
+        for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+            // Nothing in the cache has triangles left, so start again from the first unemitted one
+            if (bestTriangle < 0) {
+                while (emitted[scanCursor]) ++scanCursor;
+                bestTriangle = scanCursor;
+            }
+
+            const uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+            const uint32_t* triangleIndices = &indices[triangle * 3];
+            emitted[triangle] = true;
+
+            newCache.clear();
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = triangleIndices[k];
+                result.push_back(v);
+
+                uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+                uint32_t* end = begin + remaining[v];
+                std::iter_swap(std::find(begin, end, triangle), end - 1);
+                remaining[v]--;
+
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                    newCache.push_back(v);
+                }
+            }
+
+            // The triangle's vertices move to the front, everything else shifts back, past the end is evicted
+            for (uint32_t v : cache) {
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                    newCache.push_back(v);
+                }
+            }
+
+            for (size_t i = 0; i < newCache.size(); ++i) {
+                uint32_t v = newCache[i];
+                int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+                float score = forsythVertexScore(position, remaining[v]);
+                float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+
+                for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v] + remaining[v]; ++j) {
+                    triangleScores[adjacency[j]] += delta;
+                }
+            }
+
+            bestTriangle = -1;
+            float bestScore = -std::numeric_limits<float>::max();
+            newCache.resize(std::min<size_t>(newCache.size(), FORSYTH_CACHE_SIZE));
+
+            for (uint32_t v : newCache) {
+                for (uint32_t j = adjacencyOffsets[v]; j < adjacencyOffsets[v] + remaining[v]; ++j) {
+                    uint32_t candidate = adjacency[j];
+                    if (triangleScores[candidate] > bestScore) {
+                        bestScore = triangleScores[candidate];
+                        bestTriangle = candidate;
+                    }
+                }
+            }
+
+            cache.swap(newCache);
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold) {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2) return;
+
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        FifoCache cache(vertexCount, 16);
+
+        // Hard boundaries: a triangle that misses on every vertex starts over, so cutting there is free
+        std::vector<size_t> hardBoundaries;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (cache.accessTriangle(&indices[t * 3]) == 3) {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        // Soft boundaries: cut a cluster as soon as its running ACMR is within the threshold of the whole
+        // cluster's, which trades a little cache efficiency for smaller clusters to sort
+        std::vector<size_t> clusters;
+        for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+            size_t start = hardBoundaries[h];
+            size_t end = hardBoundaries[h + 1];
+
+            cache.reset();
+            uint32_t clusterMisses = 0;
+            for (size_t t = start; t < end; ++t) {
+                clusterMisses += cache.accessTriangle(&indices[t * 3]);
+            }
+            float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+            cache.reset();
+            clusters.push_back(start);
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+
+            for (size_t t = start; t < end; ++t) {
+                runningMisses += cache.accessTriangle(&indices[t * 3]);
+                runningTriangles++;
+
+                if (t + 1 < end && static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= clusterThreshold) {
+                    clusters.push_back(t + 1);
+                    cache.reset();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // Clusters are ordered by how far out they face from the mesh's center; those in front of it
+        // tend to cover the rest from any view that sees them
+        glm::vec3 meshCentroid(0.f);
+        float meshArea = 0.f;
+
+        struct ClusterKey {
+            size_t cluster;
+            float sortKey;
+        };
+        std::vector<ClusterKey> keys(clusters.size() - 1);
+        std::vector<glm::vec3> clusterCentroids(keys.size(), glm::vec3(0.f));
+        std::vector<glm::vec3> clusterNormals(keys.size(), glm::vec3(0.f));
+        std::vector<float> clusterAreas(keys.size(), 0.f);
+
+        for (size_t c = 0; c < keys.size(); ++c) {
+            for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                const glm::vec3& p0 = vertices[indices[t * 3]].position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                glm::vec3 centroid = (p0 + p1 + p2) / 3.f;
+
+                clusterCentroids[c] += centroid * area;
+                clusterNormals[c] += normal;
+                clusterAreas[c] += area;
+            }
+
+            meshCentroid += clusterCentroids[c];
+            meshArea += clusterAreas[c];
+        }
+
+        if (meshArea > 0.f) meshCentroid /= meshArea;
+
+        for (size_t c = 0; c < keys.size(); ++c) {
+            float normalLength = glm::length(clusterNormals[c]);
+            float sortKey = 0.f;
+            if (clusterAreas[c] > 0.f && normalLength > 0.f) {
+                glm::vec3 centroid = clusterCentroids[c] / clusterAreas[c];
+                sortKey = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+            }
+            keys[c] = { c, sortKey };
+        }
+
+        std::stable_sort(keys.begin(), keys.end(), [](const ClusterKey& a, const ClusterKey& b) { return a.sortKey > b.sortKey; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const ClusterKey& key : keys) {
+            result.insert(result.end(), indices.begin() + clusters[key.cluster] * 3, indices.begin() + clusters[key.cluster + 1] * 3);
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+        std::vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices) {
+            if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices.swap(reordered);
+    }
+
+    // Sum of squared distances to a set of planes, as the 10 unique coefficients of the symmetric 4x4 matrix.
+    // Planes are weighted and evaluate divides by the total weight, so the error is a mean squared distance
+    struct Quadric {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const glm::dvec3& normal, double distance, double planeWeight) {
+            a00 += planeWeight * normal.x * normal.x;
+            a01 += planeWeight * normal.x * normal.y;
+            a02 += planeWeight * normal.x * normal.z;
+            a03 += planeWeight * normal.x * distance;
+            a11 += planeWeight * normal.y * normal.y;
+            a12 += planeWeight * normal.y * normal.z;
+            a13 += planeWeight * normal.y * distance;
+            a22 += planeWeight * normal.z * normal.z;
+            a23 += planeWeight * normal.z * distance;
+            a33 += planeWeight * distance * distance;
+            weight += planeWeight;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+            a11 += other.a11; a12 += other.a12; a13 += other.a13;
+            a22 += other.a22; a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+            return *this;
+        }
+
+        double evaluate(const glm::dvec3& p) const {
+            if (weight <= 0.0) return 0.0;
+            double error =
+                a00 * p.x * p.x + 2.0 * a01 * p.x * p.y + 2.0 * a02 * p.x * p.z + 2.0 * a03 * p.x +
+                a11 * p.y * p.y + 2.0 * a12 * p.y * p.z + 2.0 * a13 * p.y +
+                a22 * p.z * p.z + 2.0 * a23 * p.z +
+                a33;
+            return std::max(error, 0.0) / weight;
+        }
+    };
+
+    // Border planes count for this much more than a triangle of the same size, so borders only move along themselves
+    static constexpr double BORDER_PLANE_WEIGHT = 10.0;
+
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float targetError,
+        float* resultError)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        const size_t triangleCount = indices.size() / 3;
+
+        std::vector<uint32_t> result(indices.begin(), indices.begin() + triangleCount * 3);
+        if (resultError) *resultError = 0.f;
+        if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+        // Vertices that only differ in attributes share a position group, the welded mesh is what gets simplified
+        std::vector<uint32_t> groups(vertexCount);
+        std::vector<uint32_t> groupSizes(vertexCount, 0);
+        {
+            std::unordered_map<glm::vec3, uint32_t> groupByPosition;
+            groupByPosition.reserve(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; ++v) {
+                groups[v] = groupByPosition.try_emplace(vertices[v].position, v).first->second;
+                groupSizes[groups[v]]++;
+            }
+        }
+        auto isSeam = [&](uint32_t v) { return groupSizes[groups[v]] > 1; };
+        auto position = [&](uint32_t v) { return glm::dvec3(vertices[v].position); };
+
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        for (const Vertex& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+        glm::vec3 extent = boundsMax - boundsMin;
+        const double meshScale = std::max({ extent.x, extent.y, extent.z, 1e-6f });
+        const double errorLimit = (static_cast<double>(targetError) * meshScale) * (static_cast<double>(targetError) * meshScale);
+
+        // Quadrics live on the position groups, so every vertex of a group agrees on the error
+        std::vector<Quadric> quadrics(vertexCount);
+        std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(triangleCount * 3);
+
+        auto edgeKey = [](uint32_t a, uint32_t b) { return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b); };
+
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            const uint32_t* triangle = &result[t * 3];
+            for (int k = 0; k < 3; ++k) {
+                vertexTriangles[triangle[k]].push_back(t);
+                uint32_t a = groups[triangle[k]];
+                uint32_t b = groups[triangle[(k + 1) % 3]];
+                if (a != b) edgeUses[edgeKey(a, b)]++;
+            }
+
+            glm::dvec3 p0 = position(triangle[0]);
+            glm::dvec3 normal = glm::cross(position(triangle[1]) - p0, position(triangle[2]) - p0);
+            double length = glm::length(normal);
+            if (length <= 0.0) continue;
+
+            normal /= length;
+            for (int k = 0; k < 3; ++k) {
+                quadrics[groups[triangle[k]]].addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+            }
+        }
+
+        // An edge with one triangle is on an open border, a plane through it perpendicular to the triangle keeps it there
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            const uint32_t* triangle = &result[t * 3];
+            glm::dvec3 p0 = position(triangle[0]);
+            glm::dvec3 faceNormal = glm::cross(position(triangle[1]) - p0, position(triangle[2]) - p0);
+            if (glm::length(faceNormal) <= 0.0) continue;
+
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = groups[triangle[k]];
+                uint32_t b = groups[triangle[(k + 1) % 3]];
+                if (a == b || edgeUses[edgeKey(a, b)] != 1) continue;
+
+                glm::dvec3 pa = position(a);
+                glm::dvec3 edge = position(b) - pa;
+                glm::dvec3 normal = glm::cross(edge, faceNormal);
+                double length = glm::length(normal);
+                if (length <= 0.0) continue;
+
+                normal /= length;
+                double planeWeight = BORDER_PLANE_WEIGHT * glm::dot(edge, edge);
+                quadrics[a].addPlane(normal, -glm::dot(normal, pa), planeWeight);
+                quadrics[b].addPlane(normal, -glm::dot(normal, pa), planeWeight);
+            }
+        }
+
+        // Moving from onto to, the lazy min heap below holds stale entries that are checked when popped
+        struct Collapse {
+            double cost;
+            uint32_t from;
+            uint32_t to;
+            uint32_t version;
+        };
+        auto heapOrder = [](const Collapse& a, const Collapse& b) { return a.cost > b.cost; };
+
+        std::vector<Collapse> heap;
+        std::vector<uint32_t> versions(vertexCount, 0);
+        std::vector<bool> collapsed(vertexCount, false);
+        std::vector<bool> triangleRemoved(triangleCount, false);
+        std::vector<uint32_t> candidates;
+
+        auto collapseCost = [&](uint32_t from, uint32_t to) {
+            Quadric combined = quadrics[groups[from]];
+            combined += quadrics[groups[to]];
+            return combined.evaluate(position(to));
+        };
+
+        auto pushCollapses = [&](uint32_t from) {
+            // Seam vertices have several attribute sets at one position, merging any of them would tear the others
+            if (collapsed[from] || isSeam(from)) return;
+
+            candidates.clear();
+            for (uint32_t t : vertexTriangles[from]) {
+                if (triangleRemoved[t]) continue;
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t to = result[t * 3 + k];
+                    if (groups[to] != groups[from] && std::find(candidates.begin(), candidates.end(), to) == candidates.end()) {
+                        candidates.push_back(to);
+                    }
+                }
+            }
+
+            for (uint32_t to : candidates) {
+                heap.push_back({ collapseCost(from, to), from, to, versions[from] });
+                std::push_heap(heap.begin(), heap.end(), heapOrder);
+            }
+        };
+
+        auto canCollapse = [&](uint32_t from, uint32_t to) {
+            const uint32_t toGroup = groups[to];
+            const glm::dvec3 target = position(to);
+
+            for (uint32_t t : vertexTriangles[from]) {
+                if (triangleRemoved[t]) continue;
+                const uint32_t* triangle = &result[t * 3];
+
+                bool onEdge = groups[triangle[0]] == toGroup || groups[triangle[1]] == toGroup || groups[triangle[2]] == toGroup;
+                if (onEdge) {
+                    // The triangles that disappear must all have used the target's attributes, or the ones left would change
+                    for (int k = 0; k < 3; ++k) {
+                        if (groups[triangle[k]] == toGroup && triangle[k] != to) return false;
+                    }
+                    continue;
+                }
+
+                // The triangles that stay must not flip over
+                glm::dvec3 before[3] = { position(triangle[0]), position(triangle[1]), position(triangle[2]) };
+                glm::dvec3 after[3] = { before[0], before[1], before[2] };
+                for (int k = 0; k < 3; ++k) {
+                    if (triangle[k] == from) after[k] = target;
+                }
+
+                glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                if (glm::dot(normalBefore, normalAfter) <= 0.0) return false;
+            }
+            return true;
+        };
+
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (!vertexTriangles[v].empty()) pushCollapses(v);
+        }
+
+        size_t liveTriangles = triangleCount;
+        double maxError = 0.0;
+        std::vector<uint32_t> neighbors;
+
+        while (liveTriangles * 3 > targetIndexCount && !heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), heapOrder);
+            Collapse collapse = heap.back();
+            heap.pop_back();
+
+            if (collapsed[collapse.from] || collapsed[collapse.to] || collapse.version != versions[collapse.from]) continue;
+
+            // The target's quadric may have grown since this was pushed, then it goes back in at its real cost
+            double cost = collapseCost(collapse.from, collapse.to);
+            if (cost > collapse.cost * 1.0001 + 1e-12) {
+                collapse.cost = cost;
+                heap.push_back(collapse);
+                std::push_heap(heap.begin(), heap.end(), heapOrder);
+                continue;
+            }
+
+            if (cost > errorLimit) break;
+            if (!canCollapse(collapse.from, collapse.to)) continue;
+
+            const uint32_t from = collapse.from;
+            const uint32_t to = collapse.to;
+            const uint32_t toGroup = groups[to];
+
+            quadrics[toGroup] += quadrics[groups[from]];
+            for (uint32_t t : vertexTriangles[from]) {
+                if (triangleRemoved[t]) continue;
+                uint32_t* triangle = &result[t * 3];
+
+                if (groups[triangle[0]] == toGroup || groups[triangle[1]] == toGroup || groups[triangle[2]] == toGroup) {
+                    triangleRemoved[t] = true;
+                    liveTriangles--;
+                    continue;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    if (triangle[k] == from) triangle[k] = to;
+                }
+                vertexTriangles[to].push_back(t);
+            }
+
+            collapsed[from] = true;
+            vertexTriangles[from].clear();
+            maxError = std::max(maxError, cost);
+
+            // Every collapse around the target changed cost
+            neighbors.clear();
+            neighbors.push_back(to);
+            for (uint32_t t : vertexTriangles[to]) {
+                if (triangleRemoved[t]) continue;
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t v = result[t * 3 + k];
+                    if (std::find(neighbors.begin(), neighbors.end(), v) == neighbors.end()) {
+                        neighbors.push_back(v);
+                    }
+                }
+            }
+            for (uint32_t v : neighbors) {
+                versions[v]++;
+                pushCollapses(v);
+            }
+        }
+
+        size_t writeIndex = 0;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (triangleRemoved[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                result[writeIndex++] = result[t * 3 + k];
+            }
+        }
+        result.resize(writeIndex);
+
+        if (resultError) *resultError = static_cast<float>(std::sqrt(maxError) / meshScale);
+        return result;
+    }
+
+} // namespace Dog
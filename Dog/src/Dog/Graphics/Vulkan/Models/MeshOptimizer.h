@@ -0,0 +1,38 @@
+#pragma once
+
+namespace Dog {
+
+    struct Vertex;
+
+    // Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache
+    struct VertexCacheStats {
+        float acmr = 0.f; // Average cache miss ratio, vertices transformed per triangle. 0.5 is ideal, 3 is the worst
+        float atvr = 0.f; // Average transform to vertex ratio, vertices transformed per vertex used. 1 is ideal
+    };
+
+    VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    // Reorders triangles so consecutive ones share vertices (Forsyth's linear-speed vertex cache optimization)
+    void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+    // Splits a cache optimized index buffer into clusters wherever the cache restarts, or where splitting costs
+    // less than threshold times the cluster's ACMR, and draws outward facing clusters first so they occlude the
+    // rest (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+    void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+    // Reorders vertices by first use so fetches walk memory in order. Vertices no triangle uses are dropped
+    void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Collapses edges in order of quadric error (Garland and Heckbert) until at most targetIndexCount indices
+    // remain or the next collapse would move the surface by more than targetError, relative to the mesh's size.
+    // Vertices are only ever merged into existing ones, so the result indexes the same vertex array. Vertices on
+    // attribute seams stay put, and open borders are held in place by extra planes. resultError gets the largest
+    // error made, also relative to the mesh's size
+    std::vector<uint32_t> simplifyMesh(
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float targetError,
+        float* resultError = nullptr);
+
+} // namespace Dog
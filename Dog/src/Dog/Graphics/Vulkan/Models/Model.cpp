@@ -1,21 +1,25 @@
 #include <PCH/pch.h>
 #include "Model.h"
+#include "CookedModel.h"
+#include "GeometryPool.h"
 #include "../Texture/Texture.h"
+#include "Assets/MappedFile/MappedFile.h"
 
 #include "assimp/Exporter.hpp"
 
 namespace Dog {
 
-    Model::Model(Device& device, const std::string& filePath, TextureLibrary& textureLibrary)
+    Model::Model(Device& device, const std::string& filePath, TextureLibrary& textureLibrary, ModelSource source)
+        : Model(device, filePath, source)
+    {
+        loadTextures(textureLibrary);
+    }
+
+    Model::Model(Device& device, const std::string& filePath, ModelSource source)
         : device{ device }
         , path(filePath)
     {
-        loadMeshes(filePath, textureLibrary);
-
-        for (Mesh& mesh : meshes) {
-            mesh.createVertexBuffers(device);
-            mesh.createIndexBuffers(device);
-        }
+        loadMeshes(filePath, source);
     }
 
     Model::~Model() {}
@@ -110,9 +114,90 @@ namespace Dog {
     // | aiProcess_RemoveRedundantMaterials // Remove redundant materials (be careful)
     // | aiProcess_ImproveCacheLocality   // Improve GPU cache performance
 
-    void Model::loadMeshes(const std::string& filepath, TextureLibrary& textureLibrary) {
-        // Making an Importer is supposedly expensive, so I made it static
-        static Assimp::Importer importer;
+    bool Model::IsCookedUpToDate(const std::string& sourcePath, const std::string& cookedPath) {
+        std::error_code error;
+        if (!std::filesystem::exists(cookedPath, error)) return false;
+        if (!std::filesystem::exists(sourcePath, error)) return true;
+
+        return std::filesystem::last_write_time(cookedPath, error) >= std::filesystem::last_write_time(sourcePath, error);
+    }
+
+    std::string Model::GetCookedPath(const std::string& modelPath) {
+        return "assets/models/cooked/" + GetCookedName(modelPath) + ".dogmesh";
+    }
+
+    std::string Model::GetCookedName(const std::string& sourcePath) {
+        std::filesystem::path path = std::filesystem::path(sourcePath).lexically_normal();
+        std::string normalized = path.generic_string();
+
+        // FNV-1a, unlike std::hash it's the same on every platform and run
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : normalized) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+
+        char hashText[17];
+        snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(hash));
+        return path.stem().string() + "_" + hashText;
+    }
+
+    void Model::loadMeshes(const std::string& filepath, ModelSource source) {
+        std::string cookedPath = GetCookedPath(filepath);
+
+        if (source != ModelSource::Assimp) {
+            bool useCooked = source == ModelSource::Cooked || IsCookedUpToDate(filepath, cookedPath);
+            if (useCooked && loadCooked(cookedPath)) {
+                computeBounds();
+                return;
+            }
+            if (source == ModelSource::Cooked) {
+                throw std::runtime_error("No usable cooked model at " + cookedPath);
+            }
+        }
+
+        // A cooked file that turned out unusable may have filled some of these in
+        meshes.clear();
+        textureRequests.clear();
+        cookedData.clear();
+        mBoneInfoMap.clear();
+        mBoneCounter = 0;
+
+        loadAssimp(filepath);
+        computeBounds();
+
+        // Cook it now so the next load skips Assimp
+        if (source == ModelSource::Auto && !cook(cookedPath)) {
+            std::cerr << "Failed to cook model: " << filepath << std::endl;
+        }
+    }
+
+    void Model::computeBounds() {
+        if (meshes.empty()) {
+            boundingSphere = glm::vec4(0.f);
+            return;
+        }
+
+        glm::vec3 aabbMin = meshes[0].aabbMin;
+        glm::vec3 aabbMax = meshes[0].aabbMax;
+        for (const Mesh& mesh : meshes) {
+            aabbMin = glm::min(aabbMin, mesh.aabbMin);
+            aabbMax = glm::max(aabbMax, mesh.aabbMax);
+        }
+
+        // Centered on the combined box and just big enough to hold every mesh's sphere
+        glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+        float radius = 0.f;
+        for (const Mesh& mesh : meshes) {
+            radius = std::max(radius, glm::length(glm::vec3(mesh.boundingSphere) - center) + mesh.boundingSphere.w);
+        }
+
+        boundingSphere = glm::vec4(center, radius);
+    }
+
+    void Model::loadAssimp(const std::string& filepath) {
+        // Making an Importer is supposedly expensive, so I made it static.
+        // Importers aren't thread safe, so every loading thread gets its own
+        static thread_local Assimp::Importer importer;
 
         // Log the file being loaded
         std::cout << "Loading model: " << filepath << std::endl;
@@ -161,7 +246,7 @@ namespace Dog {
             // Start recursive loading all the meshes
             //glm::mat4 globalTransform = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));  // Start with identity matrix
             //processNode(scene->mRootNode, scene, textureLibrary, filepath, globalTransform);
-            processNode(scene->mRootNode, scene, textureLibrary, filepath);
+            processNode(scene->mRootNode, scene, filepath);
         }
         catch (const std::exception& e) {
             std::cerr << "Exception occurred while loading model: " << e.what() << std::endl;
@@ -170,7 +255,7 @@ namespace Dog {
     }
 
     // Recursive function to process a node and its children
-    void Model::processNode(aiNode* node, const aiScene* scene, TextureLibrary& textureLibrary, const std::string& filepath, const glm::mat4& parentTransform) {
+    void Model::processNode(aiNode* node, const aiScene* scene, const std::string& filepath, const glm::mat4& parentTransform) {
         // Convert the node's transformation matrix
         glm::mat4 nodeTransform = aiMatToGlm(node->mTransformation);
 
@@ -180,20 +265,22 @@ namespace Dog {
         // Process each mesh in the current node
         for (unsigned int i = 0; i < node->mNumMeshes; i++) {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            processMesh(mesh, scene, textureLibrary, filepath, globalTransform);
+            processMesh(mesh, scene, filepath, globalTransform);
         }
 
         // Recursively process each child node
         for (unsigned int i = 0; i < node->mNumChildren; i++) {
-            processNode(node->mChildren[i], scene, textureLibrary, filepath, globalTransform);
+            processNode(node->mChildren[i], scene, filepath, globalTransform);
         }
     }
 
     // Process a single mesh and extract vertices, indices, and materials
-    void Model::processMesh(aiMesh* mesh, const aiScene* scene, TextureLibrary& textureLibrary, const std::string& filepath, const glm::mat4& transform) {
+    void Model::processMesh(aiMesh* mesh, const aiScene* scene, const std::string& filepath, const glm::mat4& transform) {
         Mesh& newMesh = meshes.emplace_back();
         newMesh.vertices.clear();
         newMesh.indices.clear();
+        newMesh.vertices.reserve(mesh->mNumVertices);
+        newMesh.indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 
         // printf("-  New Mesh\n");
 
@@ -254,7 +341,7 @@ namespace Dog {
         }
 
         // Process materials and textures
-        processMaterials(mesh, scene, newMesh, textureLibrary, filepath);
+        processMaterials(mesh, scene, meshes.size() - 1, filepath);
 
         ExtractBoneWeightForVertices(newMesh.vertices, mesh, scene);
 
@@ -265,10 +352,15 @@ namespace Dog {
                 newMesh.indices.push_back(face.mIndices[l]);
             }
         }
+
+        // Before the bounds, vertices no triangle uses are dropped
+        newMesh.optimize();
+        newMesh.generateLods();
+        newMesh.computeBounds();
     }
 
     // process materials
-    void Model::processMaterials(aiMesh* mesh, const aiScene* scene, Mesh& newMesh, TextureLibrary& textureLibrary, const std::string& filepath) {
+    void Model::processMaterials(aiMesh* mesh, const aiScene* scene, size_t meshIndex, const std::string& filepath) {
         // Loop through materials (textures)
         if (scene->HasMaterials()) {
             // auto& newMaterial = newMesh.material;
@@ -293,10 +385,11 @@ namespace Dog {
                         aiTexture* embeddedTexture = scene->mTextures[textureIndex];
 
                         if (embeddedTexture->mHeight == 0) {
+                            // The scene is freed by the next import, so the compressed image is copied out
                             unsigned char* textureData = reinterpret_cast<unsigned char*>(embeddedTexture->pcData);
                             int textureSize = embeddedTexture->mWidth;
 
-                            newMesh.textureIndex = textureLibrary.AddTextureFromMemory(textureData, textureSize);
+                            textureRequests.push_back({ meshIndex, {}, std::vector<unsigned char>(textureData, textureData + textureSize) });
                         }
                     }
 
@@ -305,8 +398,7 @@ namespace Dog {
                 else {
                     std::string textureFullpath = aiTexturePathToNLEPath(texturePath);
 
-                    textureLibrary.AddTexture(textureFullpath);
-                    newMesh.textureIndex = textureLibrary.GetTexture(textureFullpath);
+                    textureRequests.push_back({ meshIndex, textureFullpath, {} });
 
                     // log loaded texture from which model
                     // std::cout << ">  Loaded DIFFUSE " << textureFullpath << " successfully!" << std::endl;
@@ -315,6 +407,300 @@ namespace Dog {
         }
     }
 
+    void Model::loadTextures(TextureLibrary& textureLibrary) {
+        // Texture files are loaded as one batch, embedded textures one at a time
+        std::vector<std::string> filePaths;
+        std::vector<size_t> fileMeshes;
+
+        for (const TextureRequest& request : textureRequests) {
+            Mesh& mesh = meshes[request.meshIndex];
+
+            if (request.path.empty()) {
+                mesh.textureIndex = textureLibrary.AddTextureFromMemory(request.embeddedData.data(), static_cast<int>(request.embeddedData.size()));
+            }
+            else {
+                filePaths.push_back(request.path);
+                fileMeshes.push_back(request.meshIndex);
+            }
+        }
+
+        std::vector<uint32_t> textureIndices = textureLibrary.AddTextures(filePaths);
+        for (size_t i = 0; i < textureIndices.size(); ++i) {
+            meshes[fileMeshes[i]].textureIndex = textureIndices[i];
+        }
+
+        textureRequests.clear();
+    }
+
+    void Model::uploadMeshes(GeometryPool& geometryPool) {
+        if (cookedFile) {
+            geometryPool.uploadPacked(meshes, cookedData);
+
+            cookedData.clear();
+            cookedFile.reset();
+        }
+        else {
+            geometryPool.uploadMeshes(meshes);
+        }
+    }
+
+    bool Model::loadCooked(const std::string& cookedPath) {
+        // A file that can't be opened or mapped is just not usable, the source is imported instead
+        std::unique_ptr<MappedFile> file;
+        try {
+            file = std::make_unique<MappedFile>(cookedPath);
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+
+        const uint8_t* data = file->GetData();
+        const uint64_t size = file->GetSize();
+
+        CookedModelHeader header;
+        if (size < sizeof(header)) return false;
+        memcpy(&header, data, sizeof(header));
+
+        // Anything written by another version gets recooked
+        if (header.magic != COOKED_MODEL_MAGIC || header.version != COOKED_MODEL_VERSION) {
+            return false;
+        }
+
+        const uint64_t meshTableOffset = sizeof(CookedModelHeader);
+        const uint64_t boneTableOffset = meshTableOffset + sizeof(CookedMesh) * header.meshCount;
+        if (!MappedFile::InRange(boneTableOffset, sizeof(CookedBone) * header.boneCount, size) ||
+            !MappedFile::InRange(header.vertexDataOffset, header.vertexDataSize, size) ||
+            !MappedFile::InRange(header.indexDataOffset, header.indexDataSize, size) ||
+            !MappedFile::InRange(header.blobOffset, header.blobSize, size)) {
+            return false;
+        }
+
+        const uint8_t* blob = data + header.blobOffset;
+        auto inBlob = [&header](const CookedBlobRef& ref) { return MappedFile::InRange(ref.offset, ref.size, header.blobSize); };
+
+        std::cout << "Loading cooked model: " << cookedPath << std::endl;
+
+        meshes.clear();
+        meshes.resize(header.meshCount);
+        textureRequests.clear();
+        cookedData.assign(header.meshCount, {});
+
+        const uint8_t* vertexData = data + header.vertexDataOffset;
+        const uint8_t* indexData = data + header.indexDataOffset;
+
+        uint64_t vertexTotal = 0;
+        uint64_t indexTotal = 0;
+
+        for (uint32_t i = 0; i < header.meshCount; ++i) {
+            CookedMesh cookedMesh;
+            memcpy(&cookedMesh, data + meshTableOffset + sizeof(CookedMesh) * i, sizeof(cookedMesh));
+
+            Mesh& mesh = meshes[i];
+            mesh.vertexCount = cookedMesh.vertexCount;
+            mesh.indexCount = cookedMesh.indexCount;
+            mesh.layout = cookedMesh.layout;
+            mesh.aabbMin = glm::vec3(cookedMesh.aabbMin);
+            mesh.aabbMax = glm::vec3(cookedMesh.aabbMax);
+            mesh.boundingSphere = cookedMesh.boundingSphere;
+            mesh.positionDecode = cookedMesh.positionDecode;
+            mesh.uvDecode = cookedMesh.uvDecode;
+            mesh.indexType = cookedMesh.indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+            uint64_t vertexBytes = static_cast<uint64_t>(getVertexStride(mesh.layout)) * cookedMesh.vertexCount;
+            uint64_t skinBytes = static_cast<uint64_t>(getSkinStride(mesh.layout)) * cookedMesh.vertexCount;
+            uint64_t indexBytes = static_cast<uint64_t>(cookedMesh.indexSize) * cookedMesh.indexCount;
+            if (mesh.layout >= VERTEX_LAYOUT_COUNT ||
+                (cookedMesh.indexSize != sizeof(uint16_t) && cookedMesh.indexSize != sizeof(uint32_t)) ||
+                (mesh.indexType == VK_INDEX_TYPE_UINT16 && GeometryPool::getIndexType(mesh.vertexCount) != VK_INDEX_TYPE_UINT16) ||
+                !MappedFile::InRange(cookedMesh.vertexStreamOffset, vertexBytes, header.vertexDataSize) ||
+                !MappedFile::InRange(cookedMesh.skinStreamOffset, skinBytes, header.vertexDataSize) ||
+                !MappedFile::InRange(cookedMesh.indexStreamOffset, indexBytes, header.indexDataSize) ||
+                cookedMesh.lodCount == 0 || cookedMesh.lodCount > Mesh::MAX_LODS) {
+                return false;
+            }
+
+            mesh.lodCount = cookedMesh.lodCount;
+            for (uint32_t lod = 0; lod < mesh.lodCount; ++lod) {
+                const MeshLod& meshLod = cookedMesh.lods[lod];
+                if (static_cast<uint64_t>(meshLod.firstIndex) + meshLod.indexCount > cookedMesh.indexCount) return false;
+                mesh.lods[lod] = meshLod;
+            }
+
+            cookedData[i].vertices = vertexData + cookedMesh.vertexStreamOffset;
+            cookedData[i].skin = skinBytes > 0 ? vertexData + cookedMesh.skinStreamOffset : nullptr;
+            cookedData[i].indices = indexData + cookedMesh.indexStreamOffset;
+
+            vertexTotal += cookedMesh.vertexCount;
+            indexTotal += cookedMesh.indexCount;
+
+            if (!inBlob(cookedMesh.texturePath) || !inBlob(cookedMesh.embeddedTexture)) return false;
+
+            if (cookedMesh.texturePath.size > 0) {
+                const char* texturePath = reinterpret_cast<const char*>(blob + cookedMesh.texturePath.offset);
+                textureRequests.push_back({ i, std::string(texturePath, cookedMesh.texturePath.size), {} });
+            }
+            else if (cookedMesh.embeddedTexture.size > 0) {
+                const uint8_t* image = blob + cookedMesh.embeddedTexture.offset;
+                textureRequests.push_back({ i, {}, std::vector<unsigned char>(image, image + cookedMesh.embeddedTexture.size) });
+            }
+        }
+
+        if (vertexTotal != header.vertexCount || indexTotal != header.indexCount) return false;
+
+        mBoneInfoMap.clear();
+        for (uint32_t i = 0; i < header.boneCount; ++i) {
+            CookedBone cookedBone;
+            memcpy(&cookedBone, data + boneTableOffset + sizeof(CookedBone) * i, sizeof(cookedBone));
+            if (!inBlob(cookedBone.name)) return false;
+
+            std::string name(reinterpret_cast<const char*>(blob + cookedBone.name.offset), cookedBone.name.size);
+            mBoneInfoMap[name] = BoneInfo{ cookedBone.id, cookedBone.offset };
+        }
+        mBoneCounter = static_cast<int>(header.boneCounter);
+
+        cookedFile = std::move(file);
+        loadedFromCooked = true;
+
+        return true;
+    }
+
+    bool Model::cook(const std::string& outputPath) const {
+        CookedModelHeader header;
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+        header.boneCount = static_cast<uint32_t>(mBoneInfoMap.size());
+        header.boneCounter = static_cast<uint32_t>(mBoneCounter);
+
+        std::vector<uint8_t> blob;
+        auto addToBlob = [&blob](const void* bytes, size_t size) {
+            CookedBlobRef ref{ blob.size(), size };
+            blob.insert(blob.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+            return ref;
+        };
+
+        auto align16 = [](uint64_t offset) { return (offset + 15) & ~uint64_t(15); };
+
+        // Cooked files always hold packed layouts and the narrowest indices, they're what ships
+        std::vector<uint8_t> vertexData;
+        std::vector<uint8_t> indexData;
+
+        std::vector<CookedMesh> cookedMeshes(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            const Mesh& mesh = meshes[i];
+            if (mesh.vertices.empty()) return false;
+
+            // Meshes without indices are drawn with a trivial index list, same as GeometryPool does
+            std::vector<uint32_t> generatedIndices;
+            if (mesh.indices.empty()) {
+                generatedIndices.resize(mesh.vertices.size());
+                std::iota(generatedIndices.begin(), generatedIndices.end(), 0u);
+            }
+            const std::vector<uint32_t>& indices = mesh.indices.empty() ? generatedIndices : mesh.indices;
+
+            CookedMesh& cookedMesh = cookedMeshes[i];
+            cookedMesh.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            cookedMesh.indexCount = static_cast<uint32_t>(indices.size());
+            cookedMesh.aabbMin = glm::vec4(mesh.aabbMin, 0.f);
+            cookedMesh.aabbMax = glm::vec4(mesh.aabbMax, 0.f);
+            cookedMesh.boundingSphere = mesh.boundingSphere;
+
+            // Generated indices are the whole mesh, so they're one level
+            cookedMesh.lodCount = mesh.indices.empty() ? 1 : mesh.lodCount;
+            for (uint32_t lod = 0; lod < cookedMesh.lodCount; ++lod) {
+                cookedMesh.lods[lod] = mesh.indices.empty() ? MeshLod{ 0, cookedMesh.indexCount } : mesh.lods[lod];
+            }
+
+            VertexEncoding encoding = chooseVertexEncoding(mesh.vertices, mesh.aabbMin, mesh.aabbMax, true);
+            cookedMesh.layout = encoding.layout;
+            cookedMesh.positionDecode = encoding.positionDecode;
+            cookedMesh.uvDecode = encoding.uvDecode;
+
+            uint64_t vertexBytes = static_cast<uint64_t>(getVertexStride(encoding.layout)) * mesh.vertices.size();
+            uint64_t skinBytes = static_cast<uint64_t>(getSkinStride(encoding.layout)) * mesh.vertices.size();
+            cookedMesh.vertexStreamOffset = vertexData.size();
+            cookedMesh.skinStreamOffset = align16(cookedMesh.vertexStreamOffset + vertexBytes);
+            vertexData.resize(align16(cookedMesh.skinStreamOffset + skinBytes));
+            encodeVertices(
+                mesh.vertices,
+                encoding,
+                vertexData.data() + cookedMesh.vertexStreamOffset,
+                skinBytes > 0 ? vertexData.data() + cookedMesh.skinStreamOffset : nullptr);
+
+            VkIndexType indexType = GeometryPool::getIndexType(cookedMesh.vertexCount);
+            cookedMesh.indexSize = GeometryPool::getIndexSize(indexType);
+            cookedMesh.indexStreamOffset = indexData.size();
+            indexData.resize((cookedMesh.indexStreamOffset + cookedMesh.indexSize * indices.size() + 3) & ~uint64_t(3));
+            if (indexType == VK_INDEX_TYPE_UINT16) {
+                std::copy(indices.begin(), indices.end(), reinterpret_cast<uint16_t*>(indexData.data() + cookedMesh.indexStreamOffset));
+            }
+            else {
+                memcpy(indexData.data() + cookedMesh.indexStreamOffset, indices.data(), sizeof(uint32_t) * indices.size());
+            }
+
+            header.vertexCount += cookedMesh.vertexCount;
+            header.indexCount += cookedMesh.indexCount;
+        }
+
+        for (const TextureRequest& request : textureRequests) {
+            CookedMesh& cookedMesh = cookedMeshes[request.meshIndex];
+            if (!request.path.empty()) {
+                cookedMesh.texturePath = addToBlob(request.path.data(), request.path.size());
+            }
+            else {
+                cookedMesh.embeddedTexture = addToBlob(request.embeddedData.data(), request.embeddedData.size());
+            }
+        }
+
+        std::vector<CookedBone> cookedBones;
+        cookedBones.reserve(mBoneInfoMap.size());
+        for (const auto& [name, boneInfo] : mBoneInfoMap) {
+            CookedBone& cookedBone = cookedBones.emplace_back();
+            cookedBone.name = addToBlob(name.data(), name.size());
+            cookedBone.id = boneInfo.id;
+            cookedBone.offset = boneInfo.offset;
+        }
+
+        header.vertexDataOffset = align16(sizeof(CookedModelHeader) + sizeof(CookedMesh) * cookedMeshes.size() + sizeof(CookedBone) * cookedBones.size());
+        header.vertexDataSize = vertexData.size();
+        header.indexDataOffset = align16(header.vertexDataOffset + header.vertexDataSize);
+        header.indexDataSize = indexData.size();
+        header.blobOffset = align16(header.indexDataOffset + header.indexDataSize);
+        header.blobSize = blob.size();
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(outputPath).parent_path(), error);
+
+        // Written next to the target and renamed over it, so a loader never maps half a file
+        std::string tempPath = outputPath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+
+            auto padTo = [&out](uint64_t offset) {
+                static const char zeros[16]{};
+                uint64_t position = static_cast<uint64_t>(out.tellp());
+                if (offset > position) out.write(zeros, static_cast<std::streamsize>(offset - position));
+            };
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(cookedMeshes.data()), sizeof(CookedMesh) * cookedMeshes.size());
+            out.write(reinterpret_cast<const char*>(cookedBones.data()), sizeof(CookedBone) * cookedBones.size());
+
+            padTo(header.vertexDataOffset);
+            out.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+
+            padTo(header.indexDataOffset);
+            out.write(reinterpret_cast<const char*>(indexData.data()), indexData.size());
+
+            padTo(header.blobOffset);
+            out.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+            if (!out.good()) return false;
+        }
+
+        std::filesystem::rename(tempPath, outputPath, error);
+        return !error;
+    }
+
     void Model::SetVertexBoneDataToDefault(Vertex& vertex)
     {
         for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
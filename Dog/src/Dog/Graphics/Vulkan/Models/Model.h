@@ -1,16 +1,29 @@
 #pragma once
 
 #include "Mesh.h"
+#include "GeometryPool.h"
 #include "../Texture/TextureLibrary.h"
 #include "../Animation/BoneInfo.h"
 
 namespace Dog {
 
     class Texture;
+    class MappedFile;
+
+    // Where a model's meshes are read from
+    enum class ModelSource {
+        Auto,   // The cooked model when it's newer than the source file, otherwise import and cook
+        Assimp, // Always import with Assimp, through the assbin cache
+        Cooked, // Only the cooked model, throws if there is none
+    };
 
     class Model {
     public:
-        Model(Device& device, const std::string& filePath, TextureLibrary& textureLibrary);
+        Model(Device& device, const std::string& filePath, TextureLibrary& textureLibrary, ModelSource source = ModelSource::Auto);
+
+        // Only parses the file and builds the meshes, which is safe on any thread.
+        // loadTextures must be called on the main thread before the model is drawn
+        Model(Device& device, const std::string& filePath, ModelSource source = ModelSource::Auto);
         ~Model();
 
         Model(const Model&) = delete;
@@ -21,13 +34,50 @@ namespace Dog {
 
         const std::string& GetPath() const { return path; }
 
+        // Loads the textures the meshes' materials asked for and sets their texture indices
+        void loadTextures(TextureLibrary& textureLibrary);
+
+        // Copies the meshes into the pool. Cooked models copy straight out of the mapped file,
+        // which is closed afterwards
+        void uploadMeshes(GeometryPool& geometryPool);
+
+        // Writes the meshes, bones and texture references as a cooked model (see CookedModel.h), with the
+        // vertices in packed layouts. Needs the vertices an import builds and the texture references
+        // loadTextures consumes
+        bool cook(const std::string& outputPath) const;
+
+        // assets/models/cooked/<name>.dogmesh, see GetCookedName
+        static std::string GetCookedPath(const std::string& modelPath);
+
+        // The source's file stem plus a hash of its whole normalized path, so sources that only share
+        // a stem, like a/charles.fbx and b/charles.obj, don't cook to the same file
+        static std::string GetCookedName(const std::string& sourcePath);
+
+        // Cooked files are used until the source they came from changes. Without a source, the cooked file is all there is
+        static bool IsCookedUpToDate(const std::string& sourcePath, const std::string& cookedPath);
+
+        bool isCooked() const { return loadedFromCooked; }
+
         std::vector<Mesh> meshes;
 
+        // Encloses every mesh's bounding sphere, xyz is the center and w the radius. Used to pick LODs
+        glm::vec4 boundingSphere{ 0.f };
+
     private:
-        void loadMeshes(const std::string& filepath, TextureLibrary& textureLibrary);
-        void processNode(aiNode* node, const aiScene* scene, TextureLibrary& textureLibrary, const std::string& filepath, const glm::mat4& parentTransform = glm::mat4(1.f));
-        void processMesh(aiMesh* mesh, const aiScene* scene, TextureLibrary& textureLibrary, const std::string& filepath, const glm::mat4& transform);
-        void processMaterials(aiMesh* mesh, const aiScene* scene, Mesh& newMesh, TextureLibrary& textureLibrary, const std::string& filepath);
+        // A diffuse texture a mesh needs, either a file or an embedded image copied out of the aiScene
+        struct TextureRequest {
+            size_t meshIndex;
+            std::string path;
+            std::vector<unsigned char> embeddedData;
+        };
+
+        void loadMeshes(const std::string& filepath, ModelSource source);
+        void loadAssimp(const std::string& filepath);
+        bool loadCooked(const std::string& cookedPath);
+        void computeBounds();
+        void processNode(aiNode* node, const aiScene* scene, const std::string& filepath, const glm::mat4& parentTransform = glm::mat4(1.f));
+        void processMesh(aiMesh* mesh, const aiScene* scene, const std::string& filepath, const glm::mat4& transform);
+        void processMaterials(aiMesh* mesh, const aiScene* scene, size_t meshIndex, const std::string& filepath);
 
         void SetVertexBoneDataToDefault(Vertex& vertex);
         void SetVertexBoneData(Vertex& vertex, int boneID, float weight);
@@ -38,6 +88,12 @@ namespace Dog {
         Device& device;
         std::map<std::string, BoneInfo> mBoneInfoMap;
         int mBoneCounter = 0;
+        std::vector<TextureRequest> textureRequests;
+
+        // Cooked models keep their file mapped until the meshes are uploaded
+        std::unique_ptr<MappedFile> cookedFile;
+        std::vector<PackedMeshData> cookedData;
+        bool loadedFromCooked = false;
     };
 
 } // namespace Dog
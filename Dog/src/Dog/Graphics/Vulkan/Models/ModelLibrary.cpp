@@ -1,19 +1,32 @@
 #include <PCH/pch.h>
 #include "ModelLibrary.h"
 #include "Model.h"
+#include "GeometryPool.h"
 #include "../Core/Device.h"
 #include "../Texture/TextureLibrary.h"
+#include "Jobs/JobSystem.h"
 
 namespace Dog {
 
-	ModelLibrary::ModelLibrary(Device& device, TextureLibrary& textureLibrary)
+	// Time Update may spend publishing models before leaving the rest for the next frame
+	static constexpr double PUBLISH_BUDGET_MS = 2.0;
+
+	ModelLibrary::ModelLibrary(Device& device, TextureLibrary& textureLibrary, JobSystem& jobSystem, bool quantizeVertices)
 		: m_Device(device)
 		, m_TextureLibrary(textureLibrary)
+		, m_JobSystem(jobSystem)
+		, m_LoadCounter(std::make_unique<JobCounter>())
 	{
+		m_GeometryPool = std::make_unique<GeometryPool>(device, quantizeVertices);
+
+		// Cooked models are always packed, so full precision runs import everything
+		m_ModelSource = quantizeVertices ? ModelSource::Auto : ModelSource::Assimp;
 	}
 
 	ModelLibrary::~ModelLibrary()
 	{
+		// Load jobs write into this library, so none may outlive it
+		m_JobSystem.Wait(*m_LoadCounter);
 	}
 
 	uint32_t ModelLibrary::AddModel(const std::string& modelPath)
@@ -26,8 +39,12 @@ namespace Dog {
 		if (m_ModelMap.find(modelPath) == m_ModelMap.end()) {
 			uint32_t modelIndex = static_cast<uint32_t>(m_Models.size());
 
+			m_Models.push_back(std::make_unique<Model>(m_Device, modelPath, m_TextureLibrary, m_ModelSource));
 			m_ModelMap[modelPath] = modelIndex;
-			m_Models.push_back(std::make_unique<Model>(m_Device, modelPath, m_TextureLibrary));
+			m_ModelPaths.push_back(modelPath);
+
+			m_Models.back()->uploadMeshes(*m_GeometryPool);
+
 			return static_cast<uint32_t>(modelIndex);
 		}
 		else {
@@ -35,6 +52,150 @@ namespace Dog {
 		}
 	}
 
+	uint32_t ModelLibrary::AddModelAsync(const std::string& modelPath, std::function<void(uint32_t)> onLoaded)
+	{
+		// Loaded synchronously, it has to be drawable before anything else is
+		if (m_PlaceholderIndex == INVALID_MODEL_INDEX) {
+			m_PlaceholderIndex = AddModel(PLACEHOLDER_MODEL_PATH);
+		}
+
+		auto it = m_ModelMap.find(modelPath);
+		if (it != m_ModelMap.end()) {
+			uint32_t modelIndex = it->second;
+			if (onLoaded) {
+				if (IsModelReady(modelIndex)) onLoaded(modelIndex);
+				else m_LoadCallbacks[modelIndex].push_back(std::move(onLoaded));
+			}
+			return modelIndex;
+		}
+
+		if (m_Models.size() >= MAX_MODEL_COUNT) {
+			throw std::runtime_error("Model count exceeded maximum");
+			return INVALID_MODEL_INDEX;
+		}
+
+		// Reserve the slot so the index can be handed out now
+		uint32_t modelIndex = static_cast<uint32_t>(m_Models.size());
+		m_ModelMap[modelPath] = modelIndex;
+		m_ModelPaths.push_back(modelPath);
+		m_Models.push_back(nullptr);
+		m_PendingLoadCount++;
+
+		if (onLoaded) {
+			m_LoadCallbacks[modelIndex].push_back(std::move(onLoaded));
+		}
+
+		m_JobSystem.Run([this, modelPath, modelIndex]() {
+			std::unique_ptr<Model> model;
+			try {
+				model = std::make_unique<Model>(m_Device, modelPath, m_ModelSource);
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Async load of " << modelPath << " failed: " << e.what() << std::endl;
+			}
+
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			m_CompletedLoads.push_back({ modelIndex, std::move(model) });
+		}, m_LoadCounter.get());
+
+		return modelIndex;
+	}
+
+	void ModelLibrary::Update()
+	{
+		std::vector<CompletedLoad> completed;
+		{
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			if (m_CompletedLoads.empty()) return;
+			completed.swap(m_CompletedLoads);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t published = 0;
+
+		// Always publish at least one, so progress is made however slow a single upload is
+		while (published < completed.size()) {
+			CompletedLoad& load = completed[published++];
+			Publish(load.index, std::move(load.model));
+
+			double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (elapsedMs > PUBLISH_BUDGET_MS) break;
+		}
+
+		// Put the rest back for next frame, ahead of anything that finished meanwhile
+		if (published < completed.size()) {
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			m_CompletedLoads.insert(
+				m_CompletedLoads.begin(),
+				std::make_move_iterator(completed.begin() + published),
+				std::make_move_iterator(completed.end()));
+		}
+	}
+
+	void ModelLibrary::Publish(uint32_t index, std::unique_ptr<Model> model)
+	{
+		m_PendingLoadCount--;
+
+		// A failed load stays on the placeholder
+		if (!model) {
+			m_LoadCallbacks.erase(index);
+			return;
+		}
+
+		model->loadTextures(m_TextureLibrary);
+		model->uploadMeshes(*m_GeometryPool);
+		m_Models[index] = std::move(model);
+
+		auto callbacks = m_LoadCallbacks.find(index);
+		if (callbacks != m_LoadCallbacks.end()) {
+			for (auto& callback : callbacks->second) {
+				callback(index);
+			}
+			m_LoadCallbacks.erase(callbacks);
+		}
+	}
+
+	uint32_t ModelLibrary::CookModels(const std::string& directory)
+	{
+		uint32_t cookedCount = 0;
+		std::error_code error;
+
+		for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+			if (extension != ".fbx" && extension != ".gltf" && extension != ".glb" && extension != ".obj") {
+				continue;
+			}
+
+			std::string modelPath = entry.path().generic_string();
+			try {
+				Model model(m_Device, modelPath, ModelSource::Assimp);
+				if (model.cook(Model::GetCookedPath(modelPath))) {
+					cookedCount++;
+				}
+				else {
+					std::cerr << "Failed to cook model: " << modelPath << std::endl;
+				}
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Failed to cook " << modelPath << ": " << e.what() << std::endl;
+			}
+		}
+
+		return cookedCount;
+	}
+
+	bool ModelLibrary::IsModelReady(uint32_t index) const
+	{
+		return index < m_Models.size() && m_Models[index] != nullptr;
+	}
+
+	uint32_t ModelLibrary::GetRenderableIndex(uint32_t index) const
+	{
+		return IsModelReady(index) ? index : m_PlaceholderIndex;
+	}
+
 	uint32_t ModelLibrary::GetModel(const std::string& modelPath)
 	{
 		if (m_ModelMap.find(modelPath) != m_ModelMap.end()) {
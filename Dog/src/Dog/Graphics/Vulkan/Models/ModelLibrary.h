@@ -6,11 +6,18 @@ namespace Dog {
 	class Model;
 	class Device;
 	class TextureLibrary;
+	class GeometryPool;
+	class JobSystem;
+	class JobCounter;
+	enum class ModelSource;
 
 	class ModelLibrary
 	{
 	public:
-		ModelLibrary(Device& device, TextureLibrary& textureLibrary);
+		// Drawn in place of models that are still loading
+		static constexpr const char* PLACEHOLDER_MODEL_PATH = "assets/models/quad.obj";
+
+		ModelLibrary(Device& device, TextureLibrary& textureLibrary, JobSystem& jobSystem, bool quantizeVertices = true);
 		~ModelLibrary();
 
 		/*********************************************************************
@@ -21,6 +28,52 @@ namespace Dog {
 		 *********************************************************************/
 		uint32_t AddModel(const std::string& modelPath);
 
+		/*********************************************************************
+		 * param:  modelPath: path to the model file
+		 * param:  onLoaded: called on the main thread with the index once the
+		 *         model is ready. Optional.
+		 * return: index the model will have in the library
+		 *
+		 * brief:  Parses the model and builds its meshes in a job, then
+		 *         uploads it from Update. The index is reserved right away;
+		 *         until the model is ready it renders as the placeholder.
+		 *********************************************************************/
+		uint32_t AddModelAsync(const std::string& modelPath, std::function<void(uint32_t)> onLoaded = nullptr);
+
+		/*********************************************************************
+		 * brief:  Finishes models whose jobs are done: loads their textures,
+		 *         uploads their meshes and publishes them. Call once a frame
+		 *         on the main thread. Stops after a small time budget so a
+		 *         burst of loads is spread over several frames.
+		 *********************************************************************/
+		void Update();
+
+		/*********************************************************************
+		 * param:  directory: Folder of FBX, glTF and OBJ files
+		 * return: The number of models cooked
+		 *
+		 * brief:  Imports every model in the folder with Assimp and writes
+		 *         its cooked version, so later loads never touch Assimp.
+		 *         Models are also cooked the first time they're loaded; this
+		 *         does it ahead of time.
+		 *********************************************************************/
+		uint32_t CookModels(const std::string& directory);
+
+		/*********************************************************************
+		 * param:  index: The model index
+		 * return: False while the model is loading (or if loading failed)
+		 *********************************************************************/
+		bool IsModelReady(uint32_t index) const;
+
+		/*********************************************************************
+		 * param:  index: The model index
+		 * return: The index itself if ready, else the placeholder's index
+		 *********************************************************************/
+		uint32_t GetRenderableIndex(uint32_t index) const;
+
+		// Number of async loads that haven't been published yet
+		uint32_t GetPendingLoadCount() const { return m_PendingLoadCount; }
+
 		/*********************************************************************
 		 * param:  modelPath: path to the model file
 		 * return: index of the model in the library
@@ -31,12 +84,18 @@ namespace Dog {
 
 		/*********************************************************************
 		 * param:  index: The model index
-		 * return: The model at the index
+		 * return: The model at the index, null while it is still loading
 		 *
 		 * brief:  Gets the model at the given index
 		 *********************************************************************/
 		Model* GetModelByIndex(uint32_t index);
 
+		/*********************************************************************
+		 * param:  index: The model index
+		 * return: The path the model was added with, also while it loads
+		 *********************************************************************/
+		const std::string& GetModelPath(uint32_t index) const { return m_ModelPaths[index]; }
+
 		/*********************************************************************
 		 * return: The number of models in the library
 		 * 
@@ -44,12 +103,41 @@ namespace Dog {
 		 *********************************************************************/
 		uint32_t GetModelCount() const { return static_cast<uint32_t>(m_Models.size()); }
 
+		/*********************************************************************
+		 * return: The pool holding every model's vertices and indices
+		 *
+		 * brief: Bind this once per frame, then draw any mesh in the library
+		 *********************************************************************/
+		GeometryPool& GetGeometryPool() { return *m_GeometryPool; }
+
 	private:
+		// A model whose job has finished, waiting for Update to publish it
+		struct CompletedLoad {
+			uint32_t index;
+			std::unique_ptr<Model> model; // Null if loading failed
+		};
+
+		void Publish(uint32_t index, std::unique_ptr<Model> model);
+
+		// Slots of models that are still loading are null
 		std::vector<std::unique_ptr<Model>> m_Models;
+		std::vector<std::string> m_ModelPaths;
 		std::unordered_map<std::string, uint32_t> m_ModelMap;
+		std::unique_ptr<GeometryPool> m_GeometryPool;
+		ModelSource m_ModelSource;
 
 		Device& m_Device;
 		TextureLibrary& m_TextureLibrary;
+		JobSystem& m_JobSystem;
+
+		uint32_t m_PlaceholderIndex = INVALID_MODEL_INDEX;
+		uint32_t m_PendingLoadCount = 0;
+		std::unordered_map<uint32_t, std::vector<std::function<void(uint32_t)>>> m_LoadCallbacks;
+
+		// Written by load jobs, drained by Update
+		std::mutex m_CompletedMutex;
+		std::vector<CompletedLoad> m_CompletedLoads;
+		std::unique_ptr<JobCounter> m_LoadCounter;
 	};
 
 } // namespace Dog
@@ -0,0 +1,166 @@
+#include <PCH/pch.h>
+#include "VertexLayout.h"
+#include "Mesh.h"
+
+namespace Dog {
+
+    static_assert(sizeof(PackedVertex) == 16 && sizeof(PackedSkin) == 8, "Packed vertex streams must stay tightly packed");
+    static_assert(sizeof(FloatVertex) == 32 && sizeof(FloatSkin) == 32, "Float vertex streams must stay tightly packed");
+
+    static int16_t toSnorm16(float value) {
+        return static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f));
+    }
+
+    static uint16_t toUnorm16(float value) {
+        return static_cast<uint16_t>(std::round(std::clamp(value, 0.f, 1.f) * 65535.f));
+    }
+
+    static uint8_t toUnorm8(float value) {
+        return static_cast<uint8_t>(std::round(std::clamp(value, 0.f, 1.f) * 255.f));
+    }
+
+    // Folds the unit sphere onto an octahedron and unfolds it into [-1, 1]^2
+    static glm::vec2 encodeOctahedral(const glm::vec3& normal) {
+        float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (length == 0.f) return glm::vec2(0.f);
+
+        glm::vec2 p = glm::vec2(normal) / length;
+        if (normal.z < 0.f) {
+            glm::vec2 sign(p.x >= 0.f ? 1.f : -1.f, p.y >= 0.f ? 1.f : -1.f);
+            p = (1.f - glm::abs(glm::vec2(p.y, p.x))) * sign;
+        }
+        return p;
+    }
+
+    uint32_t getVertexStride(VertexLayout layout) {
+        bool hasColor = layout & VERTEX_LAYOUT_COLOR;
+        if (layout & VERTEX_LAYOUT_FLOAT) {
+            return sizeof(FloatVertex) + (hasColor ? sizeof(glm::vec3) : 0);
+        }
+        return sizeof(PackedVertex) + (hasColor ? sizeof(uint32_t) : 0);
+    }
+
+    uint32_t getSkinStride(VertexLayout layout) {
+        if (!(layout & VERTEX_LAYOUT_SKINNED)) return 0;
+        return (layout & VERTEX_LAYOUT_FLOAT) ? sizeof(FloatSkin) : sizeof(PackedSkin);
+    }
+
+    VertexEncoding chooseVertexEncoding(const std::vector<Vertex>& vertices, const glm::vec3& aabbMin, const glm::vec3& aabbMax, bool quantize) {
+        VertexEncoding encoding;
+        if (!quantize) encoding.layout |= VERTEX_LAYOUT_FLOAT;
+
+        glm::vec2 uvMin(std::numeric_limits<float>::max());
+        glm::vec2 uvMax(std::numeric_limits<float>::lowest());
+
+        for (const Vertex& vertex : vertices) {
+            if (vertex.mBoneIDs[0] >= 0) encoding.layout |= VERTEX_LAYOUT_SKINNED;
+            if (vertex.color != glm::vec3(1.f)) encoding.layout |= VERTEX_LAYOUT_COLOR;
+            uvMin = glm::min(uvMin, vertex.uv);
+            uvMax = glm::max(uvMax, vertex.uv);
+        }
+
+        if (!quantize || vertices.empty()) return encoding;
+
+        // One scale for every axis keeps the decode a similarity transform, so bounds and normals are unaffected
+        glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+        glm::vec3 halfExtent = (aabbMax - aabbMin) * 0.5f;
+        float scale = std::max({ halfExtent.x, halfExtent.y, halfExtent.z });
+        encoding.positionDecode = glm::vec4(center, scale > 0.f ? scale : 1.f);
+
+        glm::vec2 uvExtent = uvMax - uvMin;
+        encoding.uvDecode = glm::vec4(uvMin, uvExtent.x > 0.f ? uvExtent.x : 1.f, uvExtent.y > 0.f ? uvExtent.y : 1.f);
+
+        return encoding;
+    }
+
+    void encodeVertices(const std::vector<Vertex>& vertices, const VertexEncoding& encoding, void* vertexData, void* skinData) {
+        const VertexLayout layout = encoding.layout;
+        const uint32_t stride = getVertexStride(layout);
+        const bool hasColor = layout & VERTEX_LAYOUT_COLOR;
+        const bool isSkinned = layout & VERTEX_LAYOUT_SKINNED;
+
+        uint8_t* vertexOut = static_cast<uint8_t*>(vertexData);
+
+        if (layout & VERTEX_LAYOUT_FLOAT) {
+            FloatSkin* skinOut = static_cast<FloatSkin*>(skinData);
+
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                const Vertex& vertex = vertices[i];
+
+                FloatVertex packed{ vertex.position, vertex.normal, vertex.uv };
+                memcpy(vertexOut, &packed, sizeof(packed));
+                if (hasColor) {
+                    memcpy(vertexOut + sizeof(packed), &vertex.color, sizeof(vertex.color));
+                }
+                vertexOut += stride;
+
+                if (isSkinned) {
+                    FloatSkin& skin = skinOut[i];
+                    memcpy(skin.boneIds, vertex.mBoneIDs, sizeof(skin.boneIds));
+                    memcpy(skin.weights, vertex.mWeights, sizeof(skin.weights));
+                }
+            }
+            return;
+        }
+
+        PackedSkin* skinOut = static_cast<PackedSkin*>(skinData);
+        const glm::vec3 positionOffset(encoding.positionDecode);
+        const float positionScale = 1.f / encoding.positionDecode.w;
+        const glm::vec2 uvOffset(encoding.uvDecode.x, encoding.uvDecode.y);
+        const glm::vec2 uvScale = 1.f / glm::vec2(encoding.uvDecode.z, encoding.uvDecode.w);
+
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Vertex& vertex = vertices[i];
+
+            PackedVertex packed{};
+            glm::vec3 position = (vertex.position - positionOffset) * positionScale;
+            packed.position[0] = toSnorm16(position.x);
+            packed.position[1] = toSnorm16(position.y);
+            packed.position[2] = toSnorm16(position.z);
+
+            glm::vec2 normal = encodeOctahedral(vertex.normal);
+            packed.normal[0] = toSnorm16(normal.x);
+            packed.normal[1] = toSnorm16(normal.y);
+
+            glm::vec2 uv = (vertex.uv - uvOffset) * uvScale;
+            packed.uv[0] = toUnorm16(uv.x);
+            packed.uv[1] = toUnorm16(uv.y);
+
+            memcpy(vertexOut, &packed, sizeof(packed));
+            if (hasColor) {
+                uint8_t color[4] = { toUnorm8(vertex.color.r), toUnorm8(vertex.color.g), toUnorm8(vertex.color.b), 255 };
+                memcpy(vertexOut + sizeof(packed), color, sizeof(color));
+            }
+            vertexOut += stride;
+
+            if (!isSkinned) continue;
+
+            // Unused slots get bone 0 with no weight. Ids past a byte land at or above MAX_BONES,
+            // which the shader treats as unskinned, same as it did for any out of range id
+            PackedSkin& skin = skinOut[i];
+            int total = 0;
+            int largest = 0;
+            for (int j = 0; j < MAX_BONE_INFLUENCE; ++j) {
+                bool used = vertex.mBoneIDs[j] >= 0;
+                skin.boneIds[j] = used ? static_cast<uint8_t>(std::min(vertex.mBoneIDs[j], 255)) : 0;
+                skin.weights[j] = used ? toUnorm8(vertex.mWeights[j]) : 0;
+                total += skin.weights[j];
+                if (skin.weights[j] > skin.weights[largest]) largest = j;
+            }
+
+            // Rounding can leave the weights a few steps off 255, which would scale the vertex
+            if (total > 0) {
+                skin.weights[largest] = static_cast<uint8_t>(std::clamp(skin.weights[largest] + 255 - total, 0, 255));
+            }
+        }
+    }
+
+    std::vector<std::string> getVertexLayoutDefines(VertexLayout layout) {
+        std::vector<std::string> defines;
+        if (layout & VERTEX_LAYOUT_COLOR) defines.push_back("VERTEX_COLOR");
+        if (layout & VERTEX_LAYOUT_SKINNED) defines.push_back("VERTEX_SKINNED");
+        if (!(layout & VERTEX_LAYOUT_FLOAT)) defines.push_back("VERTEX_PACKED");
+        return defines;
+    }
+
+} // namespace Dog
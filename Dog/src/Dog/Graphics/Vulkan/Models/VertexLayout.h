@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Dog {
+
+    struct Vertex;
+
+    // How a mesh's vertices are stored in the GeometryPool. Every combination of the bits is a layout
+    // with its own vertex input state and shader variant. Skinned layouts keep bone indices and weights
+    // in a second stream, so static meshes never fetch them. Only the skinning pass reads skinned layouts,
+    // everything draws its output instead, in the matching full precision static layout.
+    using VertexLayout = uint32_t;
+
+    enum VertexLayoutBits : uint32_t {
+        VERTEX_LAYOUT_COLOR = 1 << 0,   // Per-vertex colors, white without
+        VERTEX_LAYOUT_SKINNED = 1 << 1, // Bone stream at binding 1
+        VERTEX_LAYOUT_FLOAT = 1 << 2,   // Full precision floats instead of packed attributes
+    };
+
+    static constexpr uint32_t VERTEX_LAYOUT_COUNT = 8;
+
+    // Packed layouts, 16 bytes (20 with colors) plus 8 bytes of skin for skinned meshes.
+    // Positions and UVs are stored relative to the mesh's bounds and expanded with its decode transforms
+    struct PackedVertex {
+        int16_t position[4]; // snorm16, w unused (three component 16 bit formats aren't required for vertex input)
+        int16_t normal[2];   // snorm16 octahedral
+        uint16_t uv[2];      // unorm16
+    };
+
+    struct PackedSkin {
+        uint8_t boneIds[4];
+        uint8_t weights[4];  // unorm8, sums to 255
+    };
+
+    // Full precision layouts, the split up equivalent of Vertex
+    struct FloatVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    struct FloatSkin {
+        int boneIds[4];      // -1 for unused slots
+        float weights[4];
+    };
+
+    // What a mesh's vertices are stored as
+    struct VertexEncoding {
+        VertexLayout layout = 0;
+        glm::vec4 positionDecode{ 0.f, 0.f, 0.f, 1.f }; // xyz offset, w scale
+        glm::vec4 uvDecode{ 0.f, 0.f, 1.f, 1.f };       // xy offset, zw scale
+    };
+
+    uint32_t getVertexStride(VertexLayout layout);
+    uint32_t getSkinStride(VertexLayout layout); // 0 for layouts without skin
+
+    // Skinned if any vertex has a bone, colored if any vertex isn't white. Packed layouts map the
+    // position bounds onto a uniformly scaled snorm cube and the UV bounds onto unorm
+    VertexEncoding chooseVertexEncoding(const std::vector<Vertex>& vertices, const glm::vec3& aabbMin, const glm::vec3& aabbMax, bool quantize);
+
+    // Writes every vertex in the encoding's layout. skinData is only written by skinned layouts
+    void encodeVertices(const std::vector<Vertex>& vertices, const VertexEncoding& encoding, void* vertexData, void* skinData);
+
+    // Preprocessor defines selecting the layout's variant of a shader that reads vertices
+    std::vector<std::string> getVertexLayoutDefines(VertexLayout layout);
+
+} // namespace Dog
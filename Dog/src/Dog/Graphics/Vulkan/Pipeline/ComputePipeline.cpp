@@ -0,0 +1,20 @@
+#include <PCH/pch.h>
+#include "ComputePipeline.h"
+#include "PipelineCache.h"
+
+namespace Dog {
+
+    ComputePipeline::ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+        : device{ device } {
+        computePipeline = device.getPipelineCache().getComputePipeline(compFilepath, pipelineLayout);
+    }
+
+    ComputePipeline::~ComputePipeline() {
+        device.getPipelineCache().releasePipeline(computePipeline);
+    }
+
+    void ComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
+} // namespace Dog
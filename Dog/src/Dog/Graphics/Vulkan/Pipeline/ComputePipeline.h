@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../Core/Device.h"
+
+namespace Dog {
+
+    class ComputePipeline {
+    public:
+        ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+        ~ComputePipeline();
+
+        ComputePipeline(const ComputePipeline&) = delete;
+        ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+        VkPipeline& getPipeline() { return computePipeline; }
+
+    private:
+        Device& device;
+        VkPipeline computePipeline; // From the device's PipelineCache, released on destruction
+    };
+
+} // namespace Dog
@@ -1,5 +1,6 @@
 #include <PCH/pch.h>
 #include "Pipeline.h"
+#include "PipelineCache.h"
 
 #include "../Models/Model.h"
 
@@ -9,11 +10,76 @@
 
 namespace Dog {
 
-    std::vector<uint32_t> compileGLSLtoSPV(const std::string& source, EShLanguage stage) {
+    static constexpr const char* SHADER_DIRECTORY = "assets/shaders/";
+
+    // Resolves a quoted #include against the directory of the file including it
+    static std::string resolveInclude(const std::string& includerPath, const std::string& headerName) {
+        std::filesystem::path path = std::filesystem::path(includerPath).parent_path() / headerName;
+        return path.lexically_normal().generic_string();
+    }
+
+    // Reads #include "file" lines, the same ones glslang's preprocessor will follow
+    static std::vector<std::string> findIncludes(const std::vector<char>& source) {
+        std::vector<std::string> includes;
+        std::string_view text(source.data(), source.size());
+
+        size_t lineStart = 0;
+        while (lineStart < text.size()) {
+            size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) lineEnd = text.size();
+            std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            size_t hash = line.find_first_not_of(" \t");
+            if (hash == std::string_view::npos || line[hash] != '#') continue;
+
+            size_t directive = line.find_first_not_of(" \t", hash + 1);
+            if (directive == std::string_view::npos || line.substr(directive, 7) != "include") continue;
+
+            size_t open = line.find_first_of("\"<", directive + 7);
+            if (open == std::string_view::npos) continue;
+            size_t close = line.find_first_of("\">", open + 1);
+            if (close == std::string_view::npos) continue;
+
+            includes.emplace_back(line.substr(open + 1, close - open - 1));
+        }
+
+        return includes;
+    }
+
+    // Hands glslang the files shaders #include from assets/shaders
+    class ShaderIncluder : public glslang::TShader::Includer {
+    public:
+        IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+            std::string path = resolveInclude(includerName, headerName);
+            std::ifstream file(SHADER_DIRECTORY + path, std::ios::binary);
+            if (!file.is_open()) {
+                return nullptr;
+            }
+
+            auto* contents = new std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return new IncludeResult(path, contents->data(), contents->size(), contents);
+        }
+
+        IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+            return includeLocal(headerName, includerName, inclusionDepth);
+        }
+
+        void releaseInclude(IncludeResult* result) override {
+            if (!result) return;
+            delete static_cast<std::string*>(result->userData);
+            delete result;
+        }
+    };
+
+    std::vector<uint32_t> compileGLSLtoSPV(const std::string& source, EShLanguage stage, const std::string& preamble, const std::string& sourcePath) {
         const char* shaderStrings[1];
         shaderStrings[0] = source.c_str();
+        const char* shaderNames[1];
+        shaderNames[0] = sourcePath.c_str();
         glslang::TShader shader(stage);
-        shader.setStrings(shaderStrings, 1);
+        shader.setStringsWithLengthsAndNames(shaderStrings, nullptr, shaderNames, 1);
+        shader.setPreamble(preamble.c_str());
 
         // Set the target language environment.
         int clientInputSemanticsVersion = 450; // Vulkan semantics
@@ -24,7 +90,8 @@ namespace Dog {
         static const TBuiltInResource* Resources = GetDefaultResources();
 
         EShMessages messages = EShMsgSuppressWarnings;
-        if (!shader.parse(Resources, 450, false, messages)) {
+        ShaderIncluder includer;
+        if (!shader.parse(Resources, 450, false, messages, includer)) {
             std::string infoLog = shader.getInfoLog();
             std::string infoDebugLog = shader.getInfoDebugLog();
             throw std::runtime_error("GLSL Parsing Failed:\n" + infoLog + "\n" + infoDebugLog);
@@ -51,18 +118,16 @@ namespace Dog {
         const std::string& fragFilepath,
         const PipelineConfigInfo& configInfo)
         : device{ device } {
-        createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+        graphicsPipeline = device.getPipelineCache().getGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
     }
 
     Pipeline::~Pipeline() {
-        vkDestroyShaderModule(device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(device, fragShaderModule, nullptr);
-        vkDestroyPipeline(device, graphicsPipeline, nullptr);
+        device.getPipelineCache().releasePipeline(graphicsPipeline);
     }
 
     std::vector<char> Pipeline::readShaderFile(const std::string& filepath) {
         //std::string enginePath = "assets/shaders/compiled/" + filepath + ".spv";
-        std::string enginePath = "assets/shaders/" + filepath;
+        std::string enginePath = SHADER_DIRECTORY + filepath;
         std::ifstream file{ enginePath, std::ios::ate | std::ios::binary };
 
         if (!file.is_open()) {
@@ -79,91 +144,29 @@ namespace Dog {
         return buffer;
     }
 
-    void Pipeline::createGraphicsPipeline(
-        const std::string& vertFile,
-        const std::string& fragFile,
-        const PipelineConfigInfo& configInfo) {
-        assert(configInfo.pipelineLayout != VK_NULL_HANDLE &&
-            "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
-        assert(configInfo.renderPass != VK_NULL_HANDLE &&
-            "Cannot create graphics pipeline: no renderPass provided in configInfo");
-
-        auto vertCode = readShaderFile(vertFile);
-        auto fragCode = readShaderFile(fragFile);
-
-        std::vector<uint32_t> vertShaderSPV = compileGLSLtoSPV(std::string(vertCode.begin(), vertCode.end()), EShLangVertex);
-        std::vector<uint32_t> fragShaderSPV = compileGLSLtoSPV(std::string(fragCode.begin(), fragCode.end()), EShLangFragment);
-
-        createShaderModule(vertShaderSPV, &vertShaderModule);
-        createShaderModule(fragShaderSPV, &fragShaderModule);
-
-        VkPipelineShaderStageCreateInfo shaderStages[2];
-        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        shaderStages[0].module = vertShaderModule;
-        shaderStages[0].pName = "main";
-        shaderStages[0].flags = 0;
-        shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
-        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        shaderStages[1].module = fragShaderModule;
-        shaderStages[1].pName = "main";
-        shaderStages[1].flags = 0;
-        shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
-
-        auto& bindingDescriptions = configInfo.bindingDescriptions;
-        auto& attributeDescriptions = configInfo.attributeDescriptions;
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexAttributeDescriptionCount =
-            static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
-        pipelineInfo.pStages = shaderStages;
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
-        pipelineInfo.pViewportState = &configInfo.viewportInfo;
-        pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
-        pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-        pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
-        pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-        pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
-
-        pipelineInfo.layout = configInfo.pipelineLayout;
-        pipelineInfo.renderPass = configInfo.renderPass;
-        pipelineInfo.subpass = configInfo.subpass;
-
-        pipelineInfo.basePipelineIndex = configInfo.basePipelineIndex;
-        pipelineInfo.basePipelineHandle = configInfo.basePipelineHandle;
-        pipelineInfo.flags = configInfo.flags;
-
-        if (vkCreateGraphicsPipelines(
-            device,
-            VK_NULL_HANDLE,
-            1,
-            &pipelineInfo,
-            nullptr,
-            &graphicsPipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create graphics pipeline");
+    std::vector<std::string> Pipeline::getShaderDependencies(const std::string& filepath) {
+        std::vector<std::string> dependencies{ filepath };
+
+        // Breadth first, the list doubles as the set of files already visited
+        for (size_t i = 0; i < dependencies.size(); ++i) {
+            std::vector<char> source;
+            try {
+                source = readShaderFile(dependencies[i]);
+            }
+            catch (const std::runtime_error&) {
+                continue;
+            }
+
+            for (const std::string& include : findIncludes(source)) {
+                std::string path = resolveInclude(dependencies[i], include);
+                if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end() &&
+                    std::filesystem::exists(SHADER_DIRECTORY + path)) {
+                    dependencies.push_back(path);
+                }
+            }
         }
-    }
 
-    void Pipeline::createShaderModule(const std::vector<uint32_t>& code, VkShaderModule* shaderModule) {
-        VkShaderModuleCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size() * sizeof(uint32_t); // Size is in bytes
-        createInfo.pCode = code.data();
-
-        if (vkCreateShaderModule(device, &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create shader module");
-        }
+        return dependencies;
     }
 
     void Pipeline::bind(VkCommandBuffer commandBuffer) {
@@ -240,8 +243,9 @@ namespace Dog {
             static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
 
-        configInfo.bindingDescriptions = Vertex::getBindingDescriptions();
-        configInfo.attributeDescriptions = Vertex::getAttributeDescriptions();
+        // Packed static meshes, pipelines drawing other layouts replace these
+        configInfo.bindingDescriptions = Vertex::getBindingDescriptions(0);
+        configInfo.attributeDescriptions = Vertex::getAttributeDescriptions(0);
     }
 
 } // namespace Dog
\ No newline at end of file
@@ -2,8 +2,15 @@
 
 #include "../Core/Device.h"
 
+#include "glslang/Public/ShaderLang.h"
+
 namespace Dog {
 
+    // Compiles GLSL source into SPIR-V, throwing on parse or link errors.
+    // The preamble is inserted after the #version line, for defines. #include "file" (with
+    // GL_GOOGLE_include_directive) is resolved relative to sourcePath, a path in assets/shaders
+    std::vector<uint32_t> compileGLSLtoSPV(const std::string& source, EShLanguage stage, const std::string& preamble = "", const std::string& sourcePath = "");
+
     struct PipelineConfigInfo {
         PipelineConfigInfo() = default;
         PipelineConfigInfo(const PipelineConfigInfo&) = delete;
@@ -11,6 +18,7 @@ namespace Dog {
 
         std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+        std::vector<std::string> shaderDefines{}; // #defined in both stages
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -46,20 +54,16 @@ namespace Dog {
 
         VkPipeline& getPipeline() { return graphicsPipeline; }
 
-    private:
-        std::vector<char> readShaderFile(const std::string& filepath);
-
-        void createGraphicsPipeline(
-            const std::string& vertFile,
-            const std::string& fragFile,
-            const PipelineConfigInfo& configInfo);
+        // Reads a shader from assets/shaders
+        static std::vector<char> readShaderFile(const std::string& filepath);
 
-        void createShaderModule(const std::vector<uint32_t>& code, VkShaderModule* shaderModule);
+        // The shader followed by every file it #includes, directly or through other includes, as paths in
+        // assets/shaders. Includes that can't be found are left out, compiling reports them
+        static std::vector<std::string> getShaderDependencies(const std::string& filepath);
 
+    private:
         Device& device;
-        VkPipeline graphicsPipeline;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkPipeline graphicsPipeline; // From the device's PipelineCache, released on destruction
     };
 
 } // namespace Dog
@@ -0,0 +1,483 @@
+#include <PCH/pch.h>
+#include "PipelineCache.h"
+#include "Pipeline.h"
+#include "../Core/Device.h"
+
+namespace Dog {
+
+    // Bump when the compiler settings in compileGLSLtoSPV change, so old SPIR-V isn't reused
+    static constexpr const char* SPIRV_COMPILER_TAG = "glslang vulkan1.3 spv1.6";
+
+    static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x48435044; // "DPCH"
+    static constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+    // Written before the driver's data. The driver checks its own header too, but a cache from another
+    // driver build can still be rejected or, with some drivers, crash, so it's only handed over on a match
+    struct PipelineCacheFileHeader {
+        uint32_t magic = PIPELINE_CACHE_MAGIC;
+        uint32_t version = PIPELINE_CACHE_VERSION;
+        uint32_t vendorID = 0;
+        uint32_t deviceID = 0;
+        uint32_t driverVersion = 0;
+        uint32_t padding = 0;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE]{};
+        uint8_t deviceUUID[VK_UUID_SIZE]{};
+        uint8_t driverUUID[VK_UUID_SIZE]{};
+        uint64_t dataSize = 0;
+        uint64_t dataHash = 0;
+    };
+
+    // FNV-1a, continued from a previous hash when chaining
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    static uint64_t hashValue(const T& value, uint64_t hash) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be hashed as bytes");
+        return hashBytes(&value, sizeof(value), hash);
+    }
+
+    // Every field that affects the pipeline, skipping sType, pNext and the pointers between the config's own structs
+    static uint64_t hashConfig(const PipelineConfigInfo& config, uint64_t hash) {
+        hash = hashBytes(config.bindingDescriptions.data(), sizeof(VkVertexInputBindingDescription) * config.bindingDescriptions.size(), hash);
+        hash = hashBytes(config.attributeDescriptions.data(), sizeof(VkVertexInputAttributeDescription) * config.attributeDescriptions.size(), hash);
+
+        hash = hashValue(config.inputAssemblyInfo.topology, hash);
+        hash = hashValue(config.inputAssemblyInfo.primitiveRestartEnable, hash);
+        hash = hashValue(config.viewportInfo.viewportCount, hash);
+        hash = hashValue(config.viewportInfo.scissorCount, hash);
+
+        const VkPipelineRasterizationStateCreateInfo& raster = config.rasterizationInfo;
+        hash = hashValue(raster.depthClampEnable, hash);
+        hash = hashValue(raster.rasterizerDiscardEnable, hash);
+        hash = hashValue(raster.polygonMode, hash);
+        hash = hashValue(raster.cullMode, hash);
+        hash = hashValue(raster.frontFace, hash);
+        hash = hashValue(raster.depthBiasEnable, hash);
+        hash = hashValue(raster.depthBiasConstantFactor, hash);
+        hash = hashValue(raster.depthBiasClamp, hash);
+        hash = hashValue(raster.depthBiasSlopeFactor, hash);
+        hash = hashValue(raster.lineWidth, hash);
+
+        hash = hashValue(config.multisampleInfo.rasterizationSamples, hash);
+        hash = hashValue(config.multisampleInfo.sampleShadingEnable, hash);
+        hash = hashValue(config.multisampleInfo.minSampleShading, hash);
+        hash = hashValue(config.multisampleInfo.alphaToCoverageEnable, hash);
+        hash = hashValue(config.multisampleInfo.alphaToOneEnable, hash);
+
+        hash = hashValue(config.colorBlendAttachment, hash);
+        hash = hashValue(config.colorBlendInfo.logicOpEnable, hash);
+        hash = hashValue(config.colorBlendInfo.logicOp, hash);
+        hash = hashValue(config.colorBlendInfo.attachmentCount, hash);
+        hash = hashValue(config.colorBlendInfo.blendConstants, hash);
+
+        const VkPipelineDepthStencilStateCreateInfo& depth = config.depthStencilInfo;
+        hash = hashValue(depth.depthTestEnable, hash);
+        hash = hashValue(depth.depthWriteEnable, hash);
+        hash = hashValue(depth.depthCompareOp, hash);
+        hash = hashValue(depth.depthBoundsTestEnable, hash);
+        hash = hashValue(depth.stencilTestEnable, hash);
+        hash = hashValue(depth.front, hash);
+        hash = hashValue(depth.back, hash);
+        hash = hashValue(depth.minDepthBounds, hash);
+        hash = hashValue(depth.maxDepthBounds, hash);
+
+        hash = hashBytes(config.dynamicStateEnables.data(), sizeof(VkDynamicState) * config.dynamicStateEnables.size(), hash);
+
+        hash = hashValue(config.pipelineLayout, hash);
+        hash = hashValue(config.renderPass, hash);
+        hash = hashValue(config.subpass, hash);
+        hash = hashValue(config.basePipelineIndex, hash);
+        hash = hashValue(config.basePipelineHandle, hash);
+        hash = hashValue(config.flags, hash);
+        return hash;
+    }
+
+    static std::string getSpirvCachePath(uint64_t key) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+        return std::string(PipelineCache::CACHE_DIRECTORY) + "/" + name;
+    }
+
+    static std::string getPipelineCachePath() {
+        return std::string(PipelineCache::CACHE_DIRECTORY) + "/pipelines.bin";
+    }
+
+    static bool readFile(const std::string& path, std::vector<char>& contents) {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) return false;
+
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(contents.data(), contents.size());
+        return file.good();
+    }
+
+    // Written next to the target and renamed over it, so a crash never leaves half a file
+    static bool writeFile(const std::string& path, const std::vector<std::pair<const void*, size_t>>& parts) {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+            for (const auto& [data, size] : parts) {
+                file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            }
+            if (!file.good()) return false;
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    static void fillFileHeader(Device& device, PipelineCacheFileHeader& header) {
+        VkPhysicalDeviceIDProperties idProperties{};
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &idProperties;
+        vkGetPhysicalDeviceProperties2(device.getPhysicalDevice(), &properties);
+
+        header.vendorID = properties.properties.vendorID;
+        header.deviceID = properties.properties.deviceID;
+        header.driverVersion = properties.properties.driverVersion;
+        memcpy(header.pipelineCacheUUID, properties.properties.pipelineCacheUUID, VK_UUID_SIZE);
+        memcpy(header.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+        memcpy(header.driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+    }
+
+    PipelineCache::PipelineCache(Device& device)
+        : device{ device } {
+        load();
+    }
+
+    PipelineCache::~PipelineCache() {
+        save();
+
+        // Anything still here was never released, the device is going away regardless
+        for (auto& [key, pipeline] : pipelines) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        }
+        vkDestroyPipelineCache(device, vkPipelineCache, nullptr);
+    }
+
+    void PipelineCache::load() {
+        std::vector<char> contents;
+        const void* initialData = nullptr;
+        size_t initialSize = 0;
+
+        if (readFile(getPipelineCachePath(), contents) && contents.size() >= sizeof(PipelineCacheFileHeader)) {
+            PipelineCacheFileHeader stored;
+            memcpy(&stored, contents.data(), sizeof(stored));
+
+            PipelineCacheFileHeader expected;
+            fillFileHeader(device, expected);
+
+            const char* data = contents.data() + sizeof(stored);
+            bool matches =
+                stored.magic == expected.magic &&
+                stored.version == expected.version &&
+                stored.vendorID == expected.vendorID &&
+                stored.deviceID == expected.deviceID &&
+                stored.driverVersion == expected.driverVersion &&
+                memcmp(stored.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+                memcmp(stored.deviceUUID, expected.deviceUUID, VK_UUID_SIZE) == 0 &&
+                memcmp(stored.driverUUID, expected.driverUUID, VK_UUID_SIZE) == 0 &&
+                stored.dataSize == contents.size() - sizeof(stored) &&
+                stored.dataHash == hashBytes(data, static_cast<size_t>(stored.dataSize));
+
+            if (matches) {
+                initialData = data;
+                initialSize = static_cast<size_t>(stored.dataSize);
+            }
+            else {
+                // The logger isn't up yet while the device is being created
+                std::cout << "Pipeline cache was written by another device or driver, starting a new one" << std::endl;
+            }
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = initialSize;
+        createInfo.pInitialData = initialData;
+
+        // A driver may still refuse data it wrote itself, an empty cache is the fallback
+        VkResult result = vkCreatePipelineCache(device, &createInfo, nullptr, &vkPipelineCache);
+        if (result != VK_SUCCESS && initialData) {
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            initialData = nullptr;
+            result = vkCreatePipelineCache(device, &createInfo, nullptr, &vkPipelineCache);
+        }
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+
+        stats.pipelineCacheLoaded = initialData != nullptr;
+    }
+
+    void PipelineCache::save() {
+        if (vkPipelineCache == VK_NULL_HANDLE) return;
+
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device, vkPipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device, vkPipelineCache, &size, data.data()) != VK_SUCCESS) return;
+        data.resize(size);
+
+        PipelineCacheFileHeader header;
+        fillFileHeader(device, header);
+        header.dataSize = size;
+        header.dataHash = hashBytes(data.data(), size);
+
+        if (!writeFile(getPipelineCachePath(), { { &header, sizeof(header) }, { data.data(), data.size() } })) {
+            DOG_WARN("Failed to write the pipeline cache to {0}", getPipelineCachePath());
+        }
+    }
+
+    void PipelineCache::clearDiskCache() {
+        std::error_code error;
+        std::filesystem::remove_all(CACHE_DIRECTORY, error);
+    }
+
+    PipelineCacheStats PipelineCache::getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    const std::vector<uint32_t>& PipelineCache::getSpirv(const std::string& filepath, EShLanguage stage, const std::string& preamble, uint64_t* hash) {
+        std::vector<char> source = Pipeline::readShaderFile(filepath);
+
+        uint64_t key = hashBytes(source.data(), source.size());
+        key = hashValue(stage, key);
+        key = hashBytes(preamble.data(), preamble.size(), key);
+        key = hashBytes(SPIRV_COMPILER_TAG, strlen(SPIRV_COMPILER_TAG), key);
+
+        // Editing an included file has to change the key as well
+        std::vector<std::string> dependencies = Pipeline::getShaderDependencies(filepath);
+        for (size_t i = 1; i < dependencies.size(); ++i) {
+            std::vector<char> include = Pipeline::readShaderFile(dependencies[i]);
+            key = hashBytes(dependencies[i].data(), dependencies[i].size(), key);
+            key = hashBytes(include.data(), include.size(), key);
+        }
+        if (hash) *hash = key;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = spirv.find(key);
+            if (it != spirv.end()) {
+                stats.shadersFromMemory++;
+                return it->second;
+            }
+        }
+
+        // Compiling happens outside the lock, so other threads can compile other shaders meanwhile
+        std::vector<uint32_t> code;
+        bool fromDisk = false;
+
+        std::vector<char> cached;
+        std::string cachePath = getSpirvCachePath(key);
+        if (readFile(cachePath, cached) && cached.size() >= sizeof(uint32_t) && cached.size() % sizeof(uint32_t) == 0) {
+            code.resize(cached.size() / sizeof(uint32_t));
+            memcpy(code.data(), cached.data(), cached.size());
+            fromDisk = code[0] == SPIRV_MAGIC;
+        }
+
+        if (!fromDisk) {
+            code = compileGLSLtoSPV(std::string(source.begin(), source.end()), stage, preamble, filepath);
+            if (!writeFile(cachePath, { { code.data(), code.size() * sizeof(uint32_t) } })) {
+                DOG_WARN("Failed to cache SPIR-V for {0} at {1}", filepath, cachePath);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [it, inserted] = spirv.try_emplace(key, std::move(code));
+        if (!inserted) {
+            stats.shadersFromMemory++;
+        }
+        else if (fromDisk) {
+            stats.shadersFromDisk++;
+        }
+        else {
+            stats.shadersCompiled++;
+        }
+        return it->second;
+    }
+
+    VkPipeline PipelineCache::findPipeline(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pipelines.find(key);
+        if (it == pipelines.end()) return VK_NULL_HANDLE;
+
+        pipelineUses[it->second].useCount++;
+        stats.pipelinesReused++;
+        return it->second;
+    }
+
+    VkPipeline PipelineCache::addPipeline(uint64_t key, VkPipeline pipeline) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [it, inserted] = pipelines.try_emplace(key, pipeline);
+        if (!inserted) {
+            // Another thread made the same pipeline meanwhile
+            vkDestroyPipeline(device, pipeline, nullptr);
+            pipelineUses[it->second].useCount++;
+            stats.pipelinesReused++;
+        }
+        else {
+            pipelineUses[pipeline] = { key, 1 };
+            stats.pipelinesCreated++;
+        }
+        return it->second;
+    }
+
+    void PipelineCache::releasePipeline(VkPipeline pipeline) {
+        if (pipeline == VK_NULL_HANDLE) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pipelineUses.find(pipeline);
+        assert(it != pipelineUses.end() && "Released a pipeline the cache didn't make");
+        if (it == pipelineUses.end() || --it->second.useCount > 0) return;
+
+        pipelines.erase(it->second.key);
+        pipelineUses.erase(it);
+        vkDestroyPipeline(device, pipeline, nullptr);
+    }
+
+    VkShaderModule PipelineCache::createShaderModule(const std::vector<uint32_t>& code) {
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size() * sizeof(uint32_t); // Size is in bytes
+        createInfo.pCode = code.data();
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module");
+        }
+        return shaderModule;
+    }
+
+    VkPipeline PipelineCache::getGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
+        assert(configInfo.pipelineLayout != VK_NULL_HANDLE &&
+            "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
+        assert(configInfo.renderPass != VK_NULL_HANDLE &&
+            "Cannot create graphics pipeline: no renderPass provided in configInfo");
+
+        std::string preamble;
+        for (const std::string& define : configInfo.shaderDefines) {
+            preamble += "#define " + define + "\n";
+        }
+
+        uint64_t vertHash = 0;
+        uint64_t fragHash = 0;
+        const std::vector<uint32_t>& vertCode = getSpirv(vertFilepath, EShLangVertex, preamble, &vertHash);
+        const std::vector<uint32_t>& fragCode = getSpirv(fragFilepath, EShLangFragment, preamble, &fragHash);
+
+        uint64_t key = hashConfig(configInfo, hashValue(fragHash, hashValue(vertHash, 0xcbf29ce484222325ull)));
+        if (VkPipeline cached = findPipeline(key)) {
+            return cached;
+        }
+
+        // Modules are only needed while the pipeline is created
+        VkShaderModule vertShaderModule = createShaderModule(vertCode);
+        VkShaderModule fragShaderModule = createShaderModule(fragCode);
+
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vertShaderModule;
+        shaderStages[0].pName = "main";
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].pName = "main";
+
+        auto& bindingDescriptions = configInfo.bindingDescriptions;
+        auto& attributeDescriptions = configInfo.attributeDescriptions;
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
+        pipelineInfo.pViewportState = &configInfo.viewportInfo;
+        pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
+        pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+        pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+        pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
+        pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+
+        pipelineInfo.layout = configInfo.pipelineLayout;
+        pipelineInfo.renderPass = configInfo.renderPass;
+        pipelineInfo.subpass = configInfo.subpass;
+
+        pipelineInfo.basePipelineIndex = configInfo.basePipelineIndex;
+        pipelineInfo.basePipelineHandle = configInfo.basePipelineHandle;
+        pipelineInfo.flags = configInfo.flags;
+
+        VkPipeline pipeline;
+        VkResult result = vkCreateGraphicsPipelines(device, vkPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+        vkDestroyShaderModule(device, vertShaderModule, nullptr);
+        vkDestroyShaderModule(device, fragShaderModule, nullptr);
+
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create graphics pipeline");
+        }
+
+        return addPipeline(key, pipeline);
+    }
+
+    VkPipeline PipelineCache::getComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout) {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        uint64_t compHash = 0;
+        const std::vector<uint32_t>& compCode = getSpirv(compFilepath, EShLangCompute, "", &compHash);
+
+        uint64_t key = hashValue(pipelineLayout, hashValue(compHash, 0xcbf29ce484222325ull));
+        if (VkPipeline cached = findPipeline(key)) {
+            return cached;
+        }
+
+        VkShaderModule compShaderModule = createShaderModule(compCode);
+
+        VkPipelineShaderStageCreateInfo shaderStage{};
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        shaderStage.module = compShaderModule;
+        shaderStage.pName = "main";
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = shaderStage;
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline;
+        VkResult result = vkCreateComputePipelines(device, vkPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(device, compShaderModule, nullptr);
+
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+
+        return addPipeline(key, pipeline);
+    }
+
+} // namespace Dog
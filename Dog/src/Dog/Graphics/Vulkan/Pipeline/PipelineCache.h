@@ -0,0 +1,81 @@
+#pragma once
+
+#include "glslang/Public/ShaderLang.h"
+
+namespace Dog {
+
+    class Device;
+    struct PipelineConfigInfo;
+
+    struct PipelineCacheStats {
+        uint32_t shadersCompiled = 0;   // Ran glslang
+        uint32_t shadersFromDisk = 0;   // Read from the SPIR-V cache
+        uint32_t shadersFromMemory = 0; // Already used this run
+        uint32_t pipelinesCreated = 0;
+        uint32_t pipelinesReused = 0;   // Identical to one created earlier this run
+        bool pipelineCacheLoaded = false; // The driver's cache from last run matched this device
+    };
+
+    // Everything that makes creating pipelines at startup slow, cached:
+    //  - SPIR-V, in memory and in assets/shaders/cache, keyed by a hash of the source, stage and defines
+    //  - the driver's VkPipelineCache, loaded at creation if it was written by the same device and driver,
+    //    and saved when the cache is destroyed
+    //  - pipelines, keyed by a hash of their state and shaders, so identical ones are only created once.
+    //    Every pipeline handed out is counted, and destroyed once each of them has been released
+    // Owned by the Device, get it with Device::getPipelineCache. Safe to use from any thread.
+    class PipelineCache {
+    public:
+        static constexpr const char* CACHE_DIRECTORY = "assets/shaders/cache";
+
+        PipelineCache(Device& device);
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        // SPIR-V of a shader in assets/shaders, compiled only when neither memory nor disk has it. The key covers
+        // the files it #includes too. The preamble is inserted after the #version line. hash gets the code's key
+        const std::vector<uint32_t>& getSpirv(const std::string& filepath, EShLanguage stage, const std::string& preamble = "", uint64_t* hash = nullptr);
+
+        VkPipeline getGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+        VkPipeline getComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+
+        // Gives back a pipeline from getGraphicsPipeline or getComputePipeline. The last release destroys it,
+        // so the GPU must be done with it
+        void releasePipeline(VkPipeline pipeline);
+
+        // Writes the driver's pipeline cache to disk, also done on destruction
+        void save();
+
+        // Deletes every cached shader and the pipeline cache file, for measuring a cold start
+        static void clearDiskCache();
+
+        PipelineCacheStats getStats() const;
+        VkPipelineCache getVkPipelineCache() const { return vkPipelineCache; }
+
+    private:
+        void load();
+        VkShaderModule createShaderModule(const std::vector<uint32_t>& code);
+
+        // Returns the pipeline made for the key if there is one, counting the use
+        VkPipeline findPipeline(uint64_t key);
+
+        // Keeps a pipeline just created, unless another thread made the same one meanwhile
+        VkPipeline addPipeline(uint64_t key, VkPipeline pipeline);
+
+        struct CachedPipeline {
+            uint64_t key;
+            uint32_t useCount;
+        };
+
+        Device& device;
+        VkPipelineCache vkPipelineCache = VK_NULL_HANDLE;
+
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> spirv;
+        std::unordered_map<uint64_t, VkPipeline> pipelines;
+        std::unordered_map<VkPipeline, CachedPipeline> pipelineUses;
+        PipelineCacheStats stats;
+    };
+
+} // namespace Dog
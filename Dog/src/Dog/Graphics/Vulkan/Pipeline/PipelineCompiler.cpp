@@ -0,0 +1,197 @@
+#include <PCH/pch.h>
+#include "PipelineCompiler.h"
+#include "PipelineCache.h"
+
+namespace Dog {
+
+    AsyncPipeline::~AsyncPipeline() {
+        if (!cache) return;
+
+        cache->releasePipeline(pipeline.load(std::memory_order_acquire));
+        cache->releasePipeline(rebuilt.load(std::memory_order_acquire));
+    }
+
+    // Every file the sources include, each listed once
+    static std::vector<std::string> getDependencies(const std::vector<std::string>& sources) {
+        std::vector<std::string> dependencies;
+        for (const std::string& source : sources) {
+            for (std::string& dependency : Pipeline::getShaderDependencies(source)) {
+                if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end()) {
+                    dependencies.push_back(std::move(dependency));
+                }
+            }
+        }
+        return dependencies;
+    }
+
+    PipelineCompiler::PipelineCompiler(Device& device, JobSystem& jobSystem, uint32_t framesInFlight)
+        : device{ device }
+        , jobSystem{ jobSystem }
+        , framesInFlight{ framesInFlight } {
+    }
+
+    PipelineCompiler::~PipelineCompiler() {
+        // Jobs still running hold the device and glslang, which must outlive them
+        for (auto& weakPipeline : pipelines) {
+            if (auto pipeline = weakPipeline.lock()) {
+                jobSystem.Wait(pipeline->counter);
+            }
+        }
+
+        vkDeviceWaitIdle(device);
+        for (const RetiredPipeline& retired : retiredPipelines) {
+            device.getPipelineCache().releasePipeline(retired.pipeline);
+        }
+    }
+
+    std::shared_ptr<AsyncPipeline> PipelineCompiler::compileGraphics(
+        const std::string& vertFilepath,
+        const std::string& fragFilepath,
+        ConfigureFunction configure,
+        std::shared_ptr<AsyncPipeline> basePipeline) {
+        auto create = [this, vertFilepath, fragFilepath, configure = std::move(configure), basePipeline]() {
+            PipelineConfigInfo config{};
+            Pipeline::defaultPipelineConfigInfo(config);
+            configure(config);
+
+            if (basePipeline) {
+                // A failed base leaves this as a plain pipeline
+                VkPipeline base = basePipeline->getPipeline();
+                config.basePipelineIndex = -1;
+                config.basePipelineHandle = base;
+                config.flags = base != VK_NULL_HANDLE
+                    ? config.flags | VK_PIPELINE_CREATE_DERIVATIVE_BIT
+                    : config.flags & ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+            }
+
+            return device.getPipelineCache().getGraphicsPipeline(vertFilepath, fragFilepath, config);
+        };
+
+        return compile(
+            vertFilepath + " + " + fragFilepath,
+            { vertFilepath, fragFilepath },
+            std::move(create),
+            basePipeline ? &basePipeline->counter : nullptr);
+    }
+
+    std::shared_ptr<AsyncPipeline> PipelineCompiler::compileCompute(const std::string& compFilepath, VkPipelineLayout pipelineLayout) {
+        auto create = [this, compFilepath, pipelineLayout]() {
+            return device.getPipelineCache().getComputePipeline(compFilepath, pipelineLayout);
+        };
+
+        return compile(compFilepath, { compFilepath }, std::move(create), nullptr);
+    }
+
+    std::shared_ptr<AsyncPipeline> PipelineCompiler::compile(const std::string& name, std::vector<std::string> sources, std::function<VkPipeline()> create, JobCounter* dependency) {
+        auto pipeline = std::make_shared<AsyncPipeline>();
+        pipeline->cache = &device.getPipelineCache();
+        pipeline->name = name;
+        pipeline->dependencies = getDependencies(sources);
+        pipeline->sources = std::move(sources);
+        pipeline->create = std::move(create);
+
+        // Requests that went away are only dropped now and then
+        std::erase_if(pipelines, [](const std::weak_ptr<AsyncPipeline>& weakPipeline) { return weakPipeline.expired(); });
+        pipelines.push_back(pipeline);
+        pendingCount.fetch_add(1, std::memory_order_acq_rel);
+
+        // The job keeps the pipeline alive, so dropping a request early is safe
+        jobSystem.Run([this, pipeline]() {
+            try {
+                // A rebuild that finished first has already been swapped in, and is newer
+                VkPipeline created = pipeline->create();
+                VkPipeline expected = VK_NULL_HANDLE;
+                if (!pipeline->pipeline.compare_exchange_strong(expected, created, std::memory_order_acq_rel)) {
+                    device.getPipelineCache().releasePipeline(created);
+                }
+            }
+            catch (const std::exception& e) {
+                DOG_ERROR("Failed to compile pipeline {0}: {1}", pipeline->name, e.what());
+                pipeline->failed.store(true, std::memory_order_release);
+            }
+            pendingCount.fetch_sub(1, std::memory_order_acq_rel);
+        }, &pipeline->counter, dependency);
+
+        return pipeline;
+    }
+
+    void PipelineCompiler::wait(AsyncPipeline& pipeline) {
+        jobSystem.Wait(pipeline.counter);
+    }
+
+    void PipelineCompiler::reloadShader(const std::string& path) {
+        // Events may name the file with or without the shader directory
+        static const std::string SHADER_DIRECTORY = "assets/shaders/";
+        std::string file = std::filesystem::path(path).lexically_normal().generic_string();
+        if (file.rfind(SHADER_DIRECTORY, 0) == 0) {
+            file = file.substr(SHADER_DIRECTORY.size());
+        }
+
+        for (auto& weakPipeline : pipelines) {
+            auto pipeline = weakPipeline.lock();
+            if (!pipeline) continue;
+
+            // A failed pipeline may have been missing this very file
+            bool dependsOnFile = std::find(pipeline->dependencies.begin(), pipeline->dependencies.end(), file) != pipeline->dependencies.end();
+            if (dependsOnFile || pipeline->hasFailed()) {
+                rebuild(pipeline);
+            }
+        }
+    }
+
+    void PipelineCompiler::rebuild(const std::shared_ptr<AsyncPipeline>& pipeline) {
+        // An edit may have added or removed includes
+        pipeline->dependencies = getDependencies(pipeline->sources);
+
+        uint32_t generation = pipeline->generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+        pendingCount.fetch_add(1, std::memory_order_acq_rel);
+
+        jobSystem.Run([this, pipeline, generation]() {
+            try {
+                VkPipeline rebuilt = pipeline->create();
+
+                // A newer rebuild may have started while this one compiled, only the newest is kept
+                std::lock_guard<std::mutex> lock(rebuildMutex);
+                if (pipeline->generation.load(std::memory_order_acquire) != generation) {
+                    device.getPipelineCache().releasePipeline(rebuilt);
+                }
+                else {
+                    device.getPipelineCache().releasePipeline(pipeline->rebuilt.exchange(rebuilt, std::memory_order_acq_rel));
+                }
+            }
+            catch (const std::exception& e) {
+                DOG_ERROR("Failed to rebuild pipeline {0}, keeping the old one: {1}", pipeline->name, e.what());
+            }
+            pendingCount.fetch_sub(1, std::memory_order_acq_rel);
+        }, &pipeline->counter);
+    }
+
+    void PipelineCompiler::update() {
+        ++frame;
+
+        for (auto& weakPipeline : pipelines) {
+            auto pipeline = weakPipeline.lock();
+            if (!pipeline) continue;
+
+            VkPipeline rebuilt = pipeline->rebuilt.exchange(VK_NULL_HANDLE, std::memory_order_acq_rel);
+            if (rebuilt == VK_NULL_HANDLE) continue;
+
+            // Frames already submitted keep drawing with the old one
+            VkPipeline replaced = pipeline->pipeline.exchange(rebuilt, std::memory_order_acq_rel);
+            pipeline->failed.store(false, std::memory_order_release);
+            if (replaced != VK_NULL_HANDLE) {
+                retiredPipelines.push_back({ replaced, frame });
+            }
+            DOG_INFO("Reloaded pipeline {0}", pipeline->name);
+        }
+
+        // A pipeline replaced at frame N was last recorded in frame N - 1, whose fence has been waited on
+        // by the time frame N + framesInFlight begins
+        std::erase_if(retiredPipelines, [this](const RetiredPipeline& retired) {
+            if (frame < retired.frame + framesInFlight) return false;
+            device.getPipelineCache().releasePipeline(retired.pipeline);
+            return true;
+        });
+    }
+
+} // namespace Dog
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Pipeline.h"
+#include "Jobs/JobSystem.h"
+
+namespace Dog {
+
+    class PipelineCache;
+
+    // A pipeline being made on a job thread. It's VK_NULL_HANDLE until the job is done, and stays that
+    // way if compiling failed, so whoever draws with it needs something else to draw with meanwhile.
+    // When one of its shaders changes it's rebuilt and the new pipeline replaces it between frames
+    class AsyncPipeline {
+    public:
+        AsyncPipeline() = default;
+        ~AsyncPipeline();
+
+        AsyncPipeline(const AsyncPipeline&) = delete;
+        AsyncPipeline& operator=(const AsyncPipeline&) = delete;
+
+        bool isReady() const { return getPipeline() != VK_NULL_HANDLE; }
+        bool isDone() const { return counter.IsDone(); }
+        bool hasFailed() const { return failed.load(std::memory_order_acquire); }
+
+        // From the device's PipelineCache. Only changes between frames
+        VkPipeline getPipeline() const { return pipeline.load(std::memory_order_acquire); }
+
+    private:
+        friend class PipelineCompiler;
+
+        std::atomic<VkPipeline> pipeline{ VK_NULL_HANDLE };
+        std::atomic<bool> failed{ false };
+        JobCounter counter;
+        PipelineCache* cache = nullptr;
+
+        // How to make it again, for hot reloading
+        std::string name;
+        std::vector<std::string> sources;
+        std::vector<std::string> dependencies; // The sources and everything they include
+        std::function<VkPipeline()> create;
+
+        // A rebuilt pipeline waiting for the next frame. Only the newest rebuild may publish here
+        std::atomic<VkPipeline> rebuilt{ VK_NULL_HANDLE };
+        std::atomic<uint32_t> generation{ 0 };
+    };
+
+    // Compiles shaders and creates pipelines on the job system, so adding pipelines doesn't stall the frame.
+    // Everything goes through the device's PipelineCache, so a pipeline made before is ready almost at once.
+    // It also hot reloads shaders: pipelines using a shader that changed, or a file it includes, are rebuilt in
+    // the background and swapped in by update, and the ones they replace are released once no frame in flight
+    // can still be using them. Requests, waits and updates are main thread only
+    class PipelineCompiler {
+    public:
+        // Fills in a pipeline's config on the job thread, after Pipeline::defaultPipelineConfigInfo.
+        // PipelineConfigInfo points into itself so it can't be copied, instead it's made where it's used
+        using ConfigureFunction = std::function<void(PipelineConfigInfo&)>;
+
+        PipelineCompiler(Device& device, JobSystem& jobSystem, uint32_t framesInFlight);
+        ~PipelineCompiler();
+
+        PipelineCompiler(const PipelineCompiler&) = delete;
+        PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+        // With a base pipeline this becomes its derivative, and starts once the base is done
+        std::shared_ptr<AsyncPipeline> compileGraphics(
+            const std::string& vertFilepath,
+            const std::string& fragFilepath,
+            ConfigureFunction configure,
+            std::shared_ptr<AsyncPipeline> basePipeline = nullptr);
+
+        std::shared_ptr<AsyncPipeline> compileCompute(const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+
+        // Runs jobs on this thread until the pipeline is done, for the few a frame can't do without
+        void wait(AsyncPipeline& pipeline);
+
+        // Called at the start of each frame, once its fence has been waited on. Swaps in rebuilt pipelines
+        // and releases replaced ones that every frame in flight is done with
+        void update();
+
+        // Rebuilds every pipeline whose shaders are or include the file, a path under assets/shaders
+        void reloadShader(const std::string& path);
+
+        // Pipelines requested or being rebuilt that aren't done yet
+        uint32_t getPendingCount() const { return pendingCount.load(std::memory_order_acquire); }
+
+    private:
+        std::shared_ptr<AsyncPipeline> compile(const std::string& name, std::vector<std::string> sources, std::function<VkPipeline()> create, JobCounter* dependency);
+
+        void rebuild(const std::shared_ptr<AsyncPipeline>& pipeline);
+
+        struct RetiredPipeline {
+            VkPipeline pipeline;
+            uint64_t frame; // When it was replaced
+        };
+
+        Device& device;
+        JobSystem& jobSystem;
+        uint32_t framesInFlight;
+
+        std::vector<std::weak_ptr<AsyncPipeline>> pipelines;
+        std::vector<RetiredPipeline> retiredPipelines;
+        uint64_t frame = 0;
+        std::atomic<uint32_t> pendingCount{ 0 };
+        std::mutex rebuildMutex; // Orders rebuilds finishing together
+    };
+
+} // namespace Dog
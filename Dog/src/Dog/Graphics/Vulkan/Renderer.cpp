@@ -2,46 +2,67 @@
 #include "Renderer.h"
 #include "Systems/SimpleRenderSystem.h"
 #include "Systems/PointLightSystem.h"
+#include "Systems/CullingSystem.h"
+#include "Systems/LightClusterSystem.h"
+#include "Systems/SkinningSystem.h"
+#include "Systems/AnimationSystem.h"
+#include "Systems/CrowdSystem.h"
 #include "Camera.h"
 #include "Descriptors/Descriptors.h"
 #include "Texture/TextureLibrary.h"
 #include "Models/ModelLibrary.h"
 #include "glslang/Public/ShaderLang.h"
 #include "Core/SwapChain.h"
+#include "Core/UploadManager.h"
+#include "Core/ParallelRecorder.h"
+#include "Pipeline/PipelineCompiler.h"
 #include "Input/KeyboardController.h"
 #include "Entities/GameObject.h"
 #include "Input/input.h"
+#include "Scene/SceneManager.h"
+#include "Scene/Scene.h"
 
 #include "Engine.h"
 
 #include "Graphics/Editor/Editor.h"
+#include "Profiling/FrameProfiler.h"
 
 namespace Dog {
 
-    Renderer::Renderer(Window& window, Device& device)
+    Renderer::Renderer(Window& window, Device& device, JobSystem& jobSystem, uint32_t recordBuckets)
         : m_Window{ window }
         , device{ device }
         , globalDescriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
         , uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
-        , bonesUboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        , instanceBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
     {
         recreateSwapChain();
         createCommandBuffers();
 
+        profiler = std::make_unique<FrameProfiler>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+        recorder = std::make_unique<ParallelRecorder>(device, jobSystem, recordBuckets, SwapChain::MAX_FRAMES_IN_FLIGHT);
+
         globalPool =
             DescriptorPool::Builder(device)
             .setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
             .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURE_COUNT)
-            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, SwapChain::MAX_FRAMES_IN_FLIGHT * 5)
             .build();
 
         glslang::InitializeProcess();
+        pipelineCompiler = std::make_unique<PipelineCompiler>(device, jobSystem, SwapChain::MAX_FRAMES_IN_FLIGHT);
 
-        Input::Init(m_Window.getGLFWwindow());
+        if (!m_Window.isHeadless()) {
+            Input::Init(m_Window.getGLFWwindow());
+        }
     }
 
     Renderer::~Renderer() {
+        // Waits for pipelines still compiling, which use glslang
+        shaderModifiedHandle.reset();
+        shaderCreatedHandle.reset();
+        pipelineCompiler.reset();
+        profiler.reset();
         freeCommandBuffers();
         glslang::FinalizeProcess();
     }
@@ -51,19 +72,23 @@ namespace Dog {
         auto& textureLibrary = Engine::Get().GetTextureLibrary();
         auto& modelLibrary = Engine::Get().GetModelLibrary();
 
-        textureLibrary.AddTexture("assets/textures/square.png");
-        textureLibrary.AddTexture("assets/textures/texture.jpg");
-        textureLibrary.AddTexture("assets/textures/dog.png");
-        textureLibrary.AddTexture("assets/textures/viking_room.png");
-        textureLibrary.AddTexture("assets/models/ModelTextures/Book.png");
-
-        modelLibrary.AddModel("assets/models/quad.obj");
-        modelLibrary.AddModel("assets/models/charles.glb");
-        modelLibrary.AddModel("assets/models/AlisaMikhailovna.fbx");
-        modelLibrary.AddModel("assets/models/Mon_BlackDragon31_Skeleton.FBX");
-        modelLibrary.AddModel("assets/models/Book.fbx");
-        modelLibrary.AddModel("assets/models/smooth_vase.obj");
-        modelLibrary.AddModel("assets/models/viking_room.obj");
+        const std::string texturePaths[] = {
+            "assets/textures/square.png",
+            "assets/textures/texture.jpg",
+            "assets/textures/dog.png",
+            "assets/textures/viking_room.png",
+            "assets/models/ModelTextures/Book.png",
+        };
+        textureLibrary.AddTextures(texturePaths);
+
+        // The placeholder is loaded synchronously, everything else streams in
+        modelLibrary.AddModel(ModelLibrary::PLACEHOLDER_MODEL_PATH);
+        modelLibrary.AddModelAsync("assets/models/charles.glb");
+        modelLibrary.AddModelAsync("assets/models/AlisaMikhailovna.fbx");
+        modelLibrary.AddModelAsync("assets/models/Mon_BlackDragon31_Skeleton.FBX");
+        modelLibrary.AddModelAsync("assets/models/Book.fbx");
+        modelLibrary.AddModelAsync("assets/models/smooth_vase.obj");
+        modelLibrary.AddModelAsync("assets/models/viking_room.obj");
 
         for (size_t i = 0; i < uboBuffers.size(); i++) {
             uboBuffers[i] = std::make_unique<Buffer>(
@@ -75,48 +100,52 @@ namespace Dog {
             uboBuffers[i]->map();
         }
 
-        for (size_t i = 0; i < bonesUboBuffers.size(); i++) {
-            bonesUboBuffers[i] = std::make_unique<Buffer>(
+        for (size_t i = 0; i < instanceBuffers.size(); i++) {
+            instanceBuffers[i] = std::make_unique<Buffer>(
                 device,
-                sizeof(BonesUbo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VMA_MEMORY_USAGE_CPU_ONLY);
-            bonesUboBuffers[i]->map();
+                sizeof(InstanceData),
+                MAX_INSTANCES,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            instanceBuffers[i]->map();
         }
 
-        auto globalSetLayout =
+        cullingSystem = std::make_unique<CullingSystem>(device, instanceBuffers, *pipelineCompiler);
+        lightClusterSystem = std::make_unique<LightClusterSystem>(device, *pipelineCompiler);
+        skinningSystem = std::make_unique<SkinningSystem>(device, modelLibrary.GetGeometryPool(), *pipelineCompiler);
+        animationSystem = std::make_unique<AnimationSystem>(
+            Engine::Get().GetJobSystem(),
+            modelLibrary,
+            Engine::Get().GetAnimationLibrary(),
+            *skinningSystem);
+        animationSystem->setUpdateLodEnabled(animationLodEnabled);
+
+        globalSetLayout =
             DescriptorSetLayout::Builder(device)
             .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-            .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_TEXTURE_COUNT)
-            .addBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+            .addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .addBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .build();
 
-        // Atleast 1 texture must be added by this point, or uh-oh.
-        // Set up image infos for the descriptor set
-        std::vector<VkDescriptorImageInfo> imageInfos(MAX_TEXTURE_COUNT);
-        for (size_t j = 0; j < MAX_TEXTURE_COUNT; j++) {
-            if (j < textureLibrary.getTextureCount()) {
-                imageInfos[j].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                imageInfos[j].imageView = textureLibrary.getTextureByIndex(j).getImageView();
-                imageInfos[j].sampler = textureLibrary.getTextureByIndex(j).getSampler();
-            }
-            else {
-                imageInfos[j].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                imageInfos[j].imageView = textureLibrary.getTextureByIndex(0).getImageView();
-                imageInfos[j].sampler = textureLibrary.getTextureByIndex(0).getSampler();
-            }
-        }
-
         // Create descriptor sets
         for (size_t i = 0; i < globalDescriptorSets.size(); i++) {
             auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            auto boneBufferInfo = bonesUboBuffers[i]->descriptorInfo();
+            auto instanceBufferInfo = instanceBuffers[i]->descriptorInfo();
+            auto visibleInstanceInfo = cullingSystem->getVisibleInstanceBuffer(static_cast<int>(i)).descriptorInfo();
+            auto lightInfo = lightClusterSystem->getLightBuffer(static_cast<int>(i)).descriptorInfo();
+            auto clusterInfo = lightClusterSystem->getClusterBuffer(static_cast<int>(i)).descriptorInfo();
+            auto lightIndexInfo = lightClusterSystem->getLightIndexBuffer(static_cast<int>(i)).descriptorInfo();
 
             DescriptorWriter(*globalSetLayout, *globalPool)
                 .writeBuffer(0, &bufferInfo)
-                .writeImage(1, imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
-                .writeBuffer(2, &boneBufferInfo)
+                .writeBuffer(3, &instanceBufferInfo)
+                .writeBuffer(4, &visibleInstanceInfo)
+                .writeBuffer(5, &lightInfo)
+                .writeBuffer(6, &clusterInfo)
+                .writeBuffer(7, &lightIndexInfo)
                 .build(globalDescriptorSets[i]);
         }
 
@@ -125,12 +154,36 @@ namespace Dog {
 			getSwapChainRenderPass(),
 			globalSetLayout->getDescriptorSetLayout(),
 			textureLibrary,
-			modelLibrary);
+			modelLibrary,
+			*cullingSystem,
+			*skinningSystem,
+			*recorder,
+			*pipelineCompiler);
+        simpleRenderSystem->setLodQuality(lodQuality);
+        simpleRenderSystem->setDrawSortingEnabled(drawSortingEnabled);
 
         pointLightSystem = std::make_unique<PointLightSystem>(
             device,
             getSwapChainRenderPass(),
-            globalSetLayout->getDescriptorSetLayout());       
+            globalSetLayout->getDescriptorSetLayout(),
+            *pipelineCompiler);
+
+        crowdSystem = std::make_unique<CrowdSystem>(
+            device,
+            getSwapChainRenderPass(),
+            globalSetLayout->getDescriptorSetLayout(),
+            textureLibrary,
+            modelLibrary,
+            Engine::Get().GetAnimationLibrary(),
+            *pipelineCompiler);
+
+        // A new file can be an include a pipeline failed to find
+        shaderModifiedHandle = Events::Subscribe<Event::ShaderFileModified>([this](const Event::ShaderFileModified& event) {
+            pipelineCompiler->reloadShader(event.path);
+        });
+        shaderCreatedHandle = Events::Subscribe<Event::ShaderFileCreated>([this](const Event::ShaderFileCreated& event) {
+            pipelineCompiler->reloadShader(event.path);
+        });
 
         // Temporary camera controller
         cameraController = std::make_unique<KeyboardMovementController>();
@@ -159,47 +212,174 @@ namespace Dog {
 
         // Start the frame
         if (auto commandBuffer = beginFrame()) {
-            Engine::Get().GetEditor().BeginFrame();
+            if (!m_Window.isHeadless()) {
+                Engine::Get().GetEditor().BeginFrame();
+            }
 
             int frameIndex = getFrameIndex();
+
+            // The frame's fence has been waited on, so rebuilt pipelines can be swapped in and old ones retired
+            pipelineCompiler->update();
+
+            // Writes textures added since the last frame into the bindless set, and frees removed ones
+            textureLibrary.Update();
+
             FrameInfo frameInfo{
                 frameIndex,
                 dt,
                 commandBuffer,
                 camera,
                 globalDescriptorSets[frameIndex],
-                gameObjects };
+                gameObjects,
+                *instanceBuffers[frameIndex] };
 
             // update
             GlobalUbo ubo{};
             ubo.projection = camera.getProjection();
             ubo.view = camera.getView();
             ubo.inverseView = camera.getInverseView();
-            pointLightSystem->update(frameInfo, ubo);
+            ubo.viewport = glm::vec4(m_SwapChain->width(), m_SwapChain->height(), 0.f, 0.f);
+            if (lightClusterSystem->update(frameInfo, SceneManager::GetCurrentScene()->GetRegistry(), ubo)) {
+                // The frame's light buffer grew. Nothing in flight uses this frame's set, so it can be rewritten
+                auto lightInfo = lightClusterSystem->getLightBuffer(frameIndex).descriptorInfo();
+                DescriptorWriter(*globalSetLayout, *globalPool)
+                    .writeBuffer(5, &lightInfo)
+                    .overwrite(globalDescriptorSets[frameIndex]);
+            }
+
+            // Without point lights only the ambient lights the scene, so it's full to keep unlit scenes as they were
+            if (const auto& ambientLight = SceneManager::GetCurrentScene()->GetAmbientLight()) {
+                ubo.ambientLightColor = *ambientLight;
+            }
+            else if (lightClusterSystem->getLightCount() == 0) {
+                ubo.ambientLightColor.w = 1.f;
+            }
             uboBuffers[frameIndex]->writeToBuffer(&ubo);
             uboBuffers[frameIndex]->flush();
 
-            // animator->UpdateAnimation(frameTime);
-            /*BonesUbo bonesUbo{};
-            auto transforms = animator->GetFinalBoneMatrices();
-            for (size_t i = 0; i < transforms.size(); i++) {
-                bonesUbo.finalBonesMatrices[i] = transforms[i];
-            }
-            bonesUboBuffers[frameIndex]->writeToBuffer(&bonesUbo);
-            bonesUboBuffers[frameIndex]->flush();*/
+            // Animators write their palettes into this frame's palette buffer, which the skinning pass reads
+            skinningSystem->beginFrame(frameIndex);
+            animationSystem->update(dt, SceneManager::GetCurrentScene()->GetRegistry(), camera);
+
+            // skin and cull, compute work has to be recorded before the render pass begins
+            simpleRenderSystem->prepareFrame(frameInfo);
+            crowdSystem->prepareFrame(frameInfo, SceneManager::GetCurrentScene()->GetRegistry());
+            lightClusterSystem->assignLights(frameInfo);
+
+            const CullingStats& cullingStats = cullingSystem->getStats();
+            profiler->RecordCounter("visibleInstances", cullingStats.visibleInstances);
+            profiler->RecordCounter("culledInstances", cullingStats.culledInstances);
+            profiler->RecordCounter("pendingModelLoads", modelLibrary.GetPendingLoadCount());
+
+            const TriangleStats& triangleStats = simpleRenderSystem->getTriangleStats();
+            profiler->RecordCounter("fullDetailTriangles", static_cast<double>(triangleStats.fullDetail));
+            profiler->RecordCounter("submittedTriangles", static_cast<double>(triangleStats.submitted));
+            profiler->RecordCounter("pendingPipelines", pipelineCompiler->getPendingCount());
+            profiler->RecordCounter("fallbackDraws", simpleRenderSystem->getFallbackDrawCount());
+
+            const SkinningStats& skinningStats = skinningSystem->getStats();
+            profiler->RecordCounter("skinnedInstances", skinningStats.skinnedInstances);
+            profiler->RecordCounter("skinnedVertices", skinningStats.skinnedVertices);
+
+            const AnimationStats& animationStats = animationSystem->getStats();
+            profiler->RecordCounter("animatedSkeletons", animationStats.animatedSkeletons);
+            profiler->RecordCounter("evaluatedSkeletons", animationStats.evaluatedSkeletons);
+            profiler->RecordCounter("skippedSkeletons", animationStats.interpolatedSkeletons + animationStats.culledSkeletons);
+            profiler->RecordCounter("culledSkeletons", animationStats.culledSkeletons);
+            profiler->RecordCounter("animatedBones", animationStats.animatedBones);
+            profiler->RecordCounter("animationUpdateMs", animationStats.updateMs);
+
+            const CrowdStats& crowdStats = crowdSystem->getStats();
+            profiler->RecordCounter("crowdInstances", crowdStats.crowdInstances);
+            profiler->RecordCounter("crowdDraws", crowdStats.crowdDraws);
+            profiler->RecordCounter("bakedAnimationBytes", static_cast<double>(crowdStats.bakedBytes));
+
+            const LightStats& lightStats = lightClusterSystem->getStats();
+            profiler->RecordCounter("pointLights", lightStats.pointLights);
+            profiler->RecordCounter("clusterLightAssignments", lightStats.lightAssignments);
+            profiler->RecordCounter("maxClusterLights", lightStats.maxClusterLights);
+            profiler->RecordCounter("overflowedClusters", lightStats.overflowedClusters);
+
+            // Binds from both systems, recorded inline they're the previous frame's
+            const DrawRecordStats& drawRecordStats = simpleRenderSystem->getDrawRecordStats();
+            DrawStateStats binds = drawRecordStats.binds;
+            binds += crowdStats.binds;
+            profiler->RecordCounter("pipelineBinds", binds.pipelineBinds);
+            profiler->RecordCounter("vertexBufferBinds", binds.vertexBufferBinds);
+            profiler->RecordCounter("indexBufferBinds", binds.indexBufferBinds);
+            profiler->RecordCounter("pushConstantUpdates", binds.pushConstantUpdates);
+            profiler->RecordCounter("skippedBinds", binds.skippedBinds);
+            profiler->RecordCounter("drawSortMs", drawRecordStats.sortMs);
+            profiler->RecordCounter("drawRecordMs", drawRecordStats.recordMs);
 
             // render
-            beginSwapChainRenderPass(commandBuffer);
-            simpleRenderSystem->renderGameObjects(frameInfo);
-            pointLightSystem->render(frameInfo);
-
-            Engine::Get().GetEditor().EndFrame(commandBuffer);
+            if (recorder->isParallel()) {
+                // Once a subpass takes secondaries it can't have inline commands, so the overlay gets one too
+                beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                simpleRenderSystem->renderGameObjects(frameInfo);
+
+                VkCommandBuffer overlayCommandBuffer = recorder->beginSecondary();
+                FrameInfo overlayInfo{
+                    frameIndex,
+                    dt,
+                    overlayCommandBuffer,
+                    camera,
+                    globalDescriptorSets[frameIndex],
+                    gameObjects,
+                    *instanceBuffers[frameIndex] };
+                crowdSystem->render(overlayInfo);
+                pointLightSystem->render(overlayInfo, lightClusterSystem->getLightCount());
+
+                if (!m_Window.isHeadless()) {
+                    Engine::Get().GetEditor().EndFrame(overlayCommandBuffer);
+                }
+
+                if (vkEndCommandBuffer(overlayCommandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to record command buffer!");
+                }
+                vkCmdExecuteCommands(commandBuffer, 1, &overlayCommandBuffer);
+            }
+            else {
+                beginSwapChainRenderPass(commandBuffer);
+                simpleRenderSystem->renderGameObjects(frameInfo);
+                crowdSystem->render(frameInfo);
+                pointLightSystem->render(frameInfo, lightClusterSystem->getLightCount());
+
+                if (!m_Window.isHeadless()) {
+                    Engine::Get().GetEditor().EndFrame(commandBuffer);
+                }
+            }
 
             endSwapChainRenderPass(commandBuffer);
             endFrame();
         }
     }
 
+    const CullingStats& Renderer::GetCullingStats() const {
+        return cullingSystem->getStats();
+    }
+
+    void Renderer::SetLodQuality(float quality) {
+        lodQuality = quality;
+        if (simpleRenderSystem) {
+            simpleRenderSystem->setLodQuality(quality);
+        }
+    }
+
+    void Renderer::SetAnimationLodEnabled(bool enabled) {
+        animationLodEnabled = enabled;
+        if (animationSystem) {
+            animationSystem->setUpdateLodEnabled(enabled);
+        }
+    }
+
+    void Renderer::SetDrawSortingEnabled(bool enabled) {
+        drawSortingEnabled = enabled;
+        if (simpleRenderSystem) {
+            simpleRenderSystem->setDrawSortingEnabled(enabled);
+        }
+    }
+
     void Renderer::Exit()
     {
         // Wait until the device is idle before cleaning up resources
@@ -266,6 +446,13 @@ namespace Dog {
 
         isFrameStarted = true;
 
+        // The acquire waited on this frame's fence, so its secondary pools can be recycled
+        recorder->beginFrame(
+            currentFrameIndex,
+            m_SwapChain->getRenderPass(),
+            m_SwapChain->getFrameBuffer(currentImageIndex),
+            m_SwapChain->getSwapChainExtent());
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -273,6 +460,8 @@ namespace Dog {
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+
+        profiler->BeginFrame(commandBuffer, currentFrameIndex);
         return commandBuffer;
     }
 
@@ -281,11 +470,18 @@ namespace Dog {
 
         auto commandBuffer = getCurrentCommandBuffer();
 
+        profiler->EndRecording(commandBuffer, currentFrameIndex);
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to record command buffer!");
         }
 
-        auto result = m_SwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        // Uploads recorded this frame go out first, the frame waits on them before drawing
+        UploadManager& uploads = device.getUploadManager();
+        uint64_t uploadsDone = uploads.submit();
+
+        profiler->BeginSubmit();
+        auto result = m_SwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, uploads.getTimeline(), uploadsDone);
+        profiler->EndSubmit();
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
             m_Window.wasWindowResized()) {
             m_Window.resetWindowResizedFlag();
@@ -299,7 +495,7 @@ namespace Dog {
         currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
-    void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+    void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
         assert(
             commandBuffer == getCurrentCommandBuffer() &&
@@ -319,7 +515,10 @@ namespace Dog {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+
+        // Secondaries set their own dynamic state
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) return;
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -4,6 +4,7 @@
 #include "Core/SwapChain.h"
 #include "Window/Window.h"
 #include "Entities/GameObject.h"
+#include "Events/Event.h"
 
 namespace Dog {
 
@@ -12,11 +13,23 @@ namespace Dog {
     class SimpleRenderSystem;
     class PointLightSystem;
     class DescriptorPool;
+    class DescriptorSetLayout;
     class KeyboardMovementController;
+    class FrameProfiler;
+    class CullingSystem;
+    class LightClusterSystem;
+    class SkinningSystem;
+    class AnimationSystem;
+    class CrowdSystem;
+    class ParallelRecorder;
+    class JobSystem;
+    class PipelineCompiler;
+    struct CullingStats;
 
     class Renderer {
     public:
-        Renderer(Window& window, Device& device);
+        // recordBuckets is how many jobs record draws, 1 records inline and 0 uses one per job system thread
+        Renderer(Window& window, Device& device, JobSystem& jobSystem, uint32_t recordBuckets = 1);
         ~Renderer();
 
         Renderer(const Renderer&) = delete;
@@ -33,6 +46,27 @@ namespace Dog {
         // get swapchain
         SwapChain& GetSwapChain() { return *m_SwapChain; }
 
+        // CPU/GPU frame timings, disabled until a benchmark turns it on
+        FrameProfiler& GetProfiler() { return *profiler; }
+
+        // Visible and culled instance counts from the GPU cull pass, a few frames behind
+        const CullingStats& GetCullingStats() const;
+
+        // Compiles pipelines on job threads, draws use fallbacks until theirs are ready
+        PipelineCompiler& GetPipelineCompiler() { return *pipelineCompiler; }
+
+        // Scales the screen size models pick their LOD from, higher keeps detail further away. Can be set before Init
+        void SetLodQuality(float quality);
+        float GetLodQuality() const { return lodQuality; }
+
+        // Samples small and off screen animators at reduced rates. Can be set before Init
+        void SetAnimationLodEnabled(bool enabled);
+        bool IsAnimationLodEnabled() const { return animationLodEnabled; }
+
+        // Sorts draws by render queue key and skips redundant binds. Can be set before Init
+        void SetDrawSortingEnabled(bool enabled);
+        bool IsDrawSortingEnabled() const { return drawSortingEnabled; }
+
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
             return commandBuffers[currentFrameIndex];
@@ -45,7 +79,7 @@ namespace Dog {
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
     private:
@@ -63,13 +97,29 @@ namespace Dog {
         bool isFrameStarted{ false };
 
         std::unique_ptr<DescriptorPool> globalPool{};
+        std::unique_ptr<DescriptorSetLayout> globalSetLayout;
+        std::unique_ptr<CullingSystem> cullingSystem;
+        std::unique_ptr<LightClusterSystem> lightClusterSystem;
+        std::unique_ptr<SkinningSystem> skinningSystem;
+        std::unique_ptr<AnimationSystem> animationSystem;
+        std::unique_ptr<ParallelRecorder> recorder;
         std::unique_ptr<SimpleRenderSystem> simpleRenderSystem;
         std::unique_ptr<PointLightSystem> pointLightSystem;
+        std::unique_ptr<CrowdSystem> crowdSystem;
         std::unique_ptr<KeyboardMovementController> cameraController;
+        std::unique_ptr<FrameProfiler> profiler;
+        std::unique_ptr<PipelineCompiler> pipelineCompiler;
+
+        // Shader hot reload, edited shaders rebuild the pipelines using them
+        Events::Handle<Event::ShaderFileModified> shaderModifiedHandle;
+        Events::Handle<Event::ShaderFileCreated> shaderCreatedHandle;
 
         std::vector<VkDescriptorSet> globalDescriptorSets;
         std::vector<std::unique_ptr<Buffer>> uboBuffers;
-        std::vector<std::unique_ptr<Buffer>> bonesUboBuffers;
+        std::vector<std::unique_ptr<Buffer>> instanceBuffers;
+        float lodQuality = 1.f;
+        bool animationLodEnabled = true;
+        bool drawSortingEnabled = true;
     };
 
 }
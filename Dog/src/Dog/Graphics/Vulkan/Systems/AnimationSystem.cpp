@@ -0,0 +1,198 @@
+#include <PCH/pch.h>
+#include "AnimationSystem.h"
+#include "SkinningSystem.h"
+#include "../Models/Model.h"
+#include "../Models/ModelLibrary.h"
+#include "../Animation/Animation.h"
+#include "../Animation/AnimationLibrary.h"
+#include "../Camera.h"
+#include "Jobs/JobSystem.h"
+#include "Scene/Entity/Components.h"
+
+namespace Dog {
+
+    // A pose is a few microseconds, so jobs take several to be worth spawning
+    static constexpr uint32_t ANIMATORS_PER_JOB = 8;
+
+    AnimationSystem::AnimationSystem(JobSystem& jobSystem, ModelLibrary& modelLibrary, AnimationLibrary& animationLibrary, SkinningSystem& skinningSystem)
+        : jobSystem{ jobSystem }
+        , modelLibrary{ modelLibrary }
+        , animationLibrary{ animationLibrary }
+        , skinningSystem{ skinningSystem }
+    {
+    }
+
+    Animation* AnimationSystem::resolveAnimation(AnimatorComponent& animator, uint32_t modelIndex) {
+        // A clip only fits the model it was resolved for, changing the model resolves it again
+        if (animator.AnimationModelIndex != modelIndex) {
+            animator.AnimationIndex = INVALID_ANIMATION_INDEX;
+            animator.AnimationModelIndex = modelIndex;
+            animator.PoseAnimationIndex = INVALID_ANIMATION_INDEX;
+            animator.PoseValid = false;
+        }
+
+        if (animator.AnimationIndex == INVALID_ANIMATION_INDEX) {
+            // The clip's bone ids come from the model, so it can only be read once the model has loaded
+            if (!modelLibrary.IsModelReady(modelIndex)) return nullptr;
+
+            Model* model = modelLibrary.GetModelByIndex(modelIndex);
+            const std::string& path = animator.AnimationPath.empty() ? modelLibrary.GetModelPath(modelIndex) : animator.AnimationPath;
+            animator.AnimationIndex = animationLibrary.AddAnimation(path, modelIndex, *model);
+        }
+
+        return animationLibrary.GetAnimationByIndex(animator.AnimationIndex);
+    }
+
+    uint32_t AnimationSystem::selectUpdateInterval(const glm::vec4& boundingSphere, const glm::mat4& modelMatrix) const {
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(boundingSphere), 1.f));
+        float scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+        float radius = boundingSphere.w * scale;
+
+        // Just outside the view still gets the slowest rate, so it's posed by the time it turns into view.
+        // The bounding sphere is the bind pose's, a limb can reach a little past it
+        bool offScreen = false;
+        for (const glm::vec4& plane : frustumPlanes) {
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            if (distance < -radius * 2.f) return 0;
+            if (distance < -radius) offScreen = true;
+        }
+        if (offScreen) return MAX_UPDATE_INTERVAL;
+
+        float distance = glm::length(center - cameraPosition);
+        if (distance <= radius) return 1;
+
+        float screenSize = radius * screenScale / distance;
+        uint32_t interval = 1;
+        for (float threshold : UPDATE_RATE_SCREEN_SIZES) {
+            if (screenSize >= threshold) break;
+            interval *= 2;
+        }
+        return interval;
+    }
+
+    void AnimationSystem::update(float dt, entt::registry& registry, const Camera& camera) {
+        auto start = std::chrono::high_resolution_clock::now();
+        stats = {};
+        instances.clear();
+        ++frameNumber;
+
+        cameraPosition = glm::vec3(camera.getInverseView()[3]);
+        screenScale = std::abs(camera.getProjection()[1][1]);
+
+        // Gribb/Hartmann like the culling pass, rows of the matrix are columns of its transpose
+        glm::mat4 rows = glm::transpose(camera.getProjection() * camera.getView());
+        frustumPlanes[0] = rows[3] + rows[0];
+        frustumPlanes[1] = rows[3] - rows[0];
+        frustumPlanes[2] = rows[3] + rows[1];
+        frustumPlanes[3] = rows[3] - rows[1];
+        frustumPlanes[4] = rows[2];
+        frustumPlanes[5] = rows[3] - rows[2];
+        for (glm::vec4& plane : frustumPlanes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        // Palettes are allocated up front, the buffer can only be replaced before anything is written to it
+        auto view = registry.view<TransformComponent, ModelComponent, AnimatorComponent>();
+        for (auto entity : view) {
+            auto [transform, model, animator] = view.get<TransformComponent, ModelComponent, AnimatorComponent>(entity);
+            animator.PaletteOffset = SkinningSystem::BIND_POSE_PALETTE;
+
+            Animation* animation = resolveAnimation(animator, model.ModelIndex);
+            if (!animation) continue;
+
+            const Skeleton& skeleton = animation->GetSkeleton();
+            const CompressedClip& clip = animation->GetClip();
+            if (animator.PoseAnimationIndex != animator.AnimationIndex) {
+                clip.InitPose(skeleton, animator.Pose);
+                animator.PoseAnimationIndex = animator.AnimationIndex;
+                animator.PoseValid = false;
+            }
+            ++stats.animatedSkeletons;
+
+            // Time moves on whether the animator is sampled or not
+            float duration = clip.GetDuration();
+            float ticksPerFrame = animator.Playing && duration > 0.f ? clip.GetTicksPerSecond() * animator.Speed * dt : 0.f;
+            auto wrapTime = [duration](float time) {
+                if (duration <= 0.f) return time;
+                time = std::fmod(time, duration);
+                return time < 0.f ? time + duration : time;
+            };
+            animator.Time = wrapTime(animator.Time + ticksPerFrame);
+
+            uint32_t interval = 1;
+            if (updateLodEnabled) {
+                const Model* modelData = modelLibrary.GetModelByIndex(model.ModelIndex);
+                interval = modelData ? selectUpdateInterval(modelData->boundingSphere, transform.mat4()) : 1;
+            }
+
+            if (interval == 0) {
+                animator.PoseValid = false;
+                ++stats.culledSkeletons;
+                continue;
+            }
+
+            AnimatedInstance instance{ &animator, animation, animator.Time, 0.f, true, false };
+            if (!animator.PoseValid || interval == 1) {
+                // Sampled now, a later reduced rate blends from here
+                animator.EvaluationSpan = 1;
+                animator.FramesSinceEvaluation = 0;
+                ++stats.evaluatedSkeletons;
+            }
+            else if (animator.FramesSinceEvaluation + 1 >= animator.EvaluationSpan) {
+                // Shows the last sample, which was taken for this frame, and samples ahead to the next frame that
+                // lands on the interval. Offsetting by the entity staggers animators of the same rate
+                uint32_t span = interval - static_cast<uint32_t>((frameNumber + entt::to_integral(entity)) % interval);
+                instance.sampleTime = wrapTime(animator.Time + ticksPerFrame * span);
+                instance.showPrevious = true;
+                animator.EvaluationSpan = span;
+                animator.FramesSinceEvaluation = 0;
+                ++stats.evaluatedSkeletons;
+            }
+            else {
+                ++animator.FramesSinceEvaluation;
+                instance.evaluate = false;
+                instance.blend = float(animator.FramesSinceEvaluation) / float(animator.EvaluationSpan);
+                ++stats.interpolatedSkeletons;
+            }
+
+            animator.PaletteOffset = skinningSystem.allocatePalette(skeleton.GetBoneCount());
+            instances.push_back(instance);
+            stats.animatedBones += skeleton.GetBoneCount();
+        }
+
+        // Animators only touch their own component and palette, and clips are read only
+        jobSystem.ParallelFor(static_cast<uint32_t>(instances.size()), ANIMATORS_PER_JOB, [this](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                const AnimatedInstance& instance = instances[i];
+                AnimatorComponent& animator = *instance.animator;
+                const Skeleton& skeleton = instance.animation->GetSkeleton();
+                uint32_t boneCount = skeleton.GetBoneCount();
+
+                if (!instance.evaluate) {
+                    // Blended straight into the palette, no scratch to allocate
+                    glm::mat4* palette = skinningSystem.getPalette(animator.PaletteOffset, boneCount);
+                    for (uint32_t bone = 0; bone < boneCount; ++bone) {
+                        const glm::mat4& from = animator.PreviousPalette[bone];
+                        const glm::mat4& to = animator.Pose.palette[bone];
+                        palette[bone] = from + (to - from) * instance.blend;
+                    }
+                    continue;
+                }
+
+                if (instance.showPrevious) {
+                    animator.PreviousPalette = animator.Pose.palette;
+                    instance.animation->GetClip().Sample(skeleton, instance.sampleTime, animator.Pose);
+                    skinningSystem.writePalette(animator.PaletteOffset, animator.PreviousPalette.data(), boneCount);
+                }
+                else {
+                    instance.animation->GetClip().Sample(skeleton, instance.sampleTime, animator.Pose);
+                    skinningSystem.writePalette(animator.PaletteOffset, animator.Pose.palette.data(), boneCount);
+                }
+                animator.PoseValid = true;
+            }
+        });
+
+        stats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+} // namespace Dog
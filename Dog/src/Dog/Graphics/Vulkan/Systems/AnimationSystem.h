@@ -0,0 +1,82 @@
+#pragma once
+
+namespace Dog {
+
+    class JobSystem;
+    class ModelLibrary;
+    class AnimationLibrary;
+    class SkinningSystem;
+    class Animation;
+    class Camera;
+    struct AnimatorComponent;
+
+    struct AnimationStats {
+        uint32_t animatedSkeletons = 0;     // Animators with a clip, culled or not
+        uint32_t evaluatedSkeletons = 0;    // Sampled from their clip this frame
+        uint32_t interpolatedSkeletons = 0; // Blended between their last two samples instead
+        uint32_t culledSkeletons = 0;       // Off screen, left on the bind pose without a palette
+        uint32_t animatedBones = 0;         // Palette matrices written
+        double updateMs = 0.0;              // CPU time of the whole update
+    };
+
+    // Plays every entity's AnimatorComponent. Each frame the animators get a palette in the skinning system's
+    // palette buffer, then are evaluated in parallel on the job system, each writing its own palette.
+    // The skinning pass reads each instance's palette from the offset left on its animator.
+    // How often an animator is sampled depends on its screen size. Smaller ones are sampled every few frames,
+    // staggered so they don't all land on the same frame, ahead to the time of their next sample, and blend
+    // towards it in between. Ones well outside the view aren't sampled at all
+    class AnimationSystem {
+    public:
+        // Screen sizes, like SimpleRenderSystem's LODs, below which animators are sampled every 2, 4 and 8 frames
+        static constexpr float UPDATE_RATE_SCREEN_SIZES[3] = { 0.2f, 0.1f, 0.05f };
+        static constexpr uint32_t MAX_UPDATE_INTERVAL = 8;
+
+        AnimationSystem(JobSystem& jobSystem, ModelLibrary& modelLibrary, AnimationLibrary& animationLibrary, SkinningSystem& skinningSystem);
+
+        AnimationSystem(const AnimationSystem&) = delete;
+        AnimationSystem& operator=(const AnimationSystem&) = delete;
+
+        // Must run after the skinning system's beginFrame and before anything queues skinned instances.
+        // The camera picks each animator's update rate
+        void update(float dt, entt::registry& registry, const Camera& camera);
+
+        // Off samples every animator every frame, for comparisons
+        void setUpdateLodEnabled(bool enabled) { updateLodEnabled = enabled; }
+        bool isUpdateLodEnabled() const { return updateLodEnabled; }
+
+        const AnimationStats& getStats() const { return stats; }
+
+    private:
+        struct AnimatedInstance {
+            AnimatorComponent* animator;
+            const Animation* animation;
+            float sampleTime;  // Ticks, when sampled this frame
+            float blend;       // From the previous sample to the last, when interpolated
+            bool evaluate;
+            bool showPrevious; // Sampled ahead, this frame shows the previous sample
+        };
+
+        // The animator's clip once its model has loaded, null until then or if the clip failed to load
+        Animation* resolveAnimation(AnimatorComponent& animator, uint32_t modelIndex);
+
+        // Frames between samples for a model's bounding sphere, 0 when it's culled
+        uint32_t selectUpdateInterval(const glm::vec4& boundingSphere, const glm::mat4& modelMatrix) const;
+
+        JobSystem& jobSystem;
+        ModelLibrary& modelLibrary;
+        AnimationLibrary& animationLibrary;
+        SkinningSystem& skinningSystem;
+
+        // Reused every frame to avoid reallocating
+        std::vector<AnimatedInstance> instances;
+
+        bool updateLodEnabled = true;
+        uint64_t frameNumber = 0;
+        glm::vec3 cameraPosition{ 0.f };
+        float screenScale = 1.f;
+        glm::vec4 frustumPlanes[6]{};
+
+        AnimationStats stats{};
+    };
+
+} // namespace Dog
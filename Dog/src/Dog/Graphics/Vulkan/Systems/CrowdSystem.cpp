@@ -0,0 +1,313 @@
+#include <PCH/pch.h>
+#include "CrowdSystem.h"
+#include "../Core/SwapChain.h"
+#include "../Core/UploadManager.h"
+#include "../Models/Model.h"
+#include "../Models/ModelLibrary.h"
+#include "../Models/GeometryPool.h"
+#include "../Texture/TextureLibrary.h"
+#include "../Animation/Animation.h"
+#include "../Animation/AnimationBaker.h"
+#include "../Animation/AnimationLibrary.h"
+#include "Scene/Entity/Components.h"
+
+namespace Dog {
+
+    // Matches the push constants in crowd.vert
+    struct CrowdPushConstants {
+        glm::vec4 positionDecode;
+        glm::vec4 uvDecode;
+        uint32_t firstMatrix;
+        uint32_t boneCount;
+        uint32_t frameCount;
+        float framesPerSecond;
+        float time;
+        int textureIndex;
+    };
+
+    static constexpr uint32_t INITIAL_CROWD_CAPACITY = 1024;
+
+    // The shared clock wraps so it keeps its precision in long sessions
+    static constexpr float CROWD_TIME_PERIOD = 3600.f;
+
+    CrowdSystem::CrowdSystem(
+        Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary,
+        ModelLibrary& modelLibrary, AnimationLibrary& animationLibrary, PipelineCompiler& pipelineCompiler)
+        : device{ device }
+        , textureLibrary{ textureLibrary }
+        , modelLibrary{ modelLibrary }
+        , animationLibrary{ animationLibrary }
+        , pipelineCompiler{ pipelineCompiler }
+        , renderPass{ renderPass }
+        , frames(SwapChain::MAX_FRAMES_IN_FLIGHT)
+    {
+        createResources(globalSetLayout);
+    }
+
+    CrowdSystem::~CrowdSystem() {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    void CrowdSystem::createResources(VkDescriptorSetLayout globalSetLayout) {
+        const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+
+        setLayout =
+            DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+
+        descriptorPool =
+            DescriptorPool::Builder(device)
+            .setMaxSets(frameCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 2)
+            .build();
+
+        for (FrameResources& frame : frames) {
+            if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), frame.descriptorSet)) {
+                throw std::runtime_error("failed to allocate crowd descriptor set!");
+            }
+        }
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CrowdPushConstants);
+
+        // Set 1 is the bindless texture array, read by simple_shader.frag
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+            globalSetLayout,
+            textureLibrary.getBindlessTable().getDescriptorSetLayout(),
+            setLayout->getDescriptorSetLayout()
+        };
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void CrowdSystem::createPipeline(VertexLayout layout) {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create pipeline before pipeline layout");
+
+        // Configured on the job thread, so only copies are captured
+        pipelines[layout] = pipelineCompiler.compileGraphics(
+            "crowd.vert",
+            "simple_shader.frag",
+            [layout, renderPass = renderPass, pipelineLayout = pipelineLayout](PipelineConfigInfo& pipelineConfig) {
+                pipelineConfig.bindingDescriptions = Vertex::getBindingDescriptions(layout);
+                pipelineConfig.attributeDescriptions = Vertex::getAttributeDescriptions(layout);
+                pipelineConfig.shaderDefines = getVertexLayoutDefines(layout);
+                pipelineConfig.renderPass = renderPass;
+                pipelineConfig.pipelineLayout = pipelineLayout;
+            });
+    }
+
+    uint32_t CrowdSystem::resolveClip(BakedAnimatorComponent& animator, uint32_t modelIndex) {
+        // Baked palettes only fit the model they were baked for, changing the model bakes it again
+        if (animator.ClipModelIndex != modelIndex) {
+            animator.ClipIndex = INVALID_ANIMATION_INDEX;
+            animator.ClipModelIndex = modelIndex;
+        }
+        if (animator.ClipIndex != INVALID_ANIMATION_INDEX) return animator.ClipIndex;
+
+        Model* model = modelLibrary.GetModelByIndex(modelIndex);
+        const std::string& path = animator.AnimationPath.empty() ? modelLibrary.GetModelPath(modelIndex) : animator.AnimationPath;
+        uint32_t animationIndex = animationLibrary.AddAnimation(path, modelIndex, *model);
+
+        auto it = clipsByAnimation.find(animationIndex);
+        if (it == clipsByAnimation.end()) {
+            // Baked on the main thread the first time it's played, a clip is a few hundred poses
+            BakedClipRange range;
+            if (Animation* animation = animationLibrary.GetAnimationByIndex(animationIndex)) {
+                BakedClip baked = BakeAnimation(*animation, BAKE_FRAMES_PER_SECOND);
+                if (baked.frameCount > 0) {
+                    range.firstMatrix = static_cast<uint32_t>(bakedPalettes.size());
+                    range.boneCount = baked.boneCount;
+                    range.frameCount = baked.frameCount;
+                    range.framesPerSecond = baked.framesPerSecond;
+                    bakedPalettes.insert(bakedPalettes.end(), baked.palettes.begin(), baked.palettes.end());
+                    bakedDirty = true;
+                }
+                else {
+                    DOG_WARN("Animation {0} has no frames to bake", path);
+                }
+            }
+
+            it = clipsByAnimation.emplace(animationIndex, static_cast<uint32_t>(clips.size())).first;
+            clips.push_back(range);
+        }
+
+        animator.ClipIndex = it->second;
+        return animator.ClipIndex;
+    }
+
+    void CrowdSystem::uploadBakedClips() {
+        if (bakedBuffer) {
+            retiredBuffers.push_back({ std::move(bakedBuffer), frameNumber });
+        }
+
+        bakedBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(glm::mat4),
+            static_cast<uint32_t>(bakedPalettes.size()),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+
+        // The frame's graphics submit waits on the upload batch, so it's in place before the first draw reads it
+        device.getUploadManager().uploadToBuffer(
+            bakedBuffer->getBuffer(), 0, bakedPalettes.data(), bakedPalettes.size() * sizeof(glm::mat4));
+        bakedDirty = false;
+    }
+
+    void CrowdSystem::prepareFrame(FrameInfo& frameInfo, entt::registry& registry) {
+        ++frameNumber;
+        std::erase_if(retiredBuffers, [this](const RetiredBuffer& retired) {
+            return frameNumber >= retired.frame + SwapChain::MAX_FRAMES_IN_FLIGHT;
+        });
+
+        time = std::fmod(time + frameInfo.frameTime, CROWD_TIME_PERIOD);
+        stats.crowdInstances = 0;
+        stats.crowdDraws = 0;
+        sortedInstances.clear();
+        groups.clear();
+
+        uint32_t modelCount = modelLibrary.GetModelCount();
+        auto view = registry.view<TransformComponent, ModelComponent, BakedAnimatorComponent>();
+        for (auto entity : view) {
+            auto [transform, model, animator] = view.get<TransformComponent, ModelComponent, BakedAnimatorComponent>(entity);
+            if (model.ModelIndex == INVALID_MODEL_INDEX || model.ModelIndex >= modelCount) continue;
+
+            // Crowds aren't drawn as the placeholder, the clip needs the model's skeleton anyway
+            if (!modelLibrary.IsModelReady(model.ModelIndex)) continue;
+
+            uint32_t clipIndex = resolveClip(animator, model.ModelIndex);
+            if (clipIndex == INVALID_ANIMATION_INDEX || clips[clipIndex].frameCount == 0) continue;
+
+            CrowdInstance instance{ transform.mat4(), transform.normalMatrix(), animator.TimeOffset, animator.Speed, {} };
+            sortedInstances.push_back({ (uint64_t(model.ModelIndex) << 32) | clipIndex, instance });
+        }
+
+        if (bakedDirty) {
+            uploadBakedClips();
+        }
+
+        stats.bakedClips = static_cast<uint32_t>(clips.size());
+        stats.bakedBytes = bakedPalettes.size() * sizeof(glm::mat4);
+        if (sortedInstances.empty()) return;
+
+        // Instances of the same model and clip become one contiguous range, drawn together
+        std::sort(sortedInstances.begin(), sortedInstances.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        FrameResources& frame = frames[frameInfo.frameIndex];
+        uint32_t instanceCount = static_cast<uint32_t>(sortedInstances.size());
+        if (instanceCount > frame.capacity) {
+            // The frame's fence has been waited on, so its old buffer is no longer in use
+            frame.capacity = std::max({ frame.capacity * 2, instanceCount, INITIAL_CROWD_CAPACITY });
+            frame.instanceBuffer = std::make_unique<Buffer>(
+                device,
+                sizeof(CrowdInstance),
+                frame.capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            frame.instanceBuffer->map();
+        }
+
+        CrowdInstance* instances = static_cast<CrowdInstance*>(frame.instanceBuffer->getMappedMemory());
+        for (uint32_t i = 0; i < instanceCount; ++i) {
+            instances[i] = sortedInstances[i].second;
+
+            uint32_t modelIndex = static_cast<uint32_t>(sortedInstances[i].first >> 32);
+            uint32_t clipIndex = static_cast<uint32_t>(sortedInstances[i].first);
+            if (groups.empty() || groups.back().modelIndex != modelIndex || groups.back().clipIndex != clipIndex) {
+                groups.push_back({ modelIndex, clipIndex, i, 0 });
+            }
+            ++groups.back().instanceCount;
+        }
+        frame.instanceBuffer->flush();
+
+        // Either buffer may have been replaced since this frame's set was last written
+        auto bakedInfo = bakedBuffer->descriptorInfo();
+        auto instanceInfo = frame.instanceBuffer->descriptorInfo();
+        DescriptorWriter(*setLayout, *descriptorPool)
+            .writeBuffer(0, &bakedInfo)
+            .writeBuffer(1, &instanceInfo)
+            .overwrite(frame.descriptorSet);
+
+        stats.crowdInstances = instanceCount;
+        for (const CrowdGroup& group : groups) {
+            stats.crowdDraws += static_cast<uint32_t>(modelLibrary.GetModelByIndex(group.modelIndex)->meshes.size());
+        }
+    }
+
+    void CrowdSystem::render(FrameInfo& frameInfo) {
+        stats.binds = {};
+        if (groups.empty()) return;
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        GeometryPool& geometryPool = modelLibrary.GetGeometryPool();
+
+        VkDescriptorSet descriptorSets[] = {
+            frameInfo.globalDescriptorSet,
+            textureLibrary.getBindlessTable().getDescriptorSet(),
+            frames[frameInfo.frameIndex].descriptorSet
+        };
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            3,
+            descriptorSets,
+            0,
+            nullptr);
+
+        // Meshes of a layout share their buffers, and groups of the same clip and mesh their push constants
+        DrawStateCache state(commandBuffer);
+        for (const CrowdGroup& group : groups) {
+            const BakedClipRange& clip = clips[group.clipIndex];
+            Model* model = modelLibrary.GetModelByIndex(group.modelIndex);
+
+            for (auto& mesh : model->meshes) {
+                if (!pipelines[mesh.layout]) {
+                    createPipeline(mesh.layout);
+                }
+
+                VkPipeline pipeline = pipelines[mesh.layout]->getPipeline();
+                if (pipeline == VK_NULL_HANDLE) continue;
+
+                state.bindPipeline(pipeline);
+                geometryPool.bind(state, mesh.layout, mesh.indexType);
+
+                CrowdPushConstants push{};
+                push.positionDecode = mesh.positionDecode;
+                push.uvDecode = mesh.uvDecode;
+                push.firstMatrix = clip.firstMatrix;
+                push.boneCount = clip.boneCount;
+                push.frameCount = clip.frameCount;
+                push.framesPerSecond = clip.framesPerSecond;
+                push.time = time;
+                push.textureIndex = mesh.textureIndex == INVALID_TEXTURE_INDEX ? 0 : static_cast<int>(mesh.textureIndex);
+                state.pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(CrowdPushConstants), &push);
+
+                // gl_InstanceIndex includes firstInstance, so it indexes the group's range of the instance buffer
+                const MeshLod& meshLod = mesh.lods[0];
+                vkCmdDrawIndexed(
+                    commandBuffer,
+                    meshLod.indexCount,
+                    group.instanceCount,
+                    mesh.firstIndex + meshLod.firstIndex,
+                    mesh.vertexOffset,
+                    group.firstInstance);
+            }
+        }
+
+        stats.binds = state.getStats();
+    }
+
+} // namespace Dog
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../Core/Device.h"
+#include "../Core/DrawStateCache.h"
+#include "../FrameInfo.h"
+#include "../Buffers/Buffer.h"
+#include "../Descriptors/Descriptors.h"
+#include "../Models/VertexLayout.h"
+#include "../Pipeline/PipelineCompiler.h"
+
+namespace Dog {
+
+    class TextureLibrary;
+    class ModelLibrary;
+    class AnimationLibrary;
+    struct BakedAnimatorComponent;
+
+    struct CrowdStats {
+        uint32_t crowdInstances = 0; // Entities drawn with a baked clip this frame
+        uint32_t crowdDraws = 0;
+        uint32_t bakedClips = 0;
+        uint64_t bakedBytes = 0;     // Of every baked palette on the GPU
+        DrawStateStats binds;        // Recorded in render, after the counters are read, so from the frame before
+    };
+
+    // Draws every entity with a BakedAnimatorComponent. Each clip is baked once, the first time an entity plays it,
+    // into one GPU buffer of per-frame palettes, and crowd.vert skins the instances from it with the frame time and
+    // each instance's offset. The CPU only writes transforms, so it costs the same animated or not.
+    // Instances of a model and clip draw as one instanced draw per mesh at full detail, without culling
+    class CrowdSystem {
+    public:
+        // Baked sample rate, playback blends between frames
+        static constexpr float BAKE_FRAMES_PER_SECOND = 30.f;
+
+        CrowdSystem(
+            Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary,
+            ModelLibrary& modelLibrary, AnimationLibrary& animationLibrary, PipelineCompiler& pipelineCompiler);
+        ~CrowdSystem();
+
+        CrowdSystem(const CrowdSystem&) = delete;
+        CrowdSystem& operator=(const CrowdSystem&) = delete;
+
+        // Bakes clips seen for the first time and writes this frame's instances, must be called outside the render pass
+        void prepareFrame(FrameInfo& frameInfo, entt::registry& registry);
+
+        // Records the draws, inside the render pass
+        void render(FrameInfo& frameInfo);
+
+        const CrowdStats& getStats() const { return stats; }
+
+    private:
+        // Matches CrowdInstance in crowd.vert, std430 rounds it to 144 bytes
+        struct CrowdInstance {
+            glm::mat4 modelMatrix;
+            glm::mat4 normalMatrix;
+            float timeOffset;
+            float speed;
+            float padding[2];
+        };
+
+        // Where a clip's frames are in the baked buffer. Clips that failed to load or bake have no frames
+        struct BakedClipRange {
+            uint32_t firstMatrix = 0;
+            uint32_t boneCount = 0;
+            uint32_t frameCount = 0;
+            float framesPerSecond = 0.f;
+        };
+
+        // Every instance of a model playing one clip, contiguous in the instance buffer
+        struct CrowdGroup {
+            uint32_t modelIndex;
+            uint32_t clipIndex;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        struct FrameResources {
+            std::unique_ptr<Buffer> instanceBuffer;
+            uint32_t capacity = 0; // Instances
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        struct RetiredBuffer {
+            std::unique_ptr<Buffer> buffer;
+            uint64_t frame; // When it was replaced
+        };
+
+        void createResources(VkDescriptorSetLayout globalSetLayout);
+
+        // Per vertex layout like SimpleRenderSystem's, skinned layouts read their bone stream
+        void createPipeline(VertexLayout layout);
+
+        // The entity's baked clip, baking it the first time it's played. Its model must have loaded
+        uint32_t resolveClip(BakedAnimatorComponent& animator, uint32_t modelIndex);
+
+        // Replaces the baked buffer with one holding every clip baked so far, the old one is released once
+        // no frame in flight can read it
+        void uploadBakedClips();
+
+        Device& device;
+        TextureLibrary& textureLibrary;
+        ModelLibrary& modelLibrary;
+        AnimationLibrary& animationLibrary;
+        PipelineCompiler& pipelineCompiler;
+
+        VkRenderPass renderPass;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+
+        // Crowds of a layout aren't drawn until its pipeline is compiled
+        std::array<std::shared_ptr<AsyncPipeline>, VERTEX_LAYOUT_COUNT> pipelines;
+
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::vector<FrameResources> frames;
+
+        // Baked clips, by clip index. The palettes are kept so the buffer can be rebuilt when one is added
+        std::vector<BakedClipRange> clips;
+        std::unordered_map<uint32_t, uint32_t> clipsByAnimation;
+        std::vector<glm::mat4> bakedPalettes;
+        std::unique_ptr<Buffer> bakedBuffer;
+        bool bakedDirty = false;
+        std::vector<RetiredBuffer> retiredBuffers;
+        uint64_t frameNumber = 0;
+
+        // Reused every frame to avoid reallocating
+        std::vector<std::pair<uint64_t, CrowdInstance>> sortedInstances; // Keyed by model and clip
+        std::vector<CrowdGroup> groups;
+
+        float time = 0.f; // Seconds, shared by every instance
+        CrowdStats stats{};
+    };
+
+} // namespace Dog
@@ -0,0 +1,290 @@
+#include <PCH/pch.h>
+#include "CullingSystem.h"
+#include "../Core/SwapChain.h"
+#include "../FrameInfo.h"
+
+namespace Dog {
+
+    // Matches CounterBuffer in cull.comp and cull_compact.comp
+    struct CullCounters {
+        uint32_t drawCount;
+        uint32_t visibleInstances;
+        uint32_t culledInstances;
+        uint32_t padding;
+    };
+
+    struct CullPushConstantData {
+        glm::vec4 frustumPlanes[6];
+        uint32_t instanceCount;
+        uint32_t drawCount;
+        uint32_t cullingEnabled;
+        uint32_t compactDraws;
+    };
+
+    static constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+
+    CullingSystem::CullingSystem(Device& device, const std::vector<std::unique_ptr<Buffer>>& instanceBuffers, PipelineCompiler& pipelineCompiler)
+        : device{ device }
+        , descriptorSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+        , candidateCounts(SwapChain::MAX_FRAMES_IN_FLIGHT, 0)
+        , compacted(SwapChain::MAX_FRAMES_IN_FLIGHT, false)
+    {
+        // Indirect commands can only point at a range of visible instance ids if firstInstance is honoured
+        if (!device.getEnabledFeatures().drawIndirectFirstInstance) {
+            cullingEnabled = false;
+        }
+
+        createBuffers(instanceBuffers);
+        createPipelines(pipelineCompiler);
+    }
+
+    CullingSystem::~CullingSystem() {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    void CullingSystem::createBuffers(const std::vector<std::unique_ptr<Buffer>>& instanceBuffers) {
+        const int frameCount = SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        drawDataBuffers.resize(frameCount);
+        visibleCountBuffers.resize(frameCount);
+        visibleInstanceBuffers.resize(frameCount);
+        drawCommandBuffers.resize(frameCount);
+        counterBuffers.resize(frameCount);
+
+        for (int i = 0; i < frameCount; i++) {
+            drawDataBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(DrawCullData),
+                MAX_INSTANCES,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_CPU_TO_GPU);
+            drawDataBuffers[i]->map();
+
+            visibleCountBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(uint32_t),
+                MAX_INSTANCES,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            visibleInstanceBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(uint32_t),
+                MAX_INSTANCES,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            drawCommandBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(VkDrawIndexedIndirectCommand),
+                MAX_INSTANCES,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            counterBuffers[i] = std::make_unique<Buffer>(
+                device,
+                sizeof(CullCounters),
+                1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_TO_CPU);
+            counterBuffers[i]->map();
+            memset(counterBuffers[i]->getMappedMemory(), 0, sizeof(CullCounters));
+        }
+
+        descriptorPool =
+            DescriptorPool::Builder(device)
+            .setMaxSets(frameCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 6)
+            .build();
+
+        setLayout =
+            DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+
+        for (int i = 0; i < frameCount; i++) {
+            auto instanceInfo = instanceBuffers[i]->descriptorInfo();
+            auto drawDataInfo = drawDataBuffers[i]->descriptorInfo();
+            auto visibleCountInfo = visibleCountBuffers[i]->descriptorInfo();
+            auto visibleInstanceInfo = visibleInstanceBuffers[i]->descriptorInfo();
+            auto drawCommandInfo = drawCommandBuffers[i]->descriptorInfo();
+            auto counterInfo = counterBuffers[i]->descriptorInfo();
+
+            DescriptorWriter(*setLayout, *descriptorPool)
+                .writeBuffer(0, &instanceInfo)
+                .writeBuffer(1, &drawDataInfo)
+                .writeBuffer(2, &visibleCountInfo)
+                .writeBuffer(3, &visibleInstanceInfo)
+                .writeBuffer(4, &drawCommandInfo)
+                .writeBuffer(5, &counterInfo)
+                .build(descriptorSets[i]);
+        }
+    }
+
+    void CullingSystem::createPipelines(PipelineCompiler& pipelineCompiler) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        // Both compile at once, then the first frame waits for them
+        cullPipeline = pipelineCompiler.compileCompute("cull.comp", pipelineLayout);
+        compactPipeline = pipelineCompiler.compileCompute("cull_compact.comp", pipelineLayout);
+        pipelineCompiler.wait(*cullPipeline);
+        pipelineCompiler.wait(*compactPipeline);
+
+        if (!cullPipeline->isReady() || !compactPipeline->isReady()) {
+            throw std::runtime_error("failed to create culling pipelines!");
+        }
+    }
+
+    DrawCullData* CullingSystem::getDrawData(int frameIndex) {
+        return static_cast<DrawCullData*>(drawDataBuffers[frameIndex]->getMappedMemory());
+    }
+
+    void CullingSystem::readStats(int frameIndex) {
+        // The frame slot's fence has been waited on, so its counters are final
+        counterBuffers[frameIndex]->invalidate();
+        const CullCounters* counters = static_cast<const CullCounters*>(counterBuffers[frameIndex]->getMappedMemory());
+
+        stats.candidateInstances = candidateCounts[frameIndex];
+        stats.visibleInstances = counters->visibleInstances;
+        stats.culledInstances = counters->culledInstances;
+        stats.drawCommands = counters->drawCount;
+    }
+
+    void CullingSystem::cull(
+        VkCommandBuffer commandBuffer,
+        int frameIndex,
+        const glm::mat4& viewProjection,
+        uint32_t instanceCount,
+        uint32_t drawCount,
+        bool allowCompaction)
+    {
+        readStats(frameIndex);
+        candidateCounts[frameIndex] = instanceCount;
+        compacted[frameIndex] = allowCompaction && device.getEnabledVulkan12Features().drawIndirectCount;
+
+        drawDataBuffers[frameIndex]->flush(sizeof(DrawCullData) * std::max(drawCount, 1u), 0);
+
+        vkCmdFillBuffer(commandBuffer, counterBuffers[frameIndex]->getBuffer(), 0, sizeof(CullCounters), 0);
+        if (drawCount == 0) {
+            return;
+        }
+        vkCmdFillBuffer(commandBuffer, visibleCountBuffers[frameIndex]->getBuffer(), 0, sizeof(uint32_t) * drawCount, 0);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // Gribb/Hartmann plane extraction, rows of the matrix are columns of its transpose
+        glm::mat4 rows = glm::transpose(viewProjection);
+        CullPushConstantData push{};
+        push.frustumPlanes[0] = rows[3] + rows[0]; // left
+        push.frustumPlanes[1] = rows[3] - rows[0]; // right
+        push.frustumPlanes[2] = rows[3] + rows[1]; // bottom
+        push.frustumPlanes[3] = rows[3] - rows[1]; // top
+        push.frustumPlanes[4] = rows[2];           // near (depth is 0 to 1)
+        push.frustumPlanes[5] = rows[3] - rows[2]; // far
+        for (glm::vec4& plane : push.frustumPlanes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        push.instanceCount = instanceCount;
+        push.drawCount = drawCount;
+        push.cullingEnabled = cullingEnabled ? 1 : 0;
+        push.compactDraws = compacted[frameIndex] ? 1 : 0;
+
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &descriptorSets[frameIndex],
+            0,
+            nullptr);
+
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstantData),
+            &push);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline->getPipeline());
+        vkCmdDispatch(commandBuffer, (instanceCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compactPipeline->getPipeline());
+        vkCmdDispatch(commandBuffer, (drawCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+        // Results feed the indirect draw, the vertex shader's instance lookup and the stats readback
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void CullingSystem::draw(VkCommandBuffer commandBuffer, int frameIndex, uint32_t firstDraw, uint32_t drawCount) {
+        if (drawCount == 0) return;
+
+        VkBuffer commands = drawCommandBuffers[frameIndex]->getBuffer();
+        uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        if (compacted[frameIndex]) {
+            assert(firstDraw == 0 && "Compacted draws can't be split into ranges");
+            vkCmdDrawIndexedIndirectCount(
+                commandBuffer,
+                commands,
+                0,
+                counterBuffers[frameIndex]->getBuffer(),
+                offsetof(CullCounters, drawCount),
+                drawCount,
+                stride);
+        }
+        else if (device.getEnabledFeatures().multiDrawIndirect) {
+            // Uncompacted, draws with nothing visible just have an instance count of zero
+            vkCmdDrawIndexedIndirect(commandBuffer, commands, firstDraw * stride, drawCount, stride);
+        }
+        else {
+            for (uint32_t i = firstDraw; i < firstDraw + drawCount; ++i) {
+                vkCmdDrawIndexedIndirect(commandBuffer, commands, i * stride, 1, stride);
+            }
+        }
+    }
+
+} // namespace Dog
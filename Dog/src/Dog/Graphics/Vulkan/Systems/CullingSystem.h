@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Core/Device.h"
+#include "../Buffers/Buffer.h"
+#include "../Descriptors/Descriptors.h"
+#include "../Pipeline/PipelineCompiler.h"
+
+namespace Dog {
+
+    struct CullingStats {
+        uint32_t candidateInstances = 0; // Instances submitted to the cull pass
+        uint32_t visibleInstances = 0;   // Instances that survived the frustum test
+        uint32_t culledInstances = 0;    // Instances rejected by the frustum test
+        uint32_t drawCommands = 0;       // Draws with at least one visible instance
+    };
+
+    // One entry per (model, mesh) draw group, written by the CPU each frame
+    struct DrawCullData {
+        glm::vec4 boundingSphere{ 0.f };        // Local space, w is the radius
+        VkDrawIndexedIndirectCommand command{}; // instanceCount is filled in by the GPU
+        uint32_t padding[3]{};
+    };
+
+    // GPU frustum culling. One compute pass tests every instance's bounding sphere and writes the survivors'
+    // instance ids per draw, a second pass turns the per-draw counts into a compacted indirect buffer and count.
+    class CullingSystem {
+    public:
+        CullingSystem(Device& device, const std::vector<std::unique_ptr<Buffer>>& instanceBuffers, PipelineCompiler& pipelineCompiler);
+        ~CullingSystem();
+
+        CullingSystem(const CullingSystem&) = delete;
+        CullingSystem& operator=(const CullingSystem&) = delete;
+
+        // Mapped array of MAX_INSTANCES draws for the CPU to fill
+        DrawCullData* getDrawData(int frameIndex);
+
+        // Must be recorded outside a render pass, after the frame's instances and draws are written.
+        // Without compaction every draw keeps its slot, so draw() can be called on sub ranges
+        void cull(
+            VkCommandBuffer commandBuffer,
+            int frameIndex,
+            const glm::mat4& viewProjection,
+            uint32_t instanceCount,
+            uint32_t drawCount,
+            bool allowCompaction = true);
+
+        // Draws whatever survived the last cull; the geometry pool and pipeline must already be bound.
+        // A compacted cull can only be drawn as a whole, starting at draw 0
+        void draw(VkCommandBuffer commandBuffer, int frameIndex, uint32_t firstDraw, uint32_t drawCount);
+
+        // Maps gl_InstanceIndex to an index in the instance buffer, bound to the global set
+        Buffer& getVisibleInstanceBuffer(int frameIndex) { return *visibleInstanceBuffers[frameIndex]; }
+
+        // Disabled culling still runs the passes, it just keeps every instance
+        void setEnabled(bool enabled) { cullingEnabled = enabled; }
+        bool isEnabled() const { return cullingEnabled; }
+
+        // Counts from the last completed frame that used the current frame slot
+        const CullingStats& getStats() const { return stats; }
+
+    private:
+        void createBuffers(const std::vector<std::unique_ptr<Buffer>>& instanceBuffers);
+        void createPipelines(PipelineCompiler& pipelineCompiler);
+        void readStats(int frameIndex);
+
+        Device& device;
+
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        std::vector<VkDescriptorSet> descriptorSets;
+
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::shared_ptr<AsyncPipeline> cullPipeline;    // Waited on at creation, nothing draws without them,
+        std::shared_ptr<AsyncPipeline> compactPipeline; // but still rebuilt when their shaders change
+
+        std::vector<std::unique_ptr<Buffer>> drawDataBuffers;
+        std::vector<std::unique_ptr<Buffer>> visibleCountBuffers;
+        std::vector<std::unique_ptr<Buffer>> visibleInstanceBuffers;
+        std::vector<std::unique_ptr<Buffer>> drawCommandBuffers;
+        std::vector<std::unique_ptr<Buffer>> counterBuffers;
+        std::vector<uint32_t> candidateCounts;
+        std::vector<bool> compacted;
+
+        CullingStats stats{};
+        bool cullingEnabled = true;
+    };
+
+} // namespace Dog
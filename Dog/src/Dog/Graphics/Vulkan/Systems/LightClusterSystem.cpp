@@ -0,0 +1,251 @@
+#include <PCH/pch.h>
+#include "LightClusterSystem.h"
+#include "../Core/SwapChain.h"
+#include "Scene/Entity/Components.h"
+
+namespace Dog {
+
+    // Matches CounterBuffer in light_cluster.comp
+    struct LightClusterCounters {
+        uint32_t lightAssignments;
+        uint32_t maxClusterLights;
+        uint32_t overflowedClusters;
+        uint32_t padding;
+    };
+
+    struct LightClusterPushConstants {
+        glm::mat4 view;
+        glm::vec4 projection; // x and y scale, z and w offset of the projection's x and y
+        glm::vec4 depthRange; // Near and far
+        glm::uvec4 grid;      // Clusters along each axis, w is the light count
+    };
+
+    static constexpr uint32_t CLUSTER_WORKGROUP_SIZE = 64;
+    static constexpr uint32_t INITIAL_LIGHT_CAPACITY = 1024;
+
+    LightClusterSystem::LightClusterSystem(Device& device, PipelineCompiler& pipelineCompiler)
+        : device{ device }
+        , frames(SwapChain::MAX_FRAMES_IN_FLIGHT)
+    {
+        createBuffers();
+        createPipeline(pipelineCompiler);
+    }
+
+    LightClusterSystem::~LightClusterSystem() {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    void LightClusterSystem::createBuffers() {
+        const int frameCount = SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        descriptorPool =
+            DescriptorPool::Builder(device)
+            .setMaxSets(frameCount)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * 4)
+            .build();
+
+        setLayout =
+            DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+
+        for (FrameResources& frame : frames) {
+            createLightBuffer(frame, INITIAL_LIGHT_CAPACITY);
+
+            frame.clusterBuffer = std::make_unique<Buffer>(
+                device,
+                sizeof(uint32_t),
+                CLUSTER_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            frame.lightIndexBuffer = std::make_unique<Buffer>(
+                device,
+                sizeof(uint32_t),
+                CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY);
+
+            frame.counterBuffer = std::make_unique<Buffer>(
+                device,
+                sizeof(LightClusterCounters),
+                1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_TO_CPU);
+            frame.counterBuffer->map();
+            memset(frame.counterBuffer->getMappedMemory(), 0, sizeof(LightClusterCounters));
+
+            if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), frame.descriptorSet)) {
+                throw std::runtime_error("failed to allocate light cluster descriptor set!");
+            }
+            writeDescriptorSet(frame);
+        }
+    }
+
+    void LightClusterSystem::createLightBuffer(FrameResources& frame, uint32_t capacity) {
+        frame.lightBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(PointLight),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.lightBuffer->map();
+        frame.lightCapacity = capacity;
+    }
+
+    void LightClusterSystem::writeDescriptorSet(FrameResources& frame) {
+        auto lightInfo = frame.lightBuffer->descriptorInfo();
+        auto clusterInfo = frame.clusterBuffer->descriptorInfo();
+        auto lightIndexInfo = frame.lightIndexBuffer->descriptorInfo();
+        auto counterInfo = frame.counterBuffer->descriptorInfo();
+
+        DescriptorWriter(*setLayout, *descriptorPool)
+            .writeBuffer(0, &lightInfo)
+            .writeBuffer(1, &clusterInfo)
+            .writeBuffer(2, &lightIndexInfo)
+            .writeBuffer(3, &counterInfo)
+            .overwrite(frame.descriptorSet);
+    }
+
+    void LightClusterSystem::createPipeline(PipelineCompiler& pipelineCompiler) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(LightClusterPushConstants);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        clusterPipeline = pipelineCompiler.compileCompute("light_cluster.comp", pipelineLayout);
+        pipelineCompiler.wait(*clusterPipeline);
+
+        if (!clusterPipeline->isReady()) {
+            throw std::runtime_error("failed to create light cluster pipeline!");
+        }
+    }
+
+    void LightClusterSystem::readStats(FrameResources& frame) {
+        // The frame slot's fence has been waited on, so its counters are final
+        frame.counterBuffer->invalidate();
+        const LightClusterCounters* counters = static_cast<const LightClusterCounters*>(frame.counterBuffer->getMappedMemory());
+
+        stats.lightAssignments = counters->lightAssignments;
+        stats.maxClusterLights = counters->maxClusterLights;
+        stats.overflowedClusters = counters->overflowedClusters;
+    }
+
+    bool LightClusterSystem::update(FrameInfo& frameInfo, entt::registry& registry, GlobalUbo& ubo) {
+        FrameResources& frame = frames[frameInfo.frameIndex];
+        readStats(frame);
+
+        auto view = registry.view<TransformComponent, PointLightComponent>();
+
+        // Grown to the view's upper bound up front, its last user was this slot's previous frame, which has finished
+        uint32_t maxLights = static_cast<uint32_t>(view.size_hint());
+
+        bool grew = false;
+        if (maxLights > frame.lightCapacity) {
+            uint32_t capacity = frame.lightCapacity;
+            while (capacity < maxLights) capacity *= 2;
+            createLightBuffer(frame, capacity);
+            writeDescriptorSet(frame);
+            grew = true;
+        }
+
+        PointLight* lights = static_cast<PointLight*>(frame.lightBuffer->getMappedMemory());
+        lightCount = 0;
+        for (auto entity : view) {
+            auto [transform, light] = view.get<TransformComponent, PointLightComponent>(entity);
+            lights[lightCount].position = glm::vec4(transform.Translation, light.Radius);
+            lights[lightCount].color = glm::vec4(light.Color, light.Intensity);
+            ++lightCount;
+        }
+        if (lightCount > 0) {
+            frame.lightBuffer->flush(sizeof(PointLight) * lightCount, 0);
+        }
+        stats.pointLights = lightCount;
+
+        // Slices are spaced exponentially, so each covers the same ratio of depth
+        const Camera& camera = frameInfo.camera;
+        float nearPlane = camera.getNear();
+        float farPlane = camera.getFar();
+        float sliceScale = float(CLUSTER_Z) / std::log(farPlane / nearPlane);
+
+        ubo.clusterDepth = glm::vec4(sliceScale, -std::log(nearPlane) * sliceScale, 0.f, 0.f);
+        ubo.clusterGrid = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, lightCount);
+
+        const glm::mat4& projectionMatrix = camera.getProjection();
+        viewMatrix = camera.getView();
+        projection = glm::vec4(projectionMatrix[0][0], projectionMatrix[1][1], projectionMatrix[2][0], projectionMatrix[2][1]);
+        depthRange = glm::vec2(nearPlane, farPlane);
+
+        return grew;
+    }
+
+    void LightClusterSystem::assignLights(FrameInfo& frameInfo) {
+        FrameResources& frame = frames[frameInfo.frameIndex];
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        vkCmdFillBuffer(commandBuffer, frame.counterBuffer->getBuffer(), 0, sizeof(LightClusterCounters), 0);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // Runs without lights too, every cluster then gets a count of 0
+        LightClusterPushConstants push{};
+        push.view = viewMatrix;
+        push.projection = projection;
+        push.depthRange = glm::vec4(depthRange, 0.f, 0.f);
+        push.grid = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, lightCount);
+
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0,
+            1,
+            &frame.descriptorSet,
+            0,
+            nullptr);
+
+        vkCmdPushConstants(
+            commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(LightClusterPushConstants),
+            &push);
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, clusterPipeline->getPipeline());
+        vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + CLUSTER_WORKGROUP_SIZE - 1) / CLUSTER_WORKGROUP_SIZE, 1, 1);
+
+        // The clusters are read by fragments, the counters by the stats readback
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+} // namespace Dog
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../Core/Device.h"
+#include "../FrameInfo.h"
+#include "../Buffers/Buffer.h"
+#include "../Descriptors/Descriptors.h"
+#include "../Pipeline/PipelineCompiler.h"
+
+namespace Dog {
+
+    struct LightStats {
+        uint32_t pointLights = 0;        // Lights in the light buffer this frame
+        uint32_t lightAssignments = 0;   // Lights of every cluster added up
+        uint32_t maxClusterLights = 0;   // Most lights touching one cluster, what the slowest fragments loop over
+        uint32_t overflowedClusters = 0; // Clusters touched by more lights than they hold, the extra lights are left out
+    };
+
+    // Clustered forward lighting. Every PointLightComponent is written into the frame's light buffer, then a compute
+    // pass splits the view into froxels, screen tiles cut into exponential depth slices, and lists the lights whose
+    // radius reaches each one. Fragments only shade the lights of their cluster (see clustered_lights.glsl), so
+    // their cost follows the lights around them rather than the lights in the scene
+    class LightClusterSystem {
+    public:
+        static constexpr uint32_t CLUSTER_X = 16;
+        static constexpr uint32_t CLUSTER_Y = 9;
+        static constexpr uint32_t CLUSTER_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+        // Matches MAX_LIGHTS_PER_CLUSTER in light_cluster.comp and clustered_lights.glsl
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+        LightClusterSystem(Device& device, PipelineCompiler& pipelineCompiler);
+        ~LightClusterSystem();
+
+        LightClusterSystem(const LightClusterSystem&) = delete;
+        LightClusterSystem& operator=(const LightClusterSystem&) = delete;
+
+        // Writes the scene's point lights into the frame's light buffer and the cluster grid into the ubo. Returns
+        // true if the light buffer grew, the frame's global set then has to be pointed at the new one
+        bool update(FrameInfo& frameInfo, entt::registry& registry, GlobalUbo& ubo);
+
+        // Must be recorded outside a render pass, after update
+        void assignLights(FrameInfo& frameInfo);
+
+        // Bound to the global set, the cluster buffers hold each cluster's light count and light indices
+        Buffer& getLightBuffer(int frameIndex) { return *frames[frameIndex].lightBuffer; }
+        Buffer& getClusterBuffer(int frameIndex) { return *frames[frameIndex].clusterBuffer; }
+        Buffer& getLightIndexBuffer(int frameIndex) { return *frames[frameIndex].lightIndexBuffer; }
+
+        uint32_t getLightCount() const { return lightCount; }
+
+        // Cluster counts are from the last completed frame that used the current frame slot
+        const LightStats& getStats() const { return stats; }
+
+    private:
+        struct FrameResources {
+            std::unique_ptr<Buffer> lightBuffer;
+            uint32_t lightCapacity = 0;
+            std::unique_ptr<Buffer> clusterBuffer;
+            std::unique_ptr<Buffer> lightIndexBuffer;
+            std::unique_ptr<Buffer> counterBuffer;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        void createBuffers();
+        void createPipeline(PipelineCompiler& pipelineCompiler);
+        void createLightBuffer(FrameResources& frame, uint32_t capacity);
+        void writeDescriptorSet(FrameResources& frame);
+        void readStats(FrameResources& frame);
+
+        Device& device;
+
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        std::vector<FrameResources> frames;
+
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::shared_ptr<AsyncPipeline> clusterPipeline; // Waited on at creation, nothing is lit without it
+
+        // Of this frame's update, read by assignLights
+        uint32_t lightCount = 0;
+        glm::mat4 viewMatrix{ 1.f };
+        glm::vec4 projection{ 0.f };
+        glm::vec2 depthRange{ 0.f };
+
+        LightStats stats{};
+    };
+
+} // namespace Dog
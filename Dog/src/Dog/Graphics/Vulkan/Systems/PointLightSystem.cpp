@@ -3,17 +3,11 @@
 
 namespace Dog {
 
-    struct PointLightPushConstants {
-        glm::vec4 position{};
-        glm::vec4 color{};
-        float radius;
-    };
-
     PointLightSystem::PointLightSystem(
-        Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
+        Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, PipelineCompiler& pipelineCompiler)
         : device{ device } {
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(renderPass, pipelineCompiler);
     }
 
     PointLightSystem::~PointLightSystem() {
@@ -21,64 +15,39 @@ namespace Dog {
     }
 
     void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(PointLightPushConstants);
-
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
     }
 
-    void PointLightSystem::createPipeline(VkRenderPass renderPass) {
+    void PointLightSystem::createPipeline(VkRenderPass renderPass, PipelineCompiler& pipelineCompiler) {
         assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
-        Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.attributeDescriptions.clear();
-        pipelineConfig.bindingDescriptions.clear();
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
-        lvePipeline = std::make_unique<Pipeline>(
-            device,
+        lvePipeline = pipelineCompiler.compileGraphics(
             "point_light.vert",
             "point_light.frag",
-            pipelineConfig);
+            [renderPass, pipelineLayout = pipelineLayout](PipelineConfigInfo& pipelineConfig) {
+                pipelineConfig.attributeDescriptions.clear();
+                pipelineConfig.bindingDescriptions.clear();
+                pipelineConfig.renderPass = renderPass;
+                pipelineConfig.pipelineLayout = pipelineLayout;
+            });
     }
 
-    void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
-        auto rotateLight = glm::rotate(glm::mat4(1.f), 0.5f * frameInfo.frameTime, { 0.f, -1.f, 0.f });
-        int lightIndex = 0;
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
-            assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified");
+    void PointLightSystem::render(FrameInfo& frameInfo, uint32_t lightCount) {
+        VkPipeline pipeline = lvePipeline->getPipeline();
+        if (pipeline == VK_NULL_HANDLE || lightCount == 0) return;
 
-            // update light position
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-
-            // copy light to ubo
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-
-            lightIndex += 1;
-        }
-        ubo.numLights = lightIndex;
-    }
-
-    void PointLightSystem::render(FrameInfo& frameInfo) {
-        lvePipeline->bind(frameInfo.commandBuffer);
+        vkCmdBindPipeline(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
         vkCmdBindDescriptorSets(
             frameInfo.commandBuffer,
@@ -90,24 +59,8 @@ namespace Dog {
             0,
             nullptr);
 
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
-
-            PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
-
-            vkCmdPushConstants(
-                frameInfo.commandBuffer,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(PointLightPushConstants),
-                &push);
-            vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-        }
+        // One instance per light, the vertex shader reads its light from the light buffer
+        vkCmdDraw(frameInfo.commandBuffer, 6, lightCount, 0, 0);
     }
 
 } // namespace Dog
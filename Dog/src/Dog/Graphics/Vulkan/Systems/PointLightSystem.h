@@ -3,30 +3,30 @@
 #include "../Camera.h"
 #include "../Core/Device.h"
 #include "../FrameInfo.h"
-#include "Entities/GameObject.h"
-#include "../Pipeline/Pipeline.h"
+#include "../Pipeline/PipelineCompiler.h"
 
 namespace Dog {
 
+    // Draws a billboard for every light in the frame's light buffer, written by the light cluster system
     class PointLightSystem {
     public:
         PointLightSystem(
-            Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+            Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, PipelineCompiler& pipelineCompiler);
         ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem&) = delete;
         PointLightSystem& operator=(const PointLightSystem&) = delete;
 
-        void update(FrameInfo& frameInfo, GlobalUbo& ubo);
-        void render(FrameInfo& frameInfo);
+        void render(FrameInfo& frameInfo, uint32_t lightCount);
 
     private:
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(VkRenderPass renderPass, PipelineCompiler& pipelineCompiler);
 
         Device& device;
 
-        std::unique_ptr<Pipeline> lvePipeline;
+        // Lights aren't drawn until it's compiled
+        std::shared_ptr<AsyncPipeline> lvePipeline;
         VkPipelineLayout pipelineLayout;
     };
 
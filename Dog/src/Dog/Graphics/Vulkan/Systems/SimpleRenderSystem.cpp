@@ -4,174 +4,515 @@
 #include "Scene/SceneManager.h"
 #include "Scene/Scene.h"
 #include "Scene/Entity/Components.h"
+#include "../Models/GeometryPool.h"
+#include "../Core/SwapChain.h"
 
 namespace Dog {
 
-    struct SimplePushConstantData {
-        glm::mat4 modelMatrix{ 1.f };
-        glm::mat4 normalMatrix{ 1.f };
-        int textureIndex{ 0 };
-    };
+    // Screen size (the bounding sphere's diameter over the screen height) below which each LOD gives way to the
+    // next. Every level has about half the triangles of the one before, so they halve too
+    static constexpr float LOD_SCREEN_SIZES[Mesh::MAX_LODS - 1] = { 0.5f, 0.25f, 0.125f, 0.0625f };
+
+    // How far past a threshold the screen size must go before the LOD changes
+    static constexpr float LOD_HYSTERESIS = 0.1f;
 
     SimpleRenderSystem::SimpleRenderSystem(
-        Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary, ModelLibrary& modelLibrary)
+        Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary, ModelLibrary& modelLibrary, CullingSystem& cullingSystem, SkinningSystem& skinningSystem, ParallelRecorder& recorder, PipelineCompiler& pipelineCompiler)
         : device{ device }
         , textureLibrary{ textureLibrary }
         , modelLibrary{ modelLibrary }
+        , cullingSystem{ cullingSystem }
+        , skinningSystem{ skinningSystem }
+        , recorder{ recorder }
+        , pipelineCompiler{ pipelineCompiler }
+        , renderPass{ renderPass }
     {
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+
+        // Packed static meshes are the common case, so their pipeline starts compiling now.
+        // The other layouts are requested on demand
+        createPipeline(0);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
         vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     }
 
-    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
+    uint32_t SimpleRenderSystem::getBindState(const DrawGroup& group) {
+        return (group.skinned ? VERTEX_LAYOUT_COUNT * 2 : 0) + group.layout * 2 + (group.mesh->indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0);
+    }
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+        // Set 1 is the bindless texture array
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, textureLibrary.getBindlessTable().getDescriptorSetLayout() };
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
     }
 
-    void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+    void SimpleRenderSystem::createPipeline(VertexLayout layout) {
         assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create pipeline before pipeline layout");
 
+        createFallbackPipeline(layout);
+
+        // Configured on the job thread, so only copies are captured
+        auto configure = [layout, renderPass = renderPass, pipelineLayout = pipelineLayout](PipelineConfigInfo& pipelineConfig) {
+            pipelineConfig.bindingDescriptions = Vertex::getBindingDescriptions(layout);
+            pipelineConfig.attributeDescriptions = Vertex::getAttributeDescriptions(layout);
+            pipelineConfig.shaderDefines = getVertexLayoutDefines(layout);
+            pipelineConfig.renderPass = renderPass;
+            pipelineConfig.pipelineLayout = pipelineLayout;
+            pipelineConfig.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+        };
+        lvePipelines[layout] = pipelineCompiler.compileGraphics("simple_shader.vert", "simple_shader.frag", configure);
+
+        // Using base pipeline is supposed to make pipeline creation more efficient
+        // It should also make switching between the two pipelines more efficient
+        lveWireframePipelines[layout] = pipelineCompiler.compileGraphics(
+            "simple_shader.vert",
+            "simple_shader.frag",
+            [configure](PipelineConfigInfo& pipelineConfig) {
+                configure(pipelineConfig);
+                pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
+                pipelineConfig.rasterizationInfo.lineWidth = 1.0f;
+            },
+            lvePipelines[layout]);
+    }
+
+    void SimpleRenderSystem::createFallbackPipeline(VertexLayout layout) {
         PipelineConfigInfo pipelineConfig{};
         Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.bindingDescriptions = Vertex::getBindingDescriptions(layout);
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = pipelineLayout;
-        pipelineConfig.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
-        lvePipeline = std::make_unique<Pipeline>(
-            device,
-            "simple_shader.vert",
-            "simple_shader.frag",
-            pipelineConfig);
 
-        // Using base pipeline is supposed to make pipeline creation more efficient
-        // It should also make switching between the two pipelines more efficient
-        pipelineConfig.rasterizationInfo.polygonMode = VK_POLYGON_MODE_LINE;
-        pipelineConfig.rasterizationInfo.lineWidth = 1.0f;
-        pipelineConfig.basePipelineIndex = -1; // -1 forces it to use basePipelineHandle (which must be valid)
-        pipelineConfig.basePipelineHandle = lvePipeline->getPipeline();
-        pipelineConfig.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
-        lveWireframePipeline = std::make_unique<Pipeline>(
+        // The fallback shader only reads positions
+        for (const VkVertexInputAttributeDescription& attribute : Vertex::getAttributeDescriptions(layout)) {
+            if (attribute.location == 0) {
+                pipelineConfig.attributeDescriptions = { attribute };
+            }
+        }
+
+        fallbackPipelines[layout] = std::make_unique<Pipeline>(
             device,
-            "simple_shader.vert",
-            "simple_shader.frag",
+            "fallback.vert",
+            "fallback.frag",
             pipelineConfig);
     }
 
-    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+    void SimpleRenderSystem::prepareFrame(FrameInfo& frameInfo) {
+        uint32_t bucketCount = recorder.getBucketCount();
+        buckets.resize(bucketCount);
+
+        Scene* scene = SceneManager::GetCurrentScene();
+        entt::registry& registry = scene->GetRegistry();
+        auto view = registry.view<TransformComponent, ModelComponent>(entt::exclude<BakedAnimatorComponent>);
 
-        static float frame = 0;
-        static bool wireframe = false;
-        frame += frameInfo.frameTime;
-        if (frame > 3.f) {
-            frame = 0;
-            wireframe = !wireframe;
+        // Entity ids are copied so the view can be split into contiguous slices, one per bucket
+        entities.assign(view.begin(), view.end());
+        uint32_t entityCount = static_cast<uint32_t>(entities.size());
+        uint32_t sliceSize = (entityCount + bucketCount - 1) / bucketCount;
+        uint32_t modelCount = modelLibrary.GetModelCount();
+
+        // Models still loading draw as the placeholder, so their spheres are never read
+        modelSpheres.resize(modelCount);
+        for (uint32_t i = 0; i < modelCount; ++i) {
+            Model* model = modelLibrary.GetModelByIndex(i);
+            modelSpheres[i] = model ? model->boundingSphere : glm::vec4(0.f);
         }
+        lodCameraPosition = glm::vec3(frameInfo.camera.getInverseView()[3]);
+        lodScale = std::abs(frameInfo.camera.getProjection()[1][1]) * lodQuality;
+        sortNear = frameInfo.camera.getNear();
+        sortFar = frameInfo.camera.getFar();
+
+        recorder.run([&](uint32_t bucket) {
+            uint32_t begin = std::min(bucket * sliceSize, entityCount);
+            uint32_t end = std::min(begin + sliceSize, entityCount);
+            gatherTransforms(buckets[bucket], registry, view, begin, end, modelCount);
+        });
+
+        uint32_t instanceCount = assignDrawGroups();
 
-        if (wireframe) {
-            //lveWireframePipeline->bind(frameInfo.commandBuffer);
+        // Skinned copies are written before anything that draws them, and before the buckets bind their buffers
+        skinningSystem.record(frameInfo.commandBuffer);
+
+        recorder.run([&](uint32_t bucket) {
+            writeDrawGroups(frameInfo, buckets[bucket]);
+            if (recorder.isParallel()) {
+                recordBucket(frameInfo, buckets[bucket]);
+            }
+        });
+
+        if (recorder.isParallel()) {
+            drawRecordStats.binds = {};
+            drawRecordStats.recordMs = 0.0;
+            for (const DrawBucket& bucket : buckets) {
+                drawRecordStats.binds += bucket.binds;
+                drawRecordStats.recordMs += bucket.recordMs;
+            }
+        }
+
+        if (instanceCount > 0) {
+            frameInfo.instanceBuffer.flush(instanceCount * sizeof(InstanceData), 0);
+        }
+
+        // Each bucket draws its own range of the indirect buffer, so parallel frames can't compact it
+        glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+        cullingSystem.cull(
+            frameInfo.commandBuffer,
+            frameInfo.frameIndex,
+            viewProjection,
+            instanceCount,
+            static_cast<uint32_t>(drawGroups.size()),
+            !recorder.isParallel() && !mixedBindStates);
+    }
+
+    void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo) {
+        if (recorder.isParallel()) {
+            // The buckets were recorded in prepareFrame, the render pass must have been begun for secondaries
+            secondaryCommandBuffers.clear();
+            for (const DrawBucket& bucket : buckets) {
+                if (bucket.commandBuffer != VK_NULL_HANDLE) {
+                    secondaryCommandBuffers.push_back(bucket.commandBuffer);
+                }
+            }
+
+            if (!secondaryCommandBuffers.empty()) {
+                vkCmdExecuteCommands(
+                    frameInfo.commandBuffer,
+                    static_cast<uint32_t>(secondaryCommandBuffers.size()),
+                    secondaryCommandBuffers.data());
+            }
+            return;
         }
-        else {
+
+        auto start = std::chrono::high_resolution_clock::now();
+        DrawStateCache state(frameInfo.commandBuffer, drawSorting);
+        bindResources(frameInfo, frameInfo.commandBuffer);
+        if (!drawGroups.empty()) {
+            recordDraws(frameInfo, state, 0, static_cast<uint32_t>(drawGroups.size()));
         }
-        lvePipeline->bind(frameInfo.commandBuffer);
 
-        //lvePipeline->bind(frameInfo.commandBuffer);
+        drawRecordStats.binds = state.getStats();
+        drawRecordStats.recordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void SimpleRenderSystem::bindResources(FrameInfo& frameInfo, VkCommandBuffer commandBuffer) {
+        VkDescriptorSet descriptorSets[] = {
+            frameInfo.globalDescriptorSet,
+            textureLibrary.getBindlessTable().getDescriptorSet()
+        };
 
         vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
+            commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
-            1,
-            &frameInfo.globalDescriptorSet,
+            2,
+            descriptorSets,
             0,
             nullptr);
+    }
 
-        Scene* scene = SceneManager::GetCurrentScene();
-        entt::registry& registry = scene->GetRegistry();
+    void SimpleRenderSystem::recordDraws(FrameInfo& frameInfo, DrawStateCache& state, uint32_t firstGroup, uint32_t groupCount) {
+        GeometryPool& geometryPool = modelLibrary.GetGeometryPool();
+        VkCommandBuffer commandBuffer = state.getCommandBuffer();
+        uint32_t endGroup = firstGroup + groupCount;
+
+        for (uint32_t runStart = firstGroup; runStart < endGroup;) {
+            const DrawGroup& runGroup = drawGroups[runStart];
+            uint32_t bindState = getBindState(runGroup);
+            uint32_t runEnd = runStart + 1;
+            while (runEnd < endGroup && getBindState(drawGroups[runEnd]) == bindState) {
+                ++runEnd;
+            }
+
+            // Every mesh of the run shares its arenas' buffers, so this is the only geometry bind of the run.
+            // Runs that differ only in index type or vertex source keep the pipeline, and the other buffers
+            state.bindPipeline(framePipelines[runGroup.layout]);
+            if (runGroup.skinned) {
+                skinningSystem.bind(state, frameInfo.frameIndex, runGroup.layout);
+                geometryPool.bindIndices(state, runGroup.mesh->indexType);
+            }
+            else {
+                geometryPool.bind(state, runGroup.layout, runGroup.mesh->indexType);
+            }
+
+            if (!device.getEnabledFeatures().drawIndirectFirstInstance) {
+                // Indirect commands can't offset into the visible list here, so draw each group directly.
+                // Culling is off in this case, so every instance of a group is in its range
+                for (uint32_t i = runStart; i < runEnd; ++i) {
+                    const DrawGroup& group = drawGroups[i];
+                    const MeshLod& meshLod = group.mesh->lods[group.lod];
+                    vkCmdDrawIndexed(
+                        commandBuffer,
+                        meshLod.indexCount,
+                        group.instanceCount,
+                        group.mesh->firstIndex + meshLod.firstIndex,
+                        group.vertexOffset,
+                        group.firstInstance);
+                }
+            }
+            else {
+                cullingSystem.draw(commandBuffer, frameInfo.frameIndex, runStart, runEnd - runStart);
+            }
+
+            runStart = runEnd;
+        }
+    }
+
+    void SimpleRenderSystem::recordBucket(FrameInfo& frameInfo, DrawBucket& bucket) {
+        bucket.commandBuffer = VK_NULL_HANDLE;
+        bucket.binds = {};
+        bucket.recordMs = 0.0;
+        if (bucket.groupCount == 0) return;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        VkCommandBuffer commandBuffer = recorder.beginSecondary();
+        DrawStateCache state(commandBuffer, drawSorting);
+        bindResources(frameInfo, commandBuffer);
+        recordDraws(frameInfo, state, bucket.firstGroup, bucket.groupCount);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record command buffer!");
+        }
+        bucket.commandBuffer = commandBuffer;
+        bucket.binds = state.getStats();
+        bucket.recordMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    void SimpleRenderSystem::gatherTransforms(DrawBucket& bucket, entt::registry& registry, EntityView& view, uint32_t begin, uint32_t end, uint32_t modelCount) {
+        for (auto& transforms : bucket.modelTransforms) {
+            transforms.clear();
+        }
+        bucket.modelTransforms.resize(static_cast<size_t>(modelCount) * Mesh::MAX_LODS);
+
+        // Matrices are computed once per entity, then shared by every mesh of its model
+        for (uint32_t i = begin; i < end; ++i) {
+            auto [transform, model] = view.get<TransformComponent, ModelComponent>(entities[i]);
+            if (model.ModelIndex == INVALID_MODEL_INDEX || model.ModelIndex >= modelCount) continue;
+
+            // Models that are still loading draw as the placeholder
+            uint32_t modelIndex = modelLibrary.GetRenderableIndex(model.ModelIndex);
+            if (modelIndex >= modelCount) continue;
+
+            // Animators that haven't got a pose yet are left on the bind pose
+            const AnimatorComponent* animator = registry.try_get<AnimatorComponent>(entities[i]);
+            uint32_t paletteOffset = animator ? animator->PaletteOffset : SkinningSystem::BIND_POSE_PALETTE;
+
+            glm::mat4 modelMatrix = transform.mat4();
+            uint32_t lod = selectLod(model, modelSpheres[modelIndex], modelMatrix);
+            bucket.modelTransforms[modelIndex * Mesh::MAX_LODS + lod].push_back({ modelMatrix, transform.normalMatrix(), paletteOffset });
+        }
+    }
+
+    uint32_t SimpleRenderSystem::selectLod(ModelComponent& model, const glm::vec4& boundingSphere, const glm::mat4& modelMatrix) const {
+        glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(boundingSphere), 1.f));
+        float scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+        float radius = boundingSphere.w * scale;
+        float distance = glm::length(center - lodCameraPosition);
+
+        // From inside the sphere it covers the screen
+        if (distance <= radius) {
+            model.CurrentLod = 0;
+            return 0;
+        }
+
+        float screenSize = radius * lodScale / distance * std::exp2(-model.LodBias);
+
+        uint32_t lod = std::min(model.CurrentLod, Mesh::MAX_LODS - 1);
+        while (lod + 1 < Mesh::MAX_LODS && screenSize < LOD_SCREEN_SIZES[lod] * (1.f - LOD_HYSTERESIS)) {
+            ++lod;
+        }
+        while (lod > 0 && screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.f + LOD_HYSTERESIS)) {
+            --lod;
+        }
+
+        model.CurrentLod = lod;
+        return lod;
+    }
+
+    uint32_t SimpleRenderSystem::assignDrawGroups() {
+        drawGroups.clear();
+        uint32_t instanceCount = 0;
+        uint32_t usedLayouts = 0;
+        uint32_t usedBindStates = 0;
+        triangleStats = {};
+        drawRecordStats.sortedGroups = 0;
+        drawRecordStats.sortMs = 0.0;
+
+        // Meshes get dense ids as their models are first seen this frame, so the key's mesh field only has to
+        // count the meshes drawn, not every model index and mesh index
+        meshKeyBases.assign(modelLibrary.GetModelCount(), UINT32_MAX);
+        uint32_t meshKeyCount = 0;
+
+        // Texture then mesh after bind state, so groups that share them are next to each other, then nearest first
+        auto makeSortKey = [](const DrawGroup& group, uint32_t meshKey, uint32_t depth) {
+            return RenderQueue::makeKey(RenderQueue::PASS_OPAQUE, getBindState(group), group.mesh->textureIndex, meshKey, depth);
+        };
 
-        registry.view<TransformComponent, ModelComponent>().each
-        ([&](const auto& entity, const TransformComponent& transform, const ModelComponent& model)
-            {
-                if (model.ModelIndex == INVALID_MODEL_INDEX) return;
+        // A bucket's groups are contiguous, so its secondary can draw them as one range
+        for (DrawBucket& bucket : buckets) {
+            bucket.firstGroup = static_cast<uint32_t>(drawGroups.size());
 
-                Model* pModel = modelLibrary.GetModelByIndex(model.ModelIndex);
+            for (uint32_t transformIndex = 0; transformIndex < bucket.modelTransforms.size(); ++transformIndex) {
+                const auto& transforms = bucket.modelTransforms[transformIndex];
+                if (transforms.empty()) continue;
 
-                for (auto& mesh : pModel->meshes) {
-                    SimplePushConstantData push{};
-                    push.modelMatrix = transform.mat4();
-                    push.normalMatrix = transform.normalMatrix();
+                uint32_t modelIndex = transformIndex / Mesh::MAX_LODS;
+                Model* pModel = modelLibrary.GetModelByIndex(modelIndex);
+                uint32_t lod = transformIndex % Mesh::MAX_LODS;
+                uint32_t nearestDepth = drawSorting ? getSortDepth(transforms, 0, static_cast<uint32_t>(transforms.size())) : 0;
 
-                    if (mesh.textureIndex == INVALID_TEXTURE_INDEX) {
-                        push.textureIndex = 0;
+                // Every LOD of a model shares its mesh ids
+                if (meshKeyBases[modelIndex] == UINT32_MAX) {
+                    meshKeyBases[modelIndex] = meshKeyCount;
+                    meshKeyCount += static_cast<uint32_t>(pModel->meshes.size());
+                    assert(meshKeyCount <= (1u << RenderQueue::MESH_BITS) && "More meshes than the sort key's mesh field holds");
+                }
+
+                for (uint32_t meshIndex = 0; meshIndex < pModel->meshes.size(); ++meshIndex) {
+                    Mesh& mesh = pModel->meshes[meshIndex];
+                    uint32_t meshKey = meshKeyBases[modelIndex] + meshIndex;
+                    uint32_t count = std::min(static_cast<uint32_t>(transforms.size()), MAX_INSTANCES - instanceCount);
+                    if (count < transforms.size() && !warnedInstanceOverflow) {
+                        DOG_WARN("More than {0} instances this frame, the rest won't be drawn", MAX_INSTANCES);
+                        warnedInstanceOverflow = true;
+                    }
+                    if (count == 0) break;
+
+                    // Meshes with shorter chains draw their coarsest level
+                    uint32_t meshLod = std::min(lod, mesh.lodCount - 1);
+                    if (mesh.layout & VERTEX_LAYOUT_SKINNED) {
+                        // Every instance has its own skinned vertices, so its own draw
+                        VertexLayout outputLayout = SkinningSystem::getOutputLayout(mesh.layout);
+                        for (uint32_t i = 0; i < count; ++i) {
+                            int32_t vertexOffset = skinningSystem.addInstance(mesh, transforms[i].paletteOffset);
+                            DrawGroup& group = drawGroups.emplace_back(DrawGroup{ &mesh, instanceCount + i, 1, transformIndex, i, meshLod, outputLayout, vertexOffset, true, 0 });
+                            group.sortKey = drawSorting ? makeSortKey(group, meshKey, getSortDepth(transforms, i, 1)) : 0;
+                        }
                     }
                     else {
-                        push.textureIndex = mesh.textureIndex;
+                        DrawGroup& group = drawGroups.emplace_back(DrawGroup{ &mesh, instanceCount, count, transformIndex, 0, meshLod, mesh.layout, mesh.vertexOffset, false, 0 });
+                        group.sortKey = drawSorting ? makeSortKey(group, meshKey, nearestDepth) : 0;
                     }
+                    instanceCount += count;
 
-                    vkCmdPushConstants(
-                        frameInfo.commandBuffer,
-                        pipelineLayout,
-                        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                        0,
-                        sizeof(SimplePushConstantData),
-                        &push);
-
-                    mesh.bind(frameInfo.commandBuffer);
-                    mesh.draw(frameInfo.commandBuffer);
+                    triangleStats.fullDetail += static_cast<uint64_t>(count) * mesh.getTriangleCount(0);
+                    triangleStats.submitted += static_cast<uint64_t>(count) * mesh.getTriangleCount(meshLod);
                 }
-            });
-
-        /*for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
+            }
 
-            Model* model;
+            bucket.groupCount = static_cast<uint32_t>(drawGroups.size()) - bucket.firstGroup;
 
-            if ((model = modelLibrary.GetModelByIndex(obj.model)) == nullptr) {
-                continue;
+            auto start = std::chrono::high_resolution_clock::now();
+            if (drawSorting) {
+                sortBucket(bucket);
+            }
+            else {
+                // Each group keeps its own instance range, so reordering them is free
+                std::stable_sort(
+                    drawGroups.begin() + bucket.firstGroup,
+                    drawGroups.end(),
+                    [](const DrawGroup& a, const DrawGroup& b) { return getBindState(a) < getBindState(b); });
             }
+            drawRecordStats.sortMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            drawRecordStats.sortedGroups += bucket.groupCount;
+        }
+
+        for (const DrawGroup& group : drawGroups) {
+            usedLayouts |= 1u << group.layout;
+            usedBindStates |= 1u << getBindState(group);
+        }
 
-            for (auto& mesh : model->meshes) {
-                SimplePushConstantData push{};
-                push.modelMatrix = obj.transform.mat4();
-                push.normalMatrix = obj.transform.normalMatrix();
+        // Recording may happen on job threads, so any missing pipeline is requested here on the main thread,
+        // and layouts whose pipeline is still compiling draw with their fallback this frame
+        fallbackDrawCount = 0;
+        for (VertexLayout layout = 0; layout < VERTEX_LAYOUT_COUNT; ++layout) {
+            if (!(usedLayouts & (1u << layout))) continue;
 
-                if (mesh.textureIndex == 999 && obj.textureIndex != 999) {
-                    push.textureIndex = obj.textureIndex;
-                }
-                else {
-                    push.textureIndex = mesh.textureIndex;
+            if (!lvePipelines[layout]) {
+                createPipeline(layout);
+            }
+
+            framePipelines[layout] = lvePipelines[layout]->getPipeline();
+            if (framePipelines[layout] == VK_NULL_HANDLE) {
+                framePipelines[layout] = fallbackPipelines[layout]->getPipeline();
+                for (const DrawGroup& group : drawGroups) {
+                    fallbackDrawCount += group.layout == layout ? 1 : 0;
                 }
+            }
+        }
+        mixedBindStates = (usedBindStates & (usedBindStates - 1)) != 0;
 
-                vkCmdPushConstants(
-                    frameInfo.commandBuffer,
-                    pipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                    0,
-                    sizeof(SimplePushConstantData),
-                    &push);
+        return instanceCount;
+    }
+
+    void SimpleRenderSystem::sortBucket(const DrawBucket& bucket) {
+        renderQueue.clear();
+        for (uint32_t i = 0; i < bucket.groupCount; ++i) {
+            renderQueue.push(drawGroups[bucket.firstGroup + i].sortKey, i);
+        }
+        renderQueue.sort();
+
+        sortedGroups.clear();
+        for (const RenderQueue::Entry& entry : renderQueue.getEntries()) {
+            sortedGroups.push_back(drawGroups[bucket.firstGroup + entry.item]);
+        }
+        std::copy(sortedGroups.begin(), sortedGroups.end(), drawGroups.begin() + bucket.firstGroup);
+    }
 
-                mesh.bind(frameInfo.commandBuffer);
-                mesh.draw(frameInfo.commandBuffer);
+    uint32_t SimpleRenderSystem::getSortDepth(const std::vector<InstanceTransform>& transforms, uint32_t first, uint32_t count) const {
+        // From each instance's origin, close enough to order by
+        float nearest = sortFar;
+        for (uint32_t i = first; i < first + count; ++i) {
+            nearest = std::min(nearest, glm::length(glm::vec3(transforms[i].modelMatrix[3]) - lodCameraPosition));
+        }
+        return RenderQueue::quantizeDepth(nearest, sortNear, sortFar);
+    }
+
+    void SimpleRenderSystem::writeDrawGroups(FrameInfo& frameInfo, const DrawBucket& bucket) {
+        InstanceData* instances = static_cast<InstanceData*>(frameInfo.instanceBuffer.getMappedMemory());
+        DrawCullData* draws = cullingSystem.getDrawData(frameInfo.frameIndex);
+
+        for (uint32_t drawIndex = bucket.firstGroup; drawIndex < bucket.firstGroup + bucket.groupCount; ++drawIndex) {
+            const DrawGroup& group = drawGroups[drawIndex];
+            const Mesh& mesh = *group.mesh;
+            const auto& transforms = bucket.modelTransforms[group.transformIndex];
+
+            // Skinned copies are written decoded
+            int textureIndex = mesh.textureIndex == INVALID_TEXTURE_INDEX ? 0 : static_cast<int>(mesh.textureIndex);
+            glm::vec4 positionDecode = group.skinned ? glm::vec4(0.f, 0.f, 0.f, 1.f) : mesh.positionDecode;
+            glm::vec4 uvDecode = group.skinned ? glm::vec4(0.f, 0.f, 1.f, 1.f) : mesh.uvDecode;
+            for (uint32_t i = 0; i < group.instanceCount; ++i) {
+                const InstanceTransform& transform = transforms[group.firstTransform + i];
+                InstanceData& instance = instances[group.firstInstance + i];
+                instance.modelMatrix = transform.modelMatrix;
+                instance.normalMatrix = transform.normalMatrix;
+                instance.positionDecode = positionDecode;
+                instance.uvDecode = uvDecode;
+                instance.textureIndex = textureIndex;
+                instance.drawIndex = drawIndex;
             }
-        }*/
+
+            // instanceCount is left for the cull pass to fill with the number of visible instances
+            DrawCullData& draw = draws[drawIndex];
+            draw.boundingSphere = mesh.boundingSphere;
+            VkDrawIndexedIndirectCommand& command = draw.command;
+            command.indexCount = mesh.lods[group.lod].indexCount;
+            command.instanceCount = 0;
+            command.firstIndex = mesh.firstIndex + mesh.lods[group.lod].firstIndex;
+            command.vertexOffset = group.vertexOffset;
+            command.firstInstance = group.firstInstance;
+        }
     }
 
-} // namespace Dog
\ No newline at end of file
+} // namespace Dog
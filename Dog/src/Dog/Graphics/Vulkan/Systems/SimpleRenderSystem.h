@@ -5,33 +5,182 @@
 #include "../FrameInfo.h"
 #include "Entities/GameObject.h"
 #include "../Pipeline/Pipeline.h"
+#include "../Pipeline/PipelineCompiler.h"
 #include "../Texture/TextureLibrary.h"
 #include "../Models/ModelLibrary.h"
+#include "CullingSystem.h"
+#include "SkinningSystem.h"
+#include "../Core/ParallelRecorder.h"
+#include "../Core/RenderQueue.h"
+#include "../Core/DrawStateCache.h"
+#include "Scene/Entity/Components.h"
 
 namespace Dog {
 
+    class Mesh;
+
+    // Triangles in the draws handed to the cull pass, before culling
+    struct TriangleStats {
+        uint64_t fullDetail = 0; // Had every mesh been drawn at LOD 0
+        uint64_t submitted = 0;  // At the LODs picked
+    };
+
+    // How draws were ordered and what recording them cost, over every bucket
+    struct DrawRecordStats {
+        uint32_t sortedGroups = 0;
+        double sortMs = 0.0;
+        double recordMs = 0.0;     // CPU time recording draws, added up over buckets
+        DrawStateStats binds;
+    };
+
     class SimpleRenderSystem {
     public:
         SimpleRenderSystem(
-            Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary, ModelLibrary& modelLibrary);
+            Device& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, TextureLibrary& textureLibrary, ModelLibrary& modelLibrary, CullingSystem& cullingSystem, SkinningSystem& skinningSystem, ParallelRecorder& recorder, PipelineCompiler& pipelineCompiler);
         ~SimpleRenderSystem();
 
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+        // Writes this frame's instances and draws and records the skinning and cull passes, must be called outside
+        // the render pass, after the skinning system's beginFrame and the animation update.
+        // With several buckets this also records their secondary command buffers as jobs
+        void prepareFrame(FrameInfo& frameInfo);
+
+        // Records the draws inline, or executes the secondaries from prepareFrame when recording in parallel
         void renderGameObjects(FrameInfo& frameInfo);
 
+        // Scales the screen size LODs are picked from, higher keeps detail further away. 1 by default
+        void setLodQuality(float quality) { lodQuality = quality; }
+        float getLodQuality() const { return lodQuality; }
+
+        // Sorts each bucket's draw groups by render queue key and drops redundant binds while recording. Off keeps
+        // the groups ordered only by bind state and records every bind, to compare against. On by default
+        void setDrawSortingEnabled(bool enabled) { drawSorting = enabled; }
+        bool isDrawSortingEnabled() const { return drawSorting; }
+
+        const TriangleStats& getTriangleStats() const { return triangleStats; }
+
+        // Recorded inline in renderGameObjects, so without parallel recording these are from the frame before
+        const DrawRecordStats& getDrawRecordStats() const { return drawRecordStats; }
+
+        // Draw groups this frame drawn with the fallback pipeline, because their own was still compiling
+        uint32_t getFallbackDrawCount() const { return fallbackDrawCount; }
+
     private:
+        struct InstanceTransform {
+            glm::mat4 modelMatrix;
+            glm::mat4 normalMatrix;
+            uint32_t paletteOffset; // Skinned meshes are posed with this palette
+        };
+
+        // One instanced draw: every instance of a single mesh at one LOD within one bucket.
+        // Skinned meshes draw each instance on its own, from its skinned copy
+        struct DrawGroup {
+            Mesh* mesh;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+            uint32_t transformIndex; // Into the bucket's modelTransforms
+            uint32_t firstTransform; // Of the group's instances in that list
+            uint32_t lod;
+            VertexLayout layout;     // Drawn as, the skinned copy's layout for skinned meshes
+            int32_t vertexOffset;    // Into the pool's arena, or the skinning system's output
+            bool skinned;
+            uint64_t sortKey;        // Bind state, texture, mesh, then distance of its nearest instance
+        };
+
+        // Groups with the same vertex layout, index type and vertex source draw from the same buffers with the same pipeline
+        static uint32_t getBindState(const DrawGroup& group);
+
+        // One job's slice of the entities and the draw groups built from it
+        struct DrawBucket {
+            std::vector<std::vector<InstanceTransform>> modelTransforms; // Indexed by model index * Mesh::MAX_LODS + LOD
+            uint32_t firstGroup = 0;
+            uint32_t groupCount = 0;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            DrawStateStats binds;
+            double recordMs = 0.0;
+        };
+
+        // Crowds playing baked clips are drawn by the crowd system
+        using EntityView = decltype(std::declval<entt::registry&>().view<TransformComponent, ModelComponent>(entt::exclude<BakedAnimatorComponent>));
+
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+
+        // Pipelines are per vertex layout, requested the first time a mesh of that layout is drawn. They compile
+        // on job threads, meanwhile the layout draws with its fallback, which is cheap enough to make right away
+        void createPipeline(VertexLayout layout);
+        void createFallbackPipeline(VertexLayout layout);
+
+        void gatherTransforms(DrawBucket& bucket, entt::registry& registry, EntityView& view, uint32_t begin, uint32_t end, uint32_t modelCount);
+
+        // Picks the entity's LOD from the screen size of its model's bounding sphere, moving away from
+        // the LOD it had last frame only once the size is clearly past a threshold
+        uint32_t selectLod(ModelComponent& model, const glm::vec4& boundingSphere, const glm::mat4& modelMatrix) const;
+
+        // Lays out every bucket's (model, LOD, mesh) groups in the instance buffer, returns the instance count.
+        // A bucket's groups are sorted with bind state first so each is one pipeline and buffer bind.
+        // Skinned instances are queued with the skinning system here
+        uint32_t assignDrawGroups();
+
+        // Reorders a bucket's groups by their sort keys. Each group keeps its own instance range, so this is free
+        void sortBucket(const DrawBucket& bucket);
+
+        // The quantized distance of the nearest of a group's instances
+        uint32_t getSortDepth(const std::vector<InstanceTransform>& transforms, uint32_t first, uint32_t count) const;
+
+        // Writes a bucket's instance data and cull draws for this frame
+        void writeDrawGroups(FrameInfo& frameInfo, const DrawBucket& bucket);
+
+        void bindResources(FrameInfo& frameInfo, VkCommandBuffer commandBuffer);
+
+        // Binds each run of same-layout groups' pipeline and vertex streams, then draws the run. Runs only bind
+        // what differs from the run before
+        void recordDraws(FrameInfo& frameInfo, DrawStateCache& state, uint32_t firstGroup, uint32_t groupCount);
+        void recordBucket(FrameInfo& frameInfo, DrawBucket& bucket);
 
         Device& device;
         TextureLibrary& textureLibrary;
         ModelLibrary& modelLibrary;
+        CullingSystem& cullingSystem;
+        SkinningSystem& skinningSystem;
+        ParallelRecorder& recorder;
+        PipelineCompiler& pipelineCompiler;
 
-        std::unique_ptr<Pipeline> lvePipeline;
-        std::unique_ptr<Pipeline> lveWireframePipeline;
+        VkRenderPass renderPass;
+        std::array<std::shared_ptr<AsyncPipeline>, VERTEX_LAYOUT_COUNT> lvePipelines;
+        std::array<std::shared_ptr<AsyncPipeline>, VERTEX_LAYOUT_COUNT> lveWireframePipelines;
+        std::array<std::unique_ptr<Pipeline>, VERTEX_LAYOUT_COUNT> fallbackPipelines;
         VkPipelineLayout pipelineLayout;
+
+        // Each layout's pipeline for this frame, picked once so every bucket records the same ones
+        std::array<VkPipeline, VERTEX_LAYOUT_COUNT> framePipelines{};
+        uint32_t fallbackDrawCount = 0;
+
+        // Reused every frame to avoid reallocating
+        std::vector<entt::entity> entities;
+        std::vector<DrawBucket> buckets;
+        std::vector<DrawGroup> drawGroups;
+        std::vector<DrawGroup> sortedGroups;
+        std::vector<uint32_t> meshKeyBases; // Per model, the dense id of its first mesh this frame
+        RenderQueue renderQueue;
+        std::vector<VkCommandBuffer> secondaryCommandBuffers;
+        bool mixedBindStates = false; // Compacted draws can't switch pipelines or buffers, so this frame can't compact
+        bool warnedInstanceOverflow = false;
+
+        // This frame's LOD inputs, written before the buckets gather
+        std::vector<glm::vec4> modelSpheres;
+        glm::vec3 lodCameraPosition{ 0.f };
+        float lodScale = 1.f;
+        float lodQuality = 1.f;
+
+        // Sort depths are spaced between the camera's planes
+        float sortNear = 0.1f;
+        float sortFar = 100.f;
+        bool drawSorting = true;
+
+        TriangleStats triangleStats;
+        DrawRecordStats drawRecordStats;
     };
 
 } // namespace Dog
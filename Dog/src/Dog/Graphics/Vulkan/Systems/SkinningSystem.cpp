@@ -0,0 +1,262 @@
+#include <PCH/pch.h>
+#include "SkinningSystem.h"
+#include "../Core/SwapChain.h"
+#include "../Models/GeometryPool.h"
+#include "../Models/Mesh.h"
+
+namespace Dog {
+
+    // Matches the push constants in skin.comp
+    struct SkinPushConstantData {
+        glm::vec4 positionDecode;
+        glm::vec4 uvDecode;
+        uint32_t vertexCount;
+        uint32_t sourceOffset;
+        uint32_t outputOffset;
+        uint32_t paletteOffset;
+        uint32_t sourceLayout;
+    };
+
+    static constexpr uint32_t SKIN_WORKGROUP_SIZE = 64;
+    static constexpr uint32_t INITIAL_OUTPUT_CAPACITY = 1 << 16;
+    static constexpr uint32_t INITIAL_PALETTE_CAPACITY = MAX_BONES * 64;
+
+    SkinningSystem::SkinningSystem(Device& device, GeometryPool& geometryPool, PipelineCompiler& pipelineCompiler)
+        : device{ device }
+        , geometryPool{ geometryPool }
+        , frames(SwapChain::MAX_FRAMES_IN_FLIGHT)
+    {
+        createResources();
+        createPipeline(pipelineCompiler);
+    }
+
+    SkinningSystem::~SkinningSystem() {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+
+    VertexLayout SkinningSystem::getOutputLayout(VertexLayout layout) {
+        return VERTEX_LAYOUT_FLOAT | (layout & VERTEX_LAYOUT_COLOR);
+    }
+
+    void SkinningSystem::createResources() {
+        const uint32_t frameCount = static_cast<uint32_t>(frames.size());
+
+        setLayout =
+            DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+            .build();
+
+        descriptorPool =
+            DescriptorPool::Builder(device)
+            .setMaxSets(frameCount * VERTEX_LAYOUT_COUNT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount * VERTEX_LAYOUT_COUNT * 4)
+            .build();
+
+        for (FrameResources& frame : frames) {
+            createPaletteBuffer(frame, INITIAL_PALETTE_CAPACITY);
+
+            // Written when a layout is first skinned in a frame, since the pool's buffers can be replaced
+            for (VertexLayout layout = 0; layout < VERTEX_LAYOUT_COUNT; ++layout) {
+                if (!(layout & VERTEX_LAYOUT_SKINNED)) continue;
+
+                if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), frame.descriptorSets[layout])) {
+                    throw std::runtime_error("failed to allocate skinning descriptor set!");
+                }
+            }
+        }
+    }
+
+    void SkinningSystem::createPipeline(PipelineCompiler& pipelineCompiler) {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(SkinPushConstantData);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        skinPipeline = pipelineCompiler.compileCompute("skin.comp", pipelineLayout);
+        pipelineCompiler.wait(*skinPipeline);
+
+        if (!skinPipeline->isReady()) {
+            throw std::runtime_error("failed to create skinning pipeline!");
+        }
+    }
+
+    void SkinningSystem::createPaletteBuffer(FrameResources& frame, uint32_t capacity) {
+        frame.paletteBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(glm::mat4),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU);
+        frame.paletteBuffer->map();
+        frame.paletteCapacity = capacity;
+
+        // The bind pose is written once, palettes allocated after it are rewritten every frame
+        glm::mat4* palette = static_cast<glm::mat4*>(frame.paletteBuffer->getMappedMemory());
+        std::fill(palette + BIND_POSE_PALETTE, palette + BIND_POSE_PALETTE + MAX_BONES, glm::mat4(1.f));
+    }
+
+    void SkinningSystem::beginFrame(int frameIndex) {
+        currentFrame = frameIndex;
+        jobs.clear();
+        for (OutputBuffer& output : frames[frameIndex].outputs) {
+            output.count = 0;
+        }
+        frames[frameIndex].paletteCount = BIND_POSE_PALETTE + MAX_BONES;
+    }
+
+    uint32_t SkinningSystem::allocatePalette(uint32_t boneCount) {
+        FrameResources& frame = frames[currentFrame];
+        uint32_t paletteOffset = frame.paletteCount;
+        frame.paletteCount += boneCount;
+
+        // Nothing has been written past the bind pose yet, and the frame's old buffer is no longer in use
+        if (frame.paletteCount > frame.paletteCapacity) {
+            createPaletteBuffer(frame, std::max(frame.paletteCapacity * 2, frame.paletteCount));
+        }
+        return paletteOffset;
+    }
+
+    void SkinningSystem::writePalette(uint32_t paletteOffset, const glm::mat4* bones, uint32_t boneCount) {
+        std::memcpy(getPalette(paletteOffset, boneCount), bones, boneCount * sizeof(glm::mat4));
+    }
+
+    glm::mat4* SkinningSystem::getPalette(uint32_t paletteOffset, uint32_t boneCount) {
+        FrameResources& frame = frames[currentFrame];
+        assert(paletteOffset + boneCount <= frame.paletteCount && "Palette wasn't allocated this frame");
+
+        return static_cast<glm::mat4*>(frame.paletteBuffer->getMappedMemory()) + paletteOffset;
+    }
+
+    int32_t SkinningSystem::addInstance(const Mesh& mesh, uint32_t paletteOffset) {
+        assert((mesh.layout & VERTEX_LAYOUT_SKINNED) && "Only skinned meshes can be skinned");
+
+        OutputBuffer& output = frames[currentFrame].outputs[getOutputLayout(mesh.layout)];
+        uint32_t outputOffset = output.count;
+        output.count += mesh.vertexCount;
+
+        jobs.push_back({ &mesh, outputOffset, paletteOffset });
+        return static_cast<int32_t>(outputOffset);
+    }
+
+    void SkinningSystem::reserveOutput(int frameIndex, VertexLayout outputLayout) {
+        OutputBuffer& output = frames[frameIndex].outputs[outputLayout];
+        if (output.buffer && output.count <= output.capacity) return;
+
+        uint32_t newCapacity = std::max({ output.capacity * 2, output.count, INITIAL_OUTPUT_CAPACITY });
+        output.buffer = std::make_unique<Buffer>(
+            device,
+            getVertexStride(outputLayout),
+            newCapacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+        output.capacity = newCapacity;
+    }
+
+    void SkinningSystem::record(VkCommandBuffer commandBuffer) {
+        FrameResources& frame = frames[currentFrame];
+
+        stats = {};
+        if (jobs.empty()) return;
+
+        // Each source layout's set points at its pool arena and its output buffer, either may have been replaced
+        uint32_t usedLayouts = 0;
+        for (const SkinJob& job : jobs) {
+            usedLayouts |= 1u << job.mesh->layout;
+            stats.skinnedVertices += job.mesh->vertexCount;
+        }
+        stats.skinnedInstances = static_cast<uint32_t>(jobs.size());
+
+        // Palettes were written through the mapping, the buffer may also have been replaced since last frame
+        frame.paletteBuffer->flush();
+        auto paletteInfo = frame.paletteBuffer->descriptorInfo();
+        for (VertexLayout layout = 0; layout < VERTEX_LAYOUT_COUNT; ++layout) {
+            if (!(usedLayouts & (1u << layout))) continue;
+
+            VertexLayout outputLayout = getOutputLayout(layout);
+            reserveOutput(currentFrame, outputLayout);
+
+            auto vertexInfo = geometryPool.getVertexBuffer(layout)->descriptorInfo();
+            auto skinInfo = geometryPool.getSkinBuffer(layout)->descriptorInfo();
+            auto outputInfo = frame.outputs[outputLayout].buffer->descriptorInfo();
+
+            DescriptorWriter(*setLayout, *descriptorPool)
+                .writeBuffer(0, &vertexInfo)
+                .writeBuffer(1, &skinInfo)
+                .writeBuffer(2, &paletteInfo)
+                .writeBuffer(3, &outputInfo)
+                .overwrite(frame.descriptorSets[layout]);
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinPipeline->getPipeline());
+
+        VertexLayout boundLayout = VERTEX_LAYOUT_COUNT;
+        for (const SkinJob& job : jobs) {
+            const Mesh& mesh = *job.mesh;
+            if (mesh.layout != boundLayout) {
+                vkCmdBindDescriptorSets(
+                    commandBuffer,
+                    VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelineLayout,
+                    0,
+                    1,
+                    &frame.descriptorSets[mesh.layout],
+                    0,
+                    nullptr);
+                boundLayout = mesh.layout;
+            }
+
+            SkinPushConstantData push{};
+            push.positionDecode = mesh.positionDecode;
+            push.uvDecode = mesh.uvDecode;
+            push.vertexCount = mesh.vertexCount;
+            push.sourceOffset = static_cast<uint32_t>(mesh.vertexOffset);
+            push.outputOffset = job.outputOffset;
+            push.paletteOffset = job.paletteOffset;
+            push.sourceLayout = mesh.layout;
+
+            vkCmdPushConstants(
+                commandBuffer,
+                pipelineLayout,
+                VK_SHADER_STAGE_COMPUTE_BIT,
+                0,
+                sizeof(SkinPushConstantData),
+                &push);
+            vkCmdDispatch(commandBuffer, (mesh.vertexCount + SKIN_WORKGROUP_SIZE - 1) / SKIN_WORKGROUP_SIZE, 1, 1);
+        }
+
+        // The skinned vertices are read as vertex attributes by every pass of the frame
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void SkinningSystem::bind(DrawStateCache& state, int frameIndex, VertexLayout outputLayout) {
+        const OutputBuffer& output = frames[frameIndex].outputs[outputLayout];
+        assert(output.buffer && "Nothing of this layout was skinned this frame");
+
+        VkBuffer buffer = output.buffer->getBuffer();
+        state.bindVertexBuffers(1, &buffer);
+    }
+
+} // namespace Dog
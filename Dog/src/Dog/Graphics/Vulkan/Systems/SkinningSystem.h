@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../Core/Device.h"
+#include "../Core/DrawStateCache.h"
+#include "../Buffers/Buffer.h"
+#include "../Descriptors/Descriptors.h"
+#include "../Models/VertexLayout.h"
+#include "../Pipeline/PipelineCompiler.h"
+
+namespace Dog {
+
+    class Mesh;
+    class GeometryPool;
+
+    struct SkinningStats {
+        uint32_t skinnedInstances = 0; // Mesh instances skinned this frame
+        uint32_t skinnedVertices = 0;
+    };
+
+    // GPU skinning. Each frame a compute pass transforms every skinned mesh instance's vertices once, with its
+    // bone palette, into a per-frame output buffer. Every palette of the frame is packed into one storage buffer,
+    // starting with the bind pose. The skinned copies are static full precision vertices, so
+    // every pass draws them with the ordinary static pipelines and never touches bones.
+    // Output and palette buffers are per frame in flight, so a frame's are free to rewrite once its fence is waited on
+    class SkinningSystem {
+    public:
+        SkinningSystem(Device& device, GeometryPool& geometryPool, PipelineCompiler& pipelineCompiler);
+        ~SkinningSystem();
+
+        SkinningSystem(const SkinningSystem&) = delete;
+        SkinningSystem& operator=(const SkinningSystem&) = delete;
+
+        // Palette of identity matrices, for instances that aren't animated
+        static constexpr uint32_t BIND_POSE_PALETTE = 0;
+
+        // What a skinned layout's copies are drawn as: full precision floats, keeping its colors
+        static VertexLayout getOutputLayout(VertexLayout layout);
+
+        // Starts the frame's list of instances to skin and its palettes
+        void beginFrame(int frameIndex);
+
+        // Reserves boneCount matrices in this frame's palette buffer and returns the first one's index.
+        // Must not be called while palettes are being written, writing reserved palettes is thread safe
+        uint32_t allocatePalette(uint32_t boneCount);
+        void writePalette(uint32_t paletteOffset, const glm::mat4* bones, uint32_t boneCount);
+
+        // The reserved palette in mapped memory, to build it in place. Write only, reading it back is slow
+        glm::mat4* getPalette(uint32_t paletteOffset, uint32_t boneCount);
+
+        // Queues a copy of a skinned mesh posed with a palette. Returns its vertex offset in the output
+        // buffer of the mesh's output layout, to draw it with instead of the mesh's own
+        int32_t addInstance(const Mesh& mesh, uint32_t paletteOffset = BIND_POSE_PALETTE);
+
+        // Must be recorded outside a render pass, before anything binding the output buffers is recorded
+        void record(VkCommandBuffer commandBuffer);
+
+        // Binds the frame's output buffer of an output layout as vertex binding 0
+        void bind(DrawStateCache& state, int frameIndex, VertexLayout outputLayout);
+
+        const SkinningStats& getStats() const { return stats; }
+
+    private:
+        void createResources();
+        void createPipeline(PipelineCompiler& pipelineCompiler);
+
+        // Grows a frame's output buffer to fit the vertices queued for it, it isn't in use by then
+        void reserveOutput(int frameIndex, VertexLayout outputLayout);
+
+        struct SkinJob {
+            const Mesh* mesh;
+            uint32_t outputOffset;
+            uint32_t paletteOffset;
+        };
+
+        struct OutputBuffer {
+            std::unique_ptr<Buffer> buffer;
+            uint32_t capacity = 0; // Vertices
+            uint32_t count = 0;    // Queued this frame
+        };
+
+        struct FrameResources {
+            std::array<OutputBuffer, VERTEX_LAYOUT_COUNT> outputs; // By output layout
+            std::unique_ptr<Buffer> paletteBuffer;
+            uint32_t paletteCapacity = 0; // Matrices
+            uint32_t paletteCount = 0;    // Allocated this frame
+            std::array<VkDescriptorSet, VERTEX_LAYOUT_COUNT> descriptorSets{}; // By source layout
+        };
+
+        // Replaces a frame's palette buffer with one of this many matrices, starting with the bind pose
+        void createPaletteBuffer(FrameResources& frame, uint32_t capacity);
+
+        Device& device;
+        GeometryPool& geometryPool;
+
+        std::unique_ptr<DescriptorPool> descriptorPool;
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::shared_ptr<AsyncPipeline> skinPipeline; // Waited on at creation, like the cull pipelines
+
+        std::vector<FrameResources> frames;
+        std::vector<SkinJob> jobs;
+        int currentFrame = 0;
+
+        SkinningStats stats{};
+    };
+
+} // namespace Dog
@@ -54,9 +54,29 @@ namespace Dog {
 
     void ImGuiTextureManager::AddTexture(const std::string& texturePath, const VkImageView& imageView, const VkSampler& sampler)
     {
+        // The editor (and its descriptor pool) doesn't exist when running headless
+        if (device.isHeadless()) return;
+
         descriptorMap[texturePath] = CreateDescriptorSet(imageView, sampler);
     }
 
+    VkDescriptorSet ImGuiTextureManager::RemoveTexture(const std::string& texturePath)
+    {
+        auto descriptor = descriptorMap.find(texturePath);
+        if (descriptor == descriptorMap.end()) return VK_NULL_HANDLE;
+
+        VkDescriptorSet descriptorSet = descriptor->second;
+        descriptorMap.erase(descriptor);
+        return descriptorSet;
+    }
+
+    void ImGuiTextureManager::FreeDescriptorSet(VkDescriptorSet descriptorSet)
+    {
+        if (descriptorSet == VK_NULL_HANDLE) return;
+
+        vkFreeDescriptorSets(device, Engine::Get().GetEditor().imGuiDescriptorPool, 1, &descriptorSet);
+    }
+
     VkDescriptorSet ImGuiTextureManager::GetDescriptorSet(const std::string& texturePath)
     {
         // check if in, otherwise return nullptr
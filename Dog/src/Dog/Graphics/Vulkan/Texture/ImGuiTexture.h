@@ -17,6 +17,11 @@ namespace Dog {
 
 		void AddTexture(const std::string& texturePath, const VkImageView& imageView, const VkSampler& sampler);
 
+		// Forgets the texture and returns its descriptor set, VK_NULL_HANDLE if it had none.
+		// Frames in flight may still use it, free it with FreeDescriptorSet once they're done
+		VkDescriptorSet RemoveTexture(const std::string& texturePath);
+		void FreeDescriptorSet(VkDescriptorSet descriptorSet);
+
 		// get descriptor set
 		VkDescriptorSet GetDescriptorSet(const std::string& texturePath);
 
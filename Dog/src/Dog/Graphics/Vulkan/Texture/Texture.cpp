@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.h>
 #include "Texture.h"
 #include "../Core/Device.h"
+#include "../Core/UploadManager.h"
 
 namespace Dog {
 
@@ -29,6 +30,21 @@ namespace Dog {
         createTextureSampler();
     }
 
+    Texture::Texture(Device& device, const std::string& filepath, uint32_t width, uint32_t height)
+        : device{ device }
+        , width{ width }
+        , height{ height }
+    {
+        path = filepath;
+
+        mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+        createImage(width, height, mipLevels, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+        createTextureImageView();
+        createTextureSampler();
+    }
+
     // Destructor
     Texture::~Texture() {
         vkDestroySampler(device, textureSampler, nullptr);
@@ -57,45 +73,21 @@ namespace Dog {
             throw std::runtime_error("Failed to load texture image!");
         }
 
-        // width * height * 4 (rgba)
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
+        width = static_cast<uint32_t>(texWidth);
+        height = static_cast<uint32_t>(texHeight);
 
         // Mip levels is the number of times the image can be halved in size
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-        // Create a staging buffer to load texture data
-        VkBuffer stagingBuffer;
-        VmaAllocation stagingBufferAllocation;  // VMA allocation replaces VkDeviceMemory
-        device.createBuffer(
-            imageSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY,  // Use CPU_ONLY for host-visible memory
-            stagingBuffer,
-            stagingBufferAllocation
-        );
-
-        // Copy pixel data to staging buffer
-        void* data;
-        vmaMapMemory(device.allocator, stagingBufferAllocation, &data);  // VMA maps memory for you
-        memcpy(data, pixels, static_cast<size_t>(imageSize));  // Copy pixel data into mapped memory
-        vmaUnmapMemory(device.allocator, stagingBufferAllocation);  // Unmap the memory after copy
-
-        // Free the pixel data
-        stbi_image_free(pixels);
-
         // Create the Vulkan image
         createImage(texWidth, texHeight, mipLevels, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VMA_MEMORY_USAGE_GPU_ONLY);
 
-        // Transition the image layout and copy from staging buffer
-        transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-        copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-
-        // Clean up the staging buffer
-        vmaDestroyBuffer(device.allocator, stagingBuffer, stagingBufferAllocation);
+        upload(pixels);
 
-        GenerateMipmaps(texWidth, texHeight);
+        // Free the pixel data
+        stbi_image_free(pixels);
     }
 
     // Load the texture image from file using stb_image
@@ -105,36 +97,16 @@ namespace Dog {
         stbi_set_flip_vertically_on_load(true);
 
         int texWidth, texHeight, texChannels;
-        //stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
         stbi_uc* pixels = stbi_load_from_memory(textureData, textureSize, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
 
         if (!pixels) {
             throw std::runtime_error("Failed to load texture image!");
         }
 
+        width = static_cast<uint32_t>(texWidth);
+        height = static_cast<uint32_t>(texHeight);
         mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-        // Create a staging buffer to load texture data
-        VkBuffer stagingBuffer;
-        VmaAllocation stagingBufferAllocation;  // VMA allocation replaces VkDeviceMemory
-        device.createBuffer(
-            imageSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_CPU_ONLY,  // Use CPU_ONLY for host-visible memory
-            stagingBuffer,
-            stagingBufferAllocation
-        );
-
-        // Copy pixel data to staging buffer
-        void* data;
-        vmaMapMemory(device.allocator, stagingBufferAllocation, &data);  // VMA maps memory for you
-        memcpy(data, pixels, static_cast<size_t>(imageSize));  // Copy pixel data into mapped memory
-        vmaUnmapMemory(device.allocator, stagingBufferAllocation);  // Unmap the memory after copy
-
-        // Free the pixel data
-        stbi_image_free(pixels);
-
         // Create the Vulkan image
         createImage(texWidth,
             texHeight,
@@ -144,15 +116,10 @@ namespace Dog {
             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VMA_MEMORY_USAGE_GPU_ONLY);
 
-        // Transition the image layout and copy from staging buffer
-        transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-        copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-
-        // Clean up the staging buffer
-        vmaDestroyBuffer(device.allocator, stagingBuffer, stagingBufferAllocation);
+        upload(pixels);
 
-        // Generate mipmaps for the texture
-        GenerateMipmaps(texWidth, texHeight);
+        // Free the pixel data
+        stbi_image_free(pixels);
     }
 
     // Create an image view for the texture
@@ -185,7 +152,56 @@ namespace Dog {
         }
     }
 
-    void Texture::GenerateMipmaps(int32_t texWidth, int32_t texHeight)
+    void Texture::upload(const void* pixels)
+    {
+        UploadManager& uploads = device.getUploadManager();
+
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+        StagingAllocation staging = uploads.stage(imageSize);
+        memcpy(staging.data, pixels, static_cast<size_t>(imageSize));
+
+        // Copy into mip 0 on the upload queue, which may be transfer only
+        VkCommandBuffer transferCommands = uploads.getTransferCommandBuffer();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = textureImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(transferCommands,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = staging.offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { width, height, 1 };
+
+        vkCmdCopyBufferToImage(transferCommands, staging.buffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // Blits need a graphics queue, they run once the copy has landed
+        recordMipmaps(uploads.getGraphicsCommandBuffer(), static_cast<int32_t>(width), static_cast<int32_t>(height));
+    }
+
+    void Texture::recordMipmaps(VkCommandBuffer commandBuffer, int32_t texWidth, int32_t texHeight)
     {
         // Check if image format supports linear blitting
         VkFormatProperties formatProperties;
@@ -195,8 +211,6 @@ namespace Dog {
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image = textureImage;
@@ -269,8 +283,6 @@ namespace Dog {
             0, nullptr,
             0, nullptr,
             1, &barrier);
-
-        device.endSingleTimeCommands(commandBuffer);
     }
 
     void Texture::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage) {
@@ -291,6 +303,14 @@ namespace Dog {
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;           // Number of samples for multisampling
         imageInfo.flags = 0; // Optional
 
+        // Unless uploads run on their own transfer queue family, then both families share it
+        uint32_t queueFamilies[] = { device.GetGraphicsFamily(), device.GetTransferFamily() };
+        if (device.hasDedicatedTransferQueue()) {
+            imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            imageInfo.queueFamilyIndexCount = 2;
+            imageInfo.pQueueFamilyIndices = queueFamilies;
+        }
+
         // Setup allocation info for VMA
         VmaAllocationCreateInfo allocInfo{};
         allocInfo.usage = memoryUsage;
@@ -321,80 +341,4 @@ namespace Dog {
         return imageView;
     }
 
-    void Texture::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels) {
-
-        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands(); // Helper to start recording commands
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = oldLayout;
-        barrier.newLayout = newLayout;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = mipLevels;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destinationStage;
-
-        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else {
-            throw std::invalid_argument("Unsupported layout transition!");
-        }
-
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            sourceStage, destinationStage,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier
-        );
-
-        device.endSingleTimeCommands(commandBuffer); // Helper to finish recording and submit the commands
-    }
-
-    void Texture::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
-        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = layerCount;
-
-        region.imageOffset = { 0, 0, 0 };
-        region.imageExtent = { width, height, 1 };
-
-        vkCmdCopyBufferToImage(
-            commandBuffer,
-            buffer,
-            image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region);
-        device.endSingleTimeCommands(commandBuffer);
-    }
-
 } // namespace Dog
\ No newline at end of file
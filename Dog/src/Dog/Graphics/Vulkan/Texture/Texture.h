@@ -8,6 +8,9 @@ namespace Dog {
     public:
         Texture(Device& device, const std::string& filepath);
         Texture(Device& device, const std::string& filepath, const unsigned char* textureData, int textureSize);
+
+        // Creates the image, view and sampler without any contents; fill it with upload
+        Texture(Device& device, const std::string& filepath, uint32_t width, uint32_t height);
         ~Texture();
 
         Texture(const Texture&) = delete;
@@ -16,6 +19,10 @@ namespace Dog {
         const VkImageView& getImageView() const { return textureImageView; }
         const VkSampler& getSampler() const { return textureSampler; }
 
+        // Stages width * height RGBA8 pixels and records copying them into mip 0 and generating
+        // the other mips. The texture is ready for the next frame submitted after this
+        void upload(const void* pixels);
+
         std::string path;
 
     private:
@@ -23,14 +30,11 @@ namespace Dog {
         void createTextureImageFromMemory(const unsigned char* textureData, int textureSize);
         void createTextureImageView();
         void createTextureSampler();
-        void GenerateMipmaps(int32_t texWidth, int32_t texHeight);
+        void recordMipmaps(VkCommandBuffer commandBuffer, int32_t texWidth, int32_t texHeight);
 
         void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaMemoryUsage memoryUsage);
 
         VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
-        void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
-        void copyBufferToImage(
-            VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
 
         Device& device;
@@ -40,6 +44,8 @@ namespace Dog {
         VkSampler textureSampler;
 
         uint32_t mipLevels;
+        uint32_t width = 0;
+        uint32_t height = 0;
 
     };
 
@@ -1,61 +1,150 @@
 #include <PCH/pch.h>
 #include "TextureLibrary.h"
+#include "../Core/Device.h"
+#include "../Core/UploadManager.h"
+#include "../Core/SwapChain.h"
+#include "Jobs/JobSystem.h"
+
+#include <stb_image.h>
 
 namespace Dog {
 
-	TextureLibrary::TextureLibrary(Device& device)
+	TextureLibrary::TextureLibrary(Device& device, JobSystem& jobSystem)
 		: device(device)
+		, jobSystem(jobSystem)
 		, imGuiTextureManager(device)
+		, bindlessTable(device, SwapChain::MAX_FRAMES_IN_FLIGHT)
 		, bakedInTextureCount(0)
 	{
 	}
 
 	TextureLibrary::~TextureLibrary()
 	{
+		// Pending uploads still write into the images
+		device.getUploadManager().flush();
 	}
 
 	uint32_t TextureLibrary::AddTexture(const std::string& texturePath) {
-		// check size 
-		if (textures.size() >= MAX_TEXTURE_COUNT) {
+		auto loaded = textureMap.find(texturePath);
+		if (loaded != textureMap.end()) {
+			return loaded->second;
+		}
+
+		return RegisterTexture(std::make_unique<Texture>(device, texturePath));
+	}
+
+	uint32_t TextureLibrary::AddTextureFromMemory(const unsigned char* textureData, int textureSize)
+	{
+		std::string newPath = "BAKED_IN_" + std::to_string(bakedInTextureCount);
+		bakedInTextureCount++;
+
+		return RegisterTexture(std::make_unique<Texture>(device, newPath, textureData, textureSize));
+	}
+
+	std::vector<uint32_t> TextureLibrary::AddTextures(std::span<const std::string> texturePaths)
+	{
+		struct DecodedTexture {
+			size_t request = 0;
+			stbi_uc* pixels = nullptr;
+			int width = 0;
+			int height = 0;
+		};
+
+		std::vector<uint32_t> indices(texturePaths.size(), INVALID_TEXTURE_INDEX);
+		std::vector<DecodedTexture> decoded;
+		std::unordered_map<std::string, size_t> firstRequest;
+
+		for (size_t i = 0; i < texturePaths.size(); ++i) {
+			const std::string& texturePath = texturePaths[i];
+
+			auto loaded = textureMap.find(texturePath);
+			if (loaded != textureMap.end()) {
+				indices[i] = loaded->second;
+			}
+			else if (firstRequest.emplace(texturePath, i).second) {
+				decoded.push_back({ i });
+			}
+		}
+
+		if (decoded.empty()) {
+			return indices;
+		}
+
+		// Checked before decoding, rather than by the table after the work is done
+		if (bindlessTable.getTextureCount() + decoded.size() > bindlessTable.getMaxCapacity()) {
 			throw std::runtime_error("Texture count exceeded maximum");
-			return INVALID_TEXTURE_INDEX;
 		}
 
-		if (textureMap.find(texturePath) == textureMap.end()) 
-		{
-			uint32_t textureIndex = static_cast<uint32_t>(textures.size());
+		// The flip flag is global in stb_image, so set it once before the decode jobs start
+		stbi_set_flip_vertically_on_load(true);
+
+		jobSystem.ParallelFor(static_cast<uint32_t>(decoded.size()), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i) {
+				DecodedTexture& texture = decoded[i];
+				int channels = 0;
+				texture.pixels = stbi_load(texturePaths[texture.request].c_str(), &texture.width, &texture.height, &channels, STBI_rgb_alpha);
+			}
+		});
+
+		for (const DecodedTexture& texture : decoded) {
+			if (!texture.pixels) {
+				for (const DecodedTexture& other : decoded) {
+					stbi_image_free(other.pixels);
+				}
+				throw std::runtime_error("Failed to load texture image file at file path: " + texturePaths[texture.request]);
+			}
+		}
 
-			textureMap[texturePath] = textureIndex;
-			textures.push_back(std::make_unique<Texture>(device, texturePath));
+		// Every texture is staged into the same upload batch, submitted with the next frame
+		for (DecodedTexture& decodedTexture : decoded) {
+			const std::string& texturePath = texturePaths[decodedTexture.request];
 
-			imGuiTextureManager.AddTexture(texturePath, textures.back()->getImageView(), textures.back()->getSampler());
+			auto texture = std::make_unique<Texture>(device, texturePath,
+				static_cast<uint32_t>(decodedTexture.width), static_cast<uint32_t>(decodedTexture.height));
+			texture->upload(decodedTexture.pixels);
+			stbi_image_free(decodedTexture.pixels);
+			decodedTexture.pixels = nullptr;
 
-			return textureIndex;
+			indices[decodedTexture.request] = RegisterTexture(std::move(texture));
 		}
-		else {
-			return INVALID_TEXTURE_INDEX;
+
+		// Repeated paths in the same batch share the texture of their first occurrence
+		for (size_t i = 0; i < texturePaths.size(); ++i) {
+			if (indices[i] == INVALID_TEXTURE_INDEX) {
+				indices[i] = indices[firstRequest[texturePaths[i]]];
+			}
 		}
+
+		return indices;
 	}
 
-	uint32_t TextureLibrary::AddTextureFromMemory(const unsigned char* textureData, int textureSize)
+	void TextureLibrary::RemoveTexture(const std::string& texturePath)
 	{
-		// check size 
-		if (textures.size() >= MAX_TEXTURE_COUNT) {
-			throw std::runtime_error("Texture count exceeded maximum");
-			return INVALID_TEXTURE_INDEX;
+		auto loaded = textureMap.find(texturePath);
+		if (loaded == textureMap.end()) {
+			return;
 		}
 
-		std::string newPath = "BAKED_IN_" + std::to_string(bakedInTextureCount);
-		bakedInTextureCount++;
+		removedTextures.push_back({ loaded->second, imGuiTextureManager.RemoveTexture(texturePath), frame });
+		textureMap.erase(loaded);
+	}
 
-		uint32_t textureIndex = static_cast<uint32_t>(textures.size());
+	void TextureLibrary::Update()
+	{
+		++frame;
 
-		textureMap[newPath] = textureIndex;
-		textures.push_back(std::make_unique<Texture>(device, newPath, textureData, textureSize));
+		// A texture removed at frame N was last drawn in frame N - 1 at the latest, whose fence has been
+		// waited on by the time frame N + MAX_FRAMES_IN_FLIGHT begins
+		std::erase_if(removedTextures, [this](const RemovedTexture& removed) {
+			if (frame < removed.frame + SwapChain::MAX_FRAMES_IN_FLIGHT) return false;
 
-		imGuiTextureManager.AddTexture(newPath, textures.back()->getImageView(), textures.back()->getSampler());
+			imGuiTextureManager.FreeDescriptorSet(removed.imGuiDescriptorSet);
+			bindlessTable.remove(removed.index);
+			textures[removed.index].reset();
+			return true;
+		});
 
-		return textureIndex;
+		bindlessTable.update();
 	}
 
 	uint32_t TextureLibrary::GetTexture(const std::string& texturePath) {
@@ -79,4 +168,18 @@ namespace Dog {
 		);
 	}
 
+	uint32_t TextureLibrary::RegisterTexture(std::unique_ptr<Texture> texture)
+	{
+		uint32_t textureIndex = bindlessTable.add(texture->getImageView(), texture->getSampler());
+		if (textureIndex >= textures.size()) {
+			textures.resize(textureIndex + 1);
+		}
+
+		textureMap[texture->path] = textureIndex;
+		imGuiTextureManager.AddTexture(texture->path, texture->getImageView(), texture->getSampler());
+		textures[textureIndex] = std::move(texture);
+
+		return textureIndex;
+	}
+
 } // namespace Dog
\ No newline at end of file
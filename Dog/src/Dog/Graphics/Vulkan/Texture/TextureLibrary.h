@@ -2,22 +2,52 @@
 
 #include "Texture.h"
 #include "ImGuiTexture.h"
+#include "../Descriptors/BindlessTextureTable.h"
 
 namespace Dog {
 
 	class Renderer;
+	class JobSystem;
 
 	class TextureLibrary {
 	public:
-		TextureLibrary(Device& device);
+		TextureLibrary(Device& device, JobSystem& jobSystem);
 		~TextureLibrary();
 
 		TextureLibrary(const TextureLibrary&) = delete;
 		TextureLibrary& operator=(const TextureLibrary&) = delete;
 
+		// Returns the texture's bindless index, its slot in the shaders' texture array.
+		// It stays the same until the texture is removed, a path already loaded returns its index
 		uint32_t AddTexture(const std::string& texturePath);
 		uint32_t AddTextureFromMemory(const unsigned char* textureData, int textureSize);
 
+		/*********************************************************************
+		 * param:  texturePaths: Image files to load.
+		 * return: The texture index of every path, in the same order.
+		 *
+		 * brief:  Loads a set of textures at once. Files are decoded in
+		 *         parallel on the job system and every copy and mip chain
+		 *         goes into the device's current upload batch, so the whole
+		 *         set reaches the GPU in one submission with the next frame.
+		 *         Paths that are already loaded return their existing index.
+		 *********************************************************************/
+		std::vector<uint32_t> AddTextures(std::span<const std::string> texturePaths);
+
+		/*********************************************************************
+		 * param:  texturePath: A texture added earlier.
+		 *
+		 * brief:  Unloads a texture. Its index is invalid from now on, so
+		 *         nothing may draw with it anymore. Frames in flight still
+		 *         can, so the texture is destroyed and its slot reused once
+		 *         Update has run for every frame in flight.
+		 *********************************************************************/
+		void RemoveTexture(const std::string& texturePath);
+
+		// Called at the start of each frame, once its fence has been waited on. Writes the descriptors
+		// of new textures and destroys removed ones no frame uses anymore
+		void Update();
+
 		uint32_t GetTexture(const std::string& texturePath);
 
 		VkDescriptorSet GetDescriptorSet(const std::string& texturePath);
@@ -25,16 +55,31 @@ namespace Dog {
 		Texture& getTextureByIndex(const size_t& index) { return *textures[index]; }
 		VkDescriptorSet GetDescriptorSetByIndex(const size_t& index);
 
-		const size_t getTextureCount() const { return textures.size(); }
+		// Loaded textures. Removed ones leave gaps, so this isn't a bound on the indices
+		const size_t getTextureCount() const { return textureMap.size(); }
+
+		BindlessTextureTable& getBindlessTable() { return bindlessTable; }
 
 	private:
-		std::vector<std::unique_ptr<Texture>> textures;
+		uint32_t RegisterTexture(std::unique_ptr<Texture> texture);
+
+		struct RemovedTexture {
+			uint32_t index;
+			VkDescriptorSet imGuiDescriptorSet; // A path loaded again gets a new one meanwhile
+			uint64_t frame; // When it was removed
+		};
+
+		std::vector<std::unique_ptr<Texture>> textures; // By bindless index
 		std::unordered_map<std::string, uint32_t> textureMap;
 		Device& device;
+		JobSystem& jobSystem;
 
 		ImGuiTextureManager imGuiTextureManager;
+		BindlessTextureTable bindlessTable;
+		std::vector<RemovedTexture> removedTextures;
+		uint64_t frame = 0;
 
 		uint32_t bakedInTextureCount = 0;
 	};
 
-} // namespace Dog
\ No newline at end of file
+} // namespace Dog
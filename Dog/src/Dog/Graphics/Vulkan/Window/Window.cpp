@@ -3,11 +3,16 @@
 
 namespace Dog {
 
-    Window::Window(int w, int h, std::string name) : width{ w }, height{ h }, windowName{ name } {
-        initWindow();
+    Window::Window(int w, int h, std::string name, bool headless)
+        : width{ w }, height{ h }, headless{ headless }, windowName{ name } {
+        if (!headless) {
+            initWindow();
+        }
     }
 
     Window::~Window() {
+        if (headless) return;
+
         glfwDestroyWindow(window);
         glfwTerminate();
     }
@@ -23,6 +28,7 @@ namespace Dog {
     }
 
     void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface) {
+        assert(!headless && "Headless windows have no surface");
         if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS) {
             throw std::runtime_error("failed to craete window surface");
         }
@@ -4,18 +4,21 @@ namespace Dog {
 
 	class Window {
 	public:
-		Window(int w, int h, std::string name);
+		Window(int w, int h, std::string name, bool headless = false);
 		~Window();
 
 		Window(const Window&) = delete;
 		Window& operator=(const Window&) = delete;
 
-		bool shouldClose() { return glfwWindowShouldClose(window); }
+		bool shouldClose() { return !headless && glfwWindowShouldClose(window); }
 		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 		bool wasWindowResized() { return framebufferResized; }
 		void resetWindowResizedFlag() { framebufferResized = false; }
 		GLFWwindow* getGLFWwindow() const { return window; }
-		void setWindowTitle(const char* title) { glfwSetWindowTitle(window, title); }
+		void setWindowTitle(const char* title) { if (!headless) glfwSetWindowTitle(window, title); }
+
+		// Headless windows have no GLFW window or surface, the renderer draws into offscreen images instead.
+		bool isHeadless() const { return headless; }
 
 		void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
 
@@ -29,9 +32,10 @@ namespace Dog {
 		int width;
 		int height;
 		bool framebufferResized = false;
+		bool headless = false;
 
 		std::string windowName;
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 	};
 
 } // namespace Dog
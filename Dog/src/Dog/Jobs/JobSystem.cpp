@@ -0,0 +1,198 @@
+#include <PCH/pch.h>
+#include "JobSystem.h"
+
+namespace Dog {
+
+	namespace {
+		thread_local uint32_t t_ThreadIndex = 0;
+	}
+
+	JobSystem::JobSystem(int workerCount)
+	{
+		if (workerCount < 0) {
+			int cores = static_cast<int>(std::thread::hardware_concurrency());
+			workerCount = std::max(cores - 1, 0);
+		}
+
+		m_Queues.resize(static_cast<size_t>(workerCount) + 1);
+		for (auto& queue : m_Queues) {
+			queue = std::make_unique<WorkQueue>();
+		}
+
+		for (uint32_t i = 1; i <= static_cast<uint32_t>(workerCount); ++i) {
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Stopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& worker : m_Workers) {
+			worker.join();
+		}
+	}
+
+	uint32_t JobSystem::GetThreadIndex()
+	{
+		return t_ThreadIndex;
+	}
+
+	void JobSystem::Run(std::function<void()> job, JobCounter* counter, JobCounter* dependency)
+	{
+		if (counter) {
+			counter->m_Count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (dependency && !dependency->IsDone()) {
+			std::lock_guard<std::mutex> lock(dependency->m_Mutex);
+
+			// Re-checked under the lock, Finish takes it before releasing continuations.
+			// Only the count matters here, once it's zero the continuations are being released.
+			if (dependency->m_Count.load() != 0) {
+				dependency->m_Continuations.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+
+		Push({ std::move(job), counter });
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		uint32_t threadIndex = GetThreadIndex();
+
+		while (!counter.IsDone()) {
+			if (!TryRunJob(threadIndex)) {
+				std::this_thread::yield();
+			}
+		}
+
+		// Every job has finished, so nothing else touches the exception now
+		if (counter.m_Exception) {
+			std::rethrow_exception(std::exchange(counter.m_Exception, nullptr));
+		}
+	}
+
+	void JobSystem::Push(Job job)
+	{
+		WorkQueue& queue = *m_Queues[GetThreadIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+
+		m_QueuedJobs.fetch_add(1, std::memory_order_release);
+
+		// Taking the lock orders this with a worker that is about to sleep, so the wake can't be missed
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	bool JobSystem::TryPop(uint32_t threadIndex, Job& job)
+	{
+		// Newest job from our own queue first, it's the most likely to be in cache
+		{
+			WorkQueue& own = *m_Queues[threadIndex];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.jobs.empty()) {
+				job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+				return true;
+			}
+		}
+
+		// Then steal the oldest job from someone else
+		uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+		for (uint32_t offset = 1; offset < queueCount; ++offset) {
+			WorkQueue& victim = *m_Queues[(threadIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::TryRunJob(uint32_t threadIndex)
+	{
+		Job job;
+		if (!TryPop(threadIndex, job)) {
+			return false;
+		}
+		m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+		// A throwing job must still finish, or whoever waits on its counter never returns
+		try {
+			job.function();
+		}
+		catch (...) {
+			if (job.counter) {
+				std::lock_guard<std::mutex> lock(job.counter->m_Mutex);
+				if (!job.counter->m_Exception) {
+					job.counter->m_Exception = std::current_exception();
+				}
+			}
+			else {
+				std::cerr << "A job without a counter threw, the exception is dropped" << std::endl;
+			}
+		}
+
+		Finish(job.counter);
+		return true;
+	}
+
+	void JobSystem::Finish(JobCounter* counter)
+	{
+		if (!counter) return;
+
+		// Holds off IsDone until we're done with the counter, a waiter may destroy it as soon as it returns
+		counter->m_Finishing.fetch_add(1);
+		if (counter->m_Count.fetch_sub(1) != 1) {
+			counter->m_Finishing.fetch_sub(1);
+			return;
+		}
+
+		// Last job of the counter, release anything that was waiting on it
+		std::vector<std::pair<std::function<void()>, JobCounter*>> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_Mutex);
+			continuations.swap(counter->m_Continuations);
+		}
+
+		// The last access to the counter
+		counter->m_Finishing.fetch_sub(1);
+
+		for (auto& [function, continuationCounter] : continuations) {
+			Push({ std::move(function), continuationCounter });
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t threadIndex)
+	{
+		t_ThreadIndex = threadIndex;
+
+		while (true) {
+			if (TryRunJob(threadIndex)) {
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_WakeCondition.wait(lock, [this] {
+				return m_Stopping || m_QueuedJobs.load(std::memory_order_acquire) > 0;
+			});
+
+			if (m_Stopping) return;
+		}
+	}
+
+} // namespace Dog
@@ -0,0 +1,153 @@
+#pragma once
+
+namespace Dog {
+
+	/*********************************************************************
+	 * brief:  Counts outstanding jobs. Every job scheduled with a counter
+	 *         increments it and decrements it when it finishes, so a
+	 *         counter reaching zero means all of its jobs are done. Jobs
+	 *         can also be held back until a counter reaches zero.
+	 *********************************************************************/
+	class JobCounter {
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		// Only true once the last job has also stopped touching the counter, so it can be destroyed right after
+		bool IsDone() const { return m_Count.load() == 0 && m_Finishing.load() == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_Count{ 0 };
+
+		// Jobs between decrementing m_Count and releasing the continuations
+		std::atomic<uint32_t> m_Finishing{ 0 };
+
+		// The first exception thrown by one of the jobs, rethrown by Wait
+		std::exception_ptr m_Exception;
+
+		// Jobs waiting on this counter, scheduled once it reaches zero
+		std::mutex m_Mutex;
+		std::vector<std::pair<std::function<void()>, JobCounter*>> m_Continuations;
+	};
+
+	/*********************************************************************
+	 * brief:  Work stealing job scheduler. Each thread owns a deque; it
+	 *         pushes and pops its own jobs at the back and steals from
+	 *         the front of the others' when it runs dry. The main thread
+	 *         is thread 0 and only runs jobs while it waits on a counter.
+	 *********************************************************************/
+	class JobSystem {
+	public:
+		/*********************************************************************
+		 * param:  workerCount: Threads to spawn besides the calling thread,
+		 *         which becomes thread 0. -1 spawns one per remaining core,
+		 *         0 runs every job on the calling thread while it waits.
+		 *********************************************************************/
+		JobSystem(int workerCount = -1);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		/*********************************************************************
+		 * param:  job: The work to run, on any thread.
+		 * param:  counter: Incremented now and decremented when the job is
+		 *         done. Optional.
+		 * param:  dependency: The job isn't started until this counter
+		 *         reaches zero. Optional.
+		 *********************************************************************/
+		void Run(std::function<void()> job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+		/*********************************************************************
+		 * param:  counter: The counter to wait on.
+		 *
+		 * brief:  Runs other jobs on this thread until the counter reaches
+		 *         zero, so waiting never leaves a core idle. If one of the
+		 *         counter's jobs threw, the exception is rethrown here.
+		 *********************************************************************/
+		void Wait(JobCounter& counter);
+
+		/*********************************************************************
+		 * param:  count: The number of items.
+		 * param:  grainSize: Items per job, at least 1.
+		 * param:  function: Called as function(begin, end) for each range.
+		 *
+		 * brief:  Splits [0, count) into jobs and waits for all of them.
+		 *********************************************************************/
+		template <typename Function>
+		void ParallelFor(uint32_t count, uint32_t grainSize, Function&& function)
+		{
+			if (count == 0) return;
+			grainSize = std::max(grainSize, 1u);
+
+			// A single range isn't worth the scheduling overhead
+			if (count <= grainSize || m_Queues.size() == 1) {
+				function(0u, count);
+				return;
+			}
+
+			JobCounter counter;
+			for (uint32_t begin = 0; begin < count; begin += grainSize) {
+				uint32_t end = std::min(begin + grainSize, count);
+				Run([&function, begin, end]() { function(begin, end); }, &counter);
+			}
+			Wait(counter);
+		}
+
+		/*********************************************************************
+		 * param:  view: An entt view, only read while the jobs run.
+		 * param:  grainSize: Entities per job.
+		 * param:  function: Called as function(entity) for every entity.
+		 *
+		 * brief:  ParallelFor over an entt view. Components may be read and
+		 *         written by the function, but the registry must not be
+		 *         structurally changed until it returns.
+		 *********************************************************************/
+		template <typename View, typename Function>
+		void ParallelForEach(const View& view, uint32_t grainSize, Function&& function)
+		{
+			std::vector<entt::entity> entities(view.begin(), view.end());
+			ParallelFor(static_cast<uint32_t>(entities.size()), grainSize, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; ++i) {
+					function(entities[i]);
+				}
+			});
+		}
+
+		// Workers plus the main thread
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Queues.size()); }
+
+		// The calling thread's index, 0 for the main thread and for threads the job system doesn't own
+		static uint32_t GetThreadIndex();
+
+	private:
+		struct Job {
+			std::function<void()> function;
+			JobCounter* counter = nullptr;
+		};
+
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		void Push(Job job);
+		bool TryRunJob(uint32_t threadIndex);
+		bool TryPop(uint32_t threadIndex, Job& job);
+		void Finish(JobCounter* counter);
+		void WorkerLoop(uint32_t threadIndex);
+
+		std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+		std::vector<std::thread> m_Workers;
+
+		// Jobs pushed but not yet popped, sleeping workers wake when this is non zero
+		std::atomic<int32_t> m_QueuedJobs{ 0 };
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+		std::atomic<bool> m_Stopping{ false };
+	};
+
+} // namespace Dog
@@ -0,0 +1,271 @@
+#include <PCH/pch.h>
+#include "AnimationBenchmark.h"
+
+#include "Graphics/Vulkan/Core/Device.h"
+#include "Graphics/Vulkan/Models/Model.h"
+#include "Graphics/Vulkan/Animation/Animation.h"
+
+namespace Dog {
+
+	namespace {
+		using Clock = std::chrono::high_resolution_clock;
+
+		double ToUs(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::micro>(duration).count();
+		}
+
+		// The Animator before the flattened skeleton, kept as the baseline
+		class LegacyEvaluator
+		{
+		public:
+			LegacyEvaluator(Animation& animation, uint32_t boneCount)
+				: m_Animation(animation)
+				, m_FinalBoneMatrices(std::max(boneCount, uint32_t(MAX_BONES)), glm::mat4(1.0f))
+			{
+			}
+
+			void Evaluate(float time)
+			{
+				m_Time = time;
+				CalculateBoneTransform(&m_Animation.GetRootNode(), glm::mat4(1.0f));
+			}
+
+			const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+
+		private:
+			void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+			{
+				std::string nodeName = node->name;
+				glm::mat4 nodeTransform = node->transformation;
+
+				Bone* bone = m_Animation.FindBone(nodeName);
+				if (bone)
+				{
+					bone->Update(m_Time);
+					nodeTransform = bone->GetLocalTransform();
+				}
+
+				glm::mat4 globalTransformation = parentTransform * nodeTransform;
+
+				auto boneInfoMap = m_Animation.GetBoneIDMap();
+				if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+				{
+					int index = boneInfoMap[nodeName].id;
+					glm::mat4 offset = boneInfoMap[nodeName].offset;
+					m_FinalBoneMatrices[index] = globalTransformation * offset;
+				}
+
+				for (int i = 0; i < node->childrenCount; i++)
+					CalculateBoneTransform(&node->children[i], globalTransformation);
+			}
+
+			Animation& m_Animation;
+			std::vector<glm::mat4> m_FinalBoneMatrices;
+			float m_Time = 0.f;
+		};
+
+		struct ClipResult {
+			std::string path;
+			uint32_t nodes = 0;
+			uint32_t bones = 0;  // Palette entries written per pose
+			uint32_t tracks = 0;
+			uint32_t sourceKeys = 0;
+			uint32_t compressedKeys = 0;
+			size_t boneBytes = 0; // Keys as the Bone class holds them
+			size_t flatBytes = 0;
+			size_t compressedBytes = 0;
+			uint64_t cookedFileBytes = 0;
+			double assimpLoadMs = 0.0;
+			double cookedLoadMs = 0.0;
+			double legacyUs = 0.0; // Per run
+			double flatUs = 0.0;
+			double compressedUs = 0.0;
+			float flatMaxError = 0.f; // Against the legacy matrices
+			float compressedMaxError = 0.f;
+		};
+
+		// Clip time in ticks of every benchmarked frame, looping like the Animator
+		std::vector<float> FrameTimes(const CompressedClip& clip, const AnimationBenchmarkSpec& spec)
+		{
+			std::vector<float> times(spec.frames);
+			for (uint32_t frame = 0; frame < spec.frames; ++frame) {
+				times[frame] = fmod(float(frame) / spec.frameRate * clip.GetTicksPerSecond(), clip.GetDuration());
+			}
+			return times;
+		}
+
+		double BonesPerUs(const ClipResult& result, double us, const AnimationBenchmarkSpec& spec)
+		{
+			return us > 0.0 ? double(result.bones) * spec.frames / us : 0.0;
+		}
+
+		size_t BoneBytes(const std::vector<Bone>& bones)
+		{
+			size_t bytes = 0;
+			for (const Bone& bone : bones) {
+				bytes += sizeof(Bone) +
+					bone.GetPositionKeys().size() * sizeof(KeyPosition) +
+					bone.GetRotationKeys().size() * sizeof(KeyRotation) +
+					bone.GetScaleKeys().size() * sizeof(KeyScale);
+			}
+			return bytes;
+		}
+
+		float MaxError(const std::vector<glm::mat4>& expected, const std::vector<glm::mat4>& palette, uint32_t boneCount)
+		{
+			float maxError = 0.f;
+			for (uint32_t bone = 0; bone < boneCount; ++bone) {
+				for (int column = 0; column < 4; ++column) {
+					glm::vec4 difference = glm::abs(expected[bone][column] - palette[bone][column]);
+					maxError = std::max({ maxError, difference.x, difference.y, difference.z, difference.w });
+				}
+			}
+			return maxError;
+		}
+
+		double ToMs(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		}
+	}
+
+	bool RunAnimationBenchmark(Device& device, const std::string& outputPath, const AnimationBenchmarkSpec& spec)
+	{
+		std::vector<ClipResult> results;
+		uint32_t repetitions = std::max(1u, spec.repetitions);
+
+		for (const std::string& path : spec.models) {
+			ClipResult result;
+			result.path = path;
+
+			// The animation reads the assbin cache the model's Assimp import writes. Cooking writes the
+			// same file the engine would, so it's then read back from where the engine reads it
+			std::unique_ptr<Model> model;
+			std::unique_ptr<Animation> animation;
+			std::unique_ptr<Animation> cooked;
+			try {
+				model = std::make_unique<Model>(device, path, ModelSource::Assimp);
+
+				Clock::time_point start = Clock::now();
+				animation = std::make_unique<Animation>(path, model.get(), ModelSource::Assimp);
+				result.assimpLoadMs = ToMs(Clock::now() - start);
+
+				std::string cookedPath = Animation::GetCookedPath(path);
+				if (!animation->Cook(cookedPath)) {
+					throw std::runtime_error("Failed to cook " + cookedPath);
+				}
+				std::error_code error;
+				result.cookedFileBytes = std::filesystem::file_size(cookedPath, error);
+
+				start = Clock::now();
+				cooked = std::make_unique<Animation>(path, model.get(), ModelSource::Cooked);
+				result.cookedLoadMs = ToMs(Clock::now() - start);
+			}
+			catch (const std::exception& e) {
+				DOG_ERROR("Skipping {0}: {1}", path, e.what());
+				continue;
+			}
+
+			const Skeleton& skeleton = animation->GetSkeleton();
+			const CompressedClip& compressed = animation->GetClip();
+			AnimationClip flat(animation->GetBones(), skeleton, compressed.GetDuration(), compressed.GetTicksPerSecond());
+			result.nodes = skeleton.GetNodeCount();
+			result.bones = skeleton.GetSkinnedNodeCount();
+			result.tracks = flat.GetTrackCount();
+			result.sourceKeys = flat.GetKeyCount();
+			result.compressedKeys = compressed.GetKeyCount();
+			result.boneBytes = BoneBytes(animation->GetBones());
+			result.flatBytes = flat.GetMemorySize();
+			result.compressedBytes = compressed.GetMemorySize();
+
+			std::vector<float> times = FrameTimes(compressed, spec);
+			LegacyEvaluator legacy(*animation, skeleton.GetBoneCount());
+			AnimationPose flatPose;
+			AnimationPose compressedPose;
+			flat.InitPose(skeleton, flatPose);
+			compressed.InitPose(skeleton, compressedPose);
+
+			// Untimed pass that warms every path and checks how far the others are from the legacy one
+			for (float time : times) {
+				legacy.Evaluate(time);
+				flat.Sample(skeleton, time, flatPose);
+				compressed.Sample(skeleton, time, compressedPose);
+
+				result.flatMaxError = std::max(result.flatMaxError, MaxError(legacy.GetFinalBoneMatrices(), flatPose.palette, skeleton.GetBoneCount()));
+				result.compressedMaxError = std::max(result.compressedMaxError, MaxError(legacy.GetFinalBoneMatrices(), compressedPose.palette, skeleton.GetBoneCount()));
+			}
+
+			// Alternate the paths so none benefits from running last
+			for (uint32_t run = 0; run < repetitions; ++run) {
+				Clock::time_point start = Clock::now();
+				for (float time : times) {
+					legacy.Evaluate(time);
+				}
+				result.legacyUs += ToUs(Clock::now() - start);
+
+				start = Clock::now();
+				for (float time : times) {
+					flat.Sample(skeleton, time, flatPose);
+				}
+				result.flatUs += ToUs(Clock::now() - start);
+
+				start = Clock::now();
+				for (float time : times) {
+					compressed.Sample(skeleton, time, compressedPose);
+				}
+				result.compressedUs += ToUs(Clock::now() - start);
+			}
+
+			result.legacyUs /= repetitions;
+			result.flatUs /= repetitions;
+			result.compressedUs /= repetitions;
+			results.push_back(result);
+		}
+
+		std::ofstream out(outputPath);
+		if (!out.is_open()) {
+			DOG_ERROR("Failed to open benchmark output {0}", outputPath);
+			return false;
+		}
+
+		out << "{\n";
+		out << "  \"frames\": " << spec.frames << ",\n";
+		out << "  \"repetitions\": " << repetitions << ",\n";
+		out << "  \"clips\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const ClipResult& result = results[i];
+			double legacyRate = BonesPerUs(result, result.legacyUs, spec);
+			double flatRate = BonesPerUs(result, result.flatUs, spec);
+			double compressedRate = BonesPerUs(result, result.compressedUs, spec);
+			out << "    { \"path\": \"" << result.path << "\""
+				<< ", \"nodes\": " << result.nodes
+				<< ", \"bones\": " << result.bones
+				<< ", \"tracks\": " << result.tracks
+				<< ", \"sourceKeys\": " << result.sourceKeys
+				<< ", \"compressedKeys\": " << result.compressedKeys
+				<< ", \"boneBytes\": " << result.boneBytes
+				<< ", \"flatBytes\": " << result.flatBytes
+				<< ", \"compressedBytes\": " << result.compressedBytes
+				<< ", \"cookedFileBytes\": " << result.cookedFileBytes
+				<< ", \"assimpLoadMs\": " << result.assimpLoadMs
+				<< ", \"cookedLoadMs\": " << result.cookedLoadMs
+				<< ", \"legacyUs\": " << result.legacyUs
+				<< ", \"flatUs\": " << result.flatUs
+				<< ", \"compressedUs\": " << result.compressedUs
+				<< ", \"legacyBonesPerUs\": " << legacyRate
+				<< ", \"flatBonesPerUs\": " << flatRate
+				<< ", \"compressedBonesPerUs\": " << compressedRate
+				<< ", \"speedup\": " << (legacyRate > 0.0 ? flatRate / legacyRate : 0.0)
+				<< ", \"compressedSpeedup\": " << (legacyRate > 0.0 ? compressedRate / legacyRate : 0.0)
+				<< ", \"flatMaxError\": " << result.flatMaxError
+				<< ", \"compressedMaxError\": " << result.compressedMaxError
+				<< " }" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+
+		return true;
+	}
+
+} // namespace Dog
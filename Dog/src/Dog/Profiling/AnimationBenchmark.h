@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Dog {
+
+	class Device;
+
+	struct AnimationBenchmarkSpec {
+		std::vector<std::string> models = {
+			"assets/models/Mon_BlackDragon31_Skeleton.FBX",
+			"assets/models/charles.fbx",
+		};
+		uint32_t frames = 1000;     // Poses evaluated per run, stepping through the clip at frameRate.
+		float frameRate = 60.f;
+		uint32_t repetitions = 10;  // Runs averaged for every measurement.
+	};
+
+	/*********************************************************************
+	 * param:  device: Device the models are loaded with.
+	 * param:  outputPath: Where the JSON report is written.
+	 * param:  spec: Models whose first clip is played.
+	 * return: True if the report was written.
+	 *
+	 * brief:  Plays each model's first animation through the recursive
+	 *         node walk the Animator used to do (name lookups and a bone
+	 *         map copy per node, keyframe scans from the first key) and
+	 *         through the flattened Skeleton with the full precision
+	 *         AnimationClip and with the CompressedClip the engine plays.
+	 *         Reports bones evaluated per microsecond for each, how far
+	 *         each is from the old matrices, the memory and keys of each
+	 *         clip, and how long the clip takes to load from the source
+	 *         file and from its cooked file.
+	 *********************************************************************/
+	bool RunAnimationBenchmark(Device& device, const std::string& outputPath, const AnimationBenchmarkSpec& spec = {});
+
+} // namespace Dog
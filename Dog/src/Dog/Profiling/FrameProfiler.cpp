@@ -0,0 +1,264 @@
+#include <PCH/pch.h>
+#include "FrameProfiler.h"
+
+#include "Graphics/Vulkan/Core/Device.h"
+
+namespace Dog {
+
+	namespace {
+		double ToMs(std::chrono::high_resolution_clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		}
+
+		struct TimingSummary {
+			double mean = 0.0, min = 0.0, max = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0;
+			size_t count = 0;
+		};
+
+		TimingSummary Summarize(std::vector<double> values)
+		{
+			TimingSummary summary;
+			if (values.empty()) return summary;
+
+			std::sort(values.begin(), values.end());
+			auto percentile = [&values](double p) {
+				size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+				return values[std::min(index, values.size() - 1)];
+			};
+
+			double total = 0.0;
+			for (double value : values) total += value;
+
+			summary.count = values.size();
+			summary.mean = total / static_cast<double>(values.size());
+			summary.min = values.front();
+			summary.max = values.back();
+			summary.p50 = percentile(0.50);
+			summary.p95 = percentile(0.95);
+			summary.p99 = percentile(0.99);
+			return summary;
+		}
+
+		void WriteSummary(std::ofstream& out, const char* name, const TimingSummary& summary, bool last)
+		{
+			out << "    \"" << name << "\": { "
+				<< "\"count\": " << summary.count
+				<< ", \"mean\": " << summary.mean
+				<< ", \"min\": " << summary.min
+				<< ", \"max\": " << summary.max
+				<< ", \"p50\": " << summary.p50
+				<< ", \"p95\": " << summary.p95
+				<< ", \"p99\": " << summary.p99
+				<< " }" << (last ? "\n" : ",\n");
+		}
+	}
+
+	FrameProfiler::FrameProfiler(Device& device, uint32_t framesInFlight)
+		: m_Device(device)
+		, m_PendingFrames(framesInFlight, -1)
+	{
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.getPhysicalDevice(), &familyCount, families.data());
+
+		// Without valid timestamp bits on the graphics queue only CPU timings are recorded
+		uint32_t validBits = families[device.GetGraphicsFamily()].timestampValidBits;
+		if (validBits == 0) {
+			DOG_WARN("Graphics queue doesn't support timestamps, GPU frame times will be unavailable");
+			return;
+		}
+		m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		m_TimestampPeriodNs = static_cast<double>(device.properties.limits.timestampPeriod);
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = framesInFlight * 2;
+
+		if (vkCreateQueryPool(device, &poolInfo, nullptr, &m_QueryPool) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create timestamp query pool!");
+		}
+	}
+
+	FrameProfiler::~FrameProfiler()
+	{
+		if (m_QueryPool != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(m_Device, m_QueryPool, nullptr);
+		}
+	}
+
+	void FrameProfiler::BeginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		ReadGpuTimings(frameIndex);
+		if (!m_Enabled) return;
+
+		Clock::time_point now = Clock::now();
+
+		FrameTimings timings{};
+		timings.frame = m_Timings.size();
+		timings.cpuFrameMs = m_HasPreviousFrame ? ToMs(now - m_FrameStart) : 0.0;
+		m_Timings.push_back(timings);
+
+		m_FrameStart = now;
+		m_RecordStart = now;
+		m_HasPreviousFrame = true;
+
+		if (m_QueryPool != VK_NULL_HANDLE) {
+			uint32_t firstQuery = static_cast<uint32_t>(frameIndex) * 2;
+			vkCmdResetQueryPool(commandBuffer, m_QueryPool, firstQuery, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, firstQuery);
+		}
+	}
+
+	void FrameProfiler::EndRecording(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		if (!m_Enabled || m_Timings.empty()) return;
+
+		if (m_QueryPool != VK_NULL_HANDLE) {
+			uint32_t firstQuery = static_cast<uint32_t>(frameIndex) * 2;
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, firstQuery + 1);
+			m_PendingFrames[frameIndex] = static_cast<int64_t>(m_Timings.size() - 1);
+		}
+
+		m_Timings.back().cpuRecordMs = ToMs(Clock::now() - m_RecordStart);
+	}
+
+	void FrameProfiler::BeginSubmit()
+	{
+		m_SubmitStart = Clock::now();
+	}
+
+	void FrameProfiler::EndSubmit()
+	{
+		if (!m_Enabled || m_Timings.empty()) return;
+
+		m_Timings.back().submitMs = ToMs(Clock::now() - m_SubmitStart);
+	}
+
+	void FrameProfiler::RecordCounter(const std::string& name, double value)
+	{
+		if (!m_Enabled || m_Timings.empty()) return;
+
+		m_Timings.back().counters.emplace_back(name, value);
+	}
+
+	void FrameProfiler::Resolve()
+	{
+		for (size_t i = 0; i < m_PendingFrames.size(); ++i) {
+			ReadGpuTimings(static_cast<int>(i));
+		}
+	}
+
+	void FrameProfiler::Reset()
+	{
+		m_Timings.clear();
+		std::fill(m_PendingFrames.begin(), m_PendingFrames.end(), -1);
+		m_HasPreviousFrame = false;
+	}
+
+	void FrameProfiler::ReadGpuTimings(int frameIndex)
+	{
+		int64_t pending = m_PendingFrames[frameIndex];
+		if (pending < 0 || m_QueryPool == VK_NULL_HANDLE) return;
+
+		m_PendingFrames[frameIndex] = -1;
+
+		uint64_t timestamps[2] = {};
+		VkResult result = vkGetQueryPoolResults(
+			m_Device,
+			m_QueryPool,
+			static_cast<uint32_t>(frameIndex) * 2,
+			2,
+			sizeof(timestamps),
+			timestamps,
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+		if (result != VK_SUCCESS || static_cast<size_t>(pending) >= m_Timings.size()) return;
+
+		// Bits above the valid ones are undefined, and the counter wraps at the valid width
+		uint64_t start = timestamps[0] & m_TimestampMask;
+		uint64_t end = timestamps[1] & m_TimestampMask;
+		double ticks = static_cast<double>((end - start) & m_TimestampMask);
+		m_Timings[pending].gpuMs = ticks * m_TimestampPeriodNs / 1000000.0;
+	}
+
+	bool FrameProfiler::WriteJson(const std::string& path, const std::string& sceneName, VkExtent2D extent) const
+	{
+		std::ofstream out(path);
+		if (!out.is_open()) {
+			DOG_ERROR("Failed to open benchmark output {0}", path);
+			return false;
+		}
+
+		std::vector<double> frameMs, recordMs, submitMs, gpuMs;
+		std::map<std::string, std::vector<double>> counterValues;
+		for (const FrameTimings& timings : m_Timings) {
+			if (timings.frame > 0) frameMs.push_back(timings.cpuFrameMs);
+			recordMs.push_back(timings.cpuRecordMs);
+			submitMs.push_back(timings.submitMs);
+			if (timings.gpuMs >= 0.0) gpuMs.push_back(timings.gpuMs);
+			for (const auto& [name, value] : timings.counters) {
+				counterValues[name].push_back(value);
+			}
+		}
+
+		out << "{\n";
+		out << "  \"scene\": \"" << sceneName << "\",\n";
+		out << "  \"device\": \"" << m_Device.properties.deviceName << "\",\n";
+		out << "  \"headless\": " << (m_Device.isHeadless() ? "true" : "false") << ",\n";
+		out << "  \"width\": " << extent.width << ",\n";
+		out << "  \"height\": " << extent.height << ",\n";
+		out << "  \"frames\": " << m_Timings.size() << ",\n";
+		out << "  \"load\": { "
+			<< "\"sceneLoadMs\": " << m_LoadTimings.sceneLoadMs
+			<< ", \"modelsReadyMs\": " << m_LoadTimings.modelsReadyMs
+			<< ", \"worstLoadFrameMs\": " << m_LoadTimings.worstLoadFrameMs
+			<< " },\n";
+		out << "  \"startup\": { "
+			<< "\"firstFrameMs\": " << m_StartupTimings.firstFrameMs
+			<< ", \"shadersCompiled\": " << m_StartupTimings.shadersCompiled
+			<< ", \"shadersFromDisk\": " << m_StartupTimings.shadersFromDisk
+			<< ", \"pipelineCacheLoaded\": " << (m_StartupTimings.pipelineCacheLoaded ? "true" : "false")
+			<< " },\n";
+		out << "  \"geometry\": { "
+			<< "\"quantized\": " << (m_GeometryMemory.quantized ? "true" : "false")
+			<< ", \"vertexCount\": " << m_GeometryMemory.vertexCount
+			<< ", \"vertexBytes\": " << m_GeometryMemory.vertexBytes
+			<< ", \"indexBytes\": " << m_GeometryMemory.indexBytes
+			<< ", \"unpackedVertexBytes\": " << m_GeometryMemory.unpackedVertexBytes
+			<< " },\n";
+		out << "  \"summary\": {\n";
+		WriteSummary(out, "cpuFrameMs", Summarize(frameMs), false);
+		WriteSummary(out, "cpuRecordMs", Summarize(recordMs), false);
+		WriteSummary(out, "submitMs", Summarize(submitMs), false);
+		WriteSummary(out, "gpuMs", Summarize(gpuMs), counterValues.empty());
+		for (auto it = counterValues.begin(); it != counterValues.end(); ++it) {
+			WriteSummary(out, it->first.c_str(), Summarize(it->second), std::next(it) == counterValues.end());
+		}
+		out << "  },\n";
+		out << "  \"perFrame\": [\n";
+		for (size_t i = 0; i < m_Timings.size(); ++i) {
+			const FrameTimings& timings = m_Timings[i];
+			out << "    { \"frame\": " << timings.frame
+				<< ", \"cpuFrameMs\": " << timings.cpuFrameMs
+				<< ", \"cpuRecordMs\": " << timings.cpuRecordMs
+				<< ", \"submitMs\": " << timings.submitMs
+				<< ", \"gpuMs\": ";
+			if (timings.gpuMs >= 0.0) out << timings.gpuMs;
+			else out << "null";
+			for (const auto& [name, value] : timings.counters) {
+				out << ", \"" << name << "\": " << value;
+			}
+			out << " }" << (i + 1 < m_Timings.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+
+		return true;
+	}
+
+} // namespace Dog
@@ -0,0 +1,133 @@
+#pragma once
+
+namespace Dog {
+
+	class Device;
+
+	struct FrameTimings {
+		uint64_t frame = 0;       // Frame number since the profiler was last reset.
+		double cpuFrameMs = 0.0;  // Wall time between the starts of consecutive frames.
+		double cpuRecordMs = 0.0; // Time spent recording the frame's command buffer.
+		double submitMs = 0.0;    // Time spent submitting (and presenting, when windowed).
+		double gpuMs = -1.0;      // GPU time between the frame's timestamps, -1 if unavailable.
+
+		// Named per-frame values reported by systems, e.g. visible instance counts.
+		std::vector<std::pair<std::string, double>> counters;
+	};
+
+	struct LoadTimings {
+		double sceneLoadMs = -1.0;     // From starting the scene load to the end of its first frame.
+		double modelsReadyMs = -1.0;   // From starting the scene load until no model was still loading.
+		double worstLoadFrameMs = 0.0; // Longest frame while models were loading.
+	};
+
+	struct GeometryMemory {
+		bool quantized = true;             // Packed vertex layouts, or full precision floats.
+		uint64_t vertexCount = 0;          // Vertices in the geometry pool.
+		uint64_t vertexBytes = 0;          // Every vertex and skin stream, as stored.
+		uint64_t indexBytes = 0;
+		uint64_t unpackedVertexBytes = 0;  // The same vertices as 76 byte Vertex structs, for comparison.
+	};
+
+	struct StartupTimings {
+		double firstFrameMs = -1.0;       // From creating the engine to the end of its first frame.
+		uint32_t shadersCompiled = 0;     // Shaders glslang had to compile, 0 when every one was cached.
+		uint32_t shadersFromDisk = 0;
+		bool pipelineCacheLoaded = false; // The driver's pipeline cache from the last run was reused.
+	};
+
+	class FrameProfiler {
+	public:
+		FrameProfiler(Device& device, uint32_t framesInFlight);
+		~FrameProfiler();
+
+		FrameProfiler(const FrameProfiler&) = delete;
+		FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+		/*********************************************************************
+		 * param:  commandBuffer: The frame's command buffer, already begun.
+		 * param:  frameIndex: The frame in flight slot being recorded.
+		 *
+		 * brief:  Collects the GPU results of the last frame that used this
+		 *         slot (its fence has been waited on), then writes the
+		 *         opening timestamp and starts the CPU record timer.
+		 *********************************************************************/
+		void BeginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+
+		/*********************************************************************
+		 * param:  commandBuffer: The frame's command buffer, not yet ended.
+		 * param:  frameIndex: The frame in flight slot being recorded.
+		 *
+		 * brief:  Writes the closing timestamp and stops the record timer.
+		 *********************************************************************/
+		void EndRecording(VkCommandBuffer commandBuffer, int frameIndex);
+
+		void BeginSubmit();
+		void EndSubmit();
+
+		/*********************************************************************
+		 * param:  name: The counter's name in the report.
+		 * param:  value: The value for the frame being recorded.
+		 *
+		 * brief:  Attaches a value to the current frame, summarized in the
+		 *         report alongside the timings. Ignored while disabled.
+		 *********************************************************************/
+		void RecordCounter(const std::string& name, double value);
+
+		/*********************************************************************
+		 * brief:  Reads back every outstanding GPU timing. The device must be
+		 *         idle, so call this after vkDeviceWaitIdle.
+		 *********************************************************************/
+		void Resolve();
+
+		// Drops every recorded frame and restarts the frame counter.
+		void Reset();
+
+		void SetEnabled(bool enabled) { m_Enabled = enabled; }
+		bool IsEnabled() const { return m_Enabled; }
+		bool HasGpuTimings() const { return m_QueryPool != VK_NULL_HANDLE; }
+
+		const std::vector<FrameTimings>& GetTimings() const { return m_Timings; }
+
+		// Written to the report as is, Reset leaves them alone.
+		void SetLoadTimings(const LoadTimings& loadTimings) { m_LoadTimings = loadTimings; }
+		void SetGeometryMemory(const GeometryMemory& geometryMemory) { m_GeometryMemory = geometryMemory; }
+		void SetStartupTimings(const StartupTimings& startupTimings) { m_StartupTimings = startupTimings; }
+
+		/*********************************************************************
+		 * param:  path: The file to write.
+		 * param:  sceneName: Recorded in the report so runs can be compared.
+		 * param:  extent: The render resolution, also recorded.
+		 * return: True if the file was written.
+		 *
+		 * brief:  Writes a JSON report with a summary (mean, min, max, p50,
+		 *         p95, p99) of each timing and counter followed by every
+		 *         frame.
+		 *********************************************************************/
+		bool WriteJson(const std::string& path, const std::string& sceneName, VkExtent2D extent) const;
+
+	private:
+		using Clock = std::chrono::high_resolution_clock;
+
+		void ReadGpuTimings(int frameIndex);
+
+		Device& m_Device;
+		VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+		double m_TimestampPeriodNs = 1.0;
+		uint64_t m_TimestampMask = ~0ull; // Only the queue's valid timestamp bits
+
+		// Index into m_Timings of the frame whose timestamps live in each slot, -1 if none
+		std::vector<int64_t> m_PendingFrames;
+		std::vector<FrameTimings> m_Timings;
+		LoadTimings m_LoadTimings;
+		GeometryMemory m_GeometryMemory;
+		StartupTimings m_StartupTimings;
+
+		Clock::time_point m_FrameStart;
+		Clock::time_point m_RecordStart;
+		Clock::time_point m_SubmitStart;
+		bool m_HasPreviousFrame = false;
+		bool m_Enabled = false;
+	};
+
+} // namespace Dog
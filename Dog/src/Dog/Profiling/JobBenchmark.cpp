@@ -0,0 +1,142 @@
+#include <PCH/pch.h>
+#include "JobBenchmark.h"
+
+#include "Jobs/JobSystem.h"
+
+namespace Dog {
+
+	namespace {
+		using Clock = std::chrono::high_resolution_clock;
+
+		double ToMs(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		}
+
+		// Roughly what a transform update costs, enough to keep the work compute bound
+		float Work(uint32_t item)
+		{
+			glm::mat4 matrix = glm::translate(glm::mat4(1.f), glm::vec3(static_cast<float>(item)));
+			matrix = glm::rotate(matrix, static_cast<float>(item) * 0.001f, glm::vec3(0.f, 1.f, 0.f));
+			matrix = glm::scale(matrix, glm::vec3(1.5f));
+			return matrix[3][0] + matrix[0][0];
+		}
+
+		struct SpawnResult {
+			uint32_t threads = 0;
+			double totalMs = 0.0;
+			double nsPerJob = 0.0;
+		};
+
+		struct ScalingResult {
+			uint32_t threads = 0;
+			double meanMs = 0.0;
+			double minMs = 0.0;
+			double speedup = 1.0;
+		};
+
+		SpawnResult MeasureSpawn(JobSystem& jobs, const JobBenchmarkSpec& spec)
+		{
+			std::atomic<uint32_t> executed{ 0 };
+			double totalMs = 0.0;
+
+			for (uint32_t run = 0; run < spec.repetitions; ++run) {
+				Clock::time_point start = Clock::now();
+
+				JobCounter counter;
+				for (uint32_t i = 0; i < spec.spawnJobs; ++i) {
+					jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}
+				jobs.Wait(counter);
+
+				totalMs += ToMs(Clock::now() - start);
+			}
+
+			SpawnResult result;
+			result.threads = jobs.GetThreadCount();
+			result.totalMs = totalMs / spec.repetitions;
+			result.nsPerJob = result.totalMs * 1000000.0 / spec.spawnJobs;
+			return result;
+		}
+
+		ScalingResult MeasureParallelFor(JobSystem& jobs, const JobBenchmarkSpec& spec, std::vector<float>& output)
+		{
+			ScalingResult result;
+			result.threads = jobs.GetThreadCount();
+			result.minMs = std::numeric_limits<double>::max();
+
+			for (uint32_t run = 0; run < spec.repetitions; ++run) {
+				Clock::time_point start = Clock::now();
+
+				jobs.ParallelFor(spec.parallelForItems, spec.grainSize, [&output](uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; ++i) {
+						output[i] = Work(i);
+					}
+				});
+
+				double ms = ToMs(Clock::now() - start);
+				result.meanMs += ms;
+				result.minMs = std::min(result.minMs, ms);
+			}
+
+			result.meanMs /= spec.repetitions;
+			return result;
+		}
+	}
+
+	bool RunJobBenchmark(const std::string& outputPath, const JobBenchmarkSpec& spec)
+	{
+		uint32_t maxThreads = spec.maxThreads != 0 ? spec.maxThreads : std::max(1u, std::thread::hardware_concurrency());
+		std::vector<float> output(spec.parallelForItems);
+
+		std::vector<SpawnResult> spawnResults;
+		std::vector<ScalingResult> scalingResults;
+
+		for (uint32_t threads = 1; threads <= maxThreads; ++threads) {
+			// The calling thread is thread 0, so one fewer worker than threads
+			JobSystem jobs(static_cast<int>(threads) - 1);
+
+			spawnResults.push_back(MeasureSpawn(jobs, spec));
+			scalingResults.push_back(MeasureParallelFor(jobs, spec, output));
+		}
+
+		for (ScalingResult& result : scalingResults) {
+			result.speedup = result.meanMs > 0.0 ? scalingResults.front().meanMs / result.meanMs : 0.0;
+		}
+
+		std::ofstream out(outputPath);
+		if (!out.is_open()) {
+			DOG_ERROR("Failed to open benchmark output {0}", outputPath);
+			return false;
+		}
+
+		out << "{\n";
+		out << "  \"spawnJobs\": " << spec.spawnJobs << ",\n";
+		out << "  \"parallelForItems\": " << spec.parallelForItems << ",\n";
+		out << "  \"grainSize\": " << spec.grainSize << ",\n";
+		out << "  \"repetitions\": " << spec.repetitions << ",\n";
+		out << "  \"spawn\": [\n";
+		for (size_t i = 0; i < spawnResults.size(); ++i) {
+			const SpawnResult& result = spawnResults[i];
+			out << "    { \"threads\": " << result.threads
+				<< ", \"totalMs\": " << result.totalMs
+				<< ", \"nsPerJob\": " << result.nsPerJob
+				<< " }" << (i + 1 < spawnResults.size() ? ",\n" : "\n");
+		}
+		out << "  ],\n";
+		out << "  \"parallelFor\": [\n";
+		for (size_t i = 0; i < scalingResults.size(); ++i) {
+			const ScalingResult& result = scalingResults[i];
+			out << "    { \"threads\": " << result.threads
+				<< ", \"meanMs\": " << result.meanMs
+				<< ", \"minMs\": " << result.minMs
+				<< ", \"speedup\": " << result.speedup
+				<< " }" << (i + 1 < scalingResults.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+
+		return true;
+	}
+
+} // namespace Dog
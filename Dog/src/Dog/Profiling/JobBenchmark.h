@@ -0,0 +1,25 @@
+#pragma once
+
+namespace Dog {
+
+	struct JobBenchmarkSpec {
+		uint32_t spawnJobs = 100000;      // Empty jobs spawned when measuring overhead.
+		uint32_t parallelForItems = 1 << 20; // Items processed per parallel_for run.
+		uint32_t grainSize = 1024;        // Items per parallel_for job.
+		uint32_t repetitions = 10;        // Runs averaged for every measurement.
+		uint32_t maxThreads = 0;          // Highest thread count to scale to, 0 for every core.
+	};
+
+	/*********************************************************************
+	 * param:  outputPath: Where the JSON report is written.
+	 * param:  spec: Sizes of the measured workloads.
+	 * return: True if the report was written.
+	 *
+	 * brief:  Measures the job system on its own, no window or device
+	 *         needed. Reports the cost of spawning and finishing an empty
+	 *         job, and parallel_for time and speedup over a fixed ALU
+	 *         workload for every thread count from 1 to maxThreads.
+	 *********************************************************************/
+	bool RunJobBenchmark(const std::string& outputPath, const JobBenchmarkSpec& spec = {});
+
+} // namespace Dog
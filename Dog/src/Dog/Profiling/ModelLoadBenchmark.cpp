@@ -0,0 +1,138 @@
+#include <PCH/pch.h>
+#include "ModelLoadBenchmark.h"
+
+#include "Graphics/Vulkan/Core/Device.h"
+#include "Graphics/Vulkan/Core/UploadManager.h"
+#include "Graphics/Vulkan/Models/Model.h"
+#include "Graphics/Vulkan/Models/GeometryPool.h"
+
+namespace Dog {
+
+	namespace {
+		using Clock = std::chrono::high_resolution_clock;
+
+		double ToMs(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		}
+
+		struct MeshResult {
+			uint32_t triangleCount = 0;
+			uint32_t indexBits = 0;
+			uint32_t lodCount = 0;
+			VertexCacheStats before;
+			VertexCacheStats after;
+		};
+
+		struct ModelResult {
+			std::string path;
+			size_t meshCount = 0;
+			uint64_t vertexCount = 0;
+			uint64_t cookedBytes = 0;
+			double assbinMs = 0.0;
+			double cookedMs = 0.0;
+			std::vector<MeshResult> meshes;
+		};
+
+		// Pool creation and the GPU copies stay outside the timing
+		double MeasureLoad(Device& device, const std::string& path, ModelSource source)
+		{
+			GeometryPool geometryPool(device);
+
+			Clock::time_point start = Clock::now();
+			Model model(device, path, source);
+			model.uploadMeshes(geometryPool);
+			double ms = ToMs(Clock::now() - start);
+
+			device.getUploadManager().flush();
+			return ms;
+		}
+	}
+
+	bool RunModelLoadBenchmark(Device& device, const std::string& outputPath, const ModelLoadBenchmarkSpec& spec)
+	{
+		std::vector<ModelResult> results;
+		uint32_t repetitions = std::max(1u, spec.repetitions);
+
+		for (const std::string& path : spec.models) {
+			ModelResult result;
+			result.path = path;
+
+			// Untimed import that writes the assbin cache and the cooked file, and warms the disk cache
+			try {
+				Model model(device, path, ModelSource::Assimp);
+				if (!model.cook(Model::GetCookedPath(path))) {
+					DOG_ERROR("Failed to cook {0}", path);
+					continue;
+				}
+
+				result.meshCount = model.meshes.size();
+				for (const Mesh& mesh : model.meshes) {
+					result.vertexCount += mesh.vertices.size();
+
+					MeshResult& meshResult = result.meshes.emplace_back();
+					meshResult.triangleCount = mesh.getTriangleCount(0);
+					meshResult.lodCount = mesh.lodCount;
+					meshResult.indexBits = GeometryPool::getIndexSize(GeometryPool::getIndexType(static_cast<uint32_t>(mesh.vertices.size()))) * 8;
+					meshResult.before = mesh.cacheStatsBefore;
+					meshResult.after = mesh.cacheStatsAfter;
+				}
+				result.cookedBytes = std::filesystem::file_size(Model::GetCookedPath(path));
+			}
+			catch (const std::exception& e) {
+				DOG_ERROR("Skipping {0}: {1}", path, e.what());
+				continue;
+			}
+
+			// Alternate the two paths so neither benefits from running last
+			for (uint32_t run = 0; run < repetitions; ++run) {
+				result.assbinMs += MeasureLoad(device, path, ModelSource::Assimp);
+				result.cookedMs += MeasureLoad(device, path, ModelSource::Cooked);
+			}
+
+			result.assbinMs /= repetitions;
+			result.cookedMs /= repetitions;
+			results.push_back(result);
+		}
+
+		std::ofstream out(outputPath);
+		if (!out.is_open()) {
+			DOG_ERROR("Failed to open benchmark output {0}", outputPath);
+			return false;
+		}
+
+		out << "{\n";
+		out << "  \"repetitions\": " << repetitions << ",\n";
+		out << "  \"models\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const ModelResult& result = results[i];
+			out << "    { \"path\": \"" << result.path << "\""
+				<< ", \"meshes\": " << result.meshCount
+				<< ", \"vertices\": " << result.vertexCount
+				<< ", \"cookedBytes\": " << result.cookedBytes
+				<< ", \"assbinMs\": " << result.assbinMs
+				<< ", \"cookedMs\": " << result.cookedMs
+				<< ", \"speedup\": " << (result.cookedMs > 0.0 ? result.assbinMs / result.cookedMs : 0.0)
+				<< ",\n      \"meshStats\": [";
+			for (size_t j = 0; j < result.meshes.size(); ++j) {
+				const MeshResult& mesh = result.meshes[j];
+				out << (j > 0 ? ",\n        " : "\n        ")
+					<< "{ \"triangles\": " << mesh.triangleCount
+					<< ", \"indexBits\": " << mesh.indexBits
+					<< ", \"lods\": " << mesh.lodCount
+					<< ", \"acmrBefore\": " << mesh.before.acmr
+					<< ", \"acmrAfter\": " << mesh.after.acmr
+					<< ", \"atvrBefore\": " << mesh.before.atvr
+					<< ", \"atvrAfter\": " << mesh.after.atvr
+					<< " }";
+			}
+			out << (result.meshes.empty() ? "]" : "\n      ]")
+				<< " }" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+
+		return true;
+	}
+
+} // namespace Dog
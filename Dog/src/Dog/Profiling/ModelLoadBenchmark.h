@@ -0,0 +1,36 @@
+#pragma once
+
+namespace Dog {
+
+	class Device;
+
+	struct ModelLoadBenchmarkSpec {
+		std::vector<std::string> models = {
+			"assets/models/quad.obj",
+			"assets/models/charles.glb",
+			"assets/models/charles.fbx",
+			"assets/models/AlisaMikhailovna.fbx",
+			"assets/models/Mon_BlackDragon31_Skeleton.FBX",
+			"assets/models/Book.fbx",
+			"assets/models/smooth_vase.obj",
+			"assets/models/viking_room.obj",
+		};
+		uint32_t repetitions = 5; // Loads averaged for every measurement.
+	};
+
+	/*********************************************************************
+	 * param:  device: Device the meshes are staged for.
+	 * param:  outputPath: Where the JSON report is written.
+	 * param:  spec: Models to load.
+	 * return: True if the report was written.
+	 *
+	 * brief:  Loads every model through the assbin cache (Assimp) and
+	 *         through its cooked file, and reports the time from opening
+	 *         the file to its meshes being staged for upload. Models that
+	 *         fail to load are left out of the report. Each model also
+	 *         lists its meshes' index width and vertex cache ACMR and
+	 *         ATVR before and after import optimization.
+	 *********************************************************************/
+	bool RunModelLoadBenchmark(Device& device, const std::string& outputPath, const ModelLoadBenchmarkSpec& spec = {});
+
+} // namespace Dog
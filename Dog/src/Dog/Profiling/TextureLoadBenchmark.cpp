@@ -0,0 +1,124 @@
+#include <PCH/pch.h>
+#include "TextureLoadBenchmark.h"
+
+#include "Graphics/Vulkan/Core/Device.h"
+#include "Graphics/Vulkan/Core/UploadManager.h"
+#include "Graphics/Vulkan/Texture/TextureLibrary.h"
+#include "Jobs/JobSystem.h"
+
+namespace Dog {
+
+	namespace {
+		using Clock = std::chrono::high_resolution_clock;
+
+		double ToMs(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		}
+
+		struct SetResult {
+			std::string directory;
+			size_t textureCount = 0;
+			double perTextureMs = 0.0;
+			double batchedMs = 0.0;
+		};
+
+		std::vector<std::string> ListImages(const std::string& directory)
+		{
+			std::vector<std::string> paths;
+			if (!std::filesystem::is_directory(directory)) {
+				return paths;
+			}
+
+			for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+				std::string extension = entry.path().extension().string();
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+				if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp") {
+					paths.push_back(entry.path().generic_string());
+				}
+			}
+
+			std::sort(paths.begin(), paths.end());
+			return paths;
+		}
+
+		// Only the load is timed, the library is destroyed after the clock stops
+		double MeasurePerTexture(Device& device, JobSystem& jobSystem, const std::vector<std::string>& paths)
+		{
+			TextureLibrary library(device, jobSystem);
+
+			Clock::time_point start = Clock::now();
+			for (const std::string& path : paths) {
+				library.AddTexture(path);
+			}
+			device.getUploadManager().flush();
+			return ToMs(Clock::now() - start);
+		}
+
+		double MeasureBatched(Device& device, JobSystem& jobSystem, const std::vector<std::string>& paths)
+		{
+			TextureLibrary library(device, jobSystem);
+
+			Clock::time_point start = Clock::now();
+			library.AddTextures(paths);
+			device.getUploadManager().flush();
+			return ToMs(Clock::now() - start);
+		}
+	}
+
+	bool RunTextureLoadBenchmark(Device& device, JobSystem& jobSystem, const std::string& outputPath, const TextureLoadBenchmarkSpec& spec)
+	{
+		std::vector<SetResult> results;
+		uint32_t repetitions = std::max(1u, spec.repetitions);
+
+		for (const std::string& directory : spec.directories) {
+			std::vector<std::string> paths = ListImages(directory);
+			if (paths.size() > MAX_TEXTURE_COUNT) {
+				paths.resize(MAX_TEXTURE_COUNT);
+			}
+
+			SetResult result;
+			result.directory = directory;
+			result.textureCount = paths.size();
+
+			// Untimed load so both paths read the files from a warm disk cache
+			MeasureBatched(device, jobSystem, paths);
+
+			// Alternate the two paths so neither benefits from running last
+			for (uint32_t run = 0; run < repetitions; ++run) {
+				result.perTextureMs += MeasurePerTexture(device, jobSystem, paths);
+				result.batchedMs += MeasureBatched(device, jobSystem, paths);
+			}
+
+			result.perTextureMs /= repetitions;
+			result.batchedMs /= repetitions;
+			results.push_back(result);
+		}
+
+		std::ofstream out(outputPath);
+		if (!out.is_open()) {
+			DOG_ERROR("Failed to open benchmark output {0}", outputPath);
+			return false;
+		}
+
+		out << "{\n";
+		out << "  \"threads\": " << jobSystem.GetThreadCount() << ",\n";
+		out << "  \"repetitions\": " << repetitions << ",\n";
+		out << "  \"sets\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const SetResult& result = results[i];
+			out << "    { \"directory\": \"" << result.directory << "\""
+				<< ", \"textures\": " << result.textureCount
+				<< ", \"perTextureMs\": " << result.perTextureMs
+				<< ", \"batchedMs\": " << result.batchedMs
+				<< ", \"speedup\": " << (result.batchedMs > 0.0 ? result.perTextureMs / result.batchedMs : 0.0)
+				<< " }" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "  ]\n";
+		out << "}\n";
+
+		return true;
+	}
+
+} // namespace Dog
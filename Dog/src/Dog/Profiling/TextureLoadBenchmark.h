@@ -0,0 +1,28 @@
+#pragma once
+
+namespace Dog {
+
+	class Device;
+	class JobSystem;
+
+	struct TextureLoadBenchmarkSpec {
+		std::vector<std::string> directories = { "assets/textures", "assets/models/ModelTextures" };
+		uint32_t repetitions = 3; // Loads averaged for every measurement.
+	};
+
+	/*********************************************************************
+	 * param:  device: Device the textures are uploaded to.
+	 * param:  jobSystem: Job system the batched path decodes on.
+	 * param:  outputPath: Where the JSON report is written.
+	 * param:  spec: Texture sets to load.
+	 * return: True if the report was written.
+	 *
+	 * brief:  Loads every image in each directory into a fresh texture
+	 *         library, once texture by texture with AddTexture and once as
+	 *         a single AddTextures batch, and reports both load times.
+	 *         Run headless, the editor's descriptor pool isn't sized for
+	 *         the extra libraries.
+	 *********************************************************************/
+	bool RunTextureLoadBenchmark(Device& device, JobSystem& jobSystem, const std::string& outputPath, const TextureLoadBenchmarkSpec& spec = {});
+
+} // namespace Dog
@@ -116,15 +116,15 @@ namespace Dog {
 	ModelComponent::ModelComponent(const std::string& modelPath)
 		: ModelPath(modelPath)
 	{
-		// Get the model's index from the model library
-		ModelIndex = Engine::Get().GetModelLibrary().AddModel(modelPath);
+		// Get the model's index from the model library, it draws as the placeholder until loaded
+		ModelIndex = Engine::Get().GetModelLibrary().AddModelAsync(modelPath);
 		DOG_INFO("ModelComponent: Model path: {0}, Model index: {1}", ModelPath, ModelIndex);
 	}
 
 	void ModelComponent::SetModel(const std::string& modelPath)
 	{
 		ModelPath = modelPath;
-		ModelIndex = Engine::Get().GetModelLibrary().AddModel(ModelPath);
+		ModelIndex = Engine::Get().GetModelLibrary().AddModelAsync(ModelPath);
 	}
 
 } // namespace Dog
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Graphics/Vulkan/Animation/AnimationClip.h"
+
 namespace Dog {
 
 	struct TagComponent
@@ -53,6 +55,13 @@ namespace Dog {
 		uint32_t ModelIndex = INVALID_MODEL_INDEX;
 		std::string ModelPath;
 
+		// Added to the level of detail picked from screen size, positive is coarser. Each step is a
+		// halving of the screen size the LODs switch at
+		float LodBias = 0.0f;
+
+		// Level drawn last frame, kept by the renderer so LODs don't flicker at a threshold
+		uint32_t CurrentLod = 0;
+
 		ModelComponent() = default;
 		ModelComponent(const ModelComponent&);
 		ModelComponent(const std::string& modelPath);
@@ -60,6 +69,77 @@ namespace Dog {
 		void SetModel(const std::string& modelPath);
 	};
 
+	// Plays a shared clip on the entity's model. Needs a ModelComponent, and the clip must be for that model's skeleton
+	struct AnimatorComponent
+	{
+		// File the clip is read from, empty plays the model's own file
+		std::string AnimationPath;
+		uint32_t AnimationIndex = INVALID_ANIMATION_INDEX;
+		uint32_t AnimationModelIndex = INVALID_MODEL_INDEX; // The model AnimationIndex was resolved for
+
+		float Time = 0.0f; // In ticks
+		float Speed = 1.0f;
+		bool Playing = true;
+
+		// Kept by the animation system. The pose is sized once per clip, the palette offset is rewritten every frame
+		AnimationPose Pose;
+		uint32_t PoseAnimationIndex = INVALID_ANIMATION_INDEX;
+		uint32_t PaletteOffset = 0;
+
+		// Animators sampled at a reduced rate blend from their previous palette to the pose's over EvaluationSpan frames
+		std::vector<glm::mat4> PreviousPalette;
+		uint32_t EvaluationSpan = 1;
+		uint32_t FramesSinceEvaluation = 0;
+		bool PoseValid = false; // False until sampled, and again once culled
+
+		AnimatorComponent() = default;
+		AnimatorComponent(const AnimatorComponent&) = default;
+		AnimatorComponent(const std::string& animationPath)
+			: AnimationPath(animationPath)
+		{
+		}
+	};
+
+	// Plays a clip baked into bone palettes on the GPU, for crowds. Drawn by the crowd system instead of the
+	// usual path, skinned in the vertex shader with no CPU animation work per frame
+	struct BakedAnimatorComponent
+	{
+		// File the clip is read from, empty plays the model's own file
+		std::string AnimationPath;
+
+		float TimeOffset = 0.0f; // Seconds, so instances sharing a clip don't move in step
+		float Speed = 1.0f;
+
+		// Kept by the crowd system, the clip's index among its baked clips and the model it was baked for
+		uint32_t ClipIndex = INVALID_ANIMATION_INDEX;
+		uint32_t ClipModelIndex = INVALID_MODEL_INDEX;
+
+		BakedAnimatorComponent() = default;
+		BakedAnimatorComponent(const BakedAnimatorComponent&) = default;
+		BakedAnimatorComponent(const std::string& animationPath)
+			: AnimationPath(animationPath)
+		{
+		}
+	};
+
+	// A point light at the entity's translation, shading everything within its radius. Lights are
+	// assigned to screen space clusters each frame, so a scene can have thousands
+	struct PointLightComponent
+	{
+		glm::vec3 Color = { 1.0f, 1.0f, 1.0f };
+		float Intensity = 1.0f;
+		float Radius = 10.0f; // Falls off to nothing here
+
+		PointLightComponent() = default;
+		PointLightComponent(const PointLightComponent&) = default;
+		PointLightComponent(const glm::vec3& color, float intensity, float radius)
+			: Color(color)
+			, Intensity(intensity)
+			, Radius(radius)
+		{
+		}
+	};
+
 	/*class OrthographicCamera;
 	class PerspectiveCamera;
 
@@ -22,6 +22,10 @@ namespace Dog {
 
 		const std::string& GetName() const { return sceneName; }
 
+		// Unset uses the renderer's default, or full intensity when the scene has no point lights
+		const std::optional<glm::vec4>& GetAmbientLight() const { return ambientLight; }
+		void SetAmbientLight(const std::optional<glm::vec4>& color) { ambientLight = color; }
+
 		void ClearEntities();
 		class Entity CreateEntity(const std::string& name = "Unnamed Entity");
 		class Entity CreateEntityFromUUID(const UUID& uuid, const std::string& name = "Unnamed Entity");
@@ -40,6 +44,9 @@ namespace Dog {
 		// Scene name only used for debug purposes
 		std::string sceneName;
 
+		// Ambient light color, w is intensity
+		std::optional<glm::vec4> ambientLight;
+
 		// Scene width & height, equal to window width & height
 		unsigned int width;
 		unsigned int height;
@@ -13,6 +13,9 @@ namespace Dog {
 		YAML::Emitter out;
 		out << YAML::BeginMap;
 		out << YAML::Key << "Scene" << YAML::Value << scene->GetName();
+		if (scene->GetAmbientLight()) {
+			out << YAML::Key << "AmbientLight" << YAML::Value << *scene->GetAmbientLight();
+		}
 
 		out << YAML::Key << "Entities" << YAML::Value << YAML::BeginSeq;
 
@@ -58,6 +61,13 @@ namespace Dog {
 
 		std::string sceneName = data["Scene"].as<std::string>();
 
+		if (auto ambientLight = data["AmbientLight"]) {
+			scene->SetAmbientLight(ambientLight.as<glm::vec4>());
+		}
+		else {
+			scene->SetAmbientLight(std::nullopt);
+		}
+
 		auto entities = data["Entities"];
 
 		if (entities)
@@ -82,7 +92,51 @@ namespace Dog {
 				if (modelComponent)
 				{
 					std::string modelPath = modelComponent["ModelPath"].as<std::string>();
-					deserializedEntity.AddComponent<ModelComponent>(modelPath);
+					auto& mc = deserializedEntity.AddComponent<ModelComponent>(modelPath);
+					if (modelComponent["LodBias"]) {
+						mc.LodBias = modelComponent["LodBias"].as<float>();
+					}
+				}
+
+				auto animatorComponent = entity["AnimatorComponent"];
+				if (animatorComponent)
+				{
+					std::string animationPath = animatorComponent["AnimationPath"] ? animatorComponent["AnimationPath"].as<std::string>() : "";
+					auto& ac = deserializedEntity.AddComponent<AnimatorComponent>(animationPath);
+					if (animatorComponent["Speed"]) {
+						ac.Speed = animatorComponent["Speed"].as<float>();
+					}
+					if (animatorComponent["Time"]) {
+						ac.Time = animatorComponent["Time"].as<float>();
+					}
+				}
+
+				auto bakedAnimatorComponent = entity["BakedAnimatorComponent"];
+				if (bakedAnimatorComponent)
+				{
+					std::string animationPath = bakedAnimatorComponent["AnimationPath"] ? bakedAnimatorComponent["AnimationPath"].as<std::string>() : "";
+					auto& bac = deserializedEntity.AddComponent<BakedAnimatorComponent>(animationPath);
+					if (bakedAnimatorComponent["Speed"]) {
+						bac.Speed = bakedAnimatorComponent["Speed"].as<float>();
+					}
+					if (bakedAnimatorComponent["TimeOffset"]) {
+						bac.TimeOffset = bakedAnimatorComponent["TimeOffset"].as<float>();
+					}
+				}
+
+				auto pointLightComponent = entity["PointLightComponent"];
+				if (pointLightComponent)
+				{
+					auto& plc = deserializedEntity.AddComponent<PointLightComponent>();
+					if (pointLightComponent["Color"]) {
+						plc.Color = pointLightComponent["Color"].as<glm::vec3>();
+					}
+					if (pointLightComponent["Intensity"]) {
+						plc.Intensity = pointLightComponent["Intensity"].as<float>();
+					}
+					if (pointLightComponent["Radius"]) {
+						plc.Radius = pointLightComponent["Radius"].as<float>();
+					}
 				}
 			}
 		}
@@ -114,6 +168,43 @@ namespace Dog {
 			out << YAML::Key << "ModelComponent";
 			out << YAML::BeginMap;
 			out << YAML::Key << "ModelPath" << YAML::Value << mc.ModelPath;
+			out << YAML::Key << "LodBias" << YAML::Value << mc.LodBias;
+			out << YAML::EndMap;
+		}
+
+		if (entity->HasComponent<AnimatorComponent>())
+		{
+			auto& ac = entity->GetComponent<AnimatorComponent>();
+
+			out << YAML::Key << "AnimatorComponent";
+			out << YAML::BeginMap;
+			out << YAML::Key << "AnimationPath" << YAML::Value << ac.AnimationPath;
+			out << YAML::Key << "Speed" << YAML::Value << ac.Speed;
+			out << YAML::Key << "Time" << YAML::Value << ac.Time;
+			out << YAML::EndMap;
+		}
+
+		if (entity->HasComponent<BakedAnimatorComponent>())
+		{
+			auto& bac = entity->GetComponent<BakedAnimatorComponent>();
+
+			out << YAML::Key << "BakedAnimatorComponent";
+			out << YAML::BeginMap;
+			out << YAML::Key << "AnimationPath" << YAML::Value << bac.AnimationPath;
+			out << YAML::Key << "Speed" << YAML::Value << bac.Speed;
+			out << YAML::Key << "TimeOffset" << YAML::Value << bac.TimeOffset;
+			out << YAML::EndMap;
+		}
+
+		if (entity->HasComponent<PointLightComponent>())
+		{
+			auto& plc = entity->GetComponent<PointLightComponent>();
+
+			out << YAML::Key << "PointLightComponent";
+			out << YAML::BeginMap;
+			out << YAML::Key << "Color" << YAML::Value << plc.Color;
+			out << YAML::Key << "Intensity" << YAML::Value << plc.Intensity;
+			out << YAML::Key << "Radius" << YAML::Value << plc.Radius;
 			out << YAML::EndMap;
 		}
 
@@ -5,11 +5,14 @@
 #define NOMINMAX
 
 #define MAX_MODEL_COUNT 250
-#define MAX_TEXTURE_COUNT 250
+#define MAX_TEXTURE_COUNT 4096 // Bindless table limit, must stay below INVALID_TEXTURE_INDEX
+#define INITIAL_TEXTURE_CAPACITY 256
 #define MAX_BONES 100
 #define MAX_BONE_INFLUENCE 4
+#define MAX_INSTANCES 10000
 #define INVALID_MODEL_INDEX 9999
 #define INVALID_TEXTURE_INDEX 9999
+#define INVALID_ANIMATION_INDEX 9999
 
 // glfw
 #define GLFW_INCLUDE_VULKAN
@@ -39,14 +42,17 @@
 #include <fstream>
 #include <stdexcept>
 #include <algorithm>
+#include <numeric>
 #include <chrono>
 #include <thread>
 #include <vector>
+#include <deque>
 #include <cstring>
 #include <cstdlib>
 #include <cstdint>
 #include <limits>
 #include <array>
+#include <span>
 #include <optional>
 #include <unordered_set>
 #include <set>
@@ -54,6 +60,10 @@
 #include <map>
 #include <regex>
 #include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
 #include <typeindex>
 #include <random>
 #include <filesystem>
@@ -1,23 +1,107 @@
 #include <PCH/pch.h>
 #include "Engine.h"
+#include "Profiling/JobBenchmark.h"
+#include "Profiling/TextureLoadBenchmark.h"
+#include "Profiling/ModelLoadBenchmark.h"
+#include "Profiling/AnimationBenchmark.h"
+#include "Graphics/Vulkan/Pipeline/PipelineCache.h"
 
-int main() {
+int main(int argc, char** argv) {
     Dog::EngineSpec specs;
     specs.name = "Woof";
     specs.width = 1280;
     specs.height = 720;
-    specs.fps = 60; // <- fps is unused
+    specs.fps = 60; // <- fps is unused (benchmarks use it as their fixed timestep)
+
+    // Benchmark usage: Dog --headless --benchmark <scene> [--frames N] [--out file.json] [--workers N] [--record-threads N] [--float-vertices] [--lod-quality F] [--no-animation-lod] [--no-draw-sort]
+    // Animation scaling across cores: Dog --headless --benchmark animated_crowd --workers N (see the animation counters)
+    // Animation update-rate LOD: compare evaluatedSkeletons and animationUpdateMs with and without --no-animation-lod
+    // Draw sorting: compare pipelineBinds, vertexBufferBinds, skippedBinds and drawRecordMs with and without --no-draw-sort
+    // Baked crowd animation vs CPU animators, 4096 instances each: Dog --headless --benchmark crowd_baked, then crowd_animated
+    // Clustered lighting, 4096 point lights: Dog --headless --benchmark clustered_lights (see maxClusterLights and the GPU time)
+    // Add --clear-shader-cache to any run to start without cached SPIR-V or pipeline cache data, for a cold start
+    // Job system microbenchmarks: Dog --job-benchmark file.json
+    // Texture load times, per texture vs batched: Dog --texture-benchmark file.json
+    // Model load times, assbin vs cooked: Dog --model-benchmark file.json
+    // Animation evaluation and clip memory, Bone keys vs flattened vs compressed clips: Dog --animation-benchmark file.json
+    // Cook every model in a folder ahead of time: Dog --cook-models assets/models
+    std::string benchmarkScene;
+    std::string jobBenchmarkOutput;
+    std::string textureBenchmarkOutput;
+    std::string modelBenchmarkOutput;
+    std::string animationBenchmarkOutput;
+    std::string cookDirectory;
+    bool clearShaderCache = false;
+    unsigned benchmarkFrames = 1000;
+    std::string benchmarkOutput = "benchmark.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--headless") specs.headless = true;
+        else if (arg == "--benchmark" && i + 1 < argc) benchmarkScene = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc) benchmarkFrames = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--out" && i + 1 < argc) benchmarkOutput = argv[++i];
+        else if (arg == "--job-benchmark" && i + 1 < argc) jobBenchmarkOutput = argv[++i];
+        else if (arg == "--texture-benchmark" && i + 1 < argc) textureBenchmarkOutput = argv[++i];
+        else if (arg == "--model-benchmark" && i + 1 < argc) modelBenchmarkOutput = argv[++i];
+        else if (arg == "--animation-benchmark" && i + 1 < argc) animationBenchmarkOutput = argv[++i];
+        else if (arg == "--cook-models" && i + 1 < argc) cookDirectory = argv[++i];
+        else if (arg == "--workers" && i + 1 < argc) specs.workerThreads = std::stoi(argv[++i]);
+        else if (arg == "--record-threads" && i + 1 < argc) specs.recordThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (arg == "--float-vertices") specs.quantizeVertices = false;
+        else if (arg == "--lod-quality" && i + 1 < argc) specs.lodQuality = std::stof(argv[++i]);
+        else if (arg == "--no-animation-lod") specs.animationLod = false;
+        else if (arg == "--no-draw-sort") specs.sortDraws = false;
+        else if (arg == "--clear-shader-cache") clearShaderCache = true;
+    }
+
+    // Doesn't need a window or device, so it runs before the engine is created
+    if (!jobBenchmarkOutput.empty()) {
+        return Dog::RunJobBenchmark(jobBenchmarkOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Tools that only need the device. The texture benchmark also loads extra texture libraries,
+    // which the editor's descriptor pool has no room for
+    if (!textureBenchmarkOutput.empty() || !modelBenchmarkOutput.empty() || !animationBenchmarkOutput.empty() || !cookDirectory.empty()) {
+        specs.headless = true;
+    }
+
+    // Before the engine's device loads the cache
+    if (clearShaderCache) {
+        Dog::PipelineCache::clearDiskCache();
+    }
 
     Dog::Engine& Engine = Dog::Engine::Create(specs);
 
     try {
+        if (!textureBenchmarkOutput.empty()) {
+            return Dog::RunTextureLoadBenchmark(Engine.GetDevice(), Engine.GetJobSystem(), textureBenchmarkOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (!modelBenchmarkOutput.empty()) {
+            return Dog::RunModelLoadBenchmark(Engine.GetDevice(), modelBenchmarkOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (!animationBenchmarkOutput.empty()) {
+            return Dog::RunAnimationBenchmark(Engine.GetDevice(), animationBenchmarkOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (!cookDirectory.empty()) {
+            uint32_t cooked = Engine.GetModelLibrary().CookModels(cookDirectory);
+            std::cout << "Cooked " << cooked << " models from " << cookDirectory << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        if (!benchmarkScene.empty()) {
+            return Engine.RunBenchmark(benchmarkScene, benchmarkFrames, benchmarkOutput) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
         Engine.Run("namae");
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
-        std::cin.get(); // Wait here
+        if (!specs.headless) {
+            std::cin.get(); // Wait here
+        }
         return EXIT_FAILURE;
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}